@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+// ================================ ALLOCATIONS ================================
+
+static uint64_t bench_alloc_count = 0;
+
+#ifdef __linux__
+#define _BENCH_COUNTS_ALLOCS 1
+
+// Benchmarks are linked with -Wl,--wrap=malloc etc., which sends every
+// allocation through these
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    __atomic_fetch_add(&bench_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    __atomic_fetch_add(&bench_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_fetch_add(&bench_alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#else
+#define _BENCH_COUNTS_ALLOCS 0
+#endif
+
+uint64_t bench_allocs(void) {
+    return __atomic_load_n(&bench_alloc_count, __ATOMIC_RELAXED);
+}
+
+long bench_peak_rss_kb(void) {
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage)) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // reported in bytes
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// ==================================== ZIPF ===================================
+
+static uint64_t bench_gcd(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Maps a rank to its value. The product is taken in 128 bits, since wrapping
+// it at 2^64 before the modulo would send several ranks to the same value.
+static uint64_t bench_zipf_scatter(const bench_zipf *z, uint64_t rank) {
+    __extension__ typedef unsigned __int128 bench_u128;
+
+    return (uint64_t)((bench_u128)rank * z->scatter % z->n);
+}
+
+void bench_zipf_init(bench_zipf *z, uint64_t n, double theta) {
+    unsigned char *seen = calloc(n / 8 + 1, 1);
+
+    z->n = n;
+    z->scatter = 0x9E3779B97F4A7C15ULL % n;
+    while (bench_gcd(z->scatter, n) != 1) z->scatter++;
+
+    // Every rank must have a value of its own
+    for (uint64_t rank = 0; seen && rank < n; rank++) {
+        uint64_t v = bench_zipf_scatter(z, rank);
+        if (seen[v / 8] & (1u << (v % 8))) {
+            fprintf(stderr, "bench_zipf_init: ranks collide at %llu\n", (unsigned long long)v);
+            exit(EXIT_FAILURE);
+        }
+        seen[v / 8] |= (unsigned char)(1u << (v % 8));
+    }
+    free(seen);
+
+    z->theta = theta;
+    z->zetan = 0;
+    for (uint64_t i = 1; i <= n; i++) z->zetan += 1.0 / pow((double)i, theta);
+    z->alpha = 1.0 / (1.0 - theta);
+    z->zeta2 = 1.0 + pow(0.5, theta);
+    z->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) / (1.0 - z->zeta2 / z->zetan);
+}
+
+uint64_t bench_zipf_next(const bench_zipf *z, uint64_t *state) {
+    double u = (double)(bench_rand(state) >> 11) * 0x1.0p-53;
+    double uz = u * z->zetan;
+    uint64_t rank;
+
+    if (uz < 1.0)
+        rank = 0;
+    else if (uz < z->zeta2)
+        rank = 1;
+    else
+        rank = (uint64_t)((double)z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+    if (rank >= z->n) rank = z->n - 1;
+
+    // Scatter the popular ranks so they aren't neighbours in key order
+    return bench_zipf_scatter(z, rank);
+}
+
+// ==================================== RUNS ===================================
+
+void bench_run_begin(bench_run *run, uint64_t ops) {
+    run->ops = 0;
+    run->ns = 0;
+    run->nsamples = 0;
+    run->max_samples = (size_t)(ops / (BENCH_SAMPLE_MASK + 1) + 1);
+    run->samples = malloc(run->max_samples * sizeof(uint64_t));
+    if (!run->samples) {
+        perror("bench_run_begin");
+        exit(EXIT_FAILURE);
+    }
+
+    // Taken last, so the sample buffer isn't counted
+    run->allocs = bench_allocs();
+}
+
+static int bench_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t bench_percentile(const bench_run *run, double p) {
+    if (!run->nsamples) return 0;
+    return run->samples[(size_t)(p * (double)(run->nsamples - 1))];
+}
+
+void bench_run_report(bench_run *run) {
+    uint64_t allocs = bench_allocs() - run->allocs;
+    double ops = run->ops ? (double)run->ops : 1.0;
+
+    qsort(run->samples, run->nsamples, sizeof(uint64_t), bench_cmp_u64);
+
+    printf("\"ops\": %llu, \"ns\": %llu, \"ns_per_op\": %.2f, ", (unsigned long long)run->ops,
+           (unsigned long long)run->ns, (double)run->ns / ops);
+    printf("\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, ",
+           (unsigned long long)bench_percentile(run, 0.50), (unsigned long long)bench_percentile(run, 0.99),
+           (unsigned long long)bench_percentile(run, 0.999));
+    if (_BENCH_COUNTS_ALLOCS)
+        printf("\"allocs_per_op\": %.3f, ", (double)allocs / ops);
+    else
+        printf("\"allocs_per_op\": null, ");
+    printf("\"peak_rss_kb\": %ld}\n", bench_peak_rss_kb());
+    fflush(stdout);
+
+    free(run->samples);
+    run->samples = NULL;
+}
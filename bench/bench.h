@@ -0,0 +1,181 @@
+/**
+ * @file bench.h
+ * @brief Shared helpers for the benchmark programs in `bench/`.
+ *
+ * Benchmarks print one JSON object per measured configuration to `stdout`,
+ * so their output can be collected and compared between builds.
+ *
+ * A measured configuration is a `bench_run`. Its report ends with the same
+ * statistics for every benchmark: operations, ns/op, p50/p99/p999 latency,
+ * allocations per operation and peak RSS.
+ */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief Only one in `BENCH_SAMPLE_MASK + 1` operations has its latency
+ * measured, which keeps clock reads from dominating cheap operations.
+ */
+#define BENCH_SAMPLE_MASK 7
+
+/**
+ * @brief Runs `op`, measuring its latency if `i` is a sampled index.
+ *
+ * @param run The `bench_run *` to record the sample in.
+ * @param i   Index of the operation within the run.
+ * @param op  The statement to run.
+ */
+#define BENCH_SAMPLE(run, i, op)                                  \
+    do {                                                          \
+        if ((i) & BENCH_SAMPLE_MASK) {                            \
+            op;                                                   \
+        } else {                                                  \
+            uint64_t _bench_t = bench_now_ns();                   \
+            op;                                                   \
+            bench_run_sample((run), bench_now_ns() - _bench_t);   \
+        }                                                         \
+    } while (0)
+
+/**
+ * @brief Reads a monotonic clock.
+ *
+ * @return uint64_t The current time in nanoseconds.
+ */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Consumes a value, so the compiler can't drop the work that computed
+ * it. Costs no instructions.
+ *
+ * @param value The result to keep.
+ */
+static inline void bench_sink(uint64_t value) {
+    __asm__ volatile("" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief splitmix64 pseudo-random number generator.
+ *
+ * Fast, seedable and good enough for generating benchmark keys. Each thread
+ * should use its own state.
+ *
+ * @param state The generator state. Updated on every call.
+ *
+ * @return uint64_t The next random number.
+ */
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Generates Zipf-distributed numbers in `[0, n)`.
+ *
+ * Uses the method from Gray et al., "Quickly Generating Billion-Record
+ * Synthetic Databases", so setup is O(n) but needs no tables. Popular values
+ * are scattered over the range rather than clustered at 0, by multiplying
+ * ranks by a number coprime with `n`, which maps `[0, n)` onto itself.
+ */
+typedef struct {
+    uint64_t n;
+    uint64_t scatter;  // coprime with n
+    double theta, alpha, zetan, eta, zeta2;
+} bench_zipf;
+
+/**
+ * @brief Sets up a Zipf generator.
+ *
+ * Exits if ranks would not map to distinct values, which would merge their
+ * popularity.
+ *
+ * @param z     The generator to set up.
+ * @param n     Size of the range. Must be at least 2.
+ * @param theta Skew, any value above 0 except 1, where the approximation
+ * divides by zero. 0.99 is the usual choice, and values above 1, such as 1.1,
+ * concentrate accesses on even fewer keys.
+ */
+void bench_zipf_init(bench_zipf *z, uint64_t n, double theta);
+
+/**
+ * @brief Draws the next Zipf-distributed number.
+ *
+ * @param z     The generator.
+ * @param state A `bench_rand()` state.
+ *
+ * @return uint64_t A number in `[0, n)`.
+ */
+uint64_t bench_zipf_next(const bench_zipf *z, uint64_t *state);
+
+/**
+ * @brief One measured benchmark configuration.
+ */
+typedef struct {
+    uint64_t ops;       // operations performed
+    uint64_t ns;        // time spent in timed sections
+    uint64_t allocs;    // allocation count when the run began
+    uint64_t *samples;  // sampled latencies, in nanoseconds
+    size_t nsamples, max_samples;
+} bench_run;
+
+/**
+ * @brief Starts a run.
+ *
+ * @param run The run to start.
+ * @param ops The number of operations that will be performed, used to size the
+ * latency sample buffer.
+ */
+void bench_run_begin(bench_run *run, uint64_t ops);
+
+/**
+ * @brief Records a sampled latency. Samples past the expected count are
+ * dropped.
+ */
+static inline void bench_run_sample(bench_run *run, uint64_t ns) {
+    if (run->nsamples < run->max_samples) run->samples[run->nsamples++] = ns;
+}
+
+/**
+ * @brief Prints a run's statistics and ends the JSON object, then releases
+ * the run.
+ *
+ * The caller prints the opening brace and the fields describing the
+ * configuration, each followed by `", "`.
+ *
+ * `allocs_per_op` is `null` where allocations cannot be counted. Peak RSS is
+ * the high-water mark of the whole process, so benchmarks run their smaller
+ * configurations first.
+ *
+ * @param run The run to report.
+ */
+void bench_run_report(bench_run *run);
+
+/**
+ * @brief Gets the number of `malloc`, `calloc` and `realloc` calls so far.
+ *
+ * Allocations are only counted on Linux, where benchmarks are linked with
+ * `--wrap` for each function.
+ *
+ * @return uint64_t The allocation count, or 0 if allocations are not counted.
+ */
+uint64_t bench_allocs(void);
+
+/**
+ * @brief Gets the peak resident set size of the process.
+ *
+ * @return long Peak RSS in kilobytes.
+ */
+long bench_peak_rss_kb(void);
+
+#endif
@@ -0,0 +1,692 @@
+/*
+ * Measures bt_add(), bt_get() and bt_remove() on trees from 1K keys up to
+ * `max_keys`, growing by 10x. After building each tree, mixed read/write
+ * workloads run with sequential, uniform and Zipfian key choices.
+ *
+ * Lookups of random 16-byte IDs are also measured, once stored as binary keys
+ * with bt_add_bytes() and once hex-encoded as strings. So are lookups of random
+ * 64-bit integers in a U64Tree, in a BinTree with a comparator, and formatted
+ * into strings for a plain BinTree. Counter increments compare bt_get() followed
+ * by bt_add() against a single bt_emplace(). Uniform lookups compare a bt_get()
+ * loop against bt_get_many() over batches of the same keys, and inserting
+ * batches of new, clustered keys compares a bt_add() loop against bt_add_many().
+ * Lookups of which 70% miss are measured with and without a Bloom filter.
+ * Lookups with a Zipf 1.1 key popularity compare the shuffled tree, a perfectly
+ * balanced one, the shuffled tree in splay mode and the shuffled tree rebuilt
+ * by bt_optimize() from sampled lookups. Rebuilding the shuffled tree into a
+ * complete one is timed as one bt_rebalance() call, and per call when spread
+ * over bounded bt_rebalance_step() calls. Merging a delta tree of 10% or 100%
+ * of the keys compares a bt_add() loop against bt_union(), on one thread and
+ * on several.
+ *
+ * Usage: bintree_bench [max_keys] [ops]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/bintree.h"
+#include "../src/map/u64tree.h"
+#include "bench.h"
+
+#define _BENCH_KEYLEN 32
+#define _BENCH_IDLEN 16
+// Keys are formatted in batches, outside of the timed sections
+#define _BENCH_BATCH 4096
+// Keys per bt_get_many() call
+#define _BENCH_GET_MANY 128
+// Keys per bt_add_many() call, in runs of consecutive keys
+#define _BENCH_ADD_MANY 1024
+#define _BENCH_ADD_RUN 1024
+// Work units per bt_rebalance_step() call
+#define _BENCH_REBALANCE_STEP 4096
+// Threads used by parallel bt_union() calls
+#define _BENCH_MERGE_THREADS 4
+
+static const unsigned read_percents[] = {100, 90, 50};
+
+typedef enum { BENCH_SEQUENTIAL, BENCH_UNIFORM, BENCH_ZIPF } bench_dist;
+static const char *dist_names[] = {"sequential", "uniform", "zipf"};
+
+static char batch[_BENCH_BATCH][_BENCH_KEYLEN];
+static unsigned char batch_write[_BENCH_BATCH];
+
+static void bench_key(char *key, uint64_t i) {
+    snprintf(key, _BENCH_KEYLEN, "key/%llu", (unsigned long long)i);
+}
+
+static void bench_header(const char *op, const char *dist, size_t keys, unsigned read_percent) {
+    printf("{\"bench\": \"bintree\", \"op\": \"%s\", \"dist\": \"%s\", \"keys\": %zu, \"read_percent\": %u, ", op,
+           dist, keys, read_percent);
+}
+
+// Builds the tree in shuffled order. Inserting in key order would degrade the
+// unbalanced tree into a list.
+static void bench_build(BinTree *tree, const size_t *order, size_t keys) {
+    bench_run run;
+
+    bench_run_begin(&run, keys);
+    for (size_t done = 0; done < keys; done += _BENCH_BATCH) {
+        size_t n = keys - done < _BENCH_BATCH ? keys - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], order[done + j]);
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, bt_add(tree, batch[j], &j, sizeof(j)));
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header("add", "uniform", keys, 0);
+    bench_run_report(&run);
+}
+
+static void bench_mixed(BinTree *tree, size_t keys, size_t ops, bench_dist dist, unsigned read_percent,
+                        const bench_zipf *zipf) {
+    uint64_t rng = 42;
+    size_t value = 0;
+    bench_run run;
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) {
+            uint64_t k;
+            if (dist == BENCH_SEQUENTIAL)
+                k = (done + j) % keys;
+            else if (dist == BENCH_UNIFORM)
+                k = bench_rand(&rng) % keys;
+            else
+                k = bench_zipf_next(zipf, &rng);
+            bench_key(batch[j], k);
+            batch_write[j] = bench_rand(&rng) % 100 >= read_percent;
+        }
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) {
+            if (batch_write[j])
+                BENCH_SAMPLE(&run, j, bt_add(tree, batch[j], &value, sizeof(value)));
+            else
+                BENCH_SAMPLE(&run, j, value += bt_get(tree, batch[j]) != NULL);
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header(read_percent == 100 ? "get" : "mixed", dist_names[dist], keys, read_percent);
+    bench_run_report(&run);
+}
+
+static void bench_remove(BinTree *tree, const size_t *order, size_t keys, size_t ops) {
+    bench_run run;
+
+    if (ops > keys) ops = keys;
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        // Remove in a different order than the keys were inserted in
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], order[keys - 1 - done - j]);
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, bt_remove(tree, batch[j]));
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header("remove", "uniform", keys, 0);
+    bench_run_report(&run);
+}
+
+static void bench_id(unsigned char *id, uint64_t i) {
+    uint64_t rng = i;
+
+    for (int w = 0; w < _BENCH_IDLEN; w += 8) {
+        uint64_t r = bench_rand(&rng);
+        memcpy(id + w, &r, 8);
+    }
+}
+
+static void bench_id_hex(char *hex, const unsigned char *id) {
+    for (int b = 0; b < _BENCH_IDLEN; b++) sprintf(hex + 2 * b, "%02x", id[b]);
+}
+
+static void bench_ids(size_t keys, size_t ops, int binary) {
+    static unsigned char ids[_BENCH_BATCH][_BENCH_IDLEN];
+    static char hex[_BENCH_BATCH][2 * _BENCH_IDLEN + 1];
+    BinTree *tree = NULL;
+    uint64_t rng = 42;
+    size_t value = 0;
+    bench_run run;
+
+    if (!bt_init(&tree)) {
+        perror("bench_ids");
+        exit(EXIT_FAILURE);
+    }
+
+    // Random IDs need no shuffling to keep the tree balanced
+    for (size_t done = 0; done < keys; done += _BENCH_BATCH) {
+        size_t n = keys - done < _BENCH_BATCH ? keys - done : _BENCH_BATCH;
+
+        for (size_t j = 0; j < n; j++) {
+            bench_id(ids[j], done + j);
+            bench_id_hex(hex[j], ids[j]);
+            if (binary)
+                bt_add_bytes(tree, ids[j], _BENCH_IDLEN, &j, sizeof(j));
+            else
+                bt_add(tree, hex[j], &j, sizeof(j));
+        }
+    }
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) {
+            bench_id(ids[j], bench_rand(&rng) % keys);
+            bench_id_hex(hex[j], ids[j]);
+        }
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) {
+            if (binary)
+                BENCH_SAMPLE(&run, j, value += bt_get_bytes(tree, ids[j], _BENCH_IDLEN, NULL) != NULL);
+            else
+                BENCH_SAMPLE(&run, j, value += bt_get(tree, hex[j]) != NULL);
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header("get", binary ? "id_bytes" : "id_hex", keys, 100);
+    bench_run_report(&run);
+
+    bt_free(&tree);
+}
+
+// Increments counters under uniformly chosen keys, either with a lookup and a
+// replacement or with a single emplace
+static void bench_upsert(BinTree *tree, size_t keys, size_t ops, int emplace) {
+    uint64_t rng = 7;
+    bench_run run;
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], bench_rand(&rng) % keys);
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) {
+            if (emplace) {
+                BENCH_SAMPLE(&run, j, ++*(size_t *)bt_emplace(tree, batch[j], sizeof(size_t), NULL));
+            } else {
+                size_t count = 0, *found;
+                BENCH_SAMPLE(&run, j, (found = bt_get(tree, batch[j]), count = found ? *found + 1 : 1,
+                                       bt_add(tree, batch[j], &count, sizeof(count))));
+            }
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header(emplace ? "upsert_emplace" : "upsert_get_add", "uniform", keys, 0);
+    bench_run_report(&run);
+}
+
+// Looks up uniformly chosen keys one by one, or _BENCH_GET_MANY at a time with
+// bt_get_many(). A batch's latency is spread evenly over its keys.
+static void bench_get_many(BinTree *tree, size_t keys, size_t ops, int many) {
+    static char *ptrs[_BENCH_BATCH];
+    static void *out[_BENCH_BATCH];
+    uint64_t rng = 11;
+    size_t found = 0;
+    bench_run run;
+
+    for (size_t j = 0; j < _BENCH_BATCH; j++) ptrs[j] = batch[j];
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], bench_rand(&rng) % keys);
+
+        begin = bench_now_ns();
+        if (many) {
+            for (size_t j = 0; j < n; j += _BENCH_GET_MANY) {
+                size_t m = n - j < _BENCH_GET_MANY ? n - j : _BENCH_GET_MANY;
+                uint64_t t = bench_now_ns();
+
+                found += (size_t)bt_get_many(tree, ptrs + j, m, out + j);
+                t = (bench_now_ns() - t) / m;
+                for (size_t s = 0; s < m; s += BENCH_SAMPLE_MASK + 1) bench_run_sample(&run, t);
+            }
+        } else {
+            for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, found += (out[j] = bt_get(tree, batch[j])) != NULL);
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header(many ? "get_many" : "get_loop", "uniform", keys, 100);
+    bench_run_report(&run);
+}
+
+// Inserts new keys next to existing ones, in shuffled batches made of runs of
+// neighbouring keys, one by one or with bt_add_many(). A batch's latency is
+// spread evenly over its keys. The new entries are removed again, untimed.
+static void bench_add_many(BinTree *tree, size_t keys, size_t ops, int many) {
+    static char *ptrs[_BENCH_BATCH];
+    static void *values[_BENCH_BATCH];
+    static size_t sizes[_BENCH_BATCH];
+    uint64_t rng = 13, base = 0;
+    bench_run run;
+
+    for (size_t j = 0; j < _BENCH_BATCH; j++) {
+        ptrs[j] = batch[j];
+        values[j] = &sizes[j];
+        sizes[j] = sizeof(size_t);
+    }
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) {
+            if (j % _BENCH_ADD_RUN == 0) base = bench_rand(&rng) % keys;
+            bench_key(batch[j], base + j % _BENCH_ADD_RUN);
+            strcat(batch[j], "/new");
+        }
+        for (size_t j = n - 1; j > 0; j--) {
+            size_t k = bench_rand(&rng) % (j + 1);
+            char *tmp = ptrs[j];
+            ptrs[j] = ptrs[k];
+            ptrs[k] = tmp;
+        }
+
+        begin = bench_now_ns();
+        if (many) {
+            for (size_t j = 0; j < n; j += _BENCH_ADD_MANY) {
+                size_t m = n - j < _BENCH_ADD_MANY ? n - j : _BENCH_ADD_MANY;
+                uint64_t t = bench_now_ns();
+
+                bt_add_many(tree, ptrs + j, values + j, sizes + j, m);
+                t = (bench_now_ns() - t) / m;
+                for (size_t s = 0; s < m; s += BENCH_SAMPLE_MASK + 1) bench_run_sample(&run, t);
+            }
+        } else {
+            for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, bt_add(tree, ptrs[j], values[j], sizes[j]));
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+
+        for (size_t j = 0; j < n; j++) bt_remove(tree, batch[j]);
+    }
+
+    bench_header(many ? "add_many" : "add_loop", "clustered", keys, 0);
+    bench_run_report(&run);
+}
+
+// Looks up uniformly chosen keys, 70% of them missing, with or without a
+// Bloom filter sized for a 1% false positive rate
+static void bench_bloom(BinTree *tree, size_t keys, size_t ops, int bloom) {
+    uint64_t rng = 19;
+    size_t value = 0;
+    bench_run run;
+
+    if (bloom && !bt_set_bloom(tree, keys, 0.01)) {
+        perror("bench_bloom");
+        exit(EXIT_FAILURE);
+    }
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) {
+            bench_key(batch[j], bench_rand(&rng) % keys);
+            if (bench_rand(&rng) % 100 < 70) strcat(batch[j], "/miss");
+        }
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, value += bt_get(tree, batch[j]) != NULL);
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header(bloom ? "miss70_bloom" : "miss70_plain", "uniform", keys, 100);
+    bench_run_report(&run);
+    bt_set_bloom(tree, 0, 0);
+}
+
+typedef enum { BENCH_TREE_PLAIN, BENCH_TREE_BALANCED, BENCH_TREE_SPLAY, BENCH_TREE_OPTIMIZED } bench_tree_kind;
+static const char *tree_names[] = {"zipf_plain", "zipf_balanced", "zipf_splay", "zipf_optimized"};
+
+static int bench_strcmp(const void *a, const void *b) {
+    return strcmp(a, b);
+}
+
+// Inserts the median of sorted keys, then the medians of either half
+static void bench_add_balanced(BinTree *tree, char (*sorted)[_BENCH_KEYLEN], size_t lo, size_t hi) {
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        bt_add(tree, sorted[mid], &mid, sizeof(mid));
+        bench_add_balanced(tree, sorted, lo, mid);
+        lo = mid + 1;
+    }
+}
+
+// Looks up keys with Zipf 1.1 popularity in a tree built in shuffled order,
+// in one built perfectly balanced, in the shuffled one in splay mode, or in
+// the shuffled one optimized after sampling the same number of lookups
+static void bench_skewed(const size_t *order, size_t keys, size_t ops, const bench_zipf *zipf, bench_tree_kind kind) {
+    BinTree *tree = NULL;
+    uint64_t rng = 23;
+    size_t value = 0;
+    bench_run run;
+
+    if (!bt_init(&tree)) {
+        perror("bench_skewed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (kind == BENCH_TREE_BALANCED) {
+        char (*sorted)[_BENCH_KEYLEN] = malloc(keys * _BENCH_KEYLEN);
+
+        if (!sorted) {
+            perror("bench_skewed");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < keys; i++) bench_key(sorted[i], i);
+        qsort(sorted, keys, _BENCH_KEYLEN, bench_strcmp);
+        bench_add_balanced(tree, sorted, 0, keys);
+        free(sorted);
+    } else {
+        for (size_t i = 0; i < keys; i++) {
+            bench_key(batch[0], order[i]);
+            bt_add(tree, batch[0], &i, sizeof(i));
+        }
+        bt_set_splay(tree, kind == BENCH_TREE_SPLAY);
+    }
+
+    if (kind == BENCH_TREE_OPTIMIZED) {
+        uint64_t warmup = 29;
+
+        bt_set_sampling(tree, 16);
+        for (size_t i = 0; i < ops; i++) {
+            bench_key(batch[0], bench_zipf_next(zipf, &warmup));
+            value += bt_get(tree, batch[0]) != NULL;
+        }
+        bt_set_sampling(tree, 0);
+        bt_optimize(tree);
+    }
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], bench_zipf_next(zipf, &rng));
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, value += bt_get(tree, batch[j]) != NULL);
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header(tree_names[kind], "zipf1.1", keys, 100);
+    bench_run_report(&run);
+    bt_free(&tree);
+}
+
+// Rebuilds a tree built in shuffled order into a complete one, either with one
+// bt_rebalance() call or with bounded steps, whose latency is what's sampled
+static void bench_rebalance(const size_t *order, size_t keys, int steps) {
+    BinTree *tree = NULL;
+    int status = BT_REBALANCE_PENDING;
+    bench_run run;
+
+    if (!bt_init(&tree)) {
+        perror("bench_rebalance");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < keys; i++) {
+        bench_key(batch[0], order[i]);
+        bt_add(tree, batch[0], &i, sizeof(i));
+    }
+
+    if (!steps) {
+        bench_run_begin(&run, BENCH_SAMPLE_MASK + 1);
+        BENCH_SAMPLE(&run, 0, status = bt_rebalance(tree));
+        run.ns = run.samples[0];
+        run.ops = 1;
+    } else {
+        bench_run_begin(&run, 3 * keys / _BENCH_REBALANCE_STEP + 1);
+        for (size_t j = 0; status == BT_REBALANCE_PENDING; j++) {
+            uint64_t begin = bench_now_ns();
+            BENCH_SAMPLE(&run, j, status = bt_rebalance_step(tree, _BENCH_REBALANCE_STEP));
+            run.ns += bench_now_ns() - begin;
+            run.ops++;
+        }
+    }
+    if (!status) {
+        perror("bench_rebalance");
+        exit(EXIT_FAILURE);
+    }
+
+    bench_header(steps ? "rebalance_step" : "rebalance_full", "shuffled", keys, 0);
+    bench_run_report(&run);
+    bt_free(&tree);
+}
+
+typedef enum { BENCH_MERGE_ADD, BENCH_MERGE_UNION, BENCH_MERGE_PARALLEL } bench_merge_kind;
+static const char *merge_names[] = {"merge_add", "merge_union", "merge_union_par"};
+
+static int bench_merge_visit(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    return !bt_add_bytes(ctx, key, keylen, data, size);
+}
+
+// Merges a delta tree of `delta` keys, half of them already in the base tree,
+// into a base tree built in shuffled order. The whole merge is timed, and
+// reported per delta entry.
+static void bench_merge(const size_t *order, size_t keys, size_t delta, bench_merge_kind kind) {
+    BinTree *base = NULL, *other = NULL;
+    bench_run run;
+    int ok = 1;
+
+    if (!bt_init(&base) || !bt_init(&other)) {
+        perror("bench_merge");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < keys; i++) {
+        bench_key(batch[0], order[i]);
+        bt_add(base, batch[0], &i, sizeof(i));
+    }
+    for (size_t i = 0; i < delta; i++) {
+        bench_key(batch[0], i % 2 ? order[i] : keys + order[i]);
+        bt_add(other, batch[0], &i, sizeof(i));
+    }
+    if (kind == BENCH_MERGE_PARALLEL) bt_set_parallel(base, _BENCH_MERGE_THREADS);
+
+    bench_run_begin(&run, BENCH_SAMPLE_MASK + 1);
+    if (kind == BENCH_MERGE_ADD)
+        BENCH_SAMPLE(&run, 0, ok = bt_for_each(other, bench_merge_visit, base));
+    else
+        BENCH_SAMPLE(&run, 0, ok = bt_union(base, other));
+    run.ns = run.samples[0];
+    run.ops = delta;
+    if (!ok || bt_size(base) != (int)(keys + delta / 2)) {
+        fprintf(stderr, "bench_merge: merge failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bench_header(merge_names[kind], delta == keys ? "delta100pct" : "delta10pct", keys, 0);
+    bench_run_report(&run);
+    bt_free(&other);
+    bt_free(&base);
+}
+
+typedef enum { BENCH_U64_TREE, BENCH_U64_CMP, BENCH_U64_STRING } bench_u64_kind;
+static const char *u64_names[] = {"u64_tree", "u64_cmp", "u64_string"};
+
+static int bench_u64_cmp(const void *a, size_t alen, const void *b, size_t blen) {
+    uint64_t x, y;
+
+    (void)alen;
+    (void)blen;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+// Looks up random integer keys. Formatting string keys is part of each timed
+// operation, as it is for callers that have integers to begin with.
+static void bench_u64(size_t keys, size_t ops, bench_u64_kind kind) {
+    static uint64_t ints[_BENCH_BATCH];
+    U64Tree *u64 = NULL;
+    BinTree *tree = NULL;
+    uint64_t rng = 42;
+    size_t value = 0;
+    bench_run run;
+    int ok;
+
+    if (kind == BENCH_U64_TREE)
+        ok = u64t_init(&u64);
+    else
+        ok = kind == BENCH_U64_CMP ? bt_init_with_cmp(&tree, bench_u64_cmp) : bt_init(&tree);
+    if (!ok) {
+        perror("bench_u64");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < keys; i++) {
+        uint64_t seed = i, k = bench_rand(&seed);
+        char key[_BENCH_KEYLEN];
+
+        if (kind == BENCH_U64_TREE) {
+            u64t_add(u64, k, &i, sizeof(i));
+        } else if (kind == BENCH_U64_CMP) {
+            bt_add_bytes(tree, &k, sizeof(k), &i, sizeof(i));
+        } else {
+            bench_key(key, k);
+            bt_add(tree, key, &i, sizeof(i));
+        }
+    }
+
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) {
+            uint64_t seed = bench_rand(&rng) % keys;
+            ints[j] = bench_rand(&seed);
+        }
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) {
+            if (kind == BENCH_U64_TREE) {
+                BENCH_SAMPLE(&run, j, value += u64t_get(u64, ints[j]) != NULL);
+            } else if (kind == BENCH_U64_CMP) {
+                BENCH_SAMPLE(&run, j, value += bt_get_bytes(tree, &ints[j], sizeof(uint64_t), NULL) != NULL);
+            } else {
+                BENCH_SAMPLE(&run, j, (bench_key(batch[j], ints[j]), value += bt_get(tree, batch[j]) != NULL));
+            }
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+
+    bench_header("get", u64_names[kind], keys, 100);
+    bench_run_report(&run);
+
+    u64t_free(&u64);
+    bt_free(&tree);
+}
+
+static void bench_bintree(size_t keys, size_t ops) {
+    BinTree *tree = NULL;
+    size_t *order = malloc(keys * sizeof(size_t));
+    uint64_t rng = 1;
+    bench_zipf zipf;
+
+    if (!order || !bt_init(&tree)) {
+        perror("bench_bintree");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < keys; i++) order[i] = i;
+    for (size_t i = keys - 1; i > 0; i--) {
+        size_t j = bench_rand(&rng) % (i + 1), tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    bench_build(tree, order, keys);
+
+    bench_zipf_init(&zipf, keys, 0.99);
+    for (int d = BENCH_SEQUENTIAL; d <= BENCH_ZIPF; d++) {
+        for (size_t r = 0; r < sizeof(read_percents) / sizeof(*read_percents); r++) {
+            bench_mixed(tree, keys, ops, (bench_dist)d, read_percents[r], &zipf);
+        }
+    }
+
+    bench_upsert(tree, keys, ops, 0);
+    bench_upsert(tree, keys, ops, 1);
+
+    bench_get_many(tree, keys, ops, 0);
+    bench_get_many(tree, keys, ops, 1);
+
+    bench_add_many(tree, keys, ops, 0);
+    bench_add_many(tree, keys, ops, 1);
+
+    bench_bloom(tree, keys, ops, 0);
+    bench_bloom(tree, keys, ops, 1);
+
+    bench_remove(tree, order, keys, ops);
+    bt_free(&tree);
+
+    bench_zipf_init(&zipf, keys, 1.1);
+    for (int k = BENCH_TREE_PLAIN; k <= BENCH_TREE_OPTIMIZED; k++) bench_skewed(order, keys, ops, &zipf, (bench_tree_kind)k);
+
+    bench_rebalance(order, keys, 0);
+    bench_rebalance(order, keys, 1);
+
+    for (int k = BENCH_MERGE_ADD; k <= BENCH_MERGE_PARALLEL; k++) {
+        bench_merge(order, keys, keys / 10, (bench_merge_kind)k);
+        bench_merge(order, keys, keys, (bench_merge_kind)k);
+    }
+    free(order);
+
+    bench_ids(keys, ops, 1);
+    bench_ids(keys, ops, 0);
+
+    for (int k = BENCH_U64_TREE; k <= BENCH_U64_STRING; k++) bench_u64(keys, ops, (bench_u64_kind)k);
+}
+
+int main(int argc, char **argv) {
+    size_t max_keys = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t ops = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+
+    if (max_keys < 1000 || !ops) {
+        fprintf(stderr, "usage: %s [max_keys >= 1000] [ops]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t keys = 1000; keys <= max_keys; keys *= 10) bench_bintree(keys, ops);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+/*
+ * Measures Bitset on sets from 1M bits up to `max_bits`, growing by 10x, with
+ * about half of the bits set. `set` and `test` touch uniformly chosen bits,
+ * and are compared against a Vector of one-byte flags. The bulk operations
+ * and `count` each pass over a whole set, `rank` and `select` answer random
+ * queries, and `iterate` visits every set bit with `bitset_next()`.
+ *
+ * Each report carries the bytes the structure holds, and `bits_per_ns` for
+ * operations over whole sets.
+ *
+ * Usage: bitset_bench [max_bits] [ops]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/lists/bitset.h"
+#include "../src/lists/vector.h"
+#include "bench.h"
+
+// Whole-set passes timed per bulk operation
+#define _BENCH_PASSES 10
+
+static void bench_header(const char *structure, const char *op, size_t bits, size_t bytes, double bits_per_ns) {
+    printf("{\"bench\": \"bitset\", \"structure\": \"%s\", \"op\": \"%s\", \"bits\": %zu, \"bytes\": %zu, ", structure,
+           op, bits, bytes);
+    printf("\"bits_per_ns\": %.2f, ", bits_per_ns);
+}
+
+static void bench_vector_set(Vector *v, size_t bit) {
+    *(char *)vector_get(v, bit) = 1;
+}
+
+// Runs one kind of random single-bit operation on both structures
+static void bench_single(Bitset *set, Vector *v, size_t bits, size_t ops, int test) {
+    size_t set_bytes = (bits + 7) / 8, found = 0;
+    uint64_t rng = 17, begin;
+    bench_run run;
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) {
+        size_t bit = bench_rand(&rng) % bits;
+        if (test)
+            BENCH_SAMPLE(&run, i, found += (size_t)bitset_test(set, bit));
+        else
+            BENCH_SAMPLE(&run, i, bitset_set(set, bit));
+    }
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("bitset", test ? "test" : "set", bits, set_bytes, 0);
+    bench_run_report(&run);
+
+    rng = 17;
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) {
+        size_t bit = bench_rand(&rng) % bits;
+        if (test)
+            BENCH_SAMPLE(&run, i, found += (size_t) * (char *)vector_get(v, bit));
+        else
+            BENCH_SAMPLE(&run, i, bench_vector_set(v, bit));
+    }
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("vector", test ? "test" : "set", bits, bits, 0);
+    bench_run_report(&run);
+
+    bench_sink(found);
+}
+
+// Times whole-set passes of a bulk operation
+static void bench_bulk(Bitset *set, Bitset *other, size_t bits, const char *op) {
+    uint64_t begin, ns;
+    size_t count = 0;
+    bench_run run;
+
+    bench_run_begin(&run, _BENCH_PASSES);
+    for (int pass = 0; pass < _BENCH_PASSES; pass++) {
+        begin = bench_now_ns();
+        switch (op[0]) {
+            case 'a': bitset_and(set, other); break;
+            case 'o': bitset_or(set, other); break;
+            case 'x': bitset_xor(set, other); break;
+            default: count += bitset_count(set); break;
+        }
+        ns = bench_now_ns() - begin;
+        bench_run_sample(&run, ns);
+        run.ns += ns;
+    }
+    run.ops = _BENCH_PASSES;
+
+    bench_sink(count);
+    bench_header("bitset", op, bits, (bits + 7) / 8, (double)bits * _BENCH_PASSES / (double)run.ns);
+    bench_run_report(&run);
+}
+
+static void bench_queries(Bitset *set, size_t bits, size_t ops) {
+    size_t count = bitset_count(set), sum = 0, visited = 0;
+    uint64_t rng = 19, begin;
+    bench_run run;
+
+    // The first query after the updates builds the index
+    bench_run_begin(&run, 1);
+    begin = bench_now_ns();
+    sum += bitset_rank(set, 0);
+    run.ns = bench_now_ns() - begin;
+    run.ops = 1;
+    bench_header("bitset", "index", bits, (bits + 7) / 8, (double)bits / (double)run.ns);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) BENCH_SAMPLE(&run, i, sum += bitset_rank(set, bench_rand(&rng) % bits));
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("bitset", "rank", bits, (bits + 7) / 8, 0);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) BENCH_SAMPLE(&run, i, sum += bitset_select(set, bench_rand(&rng) % count));
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("bitset", "select", bits, (bits + 7) / 8, 0);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, count);
+    begin = bench_now_ns();
+    for (size_t b = bitset_next(set, 0); b != BITSET_NONE; b = bitset_next(set, b + 1)) visited++;
+    run.ns = bench_now_ns() - begin;
+    run.ops = visited;
+    bench_header("bitset", "iterate", bits, (bits + 7) / 8, (double)bits / (double)run.ns);
+    bench_run_report(&run);
+
+    bench_sink(sum);
+    if (visited != count) fprintf(stderr, "bench_queries: visited %zu of %zu\n", visited, count);
+}
+
+int main(int argc, char **argv) {
+    size_t max_bits = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+    size_t ops = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+
+    if (max_bits < 1000000 || !ops || max_bits > UINT32_MAX - 2) {
+        fprintf(stderr, "usage: %s [max_bits >= 1000000] [ops]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t bits = 1000000; bits <= max_bits; bits *= 10) {
+        Bitset *set = NULL, *other = NULL;
+        Vector v;
+
+        if (!bitset_init(&set, bits) || !bitset_init(&other, bits)) {
+            perror("main");
+            return EXIT_FAILURE;
+        }
+        vector_init(&v, (uint32_t)bits + 2, sizeof(char), NULL);
+
+        // About half the bits end up set, as each is hit ln(2) times on average
+        bench_single(set, &v, bits, bits * 69 / 100, 0);
+        bench_single(set, &v, bits, ops, 1);
+        for (size_t i = 0; i < bits; i += 3) bitset_set(other, i);
+
+        bench_bulk(set, other, bits, "count");
+        bench_queries(set, bits, ops);
+        bench_bulk(set, other, bits, "or");
+        bench_bulk(set, other, bits, "xor");
+        bench_bulk(set, other, bits, "and");
+
+        bitset_free(&set);
+        bitset_free(&other);
+        vector_free(&v);
+    }
+
+    return EXIT_SUCCESS;
+}
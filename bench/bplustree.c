@@ -0,0 +1,190 @@
+/*
+ * Compares BPlusTree against BinTree on maps from 1K string keys up to
+ * `max_keys`, growing by 10x: insertion in shuffled order, then lookups of
+ * uniformly chosen keys that are present and that are missing. Range scans of
+ * 100 consecutive entries are measured on the B+tree alone.
+ *
+ * Built with `make STATS=1`, each report also carries the nodes visited and
+ * stored keys read per operation, a proxy for the cache lines it misses.
+ *
+ * Usage: bplustree_bench [max_keys] [ops]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/bintree.h"
+#include "../src/map/bplustree.h"
+#include "bench.h"
+
+#define _BENCH_KEYLEN 32
+#define _BENCH_BATCH 4096
+// Entries visited per range scan
+#define _BENCH_SCAN 100
+
+typedef enum { BENCH_BINTREE, BENCH_BPLUSTREE } bench_map;
+static const char *map_names[] = {"bintree", "bplustree"};
+
+static char batch[_BENCH_BATCH][_BENCH_KEYLEN];
+
+static void bench_key(char *key, uint64_t i) {
+    snprintf(key, _BENCH_KEYLEN, "key/%llu", (unsigned long long)i);
+}
+
+static void bench_header(bench_map map, const char *op, size_t keys, size_t ops, const MapStats *before,
+                         const MapStats *after) {
+    printf("{\"bench\": \"bplustree\", \"map\": \"%s\", \"op\": \"%s\", \"keys\": %zu, ", map_names[map], op, keys);
+    printf("\"nodes_per_op\": %.2f, \"key_reads_per_op\": %.2f, ",
+           (double)(after->nodes_visited - before->nodes_visited) / (double)ops,
+           (double)(after->key_cmps - before->key_cmps) / (double)ops);
+}
+
+static void *bench_get(bench_map map, void *tree, char *key) {
+    return map == BENCH_BINTREE ? bt_get(tree, key) : bp_get(tree, key);
+}
+
+static void bench_stats(bench_map map, void *tree, MapStats *out) {
+    if (map == BENCH_BINTREE)
+        bt_stats(tree, out);
+    else
+        bp_stats(tree, out);
+}
+
+static int bench_count(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)data;
+    (void)size;
+    return ++*(size_t *)ctx % _BENCH_SCAN == 0;
+}
+
+// Looks up uniformly chosen keys, or keys that are never present
+static void bench_lookup(bench_map map, void *tree, size_t keys, size_t ops, int miss) {
+    MapStats before, after;
+    uint64_t rng = 11;
+    size_t found = 0;
+    bench_run run;
+
+    bench_stats(map, tree, &before);
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], bench_rand(&rng) % keys + (miss ? keys : 0));
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, found += bench_get(map, tree, batch[j]) != NULL);
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+    bench_stats(map, tree, &after);
+
+    if (found != (miss ? 0 : ops)) fprintf(stderr, "bench_lookup: found %zu of %zu\n", found, ops);
+    bench_header(map, miss ? "miss" : "get", keys, ops, &before, &after);
+    bench_run_report(&run);
+}
+
+// Visits the entries following uniformly chosen keys
+static void bench_scan(BPlusTree *tree, size_t keys, size_t ops) {
+    MapStats before, after;
+    uint64_t rng = 13;
+    size_t visited = 0;
+    bench_run run;
+
+    bp_stats(tree, &before);
+    bench_run_begin(&run, ops);
+    for (size_t done = 0; done < ops; done += _BENCH_BATCH) {
+        size_t n = ops - done < _BENCH_BATCH ? ops - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], bench_rand(&rng) % keys);
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) BENCH_SAMPLE(&run, j, bp_range_scan(tree, batch[j], NULL, bench_count, &visited));
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+    bp_stats(tree, &after);
+
+    bench_header(BENCH_BPLUSTREE, "scan100", keys, ops, &before, &after);
+    bench_run_report(&run);
+}
+
+static void bench_map_run(bench_map map, const size_t *order, size_t keys, size_t ops) {
+    MapStats before, after;
+    BinTree *bt = NULL;
+    BPlusTree *bp = NULL;
+    void *tree;
+    bench_run run;
+
+    if (map == BENCH_BINTREE ? !bt_init(&bt) : !bp_init(&bp)) {
+        perror("bench_map_run");
+        exit(EXIT_FAILURE);
+    }
+    tree = map == BENCH_BINTREE ? (void *)bt : (void *)bp;
+
+    bench_stats(map, tree, &before);
+    bench_run_begin(&run, keys);
+    for (size_t done = 0; done < keys; done += _BENCH_BATCH) {
+        size_t n = keys - done < _BENCH_BATCH ? keys - done : _BENCH_BATCH;
+        uint64_t begin;
+
+        for (size_t j = 0; j < n; j++) bench_key(batch[j], order[done + j]);
+
+        begin = bench_now_ns();
+        for (size_t j = 0; j < n; j++) {
+            BENCH_SAMPLE(&run, j, map == BENCH_BINTREE ? bt_add(bt, batch[j], &j, sizeof(j)) : bp_add(bp, batch[j], &j, sizeof(j)));
+        }
+        run.ns += bench_now_ns() - begin;
+        run.ops += n;
+    }
+    bench_stats(map, tree, &after);
+    bench_header(map, "add", keys, keys, &before, &after);
+    bench_run_report(&run);
+
+    bench_lookup(map, tree, keys, ops, 0);
+    bench_lookup(map, tree, keys, ops, 1);
+
+    if (map == BENCH_BPLUSTREE) {
+        bench_scan(bp, keys, ops / 10 ? ops / 10 : 1);
+        bp_free(&bp);
+    } else {
+        bt_free(&bt);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t max_keys = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t ops = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    size_t *order;
+    uint64_t rng = 1;
+
+    if (max_keys < 1000 || !ops) {
+        fprintf(stderr, "usage: %s [max_keys >= 1000] [ops]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    order = malloc(max_keys * sizeof(size_t));
+    if (!order) {
+        perror("main");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t keys = 1000; keys <= max_keys; keys *= 10) {
+        for (size_t i = 0; i < keys; i++) order[i] = i;
+        for (size_t i = keys - 1; i > 0; i--) {
+            size_t j = bench_rand(&rng) % (i + 1), tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+
+        bench_map_run(BENCH_BINTREE, order, keys, ops);
+        bench_map_run(BENCH_BPLUSTREE, order, keys, ops);
+    }
+
+    free(order);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * Measures Heap as a timer queue, against the BinTree keyed by formatted
+ * deadlines that it replaces, on queues from 1K pending timers up to
+ * `max_timers`, growing by 10x.
+ *
+ * `hold` pops the earliest timer and schedules a new one a random delay after
+ * it, so the queue keeps its size. The heap runs with 2, 4 and 8 children per
+ * node, the tree with `bt_min()`, `bt_remove()` and `bt_add()`. `build` fills
+ * the queue with pushes, `heapify` with `heap_init_from_vector()`.
+ *
+ * Usage: heap_bench [max_timers] [ops]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/lists/heap.h"
+#include "../src/map/bintree.h"
+#include "bench.h"
+
+#define _BENCH_KEYLEN 32
+// Timers are scheduled up to this far past the one that fired
+#define _BENCH_MAX_DELAY 1000000
+
+typedef struct bench_timer {
+    uint64_t deadline;
+    uint64_t id;
+} bench_timer;
+
+static int bench_cmp(const void *a, const void *b) {
+    uint64_t x = ((const bench_timer *)a)->deadline, y = ((const bench_timer *)b)->deadline;
+    return (x > y) - (x < y);
+}
+
+// Formats a timer's key so that keys sort by deadline, ties broken by id
+static void bench_key(char *key, const bench_timer *t) {
+    snprintf(key, _BENCH_KEYLEN, "%020llu/%llu", (unsigned long long)t->deadline, (unsigned long long)t->id);
+}
+
+// Fires the earliest timer and schedules the next one
+static void bench_heap_hold(Heap *heap, uint64_t *rng, uint64_t *id) {
+    bench_timer t;
+
+    heap_pop(heap, &t);
+    t.deadline += bench_rand(rng) % _BENCH_MAX_DELAY;
+    t.id = (*id)++;
+    heap_push(heap, &t, NULL);
+}
+
+static void bench_tree_add(BinTree *tree, const bench_timer *t) {
+    char key[_BENCH_KEYLEN];
+
+    bench_key(key, t);
+    bt_add(tree, key, (void *)t, sizeof(bench_timer));
+}
+
+static void bench_tree_hold(BinTree *tree, uint64_t *rng, uint64_t *id) {
+    bench_timer t = *(bench_timer *)bt_min(tree);
+    char key[_BENCH_KEYLEN];
+
+    bench_key(key, &t);
+    bt_remove(tree, key);
+    t.deadline += bench_rand(rng) % _BENCH_MAX_DELAY;
+    t.id = (*id)++;
+    bench_tree_add(tree, &t);
+}
+
+static void bench_header(const char *queue, unsigned arity, const char *op, size_t timers) {
+    printf("{\"bench\": \"heap\", \"queue\": \"%s\", \"arity\": %u, \"op\": \"%s\", \"timers\": %zu, ", queue, arity, op,
+           timers);
+}
+
+static void bench_fill(Vector *v, size_t timers) {
+    uint64_t rng = 5;
+
+    vector_init(v, 16, sizeof(bench_timer), NULL);
+    for (size_t i = 0; i < timers; i++) {
+        bench_timer t = {bench_rand(&rng) % _BENCH_MAX_DELAY, i};
+        vector_pushback(v, &t);
+    }
+}
+
+static void bench_heap(size_t timers, size_t ops, unsigned arity) {
+    Heap *heap = NULL;
+    Vector v;
+    bench_run run;
+    uint64_t rng = 9, begin, id = timers;
+
+    bench_fill(&v, timers);
+    heap_init_with_arity(&heap, sizeof(bench_timer), bench_cmp, arity);
+    bench_run_begin(&run, timers);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < timers; i++) BENCH_SAMPLE(&run, i, heap_push(heap, vector_get(&v, i), NULL));
+    run.ns = bench_now_ns() - begin;
+    run.ops = timers;
+    bench_header("heap", arity, "build", timers);
+    bench_run_report(&run);
+    heap_free(&heap);
+
+    bench_run_begin(&run, timers);
+    begin = bench_now_ns();
+    heap_init_from_vector(&heap, &v, bench_cmp, arity);
+    run.ns = bench_now_ns() - begin;
+    run.ops = timers;
+    bench_header("heap", arity, "heapify", timers);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) BENCH_SAMPLE(&run, i, bench_heap_hold(heap, &rng, &id));
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("heap", arity, "hold", timers);
+    bench_run_report(&run);
+
+    heap_free(&heap);
+}
+
+static void bench_bintree(size_t timers, size_t ops) {
+    BinTree *tree = NULL;
+    Vector v;
+    bench_run run;
+    uint64_t rng = 9, begin, id = timers;
+
+    bench_fill(&v, timers);
+    if (!bt_init(&tree)) {
+        perror("bench_bintree");
+        exit(EXIT_FAILURE);
+    }
+    bench_run_begin(&run, timers);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < timers; i++) BENCH_SAMPLE(&run, i, bench_tree_add(tree, vector_get(&v, i)));
+    run.ns = bench_now_ns() - begin;
+    run.ops = timers;
+    bench_header("bintree", 0, "build", timers);
+    bench_run_report(&run);
+    vector_free(&v);
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) BENCH_SAMPLE(&run, i, bench_tree_hold(tree, &rng, &id));
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("bintree", 0, "hold", timers);
+    bench_run_report(&run);
+
+    bt_free(&tree);
+}
+
+int main(int argc, char **argv) {
+    size_t max_timers = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t ops = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+
+    if (max_timers < 1000 || !ops) {
+        fprintf(stderr, "usage: %s [max_timers >= 1000] [ops]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t timers = 1000; timers <= max_timers; timers *= 10) {
+        for (unsigned arity = 2; arity <= 8; arity *= 2) bench_heap(timers, ops, arity);
+        bench_bintree(timers, ops);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/*
+ * Measures the parallel traversals built on the work-stealing pool: a sum over
+ * every entry of a BinTree with `bt_parallel_reduce()`, and over every element
+ * of a Vector with `vector_parallel_reduce()`, on 1 thread and then doubling up
+ * to `max_threads`. Each operation is one whole pass, and `speedup` compares
+ * its time with the single-threaded run.
+ *
+ * Usage: pool_bench [keys] [max_threads]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/lists/vector.h"
+#include "../src/map/bintree.h"
+#include "bench.h"
+
+#define _BENCH_KEYLEN 32
+// Passes timed per configuration
+#define _BENCH_PASSES 10
+// Vector elements per tree entry, so both passes take a similar time
+#define _BENCH_VECTOR_SCALE 16
+
+static void bench_header(const char *structure, size_t entries, unsigned threads, double speedup) {
+    printf("{\"bench\": \"pool\", \"structure\": \"%s\", \"entries\": %zu, \"threads\": %u, \"speedup\": %.2f, ",
+           structure, entries, threads, speedup);
+}
+
+static void bench_fold_entry(void *acc, const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)size;
+    (void)ctx;
+    *(uint64_t *)acc += *(uint64_t *)data;
+}
+
+static void bench_fold_element(void *acc, void *element, size_t index, void *ctx) {
+    (void)index;
+    (void)ctx;
+    *(uint64_t *)acc += *(uint64_t *)element;
+}
+
+static void bench_add(void *acc, const void *part, void *ctx) {
+    (void)ctx;
+    *(uint64_t *)acc += *(const uint64_t *)part;
+}
+
+// Times full passes over one structure, returning the time of the whole run
+static uint64_t bench_passes(BinTree *tree, Vector *v, size_t entries, unsigned threads, uint64_t baseline) {
+    uint64_t expected = (uint64_t)entries * (entries - 1) / 2, total = 0;
+    bench_run run;
+
+    bench_run_begin(&run, _BENCH_PASSES);
+    for (int pass = 0; pass < _BENCH_PASSES; pass++) {
+        uint64_t sum = 0, begin = bench_now_ns(), ns;
+
+        if (tree)
+            bt_parallel_reduce(tree, bench_fold_entry, bench_add, &sum, sizeof(sum), NULL, threads);
+        else
+            vector_parallel_reduce(v, bench_fold_element, bench_add, &sum, sizeof(sum), NULL, threads);
+        ns = bench_now_ns() - begin;
+
+        bench_run_sample(&run, ns);
+        run.ns += ns;
+        run.ops++;
+        if (sum != expected) fprintf(stderr, "bench_passes: sum %llu, expected %llu\n", (unsigned long long)sum,
+                                     (unsigned long long)expected);
+    }
+    total = run.ns;
+
+    bench_header(tree ? "bintree" : "vector", entries, threads, baseline ? (double)baseline / (double)total : 1.0);
+    bench_run_report(&run);
+    return total;
+}
+
+int main(int argc, char **argv) {
+    size_t keys = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    unsigned max_threads = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 16;
+    size_t elements;
+    uint64_t baseline, rng = 1;
+    char key[_BENCH_KEYLEN];
+    BinTree *tree = NULL;
+    Vector v;
+
+    if (!keys || !max_threads) {
+        fprintf(stderr, "usage: %s [keys] [max_threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Insert in random order, so the tree has the usual expected depth
+    if (!bt_init(&tree)) {
+        perror("main");
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < keys; i++) {
+        uint64_t k = bench_rand(&rng);
+        snprintf(key, _BENCH_KEYLEN, "key/%016llx", (unsigned long long)k);
+        if (bt_add(tree, key, &i, sizeof(i)) != _MAP_SUCCESS) i--;
+    }
+
+    elements = keys * _BENCH_VECTOR_SCALE;
+    vector_init(&v, 16, sizeof(uint64_t), NULL);
+    for (uint64_t i = 0; i < elements; i++) vector_pushback(&v, &i);
+
+    baseline = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        uint64_t ns = bench_passes(tree, NULL, keys, threads, baseline);
+        if (!baseline) baseline = ns;
+    }
+
+    baseline = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        uint64_t ns = bench_passes(NULL, &v, elements, threads, baseline);
+        if (!baseline) baseline = ns;
+    }
+
+    bt_free(&tree);
+    vector_free(&v);
+    return EXIT_SUCCESS;
+}
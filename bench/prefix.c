@@ -0,0 +1,116 @@
+/*
+ * Compares bt_prefix_scan() against filtering a full bt_for_each() scan, for
+ * trees of increasing size where each prefix matches a fixed number of keys.
+ *
+ * Usage: prefix_bench [queries] [keys_per_prefix]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/bintree.h"
+#include "bench.h"
+
+#define _BENCH_KEYLEN 48
+
+static const size_t tree_sizes[] = {1000, 10000, 100000, 1000000};
+
+typedef struct {
+    const char *prefix;
+    size_t plen;
+    size_t matched;
+} bench_filter;
+
+static int bench_count_all(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)data;
+    (void)size;
+    ((bench_filter *)ctx)->matched++;
+    return 0;
+}
+
+static int bench_filter_prefix(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    bench_filter *f = ctx;
+    (void)data;
+    (void)size;
+    if (keylen >= f->plen && !memcmp(key, f->prefix, f->plen)) f->matched++;
+    return 0;
+}
+
+static void bench_report(const char *mode, size_t keys, size_t per_prefix, size_t queries, size_t matched, uint64_t elapsed) {
+    printf(
+        "{\"bench\": \"prefix\", \"mode\": \"%s\", \"keys\": %zu, \"keys_per_prefix\": %zu, "
+        "\"queries\": %zu, \"matched\": %zu, \"ns\": %llu, \"ns_per_query\": %.1f}\n",
+        mode, keys, per_prefix, queries, matched, (unsigned long long)elapsed, (double)elapsed / (double)queries);
+}
+
+static void bench_prefix(size_t keys, size_t per_prefix, size_t queries) {
+    BinTree *tree = NULL;
+    size_t prefixes = keys / per_prefix;
+    char key[_BENCH_KEYLEN];
+    size_t *order;
+    uint64_t rng = 1, begin, elapsed;
+    bench_filter filter;
+
+    if (!bt_init(&tree) || !(order = malloc(keys * sizeof(size_t)))) {
+        perror("bench_prefix");
+        exit(EXIT_FAILURE);
+    }
+
+    // Insert in shuffled order, since the tree does not rebalance itself
+    for (size_t i = 0; i < keys; i++) order[i] = i;
+    for (size_t i = keys - 1; i > 0; i--) {
+        size_t j = bench_rand(&rng) % (i + 1), tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (size_t i = 0; i < keys; i++) {
+        snprintf(key, sizeof(key), "tenant/%zu/item/%zu", order[i] % prefixes, order[i] / prefixes);
+        bt_add(tree, key, &i, sizeof(i));
+    }
+
+    filter.prefix = key;
+    filter.matched = 0;
+    begin = bench_now_ns();
+    for (size_t q = 0; q < queries; q++) {
+        snprintf(key, sizeof(key), "tenant/%llu/", (unsigned long long)(bench_rand(&rng) % prefixes));
+        filter.plen = strlen(key);
+        bt_prefix_scan(tree, key, bench_count_all, &filter);
+    }
+    elapsed = bench_now_ns() - begin;
+    bench_report("prefix_scan", keys, per_prefix, queries, filter.matched, elapsed);
+
+    // Full scans are orders of magnitude slower, so run fewer of them
+    queries = queries / 1000 ? queries / 1000 : 1;
+    filter.matched = 0;
+    begin = bench_now_ns();
+    for (size_t q = 0; q < queries; q++) {
+        snprintf(key, sizeof(key), "tenant/%llu/", (unsigned long long)(bench_rand(&rng) % prefixes));
+        filter.plen = strlen(key);
+        bt_for_each(tree, bench_filter_prefix, &filter);
+    }
+    elapsed = bench_now_ns() - begin;
+    bench_report("full_scan", keys, per_prefix, queries, filter.matched, elapsed);
+
+    free(order);
+    bt_free(&tree);
+}
+
+int main(int argc, char **argv) {
+    size_t queries = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000;
+    size_t per_prefix = argc > 2 ? strtoull(argv[2], NULL, 10) : 100;
+
+    if (!queries || !per_prefix) {
+        fprintf(stderr, "usage: %s [queries] [keys_per_prefix]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t s = 0; s < sizeof(tree_sizes) / sizeof(*tree_sizes); s++) {
+        if (tree_sizes[s] >= per_prefix) bench_prefix(tree_sizes[s], per_prefix, queries);
+    }
+
+    return EXIT_SUCCESS;
+}
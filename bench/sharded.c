@@ -0,0 +1,112 @@
+/*
+ * Measures ShardedMap throughput for every combination of thread count and
+ * shard count.
+ *
+ * Usage: sharded_bench [ops_per_thread] [keys] [read_percent]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/map/sharded.h"
+#include "bench.h"
+
+#define _BENCH_KEYLEN 32
+
+static const size_t thread_counts[] = {1, 2, 4, 8, 16};
+static const size_t shard_counts[] = {1, 4, 16, 64, 256};
+
+typedef struct {
+    ShardedMap *map;
+    size_t ops;
+    size_t keys;
+    unsigned read_percent;
+    uint64_t seed;
+    pthread_barrier_t *start;
+} bench_worker;
+
+static void *bench_sharded_worker(void *arg) {
+    bench_worker *w = arg;
+    uint64_t rng = w->seed;
+    char key[_BENCH_KEYLEN];
+    size_t value = 0, size;
+
+    pthread_barrier_wait(w->start);
+
+    for (size_t i = 0; i < w->ops; i++) {
+        uint64_t r = bench_rand(&rng);
+        snprintf(key, sizeof(key), "key/%llu", (unsigned long long)(r % w->keys));
+        if ((r >> 32) % 100 < w->read_percent) {
+            size = sizeof(value);
+            sharded_get(w->map, key, &value, &size);
+        } else {
+            value = i;
+            sharded_add(w->map, key, &value, sizeof(value));
+        }
+    }
+
+    return NULL;
+}
+
+static void bench_sharded(size_t nthreads, size_t nshards, size_t ops, size_t keys, unsigned read_percent) {
+    ShardedMap *map = NULL;
+    pthread_t threads[16];
+    bench_worker workers[16];
+    pthread_barrier_t start;
+    char key[_BENCH_KEYLEN];
+    uint64_t begin, elapsed;
+
+    if (!sharded_init_with_shards(&map, nshards)) {
+        perror("sharded_init_with_shards");
+        exit(EXIT_FAILURE);
+    }
+
+    // Prefill so reads mostly hit
+    for (size_t i = 0; i < keys; i++) {
+        snprintf(key, sizeof(key), "key/%llu", (unsigned long long)i);
+        sharded_add(map, key, &i, sizeof(i));
+    }
+
+    // The main thread joins the barrier too, so the clock starts once every
+    // worker is ready
+    pthread_barrier_init(&start, NULL, (unsigned)nthreads + 1);
+    for (size_t t = 0; t < nthreads; t++) {
+        workers[t] = (bench_worker){map, ops, keys, read_percent, t + 1, &start};
+        pthread_create(&threads[t], NULL, bench_sharded_worker, &workers[t]);
+    }
+
+    pthread_barrier_wait(&start);
+    begin = bench_now_ns();
+    for (size_t t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    elapsed = bench_now_ns() - begin;
+
+    printf(
+        "{\"bench\": \"sharded\", \"threads\": %zu, \"shards\": %zu, \"keys\": %zu, "
+        "\"read_percent\": %u, \"ops\": %zu, \"ns\": %llu, \"mops_per_sec\": %.3f}\n",
+        nthreads, nshards, keys, read_percent, nthreads * ops, (unsigned long long)elapsed,
+        (double)(nthreads * ops) * 1e3 / (double)elapsed);
+
+    pthread_barrier_destroy(&start);
+    sharded_free(&map);
+}
+
+int main(int argc, char **argv) {
+    size_t ops = argc > 1 ? strtoull(argv[1], NULL, 10) : 200000;
+    size_t keys = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+    unsigned read_percent = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 90;
+
+    if (!ops || !keys || read_percent > 100) {
+        fprintf(stderr, "usage: %s [ops_per_thread] [keys] [read_percent]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t s = 0; s < sizeof(shard_counts) / sizeof(*shard_counts); s++) {
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(*thread_counts); t++) {
+            bench_sharded(thread_counts[t], shard_counts[s], ops, keys, read_percent);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
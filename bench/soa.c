@@ -0,0 +1,159 @@
+/*
+ * Measures SoaVector against a Vector of the same 64-byte records, from 1K
+ * records up to `max_records`, growing by 10x.
+ *
+ * `sum` adds up the 8-byte timestamps of every record, in passes over the
+ * whole list until `ops` of them have been read: through `soa_column()` for
+ * the SoaVector, and with a stride of one record for the Vector. `push` and
+ * `get` copy whole records in and out, which the SoaVector does field by
+ * field; `get` reads as many random records as the list holds.
+ *
+ * Usage: soa_bench [max_records] [ops]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/lists/soa.h"
+#include "../src/lists/vector.h"
+#include "bench.h"
+
+typedef struct bench_record {
+    uint64_t id;
+    uint64_t timestamp;
+    double price;
+    uint32_t qty;
+    uint32_t flags;
+    char venue[32];
+} bench_record;
+
+static const SoaField bench_fields[] = {SOA_FIELD(bench_record, id),  SOA_FIELD(bench_record, timestamp),
+                                        SOA_FIELD(bench_record, price), SOA_FIELD(bench_record, qty),
+                                        SOA_FIELD(bench_record, flags), SOA_FIELD(bench_record, venue)};
+
+// The column of `timestamp` in bench_fields
+#define _BENCH_TIMESTAMP 1
+
+static void bench_header(const char *layout, const char *op, size_t records) {
+    printf("{\"bench\": \"soa\", \"layout\": \"%s\", \"op\": \"%s\", \"records\": %zu, ", layout, op, records);
+}
+
+static bench_record bench_make(size_t i) {
+    bench_record r = {i, i * 1000, (double)(i % 1000) / 8, (uint32_t)i, 0, "XNAS"};
+    return r;
+}
+
+static void bench_soa_push(SoaVector *soa, size_t i) {
+    bench_record r = bench_make(i);
+    soa_push(soa, &r);
+}
+
+static void bench_vector_push(Vector *v, size_t i) {
+    bench_record r = bench_make(i);
+    vector_pushback(v, &r);
+}
+
+static uint64_t bench_soa_sum(SoaVector *soa) {
+    const uint64_t *timestamp = soa_column(soa, _BENCH_TIMESTAMP);
+    size_t n = soa_size(soa);
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < n; i++) total += timestamp[i];
+    return total;
+}
+
+static uint64_t bench_vector_sum(Vector *v) {
+    const bench_record *records = v->data;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < v->size; i++) total += records[i].timestamp;
+    return total;
+}
+
+static void bench_layouts(size_t records, size_t ops) {
+    SoaVector *soa = NULL;
+    Vector v;
+    bench_record r;
+    bench_run run;
+    uint64_t rng = 3, begin;
+    size_t passes = ops / records ? ops / records : 1;
+    uint64_t soa_total = 0, vector_total = 0;
+
+    if (!soa_init(&soa, bench_fields, sizeof(bench_fields) / sizeof(bench_fields[0]))) {
+        perror("bench_layouts");
+        exit(EXIT_FAILURE);
+    }
+    vector_init(&v, 16, sizeof(bench_record), NULL);
+
+    bench_run_begin(&run, records);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < records; i++) BENCH_SAMPLE(&run, i, bench_soa_push(soa, i));
+    run.ns = bench_now_ns() - begin;
+    run.ops = records;
+    bench_header("soa", "push", records);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, records);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < records; i++) BENCH_SAMPLE(&run, i, bench_vector_push(&v, i));
+    run.ns = bench_now_ns() - begin;
+    run.ops = records;
+    bench_header("vector", "push", records);
+    bench_run_report(&run);
+
+    // One sample per pass, each reading every record's timestamp
+    bench_run_begin(&run, passes * (BENCH_SAMPLE_MASK + 1));
+    begin = bench_now_ns();
+    for (size_t p = 0; p < passes; p++) BENCH_SAMPLE(&run, 0, soa_total += bench_soa_sum(soa));
+    run.ns = bench_now_ns() - begin;
+    run.ops = passes * records;
+    bench_header("soa", "sum", records);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, passes * (BENCH_SAMPLE_MASK + 1));
+    begin = bench_now_ns();
+    for (size_t p = 0; p < passes; p++) BENCH_SAMPLE(&run, 0, vector_total += bench_vector_sum(&v));
+    run.ns = bench_now_ns() - begin;
+    run.ops = passes * records;
+    bench_header("vector", "sum", records);
+    bench_run_report(&run);
+
+    if (soa_total != vector_total) fprintf(stderr, "bench_layouts: sums differ\n");
+
+    bench_run_begin(&run, records);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < records; i++) BENCH_SAMPLE(&run, i, soa_get(soa, bench_rand(&rng) % records, &r));
+    run.ns = bench_now_ns() - begin;
+    run.ops = records;
+    bench_header("soa", "get", records);
+    bench_run_report(&run);
+
+    rng = 3;
+    bench_run_begin(&run, records);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < records; i++) {
+        BENCH_SAMPLE(&run, i, r = *(bench_record *)vector_get(&v, bench_rand(&rng) % records));
+    }
+    run.ns = bench_now_ns() - begin;
+    run.ops = records;
+    bench_header("vector", "get", records);
+    bench_run_report(&run);
+
+    soa_free(&soa);
+    vector_free(&v);
+}
+
+int main(int argc, char **argv) {
+    size_t max_records = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+    size_t ops = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000000;
+
+    if (max_records < 1000 || !ops || max_records > UINT32_MAX / 2) {
+        fprintf(stderr, "usage: %s [max_records >= 1000] [ops]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t records = 1000; records <= max_records; records *= 10) bench_layouts(records, ops);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+/*
+ * Measures vector_pushback() and vector_get() on vectors from 1K elements up
+ * to `max_elements`, growing by 10x.
+ *
+ * Usage: vector_bench [max_elements] [ops]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/lists/vector.h"
+#include "bench.h"
+
+static void bench_header(const char *op, const char *dist, size_t elements) {
+    printf("{\"bench\": \"vector\", \"op\": \"%s\", \"dist\": \"%s\", \"elements\": %zu, ", op, dist, elements);
+}
+
+static void bench_vector(size_t elements, size_t ops) {
+    Vector v;
+    bench_run run;
+    uint64_t rng = 7, sum = 0, begin;
+
+    // Start small, so growth is part of the measurement
+    vector_init(&v, 16, sizeof(uint64_t), NULL);
+
+    bench_run_begin(&run, elements);
+    begin = bench_now_ns();
+    for (uint64_t i = 0; i < elements; i++) BENCH_SAMPLE(&run, i, vector_pushback(&v, &i));
+    run.ns = bench_now_ns() - begin;
+    run.ops = elements;
+    bench_header("pushback", "sequential", elements);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) BENCH_SAMPLE(&run, i, sum += *(uint64_t *)vector_get(&v, i % elements));
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("get", "sequential", elements);
+    bench_run_report(&run);
+
+    bench_run_begin(&run, ops);
+    begin = bench_now_ns();
+    for (size_t i = 0; i < ops; i++) {
+        BENCH_SAMPLE(&run, i, sum += *(uint64_t *)vector_get(&v, bench_rand(&rng) % elements));
+    }
+    run.ns = bench_now_ns() - begin;
+    run.ops = ops;
+    bench_header("get", "uniform", elements);
+    bench_run_report(&run);
+
+    bench_sink(sum);
+
+    vector_free(&v);
+}
+
+int main(int argc, char **argv) {
+    size_t max_elements = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+    size_t ops = argc > 2 ? strtoull(argv[2], NULL, 10) : 10000000;
+
+    if (max_elements < 1000 || max_elements > UINT32_MAX / 2 || !ops) {
+        fprintf(stderr, "usage: %s [1000 <= max_elements <= %u] [ops]\n", argv[0], UINT32_MAX / 2);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t elements = 1000; elements <= max_elements; elements *= 10) bench_vector(elements, ops);
+
+    return EXIT_SUCCESS;
+}
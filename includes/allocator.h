@@ -0,0 +1,78 @@
+/**
+ * @file allocator.h
+ * @brief A pluggable memory allocator interface shared by every container.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * Containers that accept an `Allocator` (`bt_init_with_allocator()`,
+ * `vector_init_with_allocator()`) make every allocation through it. Passing
+ * `NULL` selects the C heap (`malloc()` and friends), which is also what the
+ * plain constructors use.
+ *
+ * An allocator whose `free` is `NULL` is a region: individual frees are
+ * skipped and all of its memory is released at once by its owner, e.g. with
+ * `arena_reset()`. Containers notice this and destroy themselves in O(1)
+ * instead of visiting every element.
+ */
+#ifndef __ALLOCATOR_H__
+#define __ALLOCATOR_H__
+
+#include <stdlib.h>
+
+/**
+ * @brief A set of allocation functions and their shared state.
+ *
+ * Containers only keep a pointer to the allocator, so it must outlive every
+ * container using it.
+ */
+typedef struct allocator {
+    /** @brief Allocates `size` bytes, aligned for any type. Returns `NULL` on failure. */
+    void *(*alloc)(size_t size, void *ctx);
+    /**
+     * @brief Resizes an allocation of `old_size` bytes to `new_size` bytes,
+     * preserving its contents. Returns `NULL` and leaves `ptr` untouched on
+     * failure.
+     */
+    void *(*realloc)(void *ptr, size_t old_size, size_t new_size, void *ctx);
+    /** @brief Frees an allocation. `NULL` if the allocator is a region. */
+    void (*free)(void *ptr, void *ctx);
+    /** @brief Passed to every function above. */
+    void *ctx;
+} Allocator;
+
+/**
+ * @brief Allocates memory from `a`, or from the C heap if `a` is `NULL`.
+ */
+static inline void *mem_alloc(const Allocator *a, size_t size) {
+    return a ? a->alloc(size, a->ctx) : malloc(size);
+}
+
+/**
+ * @brief Resizes memory from `a`, or from the C heap if `a` is `NULL`.
+ */
+static inline void *mem_realloc(const Allocator *a, void *ptr, size_t old_size, size_t new_size) {
+    return a ? a->realloc(ptr, old_size, new_size, a->ctx) : realloc(ptr, new_size);
+}
+
+/**
+ * @brief Frees memory from `a`, or from the C heap if `a` is `NULL`. Does
+ * nothing for regions.
+ */
+static inline void mem_free(const Allocator *a, void *ptr) {
+    if (!a)
+        free(ptr);
+    else if (a->free)
+        a->free(ptr, a->ctx);
+}
+
+/**
+ * @brief Whether memory from `a` is released all at once rather than freed
+ * piece by piece.
+ */
+static inline int mem_is_region(const Allocator *a) {
+    return a && !a->free;
+}
+
+#endif
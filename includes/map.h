@@ -18,4 +18,55 @@
  */
 #define _MAP_FAILURE 0
 
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of buckets in each `MapStats` depth histogram.
+ */
+#define MAP_STATS_DEPTHS 64
+
+/**
+ * @brief Called once per entry by map iteration functions.
+ *
+ * Entries are visited in key order unless stated otherwise.
+ *
+ * @param key    The entry key. Not guaranteed to be null-terminated.
+ * @param keylen The length of `key` in bytes.
+ * @param data   The data stored in the entry.
+ * @param size   The size of `data`.
+ * @param ctx    The context pointer passed to the iteration function.
+ *
+ * @return int 0 to continue iterating, or any other value to stop.
+ */
+typedef int (*map_visit_fn)(const char *key, size_t keylen, void *data, size_t size, void *ctx);
+
+
+/**
+ * @brief Operation counters reported by maps built with `MAP_STATS` defined
+ * (`make STATS=1`).
+ *
+ * Without `MAP_STATS` no counting code is compiled in, and stats functions
+ * report every counter as 0.
+ */
+typedef struct map_stats {
+    uint64_t gets;           // lookups (get, has)
+    uint64_t adds;           // insertions, including replacements
+    uint64_t removes;        // removals, including misses
+    uint64_t key_cmps;       // key comparisons made by all operations
+    uint64_t nodes_visited;  // nodes visited by all operations
+    uint64_t mallocs;        // allocations made for entries
+    uint64_t frees;          // entry allocations released
+    uint64_t bytes;          // bytes currently held by entries
+
+    /**
+     * @brief Number of operations by nodes visited. Bucket `i` counts
+     * operations that visited `i` nodes. The last bucket also counts deeper
+     * operations.
+     */
+    uint64_t get_depth[MAP_STATS_DEPTHS];
+    uint64_t add_depth[MAP_STATS_DEPTHS];
+    uint64_t remove_depth[MAP_STATS_DEPTHS];
+} MapStats;
+
 #endif
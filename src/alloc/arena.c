@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+#include "arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Every allocation is aligned to this boundary
+#define _ARENA_ALIGN (2 * sizeof(void *))
+#define _ARENA_ROUND(n) (((n) + _ARENA_ALIGN - 1) / _ARENA_ALIGN * _ARENA_ALIGN)
+
+// Two pointer-sized fields, so data starts on an _ARENA_ALIGN boundary
+typedef struct arena_chunk {
+    struct arena_chunk *next;  // previously filled chunk
+    size_t size;               // usable bytes in data
+    unsigned char data[];
+} arena_chunk;
+
+struct arena {
+    Allocator allocator;  // allocates from this arena, see arena_allocator()
+    arena_chunk *head;    // chunk currently being filled
+    size_t offset;        // bytes used in head
+    size_t chunk_size;    // usable bytes in a regular chunk
+    size_t used;          // bytes handed out since the last reset
+    void *last;           // most recent allocation, which can grow in place
+};
+
+// =============================== PRIVATE UTILS ===============================
+
+void *_arena_alloc_fn(size_t size, void *ctx) {
+    return arena_alloc(ctx, size);
+}
+
+void *_arena_realloc_fn(void *ptr, size_t old_size, size_t new_size, void *ctx) {
+    Arena *a = ctx;
+    void *copy;
+
+    // The latest allocation can usually grow or shrink where it is
+    if (ptr && ptr == a->last) {
+        size_t start = (size_t)((unsigned char *)ptr - a->head->data);
+        size_t end = start + _ARENA_ROUND(new_size);
+
+        if (end <= a->head->size) {
+            a->used = a->used - (a->offset - start) + (end - start);
+            a->offset = end;
+            return ptr;
+        }
+    }
+
+    copy = arena_alloc(a, new_size);
+    if (copy && ptr) memcpy(copy, ptr, old_size < new_size ? old_size : new_size);
+
+    return copy;
+}
+
+arena_chunk *_arena_chunk_init(size_t size) {
+    arena_chunk *c = malloc(sizeof(arena_chunk) + size);
+    if (!c) return NULL;
+
+    c->next = NULL;
+    c->size = size;
+
+    return c;
+}
+
+// =============================== INIT/DESTROY  ===============================
+
+int arena_init_with_chunk(Arena **arena, size_t chunk_size) {
+    Arena *a = NULL;
+
+    if (!arena || !chunk_size) return 0;
+
+    a = *arena = malloc(sizeof(Arena));
+    if (!a) return 0;
+
+    a->allocator.alloc = _arena_alloc_fn;
+    a->allocator.realloc = _arena_realloc_fn;
+    a->allocator.free = NULL;  // region
+    a->allocator.ctx = a;
+    a->head = NULL;
+    a->offset = 0;
+    a->chunk_size = _ARENA_ROUND(chunk_size);
+    a->used = 0;
+    a->last = NULL;
+
+    return 1;
+}
+
+int arena_init(Arena **arena) {
+    return arena_init_with_chunk(arena, ARENA_DEFAULT_CHUNK);
+}
+
+void arena_free(Arena **arena) {
+    arena_chunk *c, *next;
+
+    if (!arena || !(*arena)) return;
+
+    for (c = (*arena)->head; c; c = next) {
+        next = c->next;
+        free(c);
+    }
+
+    free(*arena);
+    *arena = NULL;
+}
+
+void arena_reset(Arena *arena) {
+    arena_chunk *c, *next, *keep = NULL;
+
+    if (!arena) return;
+
+    // Keep one regular chunk, so the arena can be refilled without touching
+    // the C heap
+    for (c = arena->head; c; c = next) {
+        next = c->next;
+        if (!keep && c->size == arena->chunk_size) {
+            keep = c;
+            keep->next = NULL;
+        } else {
+            free(c);
+        }
+    }
+
+    arena->head = keep;
+    arena->offset = 0;
+    arena->used = 0;
+    arena->last = NULL;
+}
+
+// ================================= ALLOCATION ================================
+
+void *arena_alloc(Arena *arena, size_t size) {
+    unsigned char *ptr;
+
+    if (!arena) return NULL;
+    if (size > SIZE_MAX - _ARENA_ALIGN) return NULL;
+
+    size = _ARENA_ROUND(size ? size : 1);
+
+    if (!arena->head || arena->offset + size > arena->head->size) {
+        arena_chunk *c;
+
+        if (size > arena->chunk_size) {
+            // Oversized allocations get their own chunk. It goes behind the
+            // current chunk, which still has room for small allocations.
+            c = _arena_chunk_init(size);
+            if (!c) return NULL;
+
+            if (arena->head) {
+                c->next = arena->head->next;
+                arena->head->next = c;
+            } else {
+                c->next = NULL;
+                arena->head = c;
+                arena->offset = size;
+                arena->last = c->data;
+            }
+
+            arena->used += size;
+            return c->data;
+        }
+
+        c = _arena_chunk_init(arena->chunk_size);
+        if (!c) return NULL;
+
+        c->next = arena->head;
+        arena->head = c;
+        arena->offset = 0;
+    }
+
+    ptr = arena->head->data + arena->offset;
+    arena->offset += size;
+    arena->used += size;
+    arena->last = ptr;
+
+    return ptr;
+}
+
+size_t arena_used(Arena *arena) {
+    return arena ? arena->used : 0;
+}
+
+const Allocator *arena_allocator(Arena *arena) {
+    return arena ? &arena->allocator : NULL;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file arena.h
+ * @brief A bump-pointer arena allocator.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup arena Arena
+ * Allocates by bumping a pointer through large chunks of memory. Individual
+ * allocations are never freed; everything is released at once by
+ * `arena_reset()` or `arena_free()`.
+ *
+ * Containers built on `arena_allocator()` skip their per-element frees, so a
+ * temporary map can be thrown away with a single reset.
+ */
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stdlib.h>
+
+#include "allocator.h"
+
+/**
+ * @brief Chunk size used by `arena_init()`.
+ *
+ * @ingroup arena
+ */
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+
+/**
+ * @brief A bump-pointer arena.
+ *
+ * Arenas are not thread-safe.
+ *
+ * @ingroup arena
+ */
+typedef struct arena Arena;
+
+/**
+ * @brief Constructs a new Arena that allocates `ARENA_DEFAULT_CHUNK` bytes at
+ * a time.
+ *
+ * @ingroup arena
+ *
+ * @param arena A pointer to the arena to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int arena_init(Arena **arena);
+
+/**
+ * @brief Constructs a new Arena with a custom chunk size.
+ *
+ * Allocations larger than a chunk get a chunk of their own.
+ *
+ * @ingroup arena
+ *
+ * @param arena      A pointer to the arena to construct.
+ * @param chunk_size Bytes requested from the C heap at a time.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int arena_init_with_chunk(Arena **arena, size_t chunk_size);
+
+/**
+ * @brief Destroys an Arena, releasing every allocation made from it.
+ *
+ * After destruction, the arena will be set to `NULL`.
+ *
+ * @ingroup arena
+ *
+ * @param arena A pointer to the arena to destroy.
+ */
+void arena_free(Arena **arena);
+
+/**
+ * @brief Releases every allocation made from an Arena.
+ *
+ * One chunk is kept for reuse. Containers allocated from the arena must not
+ * be used afterwards.
+ *
+ * @ingroup arena
+ *
+ * @param arena The arena to reset.
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * @brief Allocates memory from an Arena.
+ *
+ * @ingroup arena
+ *
+ * @param arena The arena to allocate from.
+ * @param size  The number of bytes to allocate.
+ *
+ * @return void* Memory aligned for any type, or `NULL` on failure.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Gets the number of bytes handed out since the last reset.
+ *
+ * @ingroup arena
+ *
+ * @param arena The target arena.
+ *
+ * @return size_t Bytes allocated, including alignment padding.
+ */
+size_t arena_used(Arena *arena);
+
+/**
+ * @brief Gets an Allocator that allocates from an Arena.
+ *
+ * The allocator is a region (its `free` is `NULL`), and lives as long as the
+ * arena.
+ *
+ * @ingroup arena
+ *
+ * @param arena The arena to allocate from.
+ *
+ * @return const Allocator* The arena's allocator.
+ */
+const Allocator *arena_allocator(Arena *arena);
+
+#endif
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+#include "slab.h"
+
+#include <stdint.h>
+
+// Every object is aligned to this boundary
+#define _SLAB_ALIGN (2 * sizeof(void *))
+
+// Two pointer-sized fields, so objects start on a _SLAB_ALIGN boundary
+typedef struct slab_page {
+    struct slab_page *next;  // previously allocated page
+    size_t pad;
+    unsigned char objects[];
+} slab_page;
+
+struct slab {
+    Allocator allocator;  // allocates from this slab, see slab_allocator()
+    slab_page *pages;     // every page, newest first
+    void *free_list;      // released objects, linked through their first word
+    size_t carved;        // objects handed out from the newest page
+    size_t object_size;   // rounded up to _SLAB_ALIGN
+    size_t per_page;      // objects in each page
+    size_t live;          // objects currently allocated
+};
+
+// =============================== PRIVATE UTILS ===============================
+
+void *_slab_alloc_fn(size_t size, void *ctx) {
+    Slab *s = ctx;
+    return size <= s->object_size ? slab_alloc(s) : NULL;
+}
+
+void *_slab_realloc_fn(void *ptr, size_t old_size, size_t new_size, void *ctx) {
+    Slab *s = ctx;
+    (void)old_size;
+
+    // Every object already has room for the largest request
+    if (new_size > s->object_size) return NULL;
+    return ptr ? ptr : slab_alloc(s);
+}
+
+void _slab_free_fn(void *ptr, void *ctx) {
+    slab_release(ctx, ptr);
+}
+
+// =============================== INIT/DESTROY  ===============================
+
+int slab_init_with_page(Slab **slab, size_t object_size, size_t per_page) {
+    Slab *s = NULL;
+
+    if (!slab || !object_size || !per_page) return 0;
+    if (object_size > (SIZE_MAX - sizeof(slab_page)) / per_page - _SLAB_ALIGN) return 0;
+
+    s = *slab = malloc(sizeof(Slab));
+    if (!s) return 0;
+
+    s->allocator.alloc = _slab_alloc_fn;
+    s->allocator.realloc = _slab_realloc_fn;
+    s->allocator.free = _slab_free_fn;
+    s->allocator.ctx = s;
+    s->pages = NULL;
+    s->free_list = NULL;
+    s->carved = per_page;  // no page yet, so the first allocation makes one
+    s->object_size = (object_size + _SLAB_ALIGN - 1) / _SLAB_ALIGN * _SLAB_ALIGN;
+    s->per_page = per_page;
+    s->live = 0;
+
+    return 1;
+}
+
+int slab_init(Slab **slab, size_t object_size) {
+    return slab_init_with_page(slab, object_size, SLAB_DEFAULT_OBJECTS);
+}
+
+void slab_free(Slab **slab) {
+    slab_page *p, *next;
+
+    if (!slab || !(*slab)) return;
+
+    for (p = (*slab)->pages; p; p = next) {
+        next = p->next;
+        free(p);
+    }
+
+    free(*slab);
+    *slab = NULL;
+}
+
+// ================================= ALLOCATION ================================
+
+void *slab_alloc(Slab *slab) {
+    void *obj;
+
+    if (!slab) return NULL;
+
+    if (slab->free_list) {
+        // Reuse the most recently released object, it is likely still cached
+        obj = slab->free_list;
+        slab->free_list = *(void **)obj;
+    } else {
+        if (slab->carved == slab->per_page) {
+            slab_page *p = malloc(sizeof(slab_page) + slab->object_size * slab->per_page);
+            if (!p) return NULL;
+
+            p->next = slab->pages;
+            slab->pages = p;
+            slab->carved = 0;
+        }
+
+        obj = slab->pages->objects + slab->object_size * slab->carved++;
+    }
+
+    slab->live++;
+    return obj;
+}
+
+void slab_release(Slab *slab, void *ptr) {
+    if (!slab || !ptr) return;
+
+    *(void **)ptr = slab->free_list;
+    slab->free_list = ptr;
+    slab->live--;
+}
+
+size_t slab_live(Slab *slab) {
+    return slab ? slab->live : 0;
+}
+
+const Allocator *slab_allocator(Slab *slab) {
+    return slab ? &slab->allocator : NULL;
+}
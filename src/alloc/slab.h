@@ -0,0 +1,122 @@
+/**
+ * @file slab.h
+ * @brief A fixed-size object allocator.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup slab Slab
+ * Hands out objects of a single size, carved from large pages. Freed objects
+ * go on a free list and are reused before any new page is allocated, so
+ * allocation and free are both O(1) and never touch the C heap in steady
+ * state.
+ */
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <stdlib.h>
+
+#include "allocator.h"
+
+/**
+ * @brief Objects per page used by `slab_init()`.
+ *
+ * @ingroup slab
+ */
+#define SLAB_DEFAULT_OBJECTS 256
+
+/**
+ * @brief A fixed-size object allocator.
+ *
+ * Slabs are not thread-safe.
+ *
+ * @ingroup slab
+ */
+typedef struct slab Slab;
+
+/**
+ * @brief Constructs a new Slab.
+ *
+ * @ingroup slab
+ *
+ * @param slab        A pointer to the slab to construct.
+ * @param object_size The size of every object. Requests up to this size are
+ * served.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int slab_init(Slab **slab, size_t object_size);
+
+/**
+ * @brief Constructs a new Slab with a custom page size.
+ *
+ * @ingroup slab
+ *
+ * @param slab        A pointer to the slab to construct.
+ * @param object_size The size of every object.
+ * @param per_page    Objects allocated from the C heap at a time.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int slab_init_with_page(Slab **slab, size_t object_size, size_t per_page);
+
+/**
+ * @brief Destroys a Slab, releasing every object allocated from it.
+ *
+ * After destruction, the slab will be set to `NULL`.
+ *
+ * @ingroup slab
+ *
+ * @param slab A pointer to the slab to destroy.
+ */
+void slab_free(Slab **slab);
+
+/**
+ * @brief Allocates an object.
+ *
+ * @ingroup slab
+ *
+ * @param slab The slab to allocate from.
+ *
+ * @return void* An object of the slab's object size, aligned for any type, or
+ * `NULL` on failure.
+ */
+void *slab_alloc(Slab *slab);
+
+/**
+ * @brief Returns an object to a Slab.
+ *
+ * @ingroup slab
+ *
+ * @param slab The slab the object was allocated from.
+ * @param ptr  The object. May be `NULL`.
+ */
+void slab_release(Slab *slab, void *ptr);
+
+/**
+ * @brief Gets the number of objects currently allocated from a Slab.
+ *
+ * @ingroup slab
+ *
+ * @param slab The target slab.
+ *
+ * @return size_t The number of live objects.
+ */
+size_t slab_live(Slab *slab);
+
+/**
+ * @brief Gets an Allocator that allocates from a Slab.
+ *
+ * Requests larger than the slab's object size fail, so a container should
+ * only use a slab whose objects fit its largest allocation.
+ *
+ * @ingroup slab
+ *
+ * @param slab The slab to allocate from.
+ *
+ * @return const Allocator* The slab's allocator.
+ */
+const Allocator *slab_allocator(Slab *slab);
+
+#endif
@@ -0,0 +1,345 @@
+// SPDX-License-Identifier: MIT
+#include "bitset.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(BITSET_NO_AVX2)
+#define _BITSET_AVX2
+#include <immintrin.h>
+#endif
+
+// Words per block, the unit of the rank index and of the bulk kernels
+#define _BITSET_BLOCK_WORDS 8
+// Blocks per superblock. Counts within one fit in 16 bits.
+#define _BITSET_SUPER_BLOCKS 128
+#define _BITSET_BLOCK_BITS (64 * _BITSET_BLOCK_WORDS)
+
+// Combines `n` words of `b` into `a`. `n` is a multiple of the block size.
+typedef void (*_bitset_op_fn)(uint64_t *a, const uint64_t *b, size_t n);
+
+// The kernels for one instruction set
+typedef struct _bitset_kernels {
+    _bitset_op_fn and_op, or_op, xor_op, andnot_op;
+    size_t (*count)(const uint64_t *words, size_t n);
+} _bitset_kernels;
+
+struct bitset {
+    uint64_t *words;         // the bits, padded to whole blocks that stay clear
+    size_t size;             // bits in the set
+    size_t nwords;           // a multiple of _BITSET_BLOCK_WORDS
+    uint64_t *supers;        // set bits before each superblock
+    uint16_t *blocks;        // set bits before each block, from its superblock
+    uint64_t total;          // set bits, as of the last index build
+    int dirty;               // the bits changed since the index was built
+    const _bitset_kernels *kernels;
+};
+
+// ================================== KERNELS ==================================
+
+#define _BITSET_SCALAR_OP(name, expr)                                             \
+    static void _bitset_##name##_scalar(uint64_t *a, const uint64_t *b, size_t n) { \
+        for (size_t i = 0; i < n; i++) a[i] = (expr);                             \
+    }
+
+_BITSET_SCALAR_OP(and, a[i] & b[i])
+_BITSET_SCALAR_OP(or, a[i] | b[i])
+_BITSET_SCALAR_OP(xor, a[i] ^ b[i])
+_BITSET_SCALAR_OP(andnot, a[i] & ~b[i])
+
+static size_t _bitset_count_scalar(const uint64_t *words, size_t n) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++) count += (size_t)__builtin_popcountll(words[i]);
+    return count;
+}
+
+static const _bitset_kernels _bitset_scalar = {
+    _bitset_and_scalar, _bitset_or_scalar, _bitset_xor_scalar, _bitset_andnot_scalar, _bitset_count_scalar,
+};
+
+#ifdef _BITSET_AVX2
+// Built for AVX2 whatever the compiler flags, and only called after checking
+// that the processor has it
+#define _BITSET_AVX2_OP(name, expr)                                                               \
+    __attribute__((target("avx2"))) static void _bitset_##name##_avx2(uint64_t *a, const uint64_t *b, \
+                                                                       size_t n) {                \
+        for (size_t i = 0; i < n; i += 4) {                                                       \
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));                             \
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));                             \
+            _mm256_storeu_si256((__m256i *)(a + i), (expr));                                      \
+        }                                                                                         \
+    }
+
+_BITSET_AVX2_OP(and, _mm256_and_si256(x, y))
+_BITSET_AVX2_OP(or, _mm256_or_si256(x, y))
+_BITSET_AVX2_OP(xor, _mm256_xor_si256(x, y))
+_BITSET_AVX2_OP(andnot, _mm256_andnot_si256(y, x))
+
+/*
+ * Counts bits a nibble at a time, looking each one up in a 16-entry table
+ * held in a register (Muła, Kurz and Lemire, "Faster Population Counts Using
+ * AVX2 Instructions"). Byte counts are summed into 64-bit lanes by
+ * _mm256_sad_epu8().
+ */
+__attribute__((target("avx2"))) static size_t _bitset_count_avx2(const uint64_t *words, size_t n) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                           2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(words + i));
+        __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+        __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+
+    return (size_t)(_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) + _mm256_extract_epi64(total, 2) +
+                    _mm256_extract_epi64(total, 3));
+}
+
+static const _bitset_kernels _bitset_avx2 = {
+    _bitset_and_avx2, _bitset_or_avx2, _bitset_xor_avx2, _bitset_andnot_avx2, _bitset_count_avx2,
+};
+#endif
+
+static const _bitset_kernels *_bitset_pick_kernels(void) {
+#ifdef _BITSET_AVX2
+    if (__builtin_cpu_supports("avx2")) return &_bitset_avx2;
+#endif
+    return &_bitset_scalar;
+}
+
+// ================================ RANK INDEX =================================
+
+static void _bitset_index(Bitset *set) {
+    size_t nblocks = set->nwords / _BITSET_BLOCK_WORDS;
+    uint64_t total = 0;
+
+    for (size_t b = 0; b < nblocks; b++) {
+        if (b % _BITSET_SUPER_BLOCKS == 0) set->supers[b / _BITSET_SUPER_BLOCKS] = total;
+        set->blocks[b] = (uint16_t)(total - set->supers[b / _BITSET_SUPER_BLOCKS]);
+        total += set->kernels->count(set->words + b * _BITSET_BLOCK_WORDS, _BITSET_BLOCK_WORDS);
+    }
+
+    set->total = total;
+    set->dirty = 0;
+}
+
+// Set bits before block `b`
+static inline uint64_t _bitset_block_rank(const Bitset *set, size_t b) {
+    return set->supers[b / _BITSET_SUPER_BLOCKS] + set->blocks[b];
+}
+
+// Position of the set bit of `w` with `rank` set bits below it
+static inline unsigned _bitset_select_word(uint64_t w, unsigned rank) {
+    unsigned shift = 0, count;
+
+    // Skip whole bytes, then clear the lowest set bits of the right one
+    while ((count = (unsigned)__builtin_popcountll(w & 0xff)) <= rank) {
+        rank -= count;
+        w >>= 8;
+        shift += 8;
+    }
+    while (rank--) w &= w - 1;
+
+    return shift + (unsigned)__builtin_ctzll(w);
+}
+
+// =============================== INIT/DESTROY ================================
+
+int bitset_init(Bitset **set, size_t size) {
+    Bitset *s;
+    size_t nblocks;
+
+    if (!set || size > SIZE_MAX - _BITSET_BLOCK_BITS) return 0;
+
+    s = calloc(1, sizeof(Bitset));
+    if (!s) return 0;
+
+    nblocks = size ? (size + _BITSET_BLOCK_BITS - 1) / _BITSET_BLOCK_BITS : 1;
+    s->size = size;
+    s->nwords = nblocks * _BITSET_BLOCK_WORDS;
+    s->words = calloc(s->nwords, sizeof(uint64_t));
+    s->blocks = calloc(nblocks, sizeof(uint16_t));
+    s->supers = calloc((nblocks + _BITSET_SUPER_BLOCKS - 1) / _BITSET_SUPER_BLOCKS, sizeof(uint64_t));
+    if (!s->words || !s->blocks || !s->supers) {
+        bitset_free(&s);
+        return 0;
+    }
+    s->kernels = _bitset_pick_kernels();
+
+    *set = s;
+    return 1;
+}
+
+void bitset_free(Bitset **set) {
+    if (!set || !*set) return;
+
+    free((*set)->words);
+    free((*set)->blocks);
+    free((*set)->supers);
+    free(*set);
+    *set = NULL;
+}
+
+size_t bitset_size(Bitset *set) {
+    return set ? set->size : 0;
+}
+
+// ================================ SINGLE BITS ================================
+
+int bitset_set(Bitset *set, size_t bit) {
+    if (!set || bit >= set->size) return 0;
+
+    set->words[bit / 64] |= (uint64_t)1 << (bit % 64);
+    set->dirty = 1;
+    return 1;
+}
+
+int bitset_clear(Bitset *set, size_t bit) {
+    if (!set || bit >= set->size) return 0;
+
+    set->words[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+    set->dirty = 1;
+    return 1;
+}
+
+int bitset_test(Bitset *set, size_t bit) {
+    if (!set || bit >= set->size) return 0;
+
+    return (int)(set->words[bit / 64] >> (bit % 64)) & 1;
+}
+
+void bitset_clear_all(Bitset *set) {
+    if (!set) return;
+
+    memset(set->words, 0, set->nwords * sizeof(uint64_t));
+    set->dirty = 1;
+}
+
+// ================================= BULK OPS ==================================
+
+size_t bitset_count(Bitset *set) {
+    if (!set) return 0;
+
+    return set->dirty ? set->kernels->count(set->words, set->nwords) : (size_t)set->total;
+}
+
+// Runs a kernel over two sets of the same size
+static int _bitset_combine(Bitset *set, Bitset *other, _bitset_op_fn fn) {
+    fn(set->words, other->words, set->nwords);
+    set->dirty = 1;
+    return 1;
+}
+
+#define _BITSET_SAME_SIZE(set, other) ((set) && (other) && (set)->size == (other)->size)
+
+int bitset_and(Bitset *set, Bitset *other) {
+    return _BITSET_SAME_SIZE(set, other) && _bitset_combine(set, other, set->kernels->and_op);
+}
+
+int bitset_or(Bitset *set, Bitset *other) {
+    return _BITSET_SAME_SIZE(set, other) && _bitset_combine(set, other, set->kernels->or_op);
+}
+
+int bitset_xor(Bitset *set, Bitset *other) {
+    return _BITSET_SAME_SIZE(set, other) && _bitset_combine(set, other, set->kernels->xor_op);
+}
+
+int bitset_andnot(Bitset *set, Bitset *other) {
+    return _BITSET_SAME_SIZE(set, other) && _bitset_combine(set, other, set->kernels->andnot_op);
+}
+
+// ================================ RANK/SELECT ================================
+
+size_t bitset_rank(Bitset *set, size_t bit) {
+    size_t b, w, end;
+    uint64_t rank;
+
+    if (!set) return 0;
+    if (set->dirty) _bitset_index(set);
+    if (bit >= set->size) return (size_t)set->total;
+
+    b = bit / _BITSET_BLOCK_BITS;
+    w = bit / 64;
+    rank = _bitset_block_rank(set, b);
+    for (end = w, w = b * _BITSET_BLOCK_WORDS; w < end; w++) rank += (uint64_t)__builtin_popcountll(set->words[w]);
+    if (bit % 64) rank += (uint64_t)__builtin_popcountll(set->words[w] << (64 - bit % 64));
+
+    return (size_t)rank;
+}
+
+size_t bitset_select(Bitset *set, size_t rank) {
+    size_t nblocks, lo, hi, w;
+    uint64_t left;
+
+    if (!set) return BITSET_NONE;
+    if (set->dirty) _bitset_index(set);
+    if (rank >= set->total) return BITSET_NONE;
+
+    // Find the last block with at most `rank` bits before it, first among
+    // superblocks and then among the blocks of one
+    nblocks = set->nwords / _BITSET_BLOCK_WORDS;
+    lo = 0;
+    hi = (nblocks - 1) / _BITSET_SUPER_BLOCKS;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (set->supers[mid] <= rank)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    hi = lo * _BITSET_SUPER_BLOCKS + _BITSET_SUPER_BLOCKS - 1;
+    if (hi >= nblocks) hi = nblocks - 1;
+    lo *= _BITSET_SUPER_BLOCKS;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (_bitset_block_rank(set, mid) <= rank)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    // Then the word, and the bit within it
+    left = rank - _bitset_block_rank(set, lo);
+    for (w = lo * _BITSET_BLOCK_WORDS;; w++) {
+        uint64_t count = (uint64_t)__builtin_popcountll(set->words[w]);
+        if (left < count) break;
+        left -= count;
+    }
+
+    return w * 64 + _bitset_select_word(set->words[w], (unsigned)left);
+}
+
+// ================================= ITERATION =================================
+
+size_t bitset_next(Bitset *set, size_t from) {
+    size_t w;
+    uint64_t word;
+
+    if (!set || from >= set->size) return BITSET_NONE;
+
+    w = from / 64;
+    word = set->words[w] & (~(uint64_t)0 << (from % 64));
+    while (!word) {
+        if (++w == set->nwords) return BITSET_NONE;
+        word = set->words[w];
+    }
+
+    // Bits past the end are never set, so this is in range
+    return w * 64 + (size_t)__builtin_ctzll(word);
+}
+
+int bitset_for_each(Bitset *set, bitset_visit_fn fn, void *ctx) {
+    if (!set || !fn) return 0;
+
+    for (size_t w = 0; w < set->nwords; w++) {
+        // Clear the lowest set bit until none is left
+        for (uint64_t word = set->words[w]; word; word &= word - 1) {
+            if (fn(w * 64 + (size_t)__builtin_ctzll(word), ctx)) return 0;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file bitset.h
+ * @brief A fixed-size set of bits with rank and select.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup bitset Bitset
+ * A set of integers from 0 to `size - 1`, one bit each.
+ *
+ * Bulk operations between sets and counting run 256 bits at a time with AVX2
+ * on x86-64 processors that support it, which is checked once at run time,
+ * and 64 bits at a time otherwise, or when built with `-DBITSET_NO_AVX2`.
+ *
+ * `bitset_rank()` and `bitset_select()` use a small index of bit counts, 1
+ * count per 512 bits and 1 per 65536, about 3% on top of the bits. The index
+ * is rebuilt by the first query after the set changes, in one pass over the
+ * bits, so queries are cheapest when they come after a batch of updates.
+ */
+#ifndef __BITSET_H__
+#define __BITSET_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Returned by bit searches that find nothing.
+ *
+ * @ingroup bitset
+ */
+#define BITSET_NONE SIZE_MAX
+
+/**
+ * @brief A fixed-size set of bits.
+ *
+ * Bitsets are not thread-safe. Even queries may rebuild the rank index.
+ *
+ * @ingroup bitset
+ */
+typedef struct bitset Bitset;
+
+/**
+ * @brief Called once per set bit by `bitset_for_each()`.
+ *
+ * @ingroup bitset
+ *
+ * @param bit The position of the bit.
+ * @param ctx The context pointer passed to `bitset_for_each()`.
+ *
+ * @return int 0 to continue iterating, or any other value to stop.
+ */
+typedef int (*bitset_visit_fn)(size_t bit, void *ctx);
+
+/**
+ * @brief Constructs a new Bitset with every bit clear.
+ *
+ * @ingroup bitset
+ *
+ * @param set  A pointer to the set to construct.
+ * @param size The number of bits.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bitset_init(Bitset **set, size_t size);
+
+/**
+ * @brief Destroys a Bitset.
+ *
+ * After destruction, the set will be set to `NULL`.
+ *
+ * @ingroup bitset
+ *
+ * @param set A pointer to the set to destroy.
+ */
+void bitset_free(Bitset **set);
+
+/**
+ * @brief Gets the number of bits in a Bitset, set or not.
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ *
+ * @return size_t The size given to `bitset_init()`, or 0 on failure.
+ */
+size_t bitset_size(Bitset *set);
+
+/**
+ * @brief Sets a bit.
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ * @param bit The position of the bit.
+ *
+ * @return int 1 on success, 0 if the bit is out of range.
+ */
+int bitset_set(Bitset *set, size_t bit);
+
+/**
+ * @brief Clears a bit.
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ * @param bit The position of the bit.
+ *
+ * @return int 1 on success, 0 if the bit is out of range.
+ */
+int bitset_clear(Bitset *set, size_t bit);
+
+/**
+ * @brief Checks whether a bit is set.
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ * @param bit The position of the bit.
+ *
+ * @return int 1 if the bit is set, 0 if it is clear or out of range.
+ */
+int bitset_test(Bitset *set, size_t bit);
+
+/**
+ * @brief Clears every bit.
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ */
+void bitset_clear_all(Bitset *set);
+
+/**
+ * @brief Counts the set bits.
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ *
+ * @return size_t The number of set bits, or 0 on failure.
+ */
+size_t bitset_count(Bitset *set);
+
+/**
+ * @brief Intersects a Bitset with another one, in place.
+ *
+ * @ingroup bitset
+ *
+ * @param set   The set to modify.
+ * @param other A set of the same size.
+ *
+ * @return int 1 on success, 0 if the sizes differ.
+ */
+int bitset_and(Bitset *set, Bitset *other);
+
+/**
+ * @brief Adds the bits of another Bitset to one, in place.
+ *
+ * @ingroup bitset
+ *
+ * @param set   The set to modify.
+ * @param other A set of the same size.
+ *
+ * @return int 1 on success, 0 if the sizes differ.
+ */
+int bitset_or(Bitset *set, Bitset *other);
+
+/**
+ * @brief Flips the bits of a Bitset that are set in another one, in place.
+ *
+ * @ingroup bitset
+ *
+ * @param set   The set to modify.
+ * @param other A set of the same size.
+ *
+ * @return int 1 on success, 0 if the sizes differ.
+ */
+int bitset_xor(Bitset *set, Bitset *other);
+
+/**
+ * @brief Clears the bits of a Bitset that are set in another one, in place.
+ *
+ * @ingroup bitset
+ *
+ * @param set   The set to modify.
+ * @param other A set of the same size.
+ *
+ * @return int 1 on success, 0 if the sizes differ.
+ */
+int bitset_andnot(Bitset *set, Bitset *other);
+
+/**
+ * @brief Counts the set bits below a position, in O(1).
+ *
+ * @ingroup bitset
+ *
+ * @param set The target set.
+ * @param bit The position to count up to, excluded. Positions past the end
+ * count every set bit.
+ *
+ * @return size_t The number of set bits in `[0, bit)`, or 0 on failure.
+ */
+size_t bitset_rank(Bitset *set, size_t bit);
+
+/**
+ * @brief Finds the set bit with a given rank, in O(log n).
+ *
+ * This is the inverse of `bitset_rank()`: if bit `b` is set, it is the
+ * `bitset_rank(set, b)`-th set bit.
+ *
+ * @ingroup bitset
+ *
+ * @param set  The target set.
+ * @param rank The number of set bits below the one to find, from 0.
+ *
+ * @return size_t The position of the bit, or `BITSET_NONE` if fewer than
+ * `rank + 1` bits are set.
+ */
+size_t bitset_select(Bitset *set, size_t rank);
+
+/**
+ * @brief Finds the first set bit at or after a position.
+ *
+ * Skips 64 clear bits at a time, so a loop over `bitset_next()` visits a
+ * sparse set quickly:
+ *
+ * ```c
+ * for (size_t b = bitset_next(set, 0); b != BITSET_NONE; b = bitset_next(set, b + 1)) ...
+ * ```
+ *
+ * @ingroup bitset
+ *
+ * @param set  The target set.
+ * @param from The position to start from.
+ *
+ * @return size_t The position of the bit, or `BITSET_NONE` if there is none.
+ */
+size_t bitset_next(Bitset *set, size_t from);
+
+/**
+ * @brief Visits every set bit, in increasing order.
+ *
+ * @ingroup bitset
+ *
+ * @param set The set to iterate over. It must not be modified by `fn`.
+ * @param fn  Called once per set bit. Returning non-zero stops the iteration.
+ * @param ctx Passed to `fn`.
+ *
+ * @return int 1 if every set bit was visited, 0 if `fn` stopped the iteration
+ * or on failure.
+ */
+int bitset_for_each(Bitset *set, bitset_visit_fn fn, void *ctx);
+
+#endif
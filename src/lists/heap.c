@@ -0,0 +1,332 @@
+// SPDX-License-Identifier: MIT
+#include "heap.h"
+
+#include <string.h>
+
+// Capacity the element and handle vectors start with
+#define _HEAP_INITIAL_CAPACITY 16
+
+struct heap {
+    Vector items;      // the elements, in heap order
+    Vector ids;        // the handle of the element at each position
+    Vector positions;  // the position of the element with each handle
+    Vector free_ids;   // handles of removed elements, reused first
+    heap_cmp_fn cmp;
+    size_t arity;
+    void *hole;        // the element being sifted, while its slot is reused
+};
+
+#define _HEAP_AT(heap, i) ((uint8_t *)(heap)->items.data + (size_t)(i) * (heap)->items.data_size)
+#define _HEAP_ID(heap, i) (((HeapHandle *)(heap)->ids.data)[i])
+#define _HEAP_POS(heap, id) (((uint32_t *)(heap)->positions.data)[id])
+
+// ================================== SIFTING ==================================
+
+// Moves the element at `from` into the slot at `to`
+static inline void _heap_move(Heap *heap, size_t from, size_t to) {
+    HeapHandle id = _HEAP_ID(heap, from);
+
+    memcpy(_HEAP_AT(heap, to), _HEAP_AT(heap, from), heap->items.data_size);
+    _HEAP_ID(heap, to) = id;
+    _HEAP_POS(heap, id) = (uint32_t)to;
+}
+
+// Stores the hole's element, with handle `id`, in the slot at `i`
+static inline void _heap_fill(Heap *heap, size_t i, HeapHandle id) {
+    memcpy(_HEAP_AT(heap, i), heap->hole, heap->items.data_size);
+    _HEAP_ID(heap, i) = id;
+    _HEAP_POS(heap, id) = (uint32_t)i;
+}
+
+/*
+ * Moves the element at `i` up past the parents it comes out before. Parents
+ * move down into its slot one by one, and it is only written once, at the end.
+ */
+static void _heap_sift_up(Heap *heap, size_t i) {
+    HeapHandle id = _HEAP_ID(heap, i);
+    size_t parent;
+
+    if (!i || heap->cmp(_HEAP_AT(heap, i), _HEAP_AT(heap, (i - 1) / heap->arity)) >= 0) return;
+
+    memcpy(heap->hole, _HEAP_AT(heap, i), heap->items.data_size);
+    do {
+        parent = (i - 1) / heap->arity;
+        _heap_move(heap, parent, i);
+        i = parent;
+    } while (i && heap->cmp(heap->hole, _HEAP_AT(heap, (i - 1) / heap->arity)) < 0);
+    _heap_fill(heap, i, id);
+}
+
+// Moves the element at `i` down past the children that come out before it
+static void _heap_sift_down(Heap *heap, size_t i) {
+    size_t n = heap->items.size, d = heap->arity;
+    HeapHandle id = _HEAP_ID(heap, i);
+    int moved = 0;
+
+    for (;;) {
+        size_t first = i * d + 1, last, best;
+
+        if (first >= n) break;
+        last = n - first > d ? first + d : n;
+
+        // The siblings are contiguous, so this scan reads one or two lines
+        best = first;
+        for (size_t c = first + 1; c < last; c++) {
+            if (heap->cmp(_HEAP_AT(heap, c), _HEAP_AT(heap, best)) < 0) best = c;
+        }
+
+        if (heap->cmp(_HEAP_AT(heap, best), moved ? heap->hole : _HEAP_AT(heap, i)) >= 0) break;
+        if (!moved) memcpy(heap->hole, _HEAP_AT(heap, i), heap->items.data_size);
+        moved = 1;
+        _heap_move(heap, best, i);
+        i = best;
+    }
+
+    if (moved) _heap_fill(heap, i, id);
+}
+
+/*
+ * Moves the empty slot at `i` down to a leaf of the first `n` positions,
+ * pulling up the child that comes out first at each level, and returns the
+ * leaf. This takes one comparison less per level than sifting an element down,
+ * and the element that fills the slot, taken from the bottom, rarely has far to
+ * go back up.
+ */
+static size_t _heap_descend(Heap *heap, size_t i, size_t n) {
+    size_t d = heap->arity;
+
+    for (;;) {
+        size_t first = i * d + 1, last, best;
+
+        if (first >= n) return i;
+        last = n - first > d ? first + d : n;
+
+        best = first;
+        for (size_t c = first + 1; c < last; c++) {
+            if (heap->cmp(_HEAP_AT(heap, c), _HEAP_AT(heap, best)) < 0) best = c;
+        }
+        _heap_move(heap, best, i);
+        i = best;
+    }
+}
+
+// Restores the order around an element that changed
+static void _heap_fix(Heap *heap, size_t i) {
+    if (i && heap->cmp(_HEAP_AT(heap, i), _HEAP_AT(heap, (i - 1) / heap->arity)) < 0)
+        _heap_sift_up(heap, i);
+    else
+        _heap_sift_down(heap, i);
+}
+
+// ================================== HANDLES ==================================
+
+static HeapHandle _heap_new_id(Heap *heap) {
+    uint32_t none = HEAP_NO_HANDLE;
+    HeapHandle id;
+
+    if (heap->free_ids.size) {
+        id = ((HeapHandle *)heap->free_ids.data)[heap->free_ids.size - 1];
+        vector_popback(&heap->free_ids);
+        return id;
+    }
+
+    id = heap->positions.size;
+    vector_pushback(&heap->positions, &none);
+    return id;
+}
+
+static void _heap_release_id(Heap *heap, HeapHandle id) {
+    _HEAP_POS(heap, id) = HEAP_NO_HANDLE;
+    vector_pushback(&heap->free_ids, &id);
+}
+
+// Gets the position of the element with handle `id`, or HEAP_NO_HANDLE
+static inline uint32_t _heap_position(Heap *heap, HeapHandle id) {
+    return id < heap->positions.size ? _HEAP_POS(heap, id) : HEAP_NO_HANDLE;
+}
+
+// Takes the element at `i` out of the heap, filling its slot with the last one
+static void _heap_take(Heap *heap, size_t i, void *out) {
+    size_t last = heap->items.size - 1, leaf;
+
+    if (out) {
+        memcpy(out, _HEAP_AT(heap, i), heap->items.data_size);
+    } else if (heap->items.free_element) {
+        heap->items.free_element(_HEAP_AT(heap, i));
+    }
+    _heap_release_id(heap, _HEAP_ID(heap, i));
+
+    if (i != last) {
+        leaf = _heap_descend(heap, i, last);
+        if (leaf != last) {
+            _heap_move(heap, last, leaf);
+            _heap_sift_up(heap, leaf);
+        }
+    }
+
+    // vector_free() frees every slot, so the one left behind must not alias
+    // an element that still exists
+    if (heap->items.free_element) memset(_HEAP_AT(heap, last), 0, heap->items.data_size);
+    vector_popback(&heap->items);
+    vector_popback(&heap->ids);
+}
+
+// =============================== INIT/DESTROY ================================
+
+// Sets up everything but the elements, for `n` of them with handles 0 to n - 1
+static int _heap_init(Heap **heap, size_t data_size, heap_cmp_fn cmp, unsigned arity, uint32_t n) {
+    Heap *h;
+
+    if (!heap || !cmp || !data_size || arity < 2) return 0;
+
+    h = calloc(1, sizeof(Heap));
+    if (!h) return 0;
+    h->hole = malloc(data_size);
+    if (!h->hole) {
+        free(h);
+        return 0;
+    }
+
+    h->cmp = cmp;
+    h->arity = arity;
+    vector_init(&h->ids, n + _HEAP_INITIAL_CAPACITY, sizeof(HeapHandle), NULL);
+    vector_init(&h->positions, n + _HEAP_INITIAL_CAPACITY, sizeof(uint32_t), NULL);
+    vector_init(&h->free_ids, _HEAP_INITIAL_CAPACITY, sizeof(HeapHandle), NULL);
+    for (uint32_t i = 0; i < n; i++) {
+        _HEAP_ID(h, i) = i;
+        _HEAP_POS(h, i) = i;
+    }
+    h->ids.size = h->positions.size = n;
+
+    *heap = h;
+    return 1;
+}
+
+int heap_init(Heap **heap, size_t data_size, heap_cmp_fn cmp) {
+    return heap_init_with_arity(heap, data_size, cmp, HEAP_DEFAULT_ARITY);
+}
+
+int heap_init_with_arity(Heap **heap, size_t data_size, heap_cmp_fn cmp, unsigned arity) {
+    if (!_heap_init(heap, data_size, cmp, arity, 0)) return 0;
+    vector_init(&(*heap)->items, _HEAP_INITIAL_CAPACITY, data_size, NULL);
+    return 1;
+}
+
+int heap_init_from_vector(Heap **heap, Vector *v, heap_cmp_fn cmp, unsigned arity) {
+    Heap *h;
+
+    if (!v || !_heap_init(heap, v->data_size, cmp, arity, v->size)) return 0;
+    h = *heap;
+
+    // vector_pushback() only grows an array with 2 free slots left
+    if (v->capacity < v->size + 2 || v->capacity < 4) {
+        uint32_t capacity = 2 * (v->size + 2);
+        size_t old_bytes = v->capacity * v->data_size, new_bytes = capacity * v->data_size;
+        void *data = mem_realloc(v->allocator, v->data, old_bytes, new_bytes);
+
+        if (!data) {
+            *heap = NULL;
+            heap_free(&h);
+            return 0;
+        }
+        memset((uint8_t *)data + old_bytes, 0, new_bytes - old_bytes);
+        v->data = data;
+        v->capacity = capacity;
+    }
+
+    h->items = *v;
+    v->data = NULL;
+    v->size = v->capacity = 0;
+    v->free_element = NULL;
+
+    // Sift down every node with children, from the last one up. Most nodes
+    // sit near the bottom and move at most a level or two, so this is O(n).
+    if (h->items.size > 1) {
+        for (size_t i = (h->items.size - 2) / h->arity + 1; i-- > 0;) _heap_sift_down(h, i);
+    }
+
+    return 1;
+}
+
+void heap_free(Heap **heap) {
+    Heap *h;
+
+    if (!heap || !*heap) return;
+    h = *heap;
+
+    if (h->items.data) vector_free(&h->items);
+    vector_free(&h->ids);
+    vector_free(&h->positions);
+    vector_free(&h->free_ids);
+    free(h->hole);
+    free(h);
+    *heap = NULL;
+}
+
+// ================================ OPERATIONS =================================
+
+size_t heap_size(Heap *heap) {
+    return heap ? heap->items.size : 0;
+}
+
+int heap_push(Heap *heap, const void *element, HeapHandle *handle) {
+    HeapHandle id;
+    size_t i;
+
+    if (!heap || !element) return 0;
+    if (heap->positions.size == HEAP_NO_HANDLE && !heap->free_ids.size) return 0;
+
+    id = _heap_new_id(heap);
+    i = heap->items.size;
+    vector_pushback(&heap->items, (void *)element);
+    vector_pushback(&heap->ids, &id);
+    _HEAP_POS(heap, id) = (uint32_t)i;
+    _heap_sift_up(heap, i);
+
+    if (handle) *handle = id;
+    return 1;
+}
+
+void *heap_peek(Heap *heap) {
+    return heap && heap->items.size ? heap->items.data : NULL;
+}
+
+int heap_pop(Heap *heap, void *out) {
+    if (!heap || !heap->items.size) return 0;
+
+    _heap_take(heap, 0, out);
+    return 1;
+}
+
+void *heap_get(Heap *heap, HeapHandle handle) {
+    uint32_t i;
+
+    if (!heap) return NULL;
+
+    i = _heap_position(heap, handle);
+    return i == HEAP_NO_HANDLE ? NULL : _HEAP_AT(heap, i);
+}
+
+int heap_update(Heap *heap, HeapHandle handle) {
+    uint32_t i;
+
+    if (!heap) return 0;
+
+    i = _heap_position(heap, handle);
+    if (i == HEAP_NO_HANDLE) return 0;
+
+    _heap_fix(heap, i);
+    return 1;
+}
+
+int heap_remove(Heap *heap, HeapHandle handle, void *out) {
+    uint32_t i;
+
+    if (!heap) return 0;
+
+    i = _heap_position(heap, handle);
+    if (i == HEAP_NO_HANDLE) return 0;
+
+    _heap_take(heap, i, out);
+    return 1;
+}
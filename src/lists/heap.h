@@ -0,0 +1,228 @@
+/**
+ * @file heap.h
+ * @brief A d-ary heap priority queue.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup heap Heap
+ * A priority queue of fixed-size elements, stored by value in a Vector.
+ *
+ * Each node has `arity` children. Wider nodes make the heap shallower, so
+ * sifting down reads fewer levels, and the children it compares sit next to
+ * each other in memory: with 4 children of up to 16 bytes, they share one
+ * cache line. Pushing and popping are O(log n).
+ *
+ * Every element gets a handle when it is pushed, which stays valid while the
+ * element moves around the heap, so an element's priority can be changed or
+ * the element removed without searching for it first.
+ */
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "vector.h"
+
+/**
+ * @brief Children per node used by `heap_init()`.
+ *
+ * @ingroup heap
+ */
+#define HEAP_DEFAULT_ARITY 4
+
+/**
+ * @brief A handle that refers to no element.
+ *
+ * @ingroup heap
+ */
+#define HEAP_NO_HANDLE UINT32_MAX
+
+/**
+ * @brief A priority queue of fixed-size elements.
+ *
+ * Heaps are not thread-safe.
+ *
+ * @ingroup heap
+ */
+typedef struct heap Heap;
+
+/**
+ * @brief Refers to an element of a Heap, from its push to its removal.
+ *
+ * Handles of removed elements are reused by later pushes.
+ *
+ * @ingroup heap
+ */
+typedef uint32_t HeapHandle;
+
+/**
+ * @brief Orders the elements of a Heap.
+ *
+ * @ingroup heap
+ *
+ * @return int Less than, equal to, or greater than 0 if `a` should come out
+ * before, at the same time as, or after `b`. Comparing deadlines with `<`
+ * makes a min-heap.
+ */
+typedef int (*heap_cmp_fn)(const void *a, const void *b);
+
+/**
+ * @brief Constructs a new, empty Heap with `HEAP_DEFAULT_ARITY` children per
+ * node.
+ *
+ * @ingroup heap
+ *
+ * @param heap      A pointer to the heap to construct.
+ * @param data_size The size of every element.
+ * @param cmp       Orders the elements.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int heap_init(Heap **heap, size_t data_size, heap_cmp_fn cmp);
+
+/**
+ * @brief Constructs a new, empty Heap with a custom number of children per
+ * node.
+ *
+ * @ingroup heap
+ *
+ * @param heap      A pointer to the heap to construct.
+ * @param data_size The size of every element.
+ * @param cmp       Orders the elements.
+ * @param arity     Children per node, at least 2. A binary heap does the
+ * fewest comparisons, wider ones touch fewer cache lines.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int heap_init_with_arity(Heap **heap, size_t data_size, heap_cmp_fn cmp, unsigned arity);
+
+/**
+ * @brief Constructs a new Heap out of the elements of a Vector, in O(n).
+ *
+ * The heap takes over the vector's array, with its allocator and
+ * `free_element` function, and reorders it in place. `v` is left empty, and
+ * must be initialized again before it is used.
+ *
+ * The element at index `i` of the vector gets handle `i`.
+ *
+ * @ingroup heap
+ *
+ * @param heap  A pointer to the heap to construct.
+ * @param v     The vector to heapify.
+ * @param cmp   Orders the elements.
+ * @param arity Children per node, at least 2.
+ *
+ * @return int 1 on success, 0 on failure, in which case `v` is untouched.
+ */
+int heap_init_from_vector(Heap **heap, Vector *v, heap_cmp_fn cmp, unsigned arity);
+
+/**
+ * @brief Destroys a Heap and frees its elements as `vector_free()` does.
+ *
+ * After destruction, the heap will be set to `NULL`.
+ *
+ * @ingroup heap
+ *
+ * @param heap A pointer to the heap to destroy.
+ */
+void heap_free(Heap **heap);
+
+/**
+ * @brief Gets the number of elements in a Heap.
+ *
+ * @ingroup heap
+ *
+ * @param heap The target heap.
+ *
+ * @return size_t The number of elements, or 0 on failure.
+ */
+size_t heap_size(Heap *heap);
+
+/**
+ * @brief Adds an element to a Heap.
+ *
+ * @ingroup heap
+ *
+ * @param heap    The target heap.
+ * @param element The element to add. It is copied.
+ * @param handle  Where to store the element's handle, or `NULL`.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int heap_push(Heap *heap, const void *element, HeapHandle *handle);
+
+/**
+ * @brief Gets the element that comes out first, without removing it.
+ *
+ * @ingroup heap
+ *
+ * @param heap The target heap.
+ *
+ * @return void* The element, valid until the heap is next modified, or
+ * `NULL` if the heap is empty.
+ */
+void *heap_peek(Heap *heap);
+
+/**
+ * @brief Removes the element that comes out first.
+ *
+ * @ingroup heap
+ *
+ * @param heap The target heap.
+ * @param out  Where to copy the element, or `NULL` to pass it to the
+ * `free_element` function of the vector it was heapified from, if any.
+ *
+ * @return int 1 on success, 0 if the heap is empty.
+ */
+int heap_pop(Heap *heap, void *out);
+
+/**
+ * @brief Gets an element by handle.
+ *
+ * The element may be modified in place, as long as `heap_update()` is
+ * called before the heap is used again if its order changed.
+ *
+ * @ingroup heap
+ *
+ * @param heap   The target heap.
+ * @param handle The element's handle.
+ *
+ * @return void* The element, valid until the heap is next modified, or
+ * `NULL` if the handle refers to no element.
+ */
+void *heap_get(Heap *heap, HeapHandle handle);
+
+/**
+ * @brief Moves an element whose order changed to its new place, in
+ * O(log n).
+ *
+ * This covers both decreasing a key, which moves the element towards the
+ * top, and increasing it, which moves it down.
+ *
+ * @ingroup heap
+ *
+ * @param heap   The target heap.
+ * @param handle The handle of the element, changed through `heap_get()`.
+ *
+ * @return int 1 on success, 0 if the handle refers to no element.
+ */
+int heap_update(Heap *heap, HeapHandle handle);
+
+/**
+ * @brief Removes an element by handle, in O(log n).
+ *
+ * @ingroup heap
+ *
+ * @param heap   The target heap.
+ * @param handle The handle of the element to remove.
+ * @param out    Where to copy the element, or `NULL` to free it as
+ * `heap_pop()` does.
+ *
+ * @return int 1 on success, 0 if the handle refers to no element.
+ */
+int heap_remove(Heap *heap, HeapHandle handle, void *out);
+
+#endif
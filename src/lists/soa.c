@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+#include "soa.h"
+
+#include <string.h>
+
+// Capacity the columns start with
+#define _SOA_INITIAL_CAPACITY 16
+
+struct soa_vector {
+    SoaField *fields;
+    Vector *columns;  // one per field, all of the same size
+    size_t nfields;
+};
+
+// =============================== INIT/DESTROY ================================
+
+int soa_init(SoaVector **soa, const SoaField *fields, size_t nfields) {
+    SoaVector *s;
+
+    if (!soa || !fields || !nfields) return 0;
+    for (size_t f = 0; f < nfields; f++) {
+        if (!fields[f].size) return 0;
+    }
+
+    s = calloc(1, sizeof(SoaVector));
+    if (!s) return 0;
+    s->fields = malloc(nfields * sizeof(SoaField));
+    s->columns = malloc(nfields * sizeof(Vector));
+    if (!s->fields || !s->columns) {
+        free(s->fields);
+        free(s->columns);
+        free(s);
+        return 0;
+    }
+
+    memcpy(s->fields, fields, nfields * sizeof(SoaField));
+    s->nfields = nfields;
+    for (size_t f = 0; f < nfields; f++) vector_init(&s->columns[f], _SOA_INITIAL_CAPACITY, fields[f].size, NULL);
+
+    *soa = s;
+    return 1;
+}
+
+void soa_free(SoaVector **soa) {
+    SoaVector *s;
+
+    if (!soa || !*soa) return;
+    s = *soa;
+
+    for (size_t f = 0; f < s->nfields; f++) vector_free(&s->columns[f]);
+    free(s->columns);
+    free(s->fields);
+    free(s);
+    *soa = NULL;
+}
+
+// ================================ OPERATIONS =================================
+
+size_t soa_size(SoaVector *soa) {
+    return soa ? soa->columns[0].size : 0;
+}
+
+int soa_push(SoaVector *soa, const void *record) {
+    if (!soa || !record || soa->columns[0].size == UINT32_MAX - 2) return 0;
+
+    for (size_t f = 0; f < soa->nfields; f++) {
+        vector_pushback(&soa->columns[f], (uint8_t *)record + soa->fields[f].offset);
+    }
+    return 1;
+}
+
+int soa_pop(SoaVector *soa, void *record) {
+    if (!soa || !soa->columns[0].size) return 0;
+
+    if (record) soa_get(soa, soa->columns[0].size - 1, record);
+    for (size_t f = 0; f < soa->nfields; f++) vector_popback(&soa->columns[f]);
+    return 1;
+}
+
+int soa_get(SoaVector *soa, size_t index, void *record) {
+    if (!soa || !record || index >= soa->columns[0].size) return 0;
+
+    for (size_t f = 0; f < soa->nfields; f++) {
+        memcpy((uint8_t *)record + soa->fields[f].offset, vector_get(&soa->columns[f], index), soa->fields[f].size);
+    }
+    return 1;
+}
+
+int soa_set(SoaVector *soa, size_t index, const void *record) {
+    if (!soa || !record || index >= soa->columns[0].size) return 0;
+
+    for (size_t f = 0; f < soa->nfields; f++) {
+        vector_set(&soa->columns[f], (uint8_t *)record + soa->fields[f].offset, index);
+    }
+    return 1;
+}
+
+void *soa_column(SoaVector *soa, size_t field) {
+    return soa && field < soa->nfields ? soa->columns[field].data : NULL;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file soa.h
+ * @brief A resizeable list of records stored one column per field.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup soa SoaVector
+ * A struct-of-arrays list: each field of a record lives in its own Vector.
+ *
+ * A Vector of structs brings every field of a record into the cache when a
+ * loop reads only one of them. A SoaVector stores field `f` of every record
+ * contiguously, so a loop over `soa_column(soa, f)` reads only that field, and
+ * the compiler can vectorize it as it would a plain array.
+ *
+ * Fields are described by their offset and size in a record struct, usually
+ * with `SOA_FIELD()`:
+ *
+ * ```c
+ * typedef struct { uint64_t id; double price; uint32_t qty; } order;
+ * const SoaField fields[] = {SOA_FIELD(order, id), SOA_FIELD(order, price), SOA_FIELD(order, qty)};
+ *
+ * soa_init(&orders, fields, 3);
+ * soa_push(orders, &(order){1, 9.5, 3});
+ *
+ * const double *price = soa_column(orders, 1);
+ * for (size_t i = 0; i < soa_size(orders); i++) total += price[i];
+ * ```
+ */
+#ifndef __SOA_H__
+#define __SOA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vector.h"
+
+/**
+ * @brief Where a field sits in a record struct.
+ *
+ * @ingroup soa
+ */
+typedef struct soa_field {
+    /** @brief Offset of the field in the record, in bytes. */
+    size_t offset;
+    /** @brief Size of the field, in bytes. */
+    size_t size;
+} SoaField;
+
+/**
+ * @brief Describes field `member` of the struct `type`.
+ *
+ * @ingroup soa
+ */
+#define SOA_FIELD(type, member) {offsetof(type, member), sizeof(((type *)0)->member)}
+
+/**
+ * @brief A list of records stored one column per field.
+ *
+ * @ingroup soa
+ */
+typedef struct soa_vector SoaVector;
+
+/**
+ * @brief Constructs a new, empty SoaVector.
+ *
+ * @ingroup soa
+ *
+ * @param soa     A pointer to the SoaVector to construct.
+ * @param fields  The fields of a record, in column order. Copied, so it does
+ * not have to outlive the SoaVector.
+ * @param nfields The number of fields, at least 1.
+ *
+ * @return int 1 on success, 0 on failure or if a field has size 0.
+ */
+int soa_init(SoaVector **soa, const SoaField *fields, size_t nfields);
+
+/**
+ * @brief Destroys a SoaVector.
+ *
+ * After destruction, the SoaVector will be set to `NULL`.
+ *
+ * @ingroup soa
+ *
+ * @param soa A pointer to the SoaVector to destroy.
+ */
+void soa_free(SoaVector **soa);
+
+/**
+ * @brief Gets the number of records in a SoaVector.
+ *
+ * @ingroup soa
+ *
+ * @param soa The target SoaVector.
+ *
+ * @return size_t The number of records, or 0 on failure.
+ */
+size_t soa_size(SoaVector *soa);
+
+/**
+ * @brief Appends a record, scattering its fields into the columns.
+ *
+ * Columns may move when they grow, so pointers from `soa_column()` must be
+ * fetched again after a push.
+ *
+ * @ingroup soa
+ *
+ * @param soa    The target SoaVector.
+ * @param record The record to copy the fields from.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int soa_push(SoaVector *soa, const void *record);
+
+/**
+ * @brief Removes the last record.
+ *
+ * @ingroup soa
+ *
+ * @param soa    The target SoaVector.
+ * @param record Where to gather the removed record's fields, or `NULL`.
+ *
+ * @return int 1 on success, 0 if the SoaVector is empty.
+ */
+int soa_pop(SoaVector *soa, void *record);
+
+/**
+ * @brief Gathers the fields of a record.
+ *
+ * Bytes of `record` that are not part of a field, such as padding, are left
+ * as they were.
+ *
+ * @ingroup soa
+ *
+ * @param soa    The target SoaVector.
+ * @param index  The position of the record.
+ * @param record Where to copy the fields to.
+ *
+ * @return int 1 on success, 0 if the index is out of range.
+ */
+int soa_get(SoaVector *soa, size_t index, void *record);
+
+/**
+ * @brief Overwrites the fields of a record.
+ *
+ * @ingroup soa
+ *
+ * @param soa    The target SoaVector.
+ * @param index  The position of the record.
+ * @param record The record to copy the fields from.
+ *
+ * @return int 1 on success, 0 if the index is out of range.
+ */
+int soa_set(SoaVector *soa, size_t index, const void *record);
+
+/**
+ * @brief Gets the contiguous array of one field of every record.
+ *
+ * Element `i` of the column is field `field` of record `i`, for `i` up to
+ * `soa_size()`. The pointer stays valid until the next `soa_push()`.
+ *
+ * @ingroup soa
+ *
+ * @param soa   The target SoaVector.
+ * @param field The position of the field in the list given to `soa_init()`.
+ *
+ * @return void* The column, or `NULL` if the field is out of range.
+ */
+void *soa_column(SoaVector *soa, size_t field);
+
+#endif
@@ -7,24 +7,43 @@
 
 #include "vector.h"
 
-void vector_init(Vector *v, uint32_t capacity, 
+void vector_init_with_allocator(Vector *v, uint32_t capacity, 
 	size_t data_size, 
-	void (*free_element)(void *)) {
+	void (*free_element)(void *),
+	const Allocator *allocator) {
 
 	v->capacity = capacity;  
 	v->size = 0; 
 	v->data_size = data_size; 
-	v->data = calloc(v->capacity, v->data_size); 
+	v->allocator = allocator;
+	v->data = mem_alloc(allocator, v->capacity * v->data_size); 
+	if (!v->data && v->capacity * v->data_size > 0) {
+		fprintf(stderr, "Error: vector init() out of memory\n");
+		exit(1);
+	}
+	// Unused slots read as zero
+	if (v->data) memset(v->data, 0, v->capacity * v->data_size);
 	v->free_element = free_element;
 
 }
 
+void vector_init(Vector *v, uint32_t capacity, 
+	size_t data_size, 
+	void (*free_element)(void *)) {
+
+	vector_init_with_allocator(v, capacity, data_size, free_element, NULL);
+}
+
 void vector_pushback(Vector *v, void *datum) {  
 	if (v->size == v->capacity -2) { 
+		size_t old_bytes = v->capacity * v->data_size;
+		void *new_arr = mem_realloc(v->allocator, v->data, old_bytes, 2 * old_bytes);   
+		if (!new_arr) {
+			fprintf(stderr, "Error: vector pushback() out of memory\n");
+			exit(1);
+		}
+		memset((uint8_t *)new_arr + old_bytes, 0, old_bytes);
 		v->capacity *= 2;  
-		void *new_arr = calloc(v->capacity, v->data_size);   
-		memcpy(new_arr, v->data, v->size * v->data_size);  
-		free(v->data);  
 		v->data = new_arr; 
 	}  
 	void * data_start = (uint8_t * )v->data + v->size * v->data_size;
@@ -68,6 +87,94 @@ void vector_free(Vector *v) {
 		}
 	} 
 	
-	free(v->data);
+	mem_free(v->allocator, v->data);
+}
+
+
+// Elements a thread handles between checks for idle threads
+#define _VECTOR_PARALLEL_GRAIN 1024
+
+// A vector_parallel_for() or vector_parallel_reduce() in progress
+typedef struct _vector_parallel {
+	Vector *v;
+	void (*visit)(void *element, size_t index, void *ctx);
+	void (*reduce)(void *acc, void *element, size_t index, void *ctx);
+	void *ctx;
+	uint8_t *parts;   // one partial result per thread, for reductions
+	size_t stride;    // distance between partial results, a cache line multiple
+} _vector_parallel;
+
+static void _vector_parallel_task(PoolWorker *worker, PoolTask *task) {
+	_vector_parallel *p = task->ctx;
+	size_t lo = task->lo, hi = task->hi;
+	void *part = p->parts ? p->parts + pool_worker_index(worker) * p->stride : NULL;
+
+	while (lo < hi) {
+		size_t end = hi - lo < _VECTOR_PARALLEL_GRAIN ? hi : lo + _VECTOR_PARALLEL_GRAIN;
+
+		// Hand half of what is left to an idle thread
+		if (hi - lo >= 2 * _VECTOR_PARALLEL_GRAIN && pool_hungry(worker)) {
+			PoolTask rest = *task;
+			rest.lo = lo + (hi - lo) / 2;
+			rest.hi = hi;
+			pool_spawn(worker, &rest);
+			hi = rest.lo;
+			continue;
+		}
+
+		for (; lo < end; lo++) {
+			void *element = (uint8_t *)p->v->data + lo * p->v->data_size;
+			if (p->reduce)
+				p->reduce(part, element, lo, p->ctx);
+			else
+				p->visit(element, lo, p->ctx);
+		}
+	}
+}
+
+static void _vector_parallel_run(_vector_parallel *p, unsigned threads) {
+	PoolTask task = {_vector_parallel_task, p, NULL, 0, 0};
+	WorkPool *pool = NULL;
+
+	task.hi = p->v->size;
+	if (!pool_init(&pool, threads ? threads : 1)) {
+		fprintf(stderr, "Error: vector parallel() could not start threads\n");
+		exit(1);
+	}
+	pool_run(pool, &task);
+	pool_free(&pool);
 }
 
+void vector_parallel_for(Vector *v,
+	void (*fn)(void *element, size_t index, void *ctx),
+	void *ctx,
+	unsigned threads) {
+
+	_vector_parallel p = {v, fn, NULL, ctx, NULL, 0};
+	_vector_parallel_run(&p, threads);
+}
+
+void vector_parallel_reduce(Vector *v,
+	void (*fn)(void *acc, void *element, size_t index, void *ctx),
+	pool_combine_fn combine,
+	void *acc,
+	size_t acc_size,
+	void *ctx,
+	unsigned threads) {
+
+	_vector_parallel p = {v, NULL, fn, ctx, NULL, 0};
+	if (!threads) threads = 1;
+
+	// Each thread starts from the identity in acc, on its own cache lines
+	p.stride = (acc_size + 63) & ~(size_t)63;
+	p.parts = malloc(threads * p.stride);
+	if (!p.parts) {
+		fprintf(stderr, "Error: vector parallel_reduce() out of memory\n");
+		exit(1);
+	}
+	for (unsigned i = 0; i < threads; i++) memcpy(p.parts + i * p.stride, acc, acc_size);
+
+	_vector_parallel_run(&p, threads);
+	for (unsigned i = 0; i < threads; i++) combine(acc, p.parts + i * p.stride, ctx);
+	free(p.parts);
+}
@@ -18,6 +18,9 @@
 #include <stdlib.h>
 #include <stddef.h>
 
+#include "allocator.h"
+#include "../util/pool.h"
+
 /**
  * @brief A Vector list
  *
@@ -44,6 +47,9 @@ typedef struct _vector {
 	 */
 	void (*free_element)(void *);
 
+	/** @brief Where the data array is allocated from, `NULL` for the C heap. */
+	const Allocator *allocator;
+
 } Vector; 
 
 /**
@@ -61,6 +67,27 @@ void vector_init(Vector *v, uint32_t capacity,
 	size_t data_size, 
 	void (*free_element)(void *));
 
+/**
+ * @brief Initializes a Vector whose data array is allocated through
+ * `allocator`.
+ *
+ * With a region allocator such as `arena_allocator()`, growing the vector
+ * leaves the old array behind until the region is released.
+ *
+ * @ingroup vector
+ *
+ * @param v
+ * @param capacity
+ * @param data_size
+ * @param free_element
+ * @param allocator The allocator to use, or `NULL` for the C heap. Must
+ * outlive the vector.
+ */
+void vector_init_with_allocator(Vector *v, uint32_t capacity, 
+	size_t data_size, 
+	void (*free_element)(void *),
+	const Allocator *allocator);
+
 /**
  * @brief 
  *
@@ -136,6 +163,53 @@ void vector_pushback(Vector *v, void *datum);
  */
 void vector_free(Vector *v);
 
+/**
+ * @brief Visits every element of a Vector on several threads.
+ *
+ * The elements are split into ranges that run on a WorkPool (see `pool.h`)
+ * started for the call. A thread works through its range in chunks, handing
+ * half of what is left to another thread whenever one is idle. `fn` runs on
+ * several threads at once, in no particular order.
+ *
+ * @ingroup vector
+ *
+ * @param v
+ * @param fn Called with each element, its index and `ctx`.
+ * @param ctx
+ * @param threads Number of threads to use, including the calling one.
+ */
+void vector_parallel_for(Vector *v,
+	void (*fn)(void *element, size_t index, void *ctx),
+	void *ctx,
+	unsigned threads);
+
+/**
+ * @brief Folds every element of a Vector into one result, on several threads.
+ *
+ * Splits the work as `vector_parallel_for()` does. Each thread folds its
+ * elements into its own copy of `acc`, and the copies are merged into `acc`
+ * with `combine` at the end.
+ *
+ * @ingroup vector
+ *
+ * @param v
+ * @param fn Folds an element, given with its index, into a partial result.
+ * @param combine Merges one partial result into another. It must be
+ * associative and commutative.
+ * @param acc Holds the identity of `combine` on entry, such as 0 for a sum,
+ * and the result on return.
+ * @param acc_size The size of the result.
+ * @param ctx Passed to `fn` and `combine`.
+ * @param threads Number of threads to use, including the calling one.
+ */
+void vector_parallel_reduce(Vector *v,
+	void (*fn)(void *acc, void *element, size_t index, void *ctx),
+	pool_combine_fn combine,
+	void *acc,
+	size_t acc_size,
+	void *ctx,
+	unsigned threads);
+
 
 
 
@@ -0,0 +1,882 @@
+// SPDX-License-Identifier: MIT
+#include "art.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Inner node layouts
+#define _ART_NODE4 1
+#define _ART_NODE16 2
+#define _ART_NODE48 3
+#define _ART_NODE256 4
+
+/*
+ * Number of compressed prefix bytes stored in each inner node. Longer prefixes
+ * are only partially stored; the remaining bytes are checked against a leaf.
+ */
+#define _ART_MAX_PREFIX 10
+
+// Entry data is stored after the key, aligned to this boundary
+#define _ART_ALIGN (2 * sizeof(void *))
+
+// Child pointers to leaves are tagged with their lowest bit
+#define _ART_IS_LEAF(x) (((uintptr_t)(x)) & 1)
+#define _ART_SET_LEAF(x) ((art_node *)((uintptr_t)(x) | 1))
+#define _ART_LEAF_RAW(x) ((art_leaf *)((uintptr_t)(x) & ~(uintptr_t)1))
+
+#define _ART_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Header shared by every inner node layout
+typedef struct art_node {
+    uint8_t type;                            // one of _ART_NODE*
+    uint16_t num_children;                   // number of non-null children
+    uint32_t prefix_len;                     // length of the compressed path
+    unsigned char prefix[_ART_MAX_PREFIX];   // first bytes of the compressed path
+} art_node;
+
+// Up to 4 children, keys kept sorted
+typedef struct art_node4 {
+    art_node n;
+    unsigned char keys[4];
+    art_node *children[4];
+} art_node4;
+
+// Up to 16 children, keys kept sorted and searched with SIMD
+typedef struct art_node16 {
+    art_node n;
+    unsigned char keys[16];
+    art_node *children[16];
+} art_node16;
+
+// Up to 48 children, indexed by key byte through a 256-entry table
+typedef struct art_node48 {
+    art_node n;
+    unsigned char index[256];  // child slot + 1, 0 if no child
+    art_node *children[48];
+} art_node48;
+
+// One slot per possible key byte
+typedef struct art_node256 {
+    art_node n;
+    art_node *children[256];
+} art_node256;
+
+/*
+ * An entry. Keys include their null terminator, so no key is a prefix of
+ * another and every key ends in its own leaf.
+ */
+typedef struct art_leaf {
+    size_t size;            // size of data
+    void *data;             // entry value, points into key
+    size_t keylen;          // length of key, including null terminator
+    unsigned char key[];    // key bytes, followed by data
+} art_leaf;
+
+struct art_tree {
+    art_node *root;
+    size_t count;
+};
+
+// ================================== LEAVES ===================================
+
+art_leaf *_art_leaf_init(const unsigned char *key, size_t keylen, void *data, size_t size) {
+    size_t offset = offsetof(art_leaf, key) + keylen;
+    art_leaf *l;
+
+    // Round up so data is suitably aligned for any type
+    offset = (offset + _ART_ALIGN - 1) / _ART_ALIGN * _ART_ALIGN;
+
+    l = malloc(offset + size);
+    if (!l) return NULL;
+
+    l->size = size;
+    l->keylen = keylen;
+    l->data = (char *)l + offset;
+    memcpy(l->key, key, keylen);
+    memcpy(l->data, data, size);
+
+    return l;
+}
+
+bool _art_leaf_matches(const art_leaf *l, const unsigned char *key, size_t keylen) {
+    return l->keylen == keylen && !memcmp(l->key, key, keylen);
+}
+
+int _art_leaf_visit(const art_leaf *l, map_visit_fn fn, void *ctx) {
+    // Don't report the null terminator as part of the key
+    return fn((const char *)l->key, l->keylen - 1, l->data, l->size, ctx);
+}
+
+// =============================== INNER NODES =================================
+
+art_node *_art_node_init(uint8_t type) {
+    art_node *n;
+
+    switch (type) {
+        case _ART_NODE4:
+            n = calloc(1, sizeof(art_node4));
+            break;
+        case _ART_NODE16:
+            n = calloc(1, sizeof(art_node16));
+            break;
+        case _ART_NODE48:
+            n = calloc(1, sizeof(art_node48));
+            break;
+        default:
+            n = calloc(1, sizeof(art_node256));
+            break;
+    }
+    if (!n) return NULL;
+
+    n->type = type;
+    return n;
+}
+
+void _art_node_copy_header(art_node *dst, const art_node *src) {
+    dst->num_children = src->num_children;
+    dst->prefix_len = src->prefix_len;
+    memcpy(dst->prefix, src->prefix, _ART_MIN(_ART_MAX_PREFIX, src->prefix_len));
+}
+
+void _art_node_free(art_node *n) {
+    int i;
+
+    if (!n) return;
+
+    if (_ART_IS_LEAF(n)) {
+        free(_ART_LEAF_RAW(n));
+        return;
+    }
+
+    switch (n->type) {
+        case _ART_NODE4:
+            for (i = 0; i < n->num_children; i++) _art_node_free(((art_node4 *)n)->children[i]);
+            break;
+        case _ART_NODE16:
+            for (i = 0; i < n->num_children; i++) _art_node_free(((art_node16 *)n)->children[i]);
+            break;
+        case _ART_NODE48:
+            for (i = 0; i < 48; i++) _art_node_free(((art_node48 *)n)->children[i]);
+            break;
+        default:
+            for (i = 0; i < 256; i++) _art_node_free(((art_node256 *)n)->children[i]);
+            break;
+    }
+
+    free(n);
+}
+
+// Returns the slot holding the child for key byte `c`, or NULL
+art_node **_art_find_child(art_node *n, unsigned char c) {
+    int i;
+
+    switch (n->type) {
+        case _ART_NODE4: {
+            art_node4 *p = (art_node4 *)n;
+            for (i = 0; i < n->num_children; i++) {
+                if (p->keys[i] == c) return &p->children[i];
+            }
+            return NULL;
+        }
+        case _ART_NODE16: {
+            art_node16 *p = (art_node16 *)n;
+#ifdef __SSE2__
+            // Compare all 16 keys at once, ignoring unused slots
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c), _mm_loadu_si128((const __m128i *)p->keys));
+            unsigned bits = (unsigned)_mm_movemask_epi8(cmp) & ((1U << n->num_children) - 1);
+            return bits ? &p->children[__builtin_ctz(bits)] : NULL;
+#else
+            for (i = 0; i < n->num_children; i++) {
+                if (p->keys[i] == c) return &p->children[i];
+            }
+            return NULL;
+#endif
+        }
+        case _ART_NODE48: {
+            art_node48 *p = (art_node48 *)n;
+            return p->index[c] ? &p->children[p->index[c] - 1] : NULL;
+        }
+        default: {
+            art_node256 *p = (art_node256 *)n;
+            return p->children[c] ? &p->children[c] : NULL;
+        }
+    }
+}
+
+// Position at which `c` must be inserted into a sorted key array
+int _art_insert_pos(const unsigned char *keys, int num_children, unsigned char c) {
+    int i;
+
+#ifdef __SSE2__
+    if (num_children > 4) {
+        // SSE2 only has signed byte comparisons. Flipping the top bit of both
+        // sides turns them into unsigned ones.
+        __m128i flip = _mm_set1_epi8((char)0x80);
+        __m128i k = _mm_xor_si128(_mm_loadu_si128((const __m128i *)keys), flip);
+        __m128i cmp = _mm_cmplt_epi8(_mm_xor_si128(_mm_set1_epi8((char)c), flip), k);
+        unsigned bits = (unsigned)_mm_movemask_epi8(cmp) & ((1U << num_children) - 1);
+        return bits ? __builtin_ctz(bits) : num_children;
+    }
+#endif
+
+    for (i = 0; i < num_children && keys[i] < c; i++) continue;
+    return i;
+}
+
+art_leaf *_art_minimum(const art_node *n) {
+    int i;
+
+    if (!n) return NULL;
+    if (_ART_IS_LEAF(n)) return _ART_LEAF_RAW(n);
+
+    switch (n->type) {
+        case _ART_NODE4:
+            return _art_minimum(((const art_node4 *)n)->children[0]);
+        case _ART_NODE16:
+            return _art_minimum(((const art_node16 *)n)->children[0]);
+        case _ART_NODE48: {
+            const art_node48 *p = (const art_node48 *)n;
+            for (i = 0; !p->index[i]; i++) continue;
+            return _art_minimum(p->children[p->index[i] - 1]);
+        }
+        default: {
+            const art_node256 *p = (const art_node256 *)n;
+            for (i = 0; !p->children[i]; i++) continue;
+            return _art_minimum(p->children[i]);
+        }
+    }
+}
+
+art_leaf *_art_maximum(const art_node *n) {
+    int i;
+
+    if (!n) return NULL;
+    if (_ART_IS_LEAF(n)) return _ART_LEAF_RAW(n);
+
+    switch (n->type) {
+        case _ART_NODE4:
+            return _art_maximum(((const art_node4 *)n)->children[n->num_children - 1]);
+        case _ART_NODE16:
+            return _art_maximum(((const art_node16 *)n)->children[n->num_children - 1]);
+        case _ART_NODE48: {
+            const art_node48 *p = (const art_node48 *)n;
+            for (i = 255; !p->index[i]; i--) continue;
+            return _art_maximum(p->children[p->index[i] - 1]);
+        }
+        default: {
+            const art_node256 *p = (const art_node256 *)n;
+            for (i = 255; !p->children[i]; i--) continue;
+            return _art_maximum(p->children[i]);
+        }
+    }
+}
+
+// ============================== PREFIX MATCHING ==============================
+
+// Number of stored prefix bytes of `n` that match `key` at `depth`
+size_t _art_check_prefix(const art_node *n, const unsigned char *key, size_t keylen, size_t depth) {
+    size_t max = _ART_MIN(_ART_MIN((size_t)n->prefix_len, _ART_MAX_PREFIX), keylen - depth);
+    size_t i;
+
+    for (i = 0; i < max && n->prefix[i] == key[depth + i]; i++) continue;
+    return i;
+}
+
+/*
+ * Index of the first byte at which the compressed path of `n` differs from
+ * `key` at `depth`. Bytes beyond the stored prefix are compared against a leaf
+ * below `n`, since they all share the full path.
+ */
+size_t _art_prefix_mismatch(const art_node *n, const unsigned char *key, size_t keylen, size_t depth) {
+    size_t i = _art_check_prefix(n, key, keylen, depth);
+
+    if (i == _ART_MAX_PREFIX && n->prefix_len > _ART_MAX_PREFIX) {
+        const art_leaf *l = _art_minimum(n);
+        size_t max = _ART_MIN(l->keylen, keylen) - depth;
+
+        for (; i < max && l->key[depth + i] == key[depth + i]; i++) continue;
+    }
+
+    return i;
+}
+
+// ================================= INSERTION =================================
+
+void _art_add_child(art_node *n, art_node **ref, unsigned char c, art_node *child);
+
+void _art_add_child256(art_node256 *n, unsigned char c, art_node *child) {
+    n->n.num_children++;
+    n->children[c] = child;
+}
+
+void _art_add_child48(art_node48 *n, art_node **ref, unsigned char c, art_node *child) {
+    if (n->n.num_children < 48) {
+        int pos = 0;
+        while (n->children[pos]) pos++;
+        n->children[pos] = child;
+        n->index[c] = (unsigned char)(pos + 1);
+        n->n.num_children++;
+    } else {
+        // Full, grow into a Node256
+        art_node256 *grown = (art_node256 *)_art_node_init(_ART_NODE256);
+        int i;
+        if (!grown) return;
+
+        for (i = 0; i < 256; i++) {
+            if (n->index[i]) grown->children[i] = n->children[n->index[i] - 1];
+        }
+        _art_node_copy_header(&grown->n, &n->n);
+        *ref = &grown->n;
+        free(n);
+        _art_add_child256(grown, c, child);
+    }
+}
+
+void _art_add_child16(art_node16 *n, art_node **ref, unsigned char c, art_node *child) {
+    if (n->n.num_children < 16) {
+        int pos = _art_insert_pos(n->keys, n->n.num_children, c);
+
+        memmove(n->keys + pos + 1, n->keys + pos, (size_t)(n->n.num_children - pos));
+        memmove(n->children + pos + 1, n->children + pos, (size_t)(n->n.num_children - pos) * sizeof(void *));
+        n->keys[pos] = c;
+        n->children[pos] = child;
+        n->n.num_children++;
+    } else {
+        // Full, grow into a Node48
+        art_node48 *grown = (art_node48 *)_art_node_init(_ART_NODE48);
+        int i;
+        if (!grown) return;
+
+        memcpy(grown->children, n->children, 16 * sizeof(void *));
+        for (i = 0; i < 16; i++) grown->index[n->keys[i]] = (unsigned char)(i + 1);
+        _art_node_copy_header(&grown->n, &n->n);
+        *ref = &grown->n;
+        free(n);
+        _art_add_child48(grown, ref, c, child);
+    }
+}
+
+void _art_add_child4(art_node4 *n, art_node **ref, unsigned char c, art_node *child) {
+    if (n->n.num_children < 4) {
+        int pos = _art_insert_pos(n->keys, n->n.num_children, c);
+
+        memmove(n->keys + pos + 1, n->keys + pos, (size_t)(n->n.num_children - pos));
+        memmove(n->children + pos + 1, n->children + pos, (size_t)(n->n.num_children - pos) * sizeof(void *));
+        n->keys[pos] = c;
+        n->children[pos] = child;
+        n->n.num_children++;
+    } else {
+        // Full, grow into a Node16
+        art_node16 *grown = (art_node16 *)_art_node_init(_ART_NODE16);
+        if (!grown) return;
+
+        memcpy(grown->children, n->children, 4 * sizeof(void *));
+        memcpy(grown->keys, n->keys, 4);
+        _art_node_copy_header(&grown->n, &n->n);
+        *ref = &grown->n;
+        free(n);
+        _art_add_child16(grown, ref, c, child);
+    }
+}
+
+void _art_add_child(art_node *n, art_node **ref, unsigned char c, art_node *child) {
+    switch (n->type) {
+        case _ART_NODE4:
+            _art_add_child4((art_node4 *)n, ref, c, child);
+            break;
+        case _ART_NODE16:
+            _art_add_child16((art_node16 *)n, ref, c, child);
+            break;
+        case _ART_NODE48:
+            _art_add_child48((art_node48 *)n, ref, c, child);
+            break;
+        default:
+            _art_add_child256((art_node256 *)n, c, child);
+            break;
+    }
+}
+
+// Whether `n` can take another child without growing
+bool _art_has_room(const art_node *n) {
+    switch (n->type) {
+        case _ART_NODE4:
+            return n->num_children < 4;
+        case _ART_NODE16:
+            return n->num_children < 16;
+        case _ART_NODE48:
+            return n->num_children < 48;
+        default:
+            return true;
+    }
+}
+
+int _art_add(art_node *n, art_node **ref, const unsigned char *key, size_t keylen, size_t depth, void *data, size_t size) {
+    art_leaf *leaf;
+    art_node **child;
+
+    if (!n) {
+        // base case: empty slot, store the entry here
+        leaf = _art_leaf_init(key, keylen, data, size);
+        if (!leaf) return _MAP_FAILURE;
+        *ref = _ART_SET_LEAF(leaf);
+        return _MAP_SUCCESS;
+    }
+
+    if (_ART_IS_LEAF(n)) {
+        art_leaf *existing = _ART_LEAF_RAW(n);
+        art_node4 *split;
+        size_t common;
+
+        if (_art_leaf_matches(existing, key, keylen)) {
+            // Entry with key already exists, replace it
+            leaf = _art_leaf_init(key, keylen, data, size);
+            if (!leaf) return _MAP_FAILURE;
+            *ref = _ART_SET_LEAF(leaf);
+            free(existing);
+            return _MAP_SUCCESS_REPLACED;
+        }
+
+        // Two different keys share this slot now, split it with a Node4 that
+        // holds their common prefix
+        leaf = _art_leaf_init(key, keylen, data, size);
+        split = (art_node4 *)_art_node_init(_ART_NODE4);
+        if (!leaf || !split) {
+            free(leaf);
+            free(split);
+            return _MAP_FAILURE;
+        }
+
+        for (common = 0; existing->key[depth + common] == key[depth + common]; common++) continue;
+        split->n.prefix_len = (uint32_t)common;
+        memcpy(split->n.prefix, key + depth, _ART_MIN(_ART_MAX_PREFIX, common));
+
+        _art_add_child4(split, ref, existing->key[depth + common], n);
+        _art_add_child4(split, ref, key[depth + common], _ART_SET_LEAF(leaf));
+        *ref = &split->n;
+        return _MAP_SUCCESS;
+    }
+
+    if (n->prefix_len) {
+        size_t diff = _art_prefix_mismatch(n, key, keylen, depth);
+
+        if (diff < n->prefix_len) {
+            // The key leaves the compressed path part way, split the path
+            art_node4 *split = (art_node4 *)_art_node_init(_ART_NODE4);
+            leaf = _art_leaf_init(key, keylen, data, size);
+            if (!leaf || !split) {
+                free(leaf);
+                free(split);
+                return _MAP_FAILURE;
+            }
+
+            split->n.prefix_len = (uint32_t)diff;
+            memcpy(split->n.prefix, n->prefix, _ART_MIN(_ART_MAX_PREFIX, diff));
+
+            if (n->prefix_len <= _ART_MAX_PREFIX) {
+                _art_add_child4(split, ref, n->prefix[diff], n);
+                n->prefix_len -= (uint32_t)(diff + 1);
+                memmove(n->prefix, n->prefix + diff + 1, _ART_MIN(_ART_MAX_PREFIX, n->prefix_len));
+            } else {
+                // Only part of the path is stored, recover the rest from a leaf
+                art_leaf *min = _art_minimum(n);
+                n->prefix_len -= (uint32_t)(diff + 1);
+                _art_add_child4(split, ref, min->key[depth + diff], n);
+                memcpy(n->prefix, min->key + depth + diff + 1, _ART_MIN(_ART_MAX_PREFIX, n->prefix_len));
+            }
+
+            _art_add_child4(split, ref, key[depth + diff], _ART_SET_LEAF(leaf));
+            *ref = &split->n;
+            return _MAP_SUCCESS;
+        }
+
+        depth += n->prefix_len;
+    }
+
+    child = _art_find_child(n, key[depth]);
+    if (child) {
+        // recursively insert into the matching subtree
+        return _art_add(*child, child, key, keylen, depth + 1, data, size);
+    }
+
+    // No child for this byte yet, add the entry directly below this node
+    leaf = _art_leaf_init(key, keylen, data, size);
+    if (!leaf) return _MAP_FAILURE;
+
+    if (!_art_has_room(n)) {
+        // Growing allocates; make sure it worked before giving up the leaf
+        art_node *before = *ref;
+        _art_add_child(n, ref, key[depth], _ART_SET_LEAF(leaf));
+        if (*ref == before) {
+            free(leaf);
+            return _MAP_FAILURE;
+        }
+    } else {
+        _art_add_child(n, ref, key[depth], _ART_SET_LEAF(leaf));
+    }
+
+    return _MAP_SUCCESS;
+}
+
+// ================================= DELETION ==================================
+
+void _art_remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
+    n->children[c] = NULL;
+    n->n.num_children--;
+
+    // Shrink into a Node48. Leave some slack so a node on the boundary doesn't
+    // flip back and forth.
+    if (n->n.num_children == 37) {
+        art_node48 *shrunk = (art_node48 *)_art_node_init(_ART_NODE48);
+        int i, pos = 0;
+        if (!shrunk) return;
+
+        _art_node_copy_header(&shrunk->n, &n->n);
+        for (i = 0; i < 256; i++) {
+            if (n->children[i]) {
+                shrunk->children[pos] = n->children[i];
+                shrunk->index[i] = (unsigned char)(pos + 1);
+                pos++;
+            }
+        }
+        *ref = &shrunk->n;
+        free(n);
+    }
+}
+
+void _art_remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
+    int pos = n->index[c] - 1;
+
+    n->index[c] = 0;
+    n->children[pos] = NULL;
+    n->n.num_children--;
+
+    if (n->n.num_children == 12) {
+        art_node16 *shrunk = (art_node16 *)_art_node_init(_ART_NODE16);
+        int i, child = 0;
+        if (!shrunk) return;
+
+        _art_node_copy_header(&shrunk->n, &n->n);
+        for (i = 0; i < 256; i++) {
+            if (n->index[i]) {
+                shrunk->keys[child] = (unsigned char)i;
+                shrunk->children[child] = n->children[n->index[i] - 1];
+                child++;
+            }
+        }
+        *ref = &shrunk->n;
+        free(n);
+    }
+}
+
+void _art_remove_child16(art_node16 *n, art_node **ref, art_node **slot) {
+    int pos = (int)(slot - n->children);
+
+    memmove(n->keys + pos, n->keys + pos + 1, (size_t)(n->n.num_children - 1 - pos));
+    memmove(n->children + pos, n->children + pos + 1, (size_t)(n->n.num_children - 1 - pos) * sizeof(void *));
+    n->n.num_children--;
+
+    if (n->n.num_children == 3) {
+        art_node4 *shrunk = (art_node4 *)_art_node_init(_ART_NODE4);
+        if (!shrunk) return;
+
+        _art_node_copy_header(&shrunk->n, &n->n);
+        memcpy(shrunk->keys, n->keys, 4);
+        memcpy(shrunk->children, n->children, 4 * sizeof(void *));
+        *ref = &shrunk->n;
+        free(n);
+    }
+}
+
+void _art_remove_child4(art_node4 *n, art_node **ref, art_node **slot) {
+    int pos = (int)(slot - n->children);
+
+    memmove(n->keys + pos, n->keys + pos + 1, (size_t)(n->n.num_children - 1 - pos));
+    memmove(n->children + pos, n->children + pos + 1, (size_t)(n->n.num_children - 1 - pos) * sizeof(void *));
+    n->n.num_children--;
+
+    if (n->n.num_children == 1) {
+        // Only one child left, merge this node's path into it
+        art_node *child = n->children[0];
+
+        if (!_ART_IS_LEAF(child)) {
+            size_t prefix = n->n.prefix_len;
+
+            if (prefix < _ART_MAX_PREFIX) n->n.prefix[prefix++] = n->keys[0];
+            if (prefix < _ART_MAX_PREFIX) {
+                size_t sub = _ART_MIN(child->prefix_len, _ART_MAX_PREFIX - prefix);
+                memcpy(n->n.prefix + prefix, child->prefix, sub);
+                prefix += sub;
+            }
+
+            memcpy(child->prefix, n->n.prefix, _ART_MIN(prefix, _ART_MAX_PREFIX));
+            child->prefix_len += n->n.prefix_len + 1;
+        }
+
+        *ref = child;
+        free(n);
+    }
+}
+
+void _art_remove_child(art_node *n, art_node **ref, unsigned char c, art_node **slot) {
+    switch (n->type) {
+        case _ART_NODE4:
+            _art_remove_child4((art_node4 *)n, ref, slot);
+            break;
+        case _ART_NODE16:
+            _art_remove_child16((art_node16 *)n, ref, slot);
+            break;
+        case _ART_NODE48:
+            _art_remove_child48((art_node48 *)n, ref, c);
+            break;
+        default:
+            _art_remove_child256((art_node256 *)n, ref, c);
+            break;
+    }
+}
+
+// Unlinks and returns the leaf for `key`, or NULL if it doesn't exist
+art_leaf *_art_remove(art_node *n, art_node **ref, const unsigned char *key, size_t keylen, size_t depth) {
+    art_node **child;
+
+    if (!n) return NULL;
+
+    if (_ART_IS_LEAF(n)) {
+        // Only reachable when the leaf is the root
+        if (!_art_leaf_matches(_ART_LEAF_RAW(n), key, keylen)) return NULL;
+        *ref = NULL;
+        return _ART_LEAF_RAW(n);
+    }
+
+    if (n->prefix_len) {
+        if (_art_check_prefix(n, key, keylen, depth) != _ART_MIN(_ART_MAX_PREFIX, n->prefix_len)) return NULL;
+        depth += n->prefix_len;
+        if (depth >= keylen) return NULL;
+    }
+
+    child = _art_find_child(n, key[depth]);
+    if (!child) return NULL;
+
+    if (_ART_IS_LEAF(*child)) {
+        art_leaf *l = _ART_LEAF_RAW(*child);
+        if (!_art_leaf_matches(l, key, keylen)) return NULL;
+
+        _art_remove_child(n, ref, key[depth], child);
+        return l;
+    }
+
+    return _art_remove(*child, child, key, keylen, depth + 1);
+}
+
+// ============================ PUBLIC FUNCTIONS ===============================
+
+int art_init(ArtTree **tree) {
+    ArtTree *t = NULL;
+
+    if (!tree) return _MAP_FAILURE;
+
+    t = *tree = malloc(sizeof(ArtTree));
+    if (!t) return _MAP_FAILURE;
+
+    t->root = NULL;
+    t->count = 0;
+
+    return _MAP_SUCCESS;
+}
+
+void art_free(ArtTree **tree) {
+    if (!tree || !(*tree)) return;
+
+    _art_node_free((*tree)->root);
+
+    free(*tree);
+    *tree = NULL;
+}
+
+int art_size(ArtTree *tree) {
+    if (!tree) return _MAP_FAILURE;
+
+    return (int)tree->count;
+}
+
+void *art_min(ArtTree *tree) {
+    art_leaf *l;
+
+    if (!tree) return NULL;
+
+    l = _art_minimum(tree->root);
+    return l ? l->data : NULL;
+}
+
+void *art_max(ArtTree *tree) {
+    art_leaf *l;
+
+    if (!tree) return NULL;
+
+    l = _art_maximum(tree->root);
+    return l ? l->data : NULL;
+}
+
+int art_add(ArtTree *tree, char *key, void *data, size_t size) {
+    int ret;
+
+    if (!tree || !key || !data) return _MAP_FAILURE;
+
+    ret = _art_add(tree->root, &tree->root, (const unsigned char *)key, strlen(key) + 1, 0, data, size);
+    if (ret == _MAP_SUCCESS) tree->count++;
+
+    return ret;
+}
+
+art_leaf *_art_get(ArtTree *tree, const unsigned char *key, size_t keylen) {
+    art_node *n = tree->root;
+    size_t depth = 0;
+
+    while (n) {
+        art_node **child;
+
+        if (_ART_IS_LEAF(n)) {
+            // Compressed paths were only partially checked, so compare the
+            // whole key
+            art_leaf *l = _ART_LEAF_RAW(n);
+            return _art_leaf_matches(l, key, keylen) ? l : NULL;
+        }
+
+        if (n->prefix_len) {
+            if (_art_check_prefix(n, key, keylen, depth) != _ART_MIN(_ART_MAX_PREFIX, n->prefix_len)) return NULL;
+            depth += n->prefix_len;
+            if (depth >= keylen) return NULL;
+        }
+
+        child = _art_find_child(n, key[depth]);
+        n = child ? *child : NULL;
+        depth++;
+    }
+
+    return NULL;
+}
+
+void *art_get(ArtTree *tree, char *key) {
+    art_leaf *l;
+
+    if (!tree || !key) return NULL;
+
+    l = _art_get(tree, (const unsigned char *)key, strlen(key) + 1);
+    return l ? l->data : NULL;
+}
+
+int art_has(ArtTree *tree, char *key) {
+    if (!tree || !key) return false;
+
+    return _art_get(tree, (const unsigned char *)key, strlen(key) + 1) ? true : false;
+}
+
+int art_remove(ArtTree *tree, char *key) {
+    art_leaf *l;
+
+    if (!tree || !key) return _MAP_FAILURE;
+
+    l = _art_remove(tree->root, &tree->root, (const unsigned char *)key, strlen(key) + 1, 0);
+    if (!l) return _MAP_FAILURE;
+
+    free(l);
+    tree->count--;
+    return _MAP_SUCCESS;
+}
+
+// ================================= ITERATION =================================
+
+// Returns non-zero if `fn` asked to stop
+int _art_for_each(const art_node *n, map_visit_fn fn, void *ctx) {
+    int i, ret;
+
+    if (!n) return 0;
+    if (_ART_IS_LEAF(n)) return _art_leaf_visit(_ART_LEAF_RAW(n), fn, ctx);
+
+    // Children are visited in key byte order
+    switch (n->type) {
+        case _ART_NODE4:
+            for (i = 0; i < n->num_children; i++) {
+                if ((ret = _art_for_each(((const art_node4 *)n)->children[i], fn, ctx))) return ret;
+            }
+            break;
+        case _ART_NODE16:
+            for (i = 0; i < n->num_children; i++) {
+                if ((ret = _art_for_each(((const art_node16 *)n)->children[i], fn, ctx))) return ret;
+            }
+            break;
+        case _ART_NODE48: {
+            const art_node48 *p = (const art_node48 *)n;
+            for (i = 0; i < 256; i++) {
+                if (!p->index[i]) continue;
+                if ((ret = _art_for_each(p->children[p->index[i] - 1], fn, ctx))) return ret;
+            }
+            break;
+        }
+        default: {
+            const art_node256 *p = (const art_node256 *)n;
+            for (i = 0; i < 256; i++) {
+                if ((ret = _art_for_each(p->children[i], fn, ctx))) return ret;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
+int art_for_each(ArtTree *tree, map_visit_fn fn, void *ctx) {
+    if (!tree || !fn) return _MAP_FAILURE;
+
+    return _art_for_each(tree->root, fn, ctx) ? _MAP_FAILURE : _MAP_SUCCESS;
+}
+
+int art_prefix_scan(ArtTree *tree, const char *prefix, map_visit_fn fn, void *ctx) {
+    const unsigned char *key = (const unsigned char *)prefix;
+    size_t keylen, depth = 0;
+    art_node *n;
+
+    if (!tree || !prefix || !fn) return _MAP_FAILURE;
+
+    // The prefix is matched without its null terminator
+    keylen = strlen(prefix);
+    n = tree->root;
+
+    while (n) {
+        art_node **child;
+
+        if (_ART_IS_LEAF(n)) {
+            art_leaf *l = _ART_LEAF_RAW(n);
+            if (l->keylen > keylen && !memcmp(l->key, key, keylen) && _art_leaf_visit(l, fn, ctx)) return _MAP_FAILURE;
+            return _MAP_SUCCESS;
+        }
+
+        if (depth == keylen) {
+            // The whole prefix has been matched, every key below matches
+            return _art_for_each(n, fn, ctx) ? _MAP_FAILURE : _MAP_SUCCESS;
+        }
+
+        if (n->prefix_len) {
+            size_t matched = _ART_MIN(_art_prefix_mismatch(n, key, keylen, depth), n->prefix_len);
+
+            if (depth + matched == keylen) {
+                // The prefix ends inside this node's compressed path
+                return _art_for_each(n, fn, ctx) ? _MAP_FAILURE : _MAP_SUCCESS;
+            }
+            if (matched < n->prefix_len) return _MAP_SUCCESS;  // No key has this prefix
+
+            depth += n->prefix_len;
+        }
+
+        child = _art_find_child(n, key[depth]);
+        n = child ? *child : NULL;
+        depth++;
+    }
+
+    return _MAP_SUCCESS;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file art.h
+ * @brief A key/value map implemented as an Adaptive Radix Tree.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup art Adaptive Radix Tree
+ * A radix tree over the bytes of string keys. Inner nodes grow and shrink
+ * between four layouts (4, 16, 48 and 256 children) as entries are added and
+ * removed, and chains of single-child nodes are collapsed into a compressed
+ * prefix.
+ *
+ * Lookups cost O(key length) regardless of the number of entries, and keys
+ * sharing a long prefix only store and compare it once. Each entry is a single
+ * allocation holding both its key and its data.
+ *
+ * Entries are kept in `strcmp` order, so in-order iteration and prefix scans
+ * come for free.
+ */
+#ifndef __ART_H__
+#define __ART_H__
+
+#include <stdlib.h>
+
+#include "map.h"
+
+/**
+ * @brief An Adaptive Radix Tree storing key/value pairs.
+ *
+ * Like a BinTree, this tree stores one entry per unique key and owns copies of
+ * both keys and data. Inserting with a duplicate key replaces the existing
+ * entry.
+ *
+ * @ingroup art
+ */
+typedef struct art_tree ArtTree;
+
+/**
+ * @brief Constructs a new ArtTree.
+ *
+ * @ingroup art
+ *
+ * @param tree A pointer to the tree to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int art_init(ArtTree **tree);
+
+/**
+ * @brief Destroys an ArtTree and frees all resources associated with it.
+ *
+ * After destruction, the tree will be set to `NULL`.
+ *
+ * @ingroup art
+ *
+ * @param tree A pointer to the tree to destroy.
+ */
+void art_free(ArtTree **tree);
+
+/**
+ * @brief Gets the number of key/value entries in an ArtTree.
+ *
+ * @ingroup art
+ *
+ * @param tree The target tree.
+ *
+ * @return int The number of entries in the tree, or 0 on failure.
+ */
+int art_size(ArtTree *tree);
+
+/**
+ * @brief Gets the value stored in the smallest entry.
+ *
+ * @ingroup art
+ *
+ * @param tree The target tree.
+ *
+ * @return The smallest entry's stored data. If the tree is empty, `NULL` is
+ * returned.
+ */
+void *art_min(ArtTree *tree);
+
+/**
+ * @brief Gets the value stored in the largest entry.
+ *
+ * @ingroup art
+ *
+ * @param tree The target tree.
+ *
+ * @return The largest entry's stored data. If the tree is empty, `NULL` is
+ * returned.
+ */
+void *art_max(ArtTree *tree);
+
+/**
+ * @brief Inserts an entry into an ArtTree.
+ *
+ * If an entry under `key` already exists, it is replaced and its memory is
+ * freed. Both the key and data are copied into the tree.
+ *
+ * @ingroup art
+ *
+ * @param tree The tree to insert into.
+ * @param key  The entry key.
+ * @param data The data stored in the entry.
+ * @param size The size of `data`.
+ *
+ * @return int A positive number on success, 0 on failure. If an existing entry
+ * is replaced, 2 is returned.
+ */
+int art_add(ArtTree *tree, char *key, void *data, size_t size);
+
+/**
+ * @brief Searches an ArtTree for an entry.
+ *
+ * As with `bt_get()`, the returned pointer is only valid until the entry is
+ * replaced or removed.
+ *
+ * @ingroup art
+ *
+ * @param tree The tree to search.
+ * @param key  The entry key.
+ *
+ * @return void* A pointer to the entry data, or `NULL` if no entry exists for
+ * the given key.
+ */
+void *art_get(ArtTree *tree, char *key);
+
+/**
+ * @brief Checks if an entry exists under a key.
+ *
+ * @ingroup art
+ *
+ * @param tree The tree to search.
+ * @param key  The entry key.
+ *
+ * @return int 1 if an entry exists for `key`, 0 if one does not.
+ */
+int art_has(ArtTree *tree, char *key);
+
+/**
+ * @brief Removes an entry from an ArtTree, freeing its memory resources.
+ *
+ * @ingroup art
+ *
+ * @param tree The tree to remove the entry from.
+ * @param key  The entry key.
+ *
+ * @return int 1 if the entry existed and was removed, 0 otherwise.
+ */
+int art_remove(ArtTree *tree, char *key);
+
+/**
+ * @brief Visits every entry of an ArtTree in key order.
+ *
+ * The tree must not be modified during iteration.
+ *
+ * @ingroup art
+ *
+ * @param tree The tree to iterate over.
+ * @param fn   Called once per entry. Returning non-zero stops the iteration.
+ * @param ctx  Passed to `fn`.
+ *
+ * @return int 1 if every entry was visited, 0 if `fn` stopped the iteration or
+ * on failure.
+ */
+int art_for_each(ArtTree *tree, map_visit_fn fn, void *ctx);
+
+/**
+ * @brief Visits every entry whose key starts with `prefix`, in key order.
+ *
+ * Only the subtree below `prefix` is visited, so the cost is O(prefix length)
+ * plus the number of matching entries.
+ *
+ * @ingroup art
+ *
+ * @param tree   The tree to search.
+ * @param prefix The key prefix. An empty prefix matches every entry.
+ * @param fn     Called once per matching entry. Returning non-zero stops the
+ * iteration.
+ * @param ctx    Passed to `fn`.
+ *
+ * @return int 1 if every matching entry was visited, 0 if `fn` stopped the
+ * iteration or on failure.
+ */
+int art_prefix_scan(ArtTree *tree, const char *prefix, map_visit_fn fn, void *ctx);
+
+#endif
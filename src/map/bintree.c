@@ -1,28 +1,273 @@
 // SPDX-License-Identifier: MIT
+#define _POSIX_C_SOURCE 200809L
+
 #include "bintree.h"
 
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/param.h>
 
+#include "../util/pool.h"
+#include "../util/stats.h"
+
+/*
+ * An entry's data and its size. Replacing data swaps in a whole new record,
+ * so epoch readers never pair a size with a buffer of another size.
+ */
+typedef struct bt_value {
+    size_t size;          // size of data
+    void *data;           // entry value. Points at buf unless the data is borrowed.
+    unsigned char buf[];  // private copy of data
+} bt_value;
+
 typedef struct bt_node {
-    char *key;             // entry lookup key
-    void *data;            // entry value
-    size_t size;           // size of data
+    bt_value *value;       // entry data and its size
+    uint32_t keylen;       // length of key, without null terminator
+    uint32_t hits;         // sampled lookups, see bt_set_sampling()
+    uint64_t prefix;       // first 8 bytes of key, see _bt_key_prefix()
+    const char *key;       // entry lookup key. Points at buf unless the key is
+                           // interned or borrowed.
     struct bt_node *left,  // left child node
         *right;            // right child node
+    char buf[];            // private copy of key, null-terminated
 } bt_node;
 
+// A key being searched for, with its length and prefix worked out once
+typedef struct bt_key {
+    const unsigned char *bytes;
+    size_t len;
+    uint64_t prefix;
+} bt_key;
+
+// A blocked Bloom filter over the tree's keys, see bt_set_bloom()
+typedef struct bt_bloom {
+    uint64_t (*blocks)[8];  // cache-line-sized blocks of 512 bits
+    void *mem;              // allocation holding blocks, which are aligned within it
+    size_t nblocks;         // number of blocks
+    unsigned hashes;        // bits set per key, all within one block
+    double bits_per_key;    // filter size per key of capacity
+    size_t expected;        // capacity asked for by the user
+    size_t capacity;        // keys the filter is currently sized for
+    size_t keys;            // keys added since the last rebuild, including removed ones
+    size_t removed;         // keys removed since the last rebuild
+    uint64_t rebuilds;      // times the filter was rebuilt from the tree
+#ifdef MAP_STATS
+    uint64_t checks, negatives, false_positives;
+#endif
+} bt_bloom;
+
+/*
+ * Progress of a Day-Stout-Warren rebuild spread over `bt_rebalance_step()`
+ * calls. The tree is first straightened into a vine, then compressed by
+ * passes of left rotations, each halving the vine's length.
+ */
+typedef struct bt_rebuild {
+    bt_node **link;  // where the next unit of work happens, NULL when idle
+    size_t count;    // nodes straightened into the vine so far
+    size_t pass;     // rotations left in the current compression pass
+    size_t next;     // length of the vine once the current pass is done
+    bool straight;   // whether the vine is complete and being compressed
+    bool balanced;   // whether the tree is unchanged since the last rebuild
+} bt_rebuild;
+
 struct bt_bintree {
     bt_node *root;
+    EpochDomain *ebr;        // defers frees while readers may be active, may be NULL
+    const Allocator *alloc;  // source of entry memory, NULL for the C heap
+    bt_cmp_fn cmp;           // key order, NULL for memcmp order
+    InternPool *intern;      // pool that keys are interned in, may be NULL
+    int borrow;              // BT_BORROW_* flags, parts of entries owned by the caller
+    bt_bloom *bloom;         // filter answering most lookups of missing keys, may be NULL
+    int splay;               // whether lookups and insertions splay, see bt_set_splay()
+    uint64_t sample_mask;    // lookups are counted when tick & mask is 0
+    uint64_t sample_tick;    // lookups seen while sampling
+    int sampling;            // whether lookups are sampled, see bt_set_sampling()
+    bt_rebuild rebalance;    // rebuild in progress, see bt_rebalance_step()
+    unsigned threads;        // threads set operations may use, see bt_set_parallel()
+    uint64_t moves;          // entries moved by removals, see _bt_remove_inner()
+#ifdef MAP_STATS
+    MapStats stats;
+    size_t depth;  // nodes visited so far by the add or remove in progress
+#endif
 };
 
+/*
+ * Links and entry data are published with release stores and read with
+ * acquire loads, so readers inside an epoch (see `bt_set_epoch()`) never see a
+ * partially initialized node. Both compile to plain moves on x86.
+ */
+#define BT_LOAD(ptr) __atomic_load_n(&(ptr), __ATOMIC_ACQUIRE)
+#define BT_STORE(ptr, val) __atomic_store_n(&(ptr), (val), __ATOMIC_RELEASE)
+
+// Starts loading a node into cache ahead of its use
+#ifdef __GNUC__
+#define BT_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define BT_PREFETCH(ptr) ((void)(ptr))
+#endif
+
+// Number of lookups bt_get_many() keeps in flight
+#define BT_GET_MANY_GROUP 16
+
+// Size of a Bloom filter block, one cache line
+#define BT_BLOOM_BLOCK 64
+// Most bits a Bloom filter sets per key
+#define BT_BLOOM_MAX_HASHES 16
+// Sampled lookups are scaled to weigh this many times the key count in total,
+// so bt_optimize() is driven by traffic rather than by the floor of 1 per key
+#define BT_OPTIMIZE_SCALE 64
+
+// Work units a full bt_rebalance() may use, enough for any tree
+#define BT_REBALANCE_ALL SIZE_MAX
+
+// Whether nodes carry a private copy of their key
+#define BT_KEY_INLINE(tree) (!(tree)->intern && !((tree)->borrow & BT_BORROW_KEYS))
+// Whether nodes carry a private copy of their data
+#define BT_DATA_OWNED(tree) (!((tree)->borrow & BT_BORROW_DATA))
+
+// Allocations and bytes held by a node and its entry, used by MAP_STATS.
+// Interned keys are owned by their pool, borrowed ones by the caller.
+#define BT_NODE_ALLOCS 2
+#define BT_VALUE_BYTES(tree, size) (sizeof(bt_value) + (BT_DATA_OWNED(tree) ? (size) : 0))
+#define BT_NODE_BYTES(tree, keylen, size) \
+    (sizeof(bt_node) + (BT_KEY_INLINE(tree) ? (keylen) + 1 : 0) + BT_VALUE_BYTES(tree, size))
+
 // =============================== PRIVATE UTILS ===============================
 
+/*
+ * Called whenever links change outside of a rebalance. The saved position of
+ * a rebuild in progress may no longer be in the tree, so it starts over.
+ */
+static inline void _bt_reshaped(BinTree *tree) {
+    tree->rebalance.link = NULL;
+    tree->rebalance.balanced = false;
+}
+
+/*
+ * The first 8 key bytes as a big-endian integer, zero padded. Comparing two
+ * prefixes as integers orders the keys the same way `memcmp` then length
+ * would, unless the prefixes are equal.
+ */
+uint64_t _bt_key_prefix(const unsigned char *key, size_t len) {
+    uint64_t prefix = 0;
+    size_t i;
+
+    for (i = 0; i < 8; i++) prefix = (prefix << 8) | (i < len ? key[i] : 0);
+
+    return prefix;
+}
+
+bt_key _bt_key(const void *key, size_t len) {
+    bt_key k;
+
+    k.bytes = key;
+    k.len = len;
+    k.prefix = _bt_key_prefix(key, len);
+
+    return k;
+}
+
+/*
+ * Compares a node's key with `k`. Unless the tree has its own comparator, keys
+ * are ordered by `memcmp`, with a key sorting before any longer key it is a
+ * prefix of. For strings this is the same order as `strcmp`.
+ *
+ * Most comparisons are settled by the cached prefixes, without touching the
+ * key bytes. Otherwise the first 8 bytes are known to match.
+ *
+ * @return <0, 0 or >0 if the node key is less than, equal to or greater than `k`.
+ */
+static inline int _bt_cmp(const BinTree *tree, const bt_node *node, const bt_key *k) {
+    size_t min;
+
+    // Interned keys are equal exactly when they are the same pointer, and
+    // callers may pass an interned key back in. A borrowed key, or one handed
+    // out by a visitor, may share its start with a key of another length.
+    if (node->key == (const char *)k->bytes && node->keylen == k->len) return 0;
+
+    if (tree->cmp) return tree->cmp(node->key, node->keylen, k->bytes, k->len);
+
+    if (node->prefix != k->prefix) return node->prefix < k->prefix ? -1 : 1;
+
+    min = node->keylen < k->len ? node->keylen : k->len;
+    if (min > 8) {
+        int cmp = memcmp(node->key + 8, k->bytes + 8, min - 8);
+        if (cmp) return cmp;
+    }
+
+    return (node->keylen > k->len) - (node->keylen < k->len);
+}
+
+/*
+ * Counts one in every `sample_mask + 1` lookups towards the entry found. The
+ * counters are relaxed atomics, as lookups may run concurrently, and saturate
+ * rather than wrap.
+ */
+static inline void _bt_sample(BinTree *tree, bt_node *node) {
+    if (__atomic_fetch_add(&tree->sample_tick, 1, __ATOMIC_RELAXED) & tree->sample_mask) return;
+
+    if (__atomic_load_n(&node->hits, __ATOMIC_RELAXED) < UINT32_MAX) {
+        __atomic_fetch_add(&node->hits, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * Creates the record holding an entry's data. Owned data is copied into it,
+ * or zero-filled if `data` is NULL, borrowed data is pointed at.
+ */
+static bt_value *_bt_value_new(BinTree *tree, const void *data, size_t size) {
+    bt_value *v = mem_alloc(tree->alloc, BT_VALUE_BYTES(tree, size));
+
+    if (!v) return NULL;
+
+    v->size = size;
+    if (!BT_DATA_OWNED(tree)) {
+        v->data = (void *)data;
+    } else {
+        v->data = v->buf;
+        if (data)
+            memcpy(v->buf, data, size);
+        else
+            memset(v->buf, 0, size);
+    }
+
+    return v;
+}
+
+// Loads a node's data. Owned data sits right after its record, so finding it
+// doesn't touch the record's cache line.
+static inline void *_bt_data(const BinTree *tree, bt_node *node) {
+    bt_value *v = BT_LOAD(node->value);
+
+    return BT_DATA_OWNED(tree) ? (void *)v->buf : v->data;
+}
+
+/*
+ * Whether an entry may have been moved out of the way of a lookup that started
+ * when the tree's move count was `*moves`. If so, `*moves` is brought up to
+ * date, and the lookup should retry from the root, where the entry has been
+ * published. See _bt_remove_inner().
+ */
+static inline bool _bt_moved(BinTree *tree, uint64_t *moves) {
+    uint64_t now;
+
+    if (!tree->ebr) return false;
+
+    now = __atomic_load_n(&tree->moves, __ATOMIC_ACQUIRE);
+    if (now == *moves) return false;
+
+    *moves = now;
+    return true;
+}
+
 bt_node *_bt_min(bt_node *node);
 bt_node *_bt_max(bt_node *node);
+int _bt_size(bt_node *node);
+int _bt_replace(BinTree *tree, bt_node *node, void *data, size_t size);
 
 int _bt_num_children(bt_node *node) {
     assert(node);
@@ -45,324 +290,2009 @@ bool _bt_node_is_leaf(bt_node *node) {
     return _bt_num_children(node) == 0;
 }
 
+// ================================ BLOOM FILTER ===============================
+
+// Spreads the bits of a key's hash over a Bloom filter block
+static const uint32_t bt_bloom_salts[BT_BLOOM_MAX_HASHES] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+    0x2ce2d5e5U, 0x61c8864fU, 0x9e3779b1U, 0xc2b2ae35U, 0x27d4eb2fU, 0x165667b1U, 0x85ebca77U, 0xd3a2646dU,
+};
+
+// A 64-bit hash of a key, read 8 bytes at a time
+uint64_t _bt_hash(const unsigned char *key, size_t len) {
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ len, w;
+
+    for (; len >= 8; key += 8, len -= 8) {
+        memcpy(&w, key, 8);
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }
+    w = 0;
+    if (len) memcpy(&w, key, len);
+    h ^= w;
+
+    // Final mix, so every key bit affects every hash bit
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+
+    return h;
+}
+
+/*
+ * Works out the block a hash maps to, and the bits to test in each of its 8
+ * words. The upper half of the hash picks the block, the lower half the bits.
+ */
+static inline uint64_t *_bt_bloom_masks(const bt_bloom *b, uint64_t h, uint64_t mask[8]) {
+    uint32_t lo = (uint32_t)h;
+
+    memset(mask, 0, 8 * sizeof(uint64_t));
+    for (unsigned i = 0; i < b->hashes; i++) mask[i & 7] |= 1ULL << ((lo * bt_bloom_salts[i]) >> 26);
+
+    return b->blocks[(uint64_t)(uint32_t)(h >> 32) * b->nblocks >> 32];
+}
+
+void _bt_bloom_add(bt_bloom *b, uint64_t h) {
+    uint64_t mask[8], *block = _bt_bloom_masks(b, h, mask);
+
+    for (int i = 0; i < 8; i++) block[i] |= mask[i];
+    b->keys++;
+}
+
+/*
+ * Whether a key may be in the tree. All of a key's bits live in one cache
+ * line, and the 8 words are tested without branches, which compilers turn
+ * into a few vector instructions.
+ */
+static inline bool _bt_bloom_test(const bt_bloom *b, uint64_t h) {
+    uint64_t mask[8], missing = 0, *block = _bt_bloom_masks(b, h, mask);
+
+    for (int i = 0; i < 8; i++) missing |= mask[i] & ~block[i];
+
+    return !missing;
+}
+
+void _bt_bloom_fill(bt_bloom *b, const bt_node *node) {
+    while (node) {
+        _bt_bloom_fill(b, node->left);
+        _bt_bloom_add(b, _bt_hash((const unsigned char *)node->key, node->keylen));
+        node = node->right;
+    }
+}
+
+/*
+ * Rebuilds a tree's filter from its entries, sized for at least `capacity`
+ * keys. On failure the old filter is kept: it still holds every key, it just
+ * has more false positives than it should.
+ */
+int _bt_bloom_rebuild(BinTree *tree, size_t capacity) {
+    bt_bloom *b = tree->bloom;
+    size_t count = (size_t)_bt_size(tree->root), nblocks;
+    void *mem;
+
+    capacity = MAX(capacity, count);
+    nblocks = (size_t)((double)capacity * b->bits_per_key / (8 * BT_BLOOM_BLOCK)) + 1;
+    if (nblocks > UINT32_MAX) return _MAP_FAILURE;
+
+    mem = calloc(nblocks * BT_BLOOM_BLOCK + BT_BLOOM_BLOCK - 1, 1);
+    if (!mem) return _MAP_FAILURE;
+
+    free(b->mem);
+    b->mem = mem;
+    b->blocks = (void *)(((uintptr_t)mem + BT_BLOOM_BLOCK - 1) & ~(uintptr_t)(BT_BLOOM_BLOCK - 1));
+    b->nblocks = nblocks;
+    b->capacity = capacity;
+    b->keys = b->removed = 0;
+    b->rebuilds++;
+    _bt_bloom_fill(b, tree->root);
+
+    return _MAP_SUCCESS;
+}
+
+// Records a key about to be added. A filter that is full grows first.
+void _bt_bloom_insert(BinTree *tree, const bt_key *k) {
+    bt_bloom *b = tree->bloom;
+
+    if (b->keys >= b->capacity) _bt_bloom_rebuild(tree, 2 * (b->keys + 1));
+    _bt_bloom_add(b, _bt_hash(k->bytes, k->len));
+}
+
+// Records a removed key. Its bits can't be cleared, as other keys may share
+// them, so the filter is rebuilt once half the keys it holds are stale.
+void _bt_bloom_remove(BinTree *tree) {
+    bt_bloom *b = tree->bloom;
+
+    if (++b->removed > b->keys / 2) _bt_bloom_rebuild(tree, b->expected);
+}
+
+// Whether a lookup of `k` can skip the tree, as the filter rules the key out
+bool _bt_bloom_skip(BinTree *tree, const bt_key *k) {
+    bool skip;
+
+    if (!tree->bloom) return false;
+
+    skip = !_bt_bloom_test(tree->bloom, _bt_hash(k->bytes, k->len));
+    MAP_STAT_INC(*tree->bloom, checks);
+    if (skip) MAP_STAT_INC(*tree->bloom, negatives);
+
+    return skip;
+}
+
 // =============================== INIT/DESTROY  =================================
 
-int _bt_node_init(bt_node **node, char *key, void *data, size_t size) {
+// Creates a node and links it in at `node`. Owned data is zero-filled if `data` is NULL.
+int _bt_node_init(BinTree *tree, bt_node **node, const bt_key *k, void *data, size_t size) {
     bt_node *n = NULL;
-    size_t keylen = 0;
 
     // Check parameters
-    if (!node || !key || !data) return _MAP_FAILURE;
+    if (!node || !k || (!data && !BT_DATA_OWNED(tree)) || k->len > UINT32_MAX) return _MAP_FAILURE;
 
-    // Allocate memory for new node
-    n = *node = malloc(sizeof(bt_node));
+    // Allocate memory for new node, with the key stored inline unless it is
+    // interned or borrowed. The extra byte is for a null terminator, so string
+    // keys can be handed out as is.
+    n = mem_alloc(tree->alloc, sizeof(bt_node) + (BT_KEY_INLINE(tree) ? k->len + 1 : 0));
     if (!n) return _MAP_FAILURE;
 
     // The node has no children
     n->left = NULL;
     n->right = NULL;
+    n->hits = 0;
+
+    // copy over key, or share the pool's or caller's copy
+    n->keylen = (uint32_t)k->len;
+    n->prefix = k->prefix;
+    if (tree->intern) {
+        n->key = intern_acquire(tree->intern, k->bytes, k->len);
+        if (!n->key) goto bt_node_init_err_key;
+    } else if (tree->borrow & BT_BORROW_KEYS) {
+        n->key = (const char *)k->bytes;
+    } else {
+        if (k->len) memcpy(n->buf, k->bytes, k->len);
+        n->buf[k->len] = '\0';
+        n->key = n->buf;
+    }
 
-    // copy over key string
-    keylen = strlen(key);
-    n->key = malloc(keylen + 1);       // Extra byte for null terminator
-    if (!n->key) return _MAP_FAILURE;  // TODO: this will leak memory
-    strncpy(n->key, key, keylen + 1);
+    // copy over entry data, unless the caller keeps it
+    n->value = _bt_value_new(tree, data, size);
+    if (!n->value) goto bt_node_init_err_data;
 
-    // copy over entry data
-    n->size = size;
-    n->data = malloc(size);
-    if (!n->data) return _MAP_FAILURE;  // TODO: this will leak memory
-    memcpy(n->data, data, size);
+    // A filter that grows is rebuilt from the tree, without this node
+    if (tree->bloom) _bt_bloom_insert(tree, k);
+
+    // Only link the node into the tree once it is fully initialized
+    _bt_reshaped(tree);
+    BT_STORE(*node, n);
 
     return _MAP_SUCCESS;
+
+bt_node_init_err_data:
+    if (tree->intern) intern_release(tree->intern, n->key);
+bt_node_init_err_key:
+    mem_free(tree->alloc, n);
+    return _MAP_FAILURE;
 }
 
-int bt_init(BinTree **tree) {
+int _bt_init(BinTree **tree, const Allocator *alloc, bt_cmp_fn cmp) {
     BinTree *t = NULL;
 
     if (!tree) return _MAP_FAILURE;
 
+    // Only entries come from the allocator, so a slab sized for nodes works
     t = *tree = malloc(sizeof(BinTree));
     if (!t) return _MAP_FAILURE;
 
     t->root = NULL;
+    t->ebr = NULL;
+    t->alloc = alloc;
+    t->cmp = cmp;
+    t->intern = NULL;
+    t->borrow = 0;
+    t->bloom = NULL;
+    t->splay = 0;
+    t->sampling = 0;
+    t->sample_mask = 0;
+    t->sample_tick = 0;
+    t->rebalance = (bt_rebuild){0};
+    t->threads = 1;
+    t->moves = 0;
+    MAP_STATS_ONLY(memset(&t->stats, 0, sizeof(MapStats)));
 
     return _MAP_SUCCESS;
 }
 
-void _bt_node_free(bt_node *node) {
-    // Node must point to a leaf node
-    assert(node);
-    // assert(node->left == NULL);
-    // assert(node->right == NULL);
+int bt_init_with_allocator(BinTree **tree, const Allocator *alloc) {
+    return _bt_init(tree, alloc, NULL);
+}
+
+int bt_init_with_cmp(BinTree **tree, bt_cmp_fn cmp) {
+    if (!cmp) return _MAP_FAILURE;
+
+    return _bt_init(tree, NULL, cmp);
+}
+
+int bt_init(BinTree **tree) {
+    return _bt_init(tree, NULL, NULL);
+}
+
+int bt_set_intern_pool(BinTree *tree, InternPool *pool) {
+    // Every key in the tree must come from the same place
+    if (!tree || tree->root || (pool && (tree->borrow & BT_BORROW_KEYS))) return _MAP_FAILURE;
+
+    tree->intern = pool;
+
+    return _MAP_SUCCESS;
+}
+
+int bt_set_borrowed(BinTree *tree, int flags) {
+    // Ownership can't change under existing entries
+    if (!tree || tree->root || (flags & ~(BT_BORROW_KEYS | BT_BORROW_DATA))) return _MAP_FAILURE;
+    if (tree->intern && (flags & BT_BORROW_KEYS)) return _MAP_FAILURE;
+
+    tree->borrow = flags;
+
+    return _MAP_SUCCESS;
+}
+
+int bt_set_epoch(BinTree *tree, EpochDomain *ebr) {
+    // Readers would race with the filter being rebuilt, or with splaying
+    if (!tree || (ebr && (tree->bloom || tree->splay))) return _MAP_FAILURE;
+
+    tree->ebr = ebr;
+
+    return _MAP_SUCCESS;
+}
+
+// Reclaim callbacks, `ctx` is the tree's allocator. Replaced values are freed
+// with _bt_data_destroy().
+void _bt_node_destroy(void *ptr, void *ctx) {
+    const Allocator *alloc = ctx;
+    bt_node *node = ptr;
 
     // Free node memory resources
-    free(node->key);
-    free(node->data);
-    free(node);
+    mem_free(alloc, node->value);
+    mem_free(alloc, node);
+}
+
+void _bt_data_destroy(void *ptr, void *ctx) {
+    mem_free(ctx, ptr);
+}
+
+// `ctx` is the tree's intern pool
+void _bt_key_release(void *ptr, void *ctx) {
+    intern_release(ctx, ptr);
 }
 
-void _bt_node_free_all(bt_node *node) {
-    // Base case
-    if (!node) return;
+/*
+ * Frees a node that has been unlinked from the tree. If readers may still be
+ * looking at it, it is retired to the tree's epoch domain instead.
+ */
+void _bt_node_free(BinTree *tree, bt_node *node) {
+    assert(node);
+
+    MAP_STAT_ADD(tree->stats, frees, BT_NODE_ALLOCS);
+    MAP_STAT_SUB(tree->stats, bytes, BT_NODE_BYTES(tree, node->keylen, node->value->size));
+
+    if (tree->ebr) {
+        if (tree->intern) ebr_retire(tree->ebr, (void *)node->key, _bt_key_release, tree->intern);
+        ebr_retire(tree->ebr, node, _bt_node_destroy, (void *)tree->alloc);
+    } else {
+        if (tree->intern) intern_release(tree->intern, node->key);
+        _bt_node_destroy(node, (void *)tree->alloc);
+    }
+}
 
-    // Recursively free children
-    _bt_node_free_all(node->left);
-    _bt_node_free_all(node->right);
+void _bt_node_free_all(BinTree *tree, bt_node *node) {
+    // Rotate left children up so the tree is freed without recursion, as
+    // splaying can leave it as deep as it is large
+    while (node) {
+        bt_node *next;
+
+        if (node->left) {
+            next = node->left;
+            node->left = next->right;
+            next->right = node;
+            node = next;
+            continue;
+        }
+        next = node->right;
 
-    // Free current node
-    _bt_node_free(node);
+        // Free current node. The whole tree is going away, so there can be no
+        // readers left to defer to.
+        if (tree->intern) intern_release(tree->intern, node->key);
+        _bt_node_destroy(node, (void *)tree->alloc);
+        node = next;
+    }
 }
 
 void bt_free(BinTree **tree) {
     if (!tree || !(*tree)) return;
 
-    // Free root if it exists
-    if ((*tree)->root) {
-        _bt_node_free_all((*tree)->root);
+    // Region memory is released by its owner all at once, so there is no
+    // need to visit every node, unless interned keys must be released
+    if ((*tree)->root && (!mem_is_region((*tree)->alloc) || (*tree)->intern)) {
+        _bt_node_free_all(*tree, (*tree)->root);
     }
 
+    if ((*tree)->bloom) free((*tree)->bloom->mem);
+    free((*tree)->bloom);
     free(*tree);
     *tree = NULL;
 }
 
+int bt_set_sampling(BinTree *tree, unsigned rate) {
+    uint64_t mask = 0;
+
+    if (!tree) return _MAP_FAILURE;
+
+    // Round the rate up to a power of 2, so sampling is a mask test
+    while (mask + 1 < rate) mask = mask * 2 + 1;
+
+    tree->sample_mask = mask;
+    tree->sampling = rate ? 1 : 0;
+
+    return _MAP_SUCCESS;
+}
+
+int bt_set_splay(BinTree *tree, int enabled) {
+    // Lookups would modify the tree under concurrent readers
+    if (!tree || (enabled && tree->ebr)) return _MAP_FAILURE;
+
+    tree->splay = enabled ? 1 : 0;
+
+    return _MAP_SUCCESS;
+}
+
+int bt_set_bloom(BinTree *tree, size_t expected, double fp_rate) {
+    bt_bloom *b, *old;
+    unsigned hashes = 0;
+
+    if (!tree) return _MAP_FAILURE;
+
+    if (!expected) {
+        // Remove the filter
+        if (tree->bloom) free(tree->bloom->mem);
+        free(tree->bloom);
+        tree->bloom = NULL;
+        return _MAP_SUCCESS;
+    }
+
+    // The filter hashes key bytes, so keys that a comparator considers equal
+    // must also be identical
+    if (!(fp_rate > 0 && fp_rate < 1) || tree->cmp || tree->ebr) return _MAP_FAILURE;
+
+    // The best number of bits per key is log2(1 / fp_rate), and the filter
+    // then takes that many bits per key over ln(2)
+    for (double p = fp_rate; p < 1 && hashes < BT_BLOOM_MAX_HASHES; p *= 2) hashes++;
+
+    b = calloc(1, sizeof(bt_bloom));
+    if (!b) return _MAP_FAILURE;
+    b->hashes = hashes;
+    b->bits_per_key = hashes / 0.6931471805599453;
+    b->expected = expected;
+
+    // Build the new filter before dropping any old one
+    old = tree->bloom;
+    tree->bloom = b;
+    if (!_bt_bloom_rebuild(tree, expected)) {
+        free(b);
+        tree->bloom = old;
+        return _MAP_FAILURE;
+    }
+    b->rebuilds = 0;
+    if (old) free(old->mem);
+    free(old);
+
+    return _MAP_SUCCESS;
+}
+
 // ================================ HEIGHT/SIZE ================================
 
 int _bt_height(bt_node *node) {
+    int left, right;
+
     if (!node) return 0;
-    return 1 + MAX(_bt_height(node->left), _bt_height(node->right));
+
+    // MAX() evaluates its arguments twice, so recurse outside of it
+    left = _bt_height(BT_LOAD(node->left));
+    right = _bt_height(BT_LOAD(node->right));
+    return 1 + MAX(left, right);
 }
 
 int bt_height(BinTree *tree) {
-    if (!tree || !tree->root) return 0;
+    if (!tree) return 0;
 
-    return _bt_height(tree->root);
+    return _bt_height(BT_LOAD(tree->root));
 }
 
 int _bt_size(bt_node *node) {
     if (!node)
         return 0;
     else
-        return 1 + _bt_size(node->left) + _bt_size(node->right);
+        return 1 + _bt_size(BT_LOAD(node->left)) + _bt_size(BT_LOAD(node->right));
 }
 
 int bt_size(BinTree *tree) {
-    if (!tree || !tree->root) return _MAP_FAILURE;
+    if (!tree) return _MAP_FAILURE;
+
+    return _bt_size(BT_LOAD(tree->root));
+}
+
+// ================================== SPLAYING =================================
+
+/*
+ * Top-down splay: walks from `root` towards `k`, rotating pairs of nodes
+ * passed in the same direction and setting the rest aside in a left tree (keys
+ * less than `k`) and a right tree (keys greater than `k`). The last node
+ * reached, which holds `k` if it is in the tree, becomes the new root with the
+ * left and right trees as its children. Every node on the path ends up about
+ * half as deep as before, so frequently used keys stay near the root.
+ *
+ * `*cmp` is set to the comparison between the new root and `k`, and `*depth`
+ * to the number of nodes compared. `root` must not be NULL.
+ */
+bt_node *_bt_splay(BinTree *tree, bt_node *root, const bt_key *k, int *cmp, size_t *depth) {
+    bt_node *t = root, *ltree = NULL, *rtree = NULL, **lhook = &ltree, **rhook = &rtree;
+    int c = _bt_cmp(tree, t, k);
+
+    _bt_reshaped(tree);
+    *depth = 1;
+    while (c) {
+        bt_node *child = c > 0 ? t->left : t->right;
+        int c2;
+
+        if (!child) break;
+        c2 = _bt_cmp(tree, child, k);
+        ++*depth;
+
+        if (c2 && (c2 > 0) == (c > 0)) {
+            // Zig-zig, rotate the child above t
+            if (c > 0) {
+                t->left = child->right;
+                child->right = t;
+            } else {
+                t->right = child->left;
+                child->left = t;
+            }
+            t = child;
+            c = c2;
+
+            child = c > 0 ? t->left : t->right;
+            if (!child) break;
+            c2 = _bt_cmp(tree, child, k);
+            ++*depth;
+        }
+
+        // Set t aside, with the keys on its side of k
+        if (c > 0) {
+            *rhook = t;
+            rhook = &t->left;
+        } else {
+            *lhook = t;
+            lhook = &t->right;
+        }
+        t = child;
+        c = c2;
+    }
+
+    // Reassemble around t
+    *lhook = t->left;
+    *rhook = t->right;
+    t->left = ltree;
+    t->right = rtree;
+
+    *cmp = c;
+    return t;
+}
+
+// bt_add() for trees in splay mode, the new or replaced entry becomes the root
+int _bt_splay_add(BinTree *tree, const bt_key *k, void *data, size_t size) {
+    bt_node *root, *n = NULL;
+    int cmp, status;
+    size_t depth;
+
+    if (!tree->root) return _bt_node_init(tree, &tree->root, k, data, size);
+
+    root = tree->root = _bt_splay(tree, tree->root, k, &cmp, &depth);
+    MAP_STATS_ONLY(tree->depth = depth);
+    if (!cmp) return _bt_replace(tree, root, data, size);
+
+    status = _bt_node_init(tree, &n, k, data, size);
+    if (!status) return status;
+
+    // The old root and the subtree on its far side from k go under the new node
+    if (cmp > 0) {
+        n->left = root->left;
+        n->right = root;
+        root->left = NULL;
+    } else {
+        n->right = root->right;
+        n->left = root;
+        root->right = NULL;
+    }
+    tree->root = n;
 
-    return _bt_size(tree->root);
+    return status;
 }
 
 // ================================= INSERTION =================================
 
-int _bt_add(bt_node *node, char *key, void *data, size_t size) {
+/*
+ * Swaps a new value record in for a node's current one, which is released
+ * once readers are done with it. Borrowed buffers belong to the caller, so
+ * only their record is freed.
+ */
+void _bt_publish(BinTree *tree, bt_node *node, bt_value *value) {
+    bt_value *old = node->value;
+
+    MAP_STAT_INC(tree->stats, mallocs);
+    MAP_STAT_INC(tree->stats, frees);
+    MAP_STAT_ADD(tree->stats, bytes, BT_VALUE_BYTES(tree, value->size));
+    MAP_STAT_SUB(tree->stats, bytes, BT_VALUE_BYTES(tree, old->size));
+    BT_STORE(node->value, value);
+
+    if (tree->ebr)
+        ebr_retire(tree->ebr, old, _bt_data_destroy, (void *)tree->alloc);
+    else
+        mem_free(tree->alloc, old);
+}
+
+// Replaces the data of an existing entry
+int _bt_replace(BinTree *tree, bt_node *node, void *data, size_t size) {
+    // The new record is published before the old one is released, so a failed
+    // allocation leaves the entry untouched and readers never see freed data.
+    bt_value *value = _bt_value_new(tree, data, size);
+
+    if (!value) return _MAP_FAILURE;
+    _bt_publish(tree, node, value);
+
+    return _MAP_SUCCESS_REPLACED;
+}
+
+int _bt_add(BinTree *tree, bt_node *node, const bt_key *k, void *data, size_t size) {
     int cmp;  // Comparison between node key and target key
 
     // Check params
-    if (!node || !key || !data) return _MAP_FAILURE;
+    if (!node || !k || !data) return _MAP_FAILURE;
 
-    assert(node->key);
-    cmp = strcmp(node->key, key);
+    MAP_STATS_ONLY(tree->depth++);
+    cmp = _bt_cmp(tree, node, k);
     if (!cmp) {
         // Entry with key already exists, replace data
-        free(node->data);
-        node->data = malloc(size);
-        if (!node->data) return _MAP_FAILURE;
-        memcpy(node->data, data, size);
-        node->size = size;
-        return _MAP_SUCCESS_REPLACED;
+        return _bt_replace(tree, node, data, size);
 
     } else if (cmp > 0) {
         // node key > target key, so go left
         if (!node->left) {
             // base case: no left subtree, create new leaf node
-            return _bt_node_init(&node->left, key, data, size);
+            return _bt_node_init(tree, &node->left, k, data, size);
         } else {
             // left subtree exists, recursively insert into it
-            return _bt_add(node->left, key, data, size);
+            return _bt_add(tree, node->left, k, data, size);
         }
 
     } else {
         // node key < target key, so go right
         if (!node->right) {
             // base case: no right subtree, create new leaf node
-            return _bt_node_init(&node->right, key, data, size);
+            return _bt_node_init(tree, &node->right, k, data, size);
         } else {
             // right subtree exists, recursively insert into it
-            return _bt_add(node->right, key, data, size);
+            return _bt_add(tree, node->right, k, data, size);
         }
     }
 }
 
-int bt_add(BinTree *tree, char *key, void *data, size_t size) {
-    if (!tree || !key || !data) return _MAP_FAILURE;
+int bt_add_bytes(BinTree *tree, const void *key, size_t keylen, void *data, size_t size) {
+    bt_key k;
+    int status;
+
+    if (!tree || (!key && keylen) || !data) return _MAP_FAILURE;
+
+    k = _bt_key(key, keylen);
+    MAP_STATS_ONLY(tree->depth = 0);
+
+    if (tree->splay) {
+        // Insert at the root
+        status = _bt_splay_add(tree, &k, data, size);
+    } else if (!tree->root) {
+        // Tree is empty, create a new root node
+        status = _bt_node_init(tree, &tree->root, &k, data, size);
+    } else {
+        // Tree is not empty, recursively insert into root node
+        status = _bt_add(tree, tree->root, &k, data, size);
+    }
 
-    // Tree is empty, create a new root node
-    if (!tree->root) {
-        return _bt_node_init(&tree->root, key, data, size);
+    MAP_STAT_INC(tree->stats, adds);
+    MAP_STAT_ADD(tree->stats, key_cmps, tree->depth);
+    MAP_STAT_ADD(tree->stats, nodes_visited, tree->depth);
+    MAP_STAT_DEPTH(tree->stats, add_depth, tree->depth);
+    if (status == _MAP_SUCCESS) {
+        MAP_STAT_ADD(tree->stats, mallocs, BT_NODE_ALLOCS);
+        MAP_STAT_ADD(tree->stats, bytes, BT_NODE_BYTES(tree, keylen, size));
     }
 
-    // Tree is not empty, recursively insert into root node
-    return _bt_add(tree->root, key, data, size);
+    return status;
 }
 
-// =================================== READ ====================================
+int bt_add(BinTree *tree, char *key, void *data, size_t size) {
+    if (!key) return _MAP_FAILURE;
 
-void *_bt_get(bt_node *node, char *key) {
-    int cmp;
+    return bt_add_bytes(tree, key, strlen(key), data, size);
+}
 
-    if (!node || !key) return NULL;
+// One entry of a batch being added, see _bt_add_many()
+typedef struct bt_batch_item {
+    bt_key k;
+    size_t index;  // position of the entry in the batch
+} bt_batch_item;
 
-    cmp = strcmp(node->key, key);
+// A link on the path to the last entry added, see _bt_add_many()
+typedef struct bt_finger {
+    bt_node **link;
+    const bt_node *upper;  // every key under link sorts before this one, NULL if unbounded
+} bt_finger;
 
-    if (!cmp) {
-        // Entry found, return data
-        return node->data;
-    } else if (cmp > 0) {
-        // node key > target key, go left
-        return _bt_get(node->left, key);
-    } else {
-        // node key < target key, go right
-        return _bt_get(node->right, key);
-    }
-}
+// Like _bt_cmp(), for two keys that are not in the tree yet
+static inline int _bt_key_cmp(const BinTree *tree, const bt_key *a, const bt_key *b) {
+    size_t min;
 
-void *bt_get(BinTree *tree, char *key) {
-    if (!tree || !key) return NULL;  // Bad parameters
-    if (!tree->root) return NULL;    // Tree is empty
+    if (tree->cmp) return tree->cmp(a->bytes, a->len, b->bytes, b->len);
 
-    return _bt_get(tree->root, key);
-}
+    if (a->prefix != b->prefix) return a->prefix < b->prefix ? -1 : 1;
 
-int bt_has(BinTree *tree, char *key) {
-    if (!tree || !key) return false;  // Bad parameters
+    min = a->len < b->len ? a->len : b->len;
+    if (min > 8) {
+        int cmp = memcmp(a->bytes + 8, b->bytes + 8, min - 8);
+        if (cmp) return cmp;
+    }
 
-    return _bt_get(tree->root, key) == NULL ? false : true;
+    return (a->len > b->len) - (a->len < b->len);
 }
 
-// ================================= DELETION ==================================
+/*
+ * Sorts a batch by key, unless it is sorted already. The sort is a stable
+ * bottom-up merge sort, so that of several entries with the same key the last
+ * one is added last and wins, as it would with a bt_add() loop.
+ */
+int _bt_batch_sort(BinTree *tree, bt_batch_item *items, size_t n) {
+    bt_batch_item *src = items, *dst;
+    size_t i;
 
-bt_node *_bt_remove(bt_node *node, char *key, int *status) {
-    int cmp;
+    for (i = 1; i < n && _bt_key_cmp(tree, &items[i - 1].k, &items[i].k) <= 0; i++);
+    if (i >= n) return _MAP_SUCCESS;
 
-    assert(key);
-    assert(status);
+    dst = malloc(n * sizeof(bt_batch_item));
+    if (!dst) return _MAP_FAILURE;
 
-    // Base case: key not found.
-    if (!node) {
-        *status = 0;
-        return NULL;
+    for (size_t width = 1; width < n; width *= 2) {
+        bt_batch_item *tmp;
+
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = MIN(lo + width, n), hi = MIN(lo + 2 * width, n), a = lo, b = mid, out = lo;
+
+            while (a < mid && b < hi) dst[out++] = _bt_key_cmp(tree, &src[b].k, &src[a].k) < 0 ? src[b++] : src[a++];
+            while (a < mid) dst[out++] = src[a++];
+            while (b < hi) dst[out++] = src[b++];
+        }
+        tmp = src;
+        src = dst;
+        dst = tmp;
     }
 
-    cmp = strcmp(node->key, key);
-    if (!cmp) {  // Base case: entry found, delete current node
-        if (_bt_node_is_leaf(node)) {
-            *status = _MAP_SUCCESS;
-            _bt_node_free(node);
-            return NULL;
+    // The sorted batch ended up in the scratch buffer
+    if (src != items) {
+        memcpy(items, src, n * sizeof(bt_batch_item));
+        dst = src;
+    }
+    free(dst);
 
-        } else if (  // Node only has 1 child;
-            (node->left && !node->right) ||
-            (node->right && !node->left)) {
-            bt_node *child = node->left ? node->left : node->right;  // Get child subtree
-            *status = _MAP_SUCCESS;
-            _bt_node_free(node);
-            return child;
-
-        } else {  // Node has two children, replace self with right child's min node
-            bt_node *right_min = _bt_min(node->right);
-            assert(right_min);
-
-            // Replace node's key with right min's key
-            size_t keylen = strlen(right_min->key);  // Free old key
-            free(node->key);
-            node->key = malloc(keylen + 1);
-            if (!node->key) return NULL;                     // TODO: What do here?
-            strncpy(node->key, right_min->key, keylen + 1);  // Copy key to node
-
-            // Replace node's value with right min's value
-            free(node->data);  // Free old data
-            node->size = right_min->size;
-            node->data = malloc(right_min->size);
-            if (!node->data) return NULL;                          // TODO: What do here?
-            memcpy(node->data, right_min->data, right_min->size);  // Copy data to node
-
-            // Remove (now duplicate) min node from right subtree
-            node->right = _bt_remove(node->right, right_min->key, status);
-            *status = 1;
-
-            return node;
+    return _MAP_SUCCESS;
+}
+
+/*
+ * Adds a sorted batch in one pass. The path to the last entry added is kept
+ * as a stack of links, each with the smallest key known to sort after its
+ * subtree. The next, larger key only climbs back up the path until it fits
+ * under a link, and descends from there. A cluster of nearby keys is thus
+ * added without going back to the root each time, and the nodes near the top
+ * of the tree are compared against once per batch instead of once per key.
+ */
+int _bt_add_many(BinTree *tree, bt_batch_item *items, size_t n, void *const *values, const size_t *sizes) {
+    bt_finger *path;
+    size_t depth = 1, cap = 64;
+    int status = _MAP_SUCCESS;
+
+    if (!_bt_batch_sort(tree, items, n)) return _MAP_FAILURE;
+
+    path = malloc(cap * sizeof(bt_finger));
+    if (!path) return _MAP_FAILURE;
+    path[0].link = &tree->root;
+    path[0].upper = NULL;
+
+    for (size_t i = 0; i < n && status; i++) {
+        const bt_key *k = &items[i].k;
+        size_t cmps = 0;
+        bt_node *node;
+
+        // Climb until the key fits under the link. Links that share a bound
+        // are passed over together.
+        while (path[depth - 1].upper) {
+            const bt_node *upper = path[depth - 1].upper;
+
+            cmps++;
+            if (_bt_cmp(tree, upper, k) > 0) break;
+            while (path[depth - 1].upper == upper) depth--;
         }
 
-    } else if (cmp > 0) {
-        // node key > target key, go left
-        node->left = _bt_remove(node->left, key, status);
-        return node;
+        // Then descend from there, extending the path
+        while ((node = *path[depth - 1].link)) {
+            int cmp = _bt_cmp(tree, node, k);
+
+            cmps++;
+            if (!cmp) break;
+
+            if (depth == cap) {
+                bt_finger *grown = realloc(path, 2 * cap * sizeof(bt_finger));
+                if (!grown) {
+                    status = _MAP_FAILURE;
+                    break;
+                }
+                path = grown;
+                cap *= 2;
+            }
+            path[depth].link = cmp > 0 ? &node->left : &node->right;
+            path[depth].upper = cmp > 0 ? node : path[depth - 1].upper;
+            depth++;
+        }
+        if (!status) break;
 
-    } else {
-        // node key < target key, go right
-        node->right = _bt_remove(node->right, key, status);
-        return node;
+        if (node) {
+            status = _bt_replace(tree, node, values[items[i].index], sizes[items[i].index]);
+        } else {
+            status = _bt_node_init(tree, path[depth - 1].link, k, values[items[i].index], sizes[items[i].index]);
+            if (status == _MAP_SUCCESS) {
+                MAP_STAT_ADD(tree->stats, mallocs, BT_NODE_ALLOCS);
+                MAP_STAT_ADD(tree->stats, bytes, BT_NODE_BYTES(tree, k->len, sizes[items[i].index]));
+            }
+        }
+
+        MAP_STAT_INC(tree->stats, adds);
+        MAP_STAT_ADD(tree->stats, key_cmps, cmps);
+        MAP_STAT_ADD(tree->stats, nodes_visited, cmps);
+        MAP_STAT_DEPTH(tree->stats, add_depth, depth - (node == NULL));
     }
+
+    free(path);
+    return status ? _MAP_SUCCESS : _MAP_FAILURE;
 }
 
-int bt_remove(BinTree *tree, char *key) {
-    int status = _MAP_FAILURE;
+int bt_add_many(BinTree *tree, char *const *keys, void *const *values, const size_t *sizes, size_t n) {
+    bt_batch_item *items;
+    int status;
 
-    if (!tree || !key) return _MAP_FAILURE;
+    if (!tree || (n && (!keys || !values || !sizes))) return _MAP_FAILURE;
+    if (!n) return _MAP_SUCCESS;
 
-    tree->root = _bt_remove(tree->root, key, &status);
+    items = malloc(n * sizeof(bt_batch_item));
+    if (!items) return _MAP_FAILURE;
+
+    for (size_t i = 0; i < n; i++) {
+        if (!keys[i] || !values[i]) {
+            free(items);
+            return _MAP_FAILURE;
+        }
+        items[i].k = _bt_key(keys[i], strlen(keys[i]));
+        items[i].index = i;
+    }
 
+    status = _bt_add_many(tree, items, n, values, sizes);
+    free(items);
     return status;
 }
 
-// ================================== MIN/MAX ==================================
+int bt_add_many_bytes(BinTree *tree, const void *const *keys, const size_t *keylens, void *const *values,
+                      const size_t *sizes, size_t n) {
+    bt_batch_item *items;
+    int status;
 
-bt_node *_bt_min(bt_node *node) {
-    if (!node) return NULL;
+    if (!tree || (n && (!keys || !keylens || !values || !sizes))) return _MAP_FAILURE;
+    if (!n) return _MAP_SUCCESS;
 
-    switch (_bt_num_children(node)) {
-        case 0:
-            return node;
-        case 1:
-            if (node->left) {
-                return _bt_min(node->left);
-            } else {
-                return node;
-            }
-        default:
-            return _bt_min(node->left);
+    items = malloc(n * sizeof(bt_batch_item));
+    if (!items) return _MAP_FAILURE;
+
+    for (size_t i = 0; i < n; i++) {
+        if ((!keys[i] && keylens[i]) || !values[i]) {
+            free(items);
+            return _MAP_FAILURE;
+        }
+        items[i].k = _bt_key(keys[i], keylens[i]);
+        items[i].index = i;
     }
+
+    status = _bt_add_many(tree, items, n, values, sizes);
+    free(items);
+    return status;
 }
 
-void *bt_min(BinTree *tree) {
-    if (!tree || !tree->root) return NULL;
+// =================================== READ ====================================
+
+bt_node *_bt_get(BinTree *tree, const bt_key *k) {
+    // The move count is read before the root, see _bt_moved()
+    uint64_t moves = __atomic_load_n(&tree->moves, __ATOMIC_ACQUIRE);
+    bt_node *node = _bt_bloom_skip(tree, k) ? NULL : BT_LOAD(tree->root);
+    size_t depth = 0;
+
+    if (node && tree->splay) {
+        // Move the entry, or its would-be neighbour, to the root
+        int cmp;
+
+        node = tree->root = _bt_splay(tree, node, k, &cmp, &depth);
+        if (cmp) node = NULL;
+    } else {
+        for (;;) {
+            while (node) {
+                int cmp = _bt_cmp(tree, node, k);
+
+                depth++;
+                if (!cmp) {
+                    // Entry found
+                    break;
+                } else if (cmp > 0) {
+                    // node key > target key, go left
+                    node = BT_LOAD(node->left);
+                } else {
+                    // node key < target key, go right
+                    node = BT_LOAD(node->right);
+                }
+            }
+
+            if (node || !_bt_moved(tree, &moves)) break;
+            node = BT_LOAD(tree->root);
+        }
+    }
 
-    bt_node *min = _bt_min(tree->root);
+    MAP_STAT_INC(tree->stats, gets);
+    MAP_STAT_ADD(tree->stats, key_cmps, depth);
+    MAP_STAT_ADD(tree->stats, nodes_visited, depth);
+    MAP_STAT_DEPTH(tree->stats, get_depth, depth);
+    if (tree->bloom && !node && depth) MAP_STAT_INC(*tree->bloom, false_positives);
+    if (node && tree->sampling) _bt_sample(tree, node);
 
-    return min->data;
+    return node;
 }
 
-bt_node *_bt_max(bt_node *node) {
+void *bt_get_bytes(BinTree *tree, const void *key, size_t keylen, size_t *size) {
+    bt_key k;
+    bt_node *node;
+
+    if (!tree || (!key && keylen)) return NULL;  // Bad parameters
+
+    k = _bt_key(key, keylen);
+    node = _bt_get(tree, &k);
     if (!node) return NULL;
 
-    switch (_bt_num_children(node)) {
-        case 0:
-            return node;
-        case 1:
-            if (node->right) {
-                return _bt_max(node->right);
-            } else {
-                return node;
-            }
-        default:
-            return _bt_max(node->right);
+    if (size) {
+        bt_value *v = BT_LOAD(node->value);
+
+        *size = v->size;
+        return v->data;
     }
+    return _bt_data(tree, node);
 }
 
-void *bt_max(BinTree *tree) {
-    if (!tree || !tree->root) return NULL;
+void *bt_get(BinTree *tree, char *key) {
+    if (!key) return NULL;  // Bad parameters
+
+    return bt_get_bytes(tree, key, strlen(key), NULL);
+}
+
+void *bt_get_with_size(BinTree *tree, char *key, size_t *size) {
+    if (!key) return NULL;  // Bad parameters
+
+    return bt_get_bytes(tree, key, strlen(key), size);
+}
+
+int bt_has_bytes(BinTree *tree, const void *key, size_t keylen) {
+    bt_key k;
+
+    if (!tree || (!key && keylen)) return false;  // Bad parameters
+
+    k = _bt_key(key, keylen);
+    return _bt_get(tree, &k) == NULL ? false : true;
+}
+
+int bt_has(BinTree *tree, char *key) {
+    if (!key) return false;  // Bad parameters
 
-    bt_node *max = _bt_max(tree->root);
+    return bt_has_bytes(tree, key, strlen(key));
+}
 
-    return max->data;
+// One lookup of a batch, see _bt_get_many()
+typedef struct bt_lookup {
+    bt_key k;
+    bt_node *node;  // next node to compare against
+    size_t index;   // position of the key in the batch
+    size_t depth;   // nodes visited so far
+    uint64_t moves; // the tree's move count when the lookup started
+} bt_lookup;
+
+void _bt_lookup_start(BinTree *tree, bt_lookup *l, const void *const *keys, const size_t *lens, size_t index) {
+    l->k = _bt_key(keys[index], lens ? lens[index] : strlen(keys[index]));
+    l->moves = __atomic_load_n(&tree->moves, __ATOMIC_ACQUIRE);
+    l->node = _bt_bloom_skip(tree, &l->k) ? NULL : BT_LOAD(tree->root);
+    l->index = index;
+    l->depth = 0;
+}
+
+/*
+ * A lone lookup stalls on every node it loads, since it needs the node to know
+ * where to go next. Here a group of lookups advances round-robin, one level at
+ * a time, and each one prefetches its next node before yielding. By the time
+ * the round comes back to it the node is usually in cache, so the misses of
+ * the whole group overlap instead of adding up. A lookup that finishes hands
+ * its slot to the next key of the batch.
+ */
+int _bt_get_many(BinTree *tree, const void *const *keys, const size_t *lens, size_t n, void **out) {
+    bt_lookup group[BT_GET_MANY_GROUP];
+    size_t active = 0, next = 0;
+    int found = 0;
+
+    while (active < BT_GET_MANY_GROUP && next < n) _bt_lookup_start(tree, &group[active++], keys, lens, next++);
+
+    while (active) {
+        for (size_t i = 0; i < active;) {
+            bt_lookup *l = &group[i];
+            bt_node *node = l->node;
+            int cmp = 1;
+
+            if (node) {
+                l->depth++;
+                cmp = _bt_cmp(tree, node, &l->k);
+                if (cmp) {
+                    l->node = cmp > 0 ? BT_LOAD(node->left) : BT_LOAD(node->right);
+                    if (l->node) {
+                        BT_PREFETCH(l->node);
+                        i++;
+                        continue;
+                    }
+                }
+            }
+
+            if (cmp && _bt_moved(tree, &l->moves)) {
+                // Start over, see _bt_get()
+                l->node = BT_LOAD(tree->root);
+                i++;
+                continue;
+            }
+
+            // Lookup is done, either found or at an empty subtree
+            out[l->index] = cmp ? NULL : _bt_data(tree, node);
+            if (!cmp && tree->sampling) _bt_sample(tree, node);
+            found += !cmp;
+            MAP_STAT_INC(tree->stats, gets);
+            MAP_STAT_ADD(tree->stats, key_cmps, l->depth);
+            MAP_STAT_ADD(tree->stats, nodes_visited, l->depth);
+            MAP_STAT_DEPTH(tree->stats, get_depth, l->depth);
+            if (tree->bloom && cmp && l->depth) MAP_STAT_INC(*tree->bloom, false_positives);
+
+            if (next < n)
+                _bt_lookup_start(tree, l, keys, lens, next++);
+            else
+                *l = group[--active];
+        }
+    }
+
+    return found;
+}
+
+int bt_get_many(BinTree *tree, char *const *keys, size_t n, void **out) {
+    if (!tree || (!keys && n) || (!out && n)) return 0;  // Bad parameters
+
+    for (size_t i = 0; i < n; i++) {
+        if (!keys[i]) return 0;
+    }
+
+    return _bt_get_many(tree, (const void *const *)keys, NULL, n, out);
+}
+
+int bt_get_many_bytes(BinTree *tree, const void *const *keys, const size_t *keylens, size_t n, void **out) {
+    if (!tree || (!keys && n) || (!keylens && n) || (!out && n)) return 0;  // Bad parameters
+
+    for (size_t i = 0; i < n; i++) {
+        if (!keys[i] && keylens[i]) return 0;
+    }
+
+    return _bt_get_many(tree, keys, keylens, n, out);
+}
+
+// ================================== UPDATE ===================================
+
+void *bt_emplace_bytes(BinTree *tree, const void *key, size_t keylen, size_t size, int *created) {
+    bt_node **link, *node;
+    bt_key k;
+    size_t depth = 0;
+
+    // Writing in place would race with epoch readers, and borrowed data
+    // isn't the tree's to hand out
+    if (!tree || (!key && keylen) || tree->ebr || !BT_DATA_OWNED(tree)) return NULL;
+
+    k = _bt_key(key, keylen);
+
+    // Find the entry, or the empty link it belongs at
+    link = &tree->root;
+    while (*link) {
+        int cmp = _bt_cmp(tree, *link, &k);
+
+        depth++;
+        if (!cmp) break;
+        link = cmp > 0 ? &(*link)->left : &(*link)->right;
+    }
+
+    MAP_STAT_INC(tree->stats, adds);
+    MAP_STAT_ADD(tree->stats, key_cmps, depth);
+    MAP_STAT_ADD(tree->stats, nodes_visited, depth);
+    MAP_STAT_DEPTH(tree->stats, add_depth, depth);
+
+    node = *link;
+    if (!node) {
+        // New entry, with zeroed data
+        if (!_bt_node_init(tree, link, &k, NULL, size)) return NULL;
+        MAP_STAT_ADD(tree->stats, mallocs, BT_NODE_ALLOCS);
+        MAP_STAT_ADD(tree->stats, bytes, BT_NODE_BYTES(tree, keylen, size));
+        if (created) *created = true;
+        return (*link)->value->data;
+    }
+
+    if (size > node->value->size) {
+        // Existing buffer is too small, grow it keeping its contents
+        size_t old_size = node->value->size;
+        bt_value *grown = mem_realloc(tree->alloc, node->value, BT_VALUE_BYTES(tree, old_size),
+                                      BT_VALUE_BYTES(tree, size));
+        if (!grown) return NULL;
+        memset(grown->buf + old_size, 0, size - old_size);
+        grown->data = grown->buf;
+        node->value = grown;
+        MAP_STAT_INC(tree->stats, mallocs);
+        MAP_STAT_INC(tree->stats, frees);
+    }
+
+    // Shrinking reuses the buffer, and so does a size that fits exactly
+    MAP_STAT_ADD(tree->stats, bytes, size);
+    MAP_STAT_SUB(tree->stats, bytes, node->value->size);
+    node->value->size = size;
+    if (created) *created = false;
+
+    return node->value->data;
+}
+
+void *bt_emplace(BinTree *tree, char *key, size_t size, int *created) {
+    if (!key) return NULL;
+
+    return bt_emplace_bytes(tree, key, strlen(key), size, created);
+}
+
+int bt_update_bytes(BinTree *tree, const void *key, size_t keylen, bt_update_fn fn, void *ctx) {
+    bt_node *node;
+    bt_key k;
+    bt_value *copy;
+
+    if (!tree || (!key && keylen) || !fn) return _MAP_FAILURE;
+
+    k = _bt_key(key, keylen);
+    node = _bt_get(tree, &k);
+    if (!node) return _MAP_FAILURE;
+
+    if (!tree->ebr) {
+        fn(node->value->data, node->value->size, ctx);
+        return _MAP_SUCCESS;
+    }
+
+    // Readers may be looking at the data, so modify a copy and publish it
+    // like a replacement
+    if (!BT_DATA_OWNED(tree)) return _MAP_FAILURE;
+    copy = _bt_value_new(tree, node->value->data, node->value->size);
+    if (!copy) return _MAP_FAILURE;
+    fn(copy->data, copy->size, ctx);
+    _bt_publish(tree, node, copy);
+
+    return _MAP_SUCCESS;
+}
+
+int bt_update(BinTree *tree, char *key, bt_update_fn fn, void *ctx) {
+    if (!key) return _MAP_FAILURE;
+
+    return bt_update_bytes(tree, key, strlen(key), fn, ctx);
+}
+
+// ================================= DELETION ==================================
+
+/*
+ * Makes a new node for the entry of `node`, sharing its key and data, so that
+ * the entry can appear in two places while it moves. Returns NULL on failure.
+ */
+bt_node *_bt_node_copy(BinTree *tree, const bt_node *node) {
+    bt_node *copy = mem_alloc(tree->alloc, sizeof(bt_node) + (BT_KEY_INLINE(tree) ? node->keylen + 1 : 0));
+
+    if (!copy) return NULL;
+
+    memcpy(copy, node, sizeof(bt_node));
+    if (BT_KEY_INLINE(tree)) {
+        memcpy(copy->buf, node->buf, node->keylen + 1);
+        copy->key = copy->buf;
+    }
+    MAP_STAT_INC(tree->stats, mallocs);
+
+    return copy;
+}
+
+/*
+ * Unlinks the node with two children at `*link`, replacing it with the
+ * smallest node of its right subtree.
+ */
+int _bt_remove_inner(BinTree *tree, bt_node **link) {
+    bt_node *node = *link, *parent = node, *right_min = node->right, *moved;
+
+    while (right_min->left) {
+        parent = right_min;
+        right_min = right_min->left;
+    }
+
+    if (parent == node) {
+        // Right min only has to take over node's left subtree. Readers that
+        // reach it before it replaces node are looking for larger keys.
+        BT_STORE(right_min->left, node->left);
+        BT_STORE(*link, right_min);
+
+    } else if (!tree->ebr) {
+        // Move right min into node's place instead of copying its entry, so
+        // no key or data is reallocated
+        parent->left = right_min->right;
+        right_min->right = node->right;
+        right_min->left = node->left;
+        *link = right_min;
+
+    } else {
+        /*
+         * Right min can't be unlinked from its parent and relinked in node's
+         * place in one step, so a copy is published in node's place first.
+         * Readers that went past node's link before that may still miss the
+         * original once it is unlinked. The move count is bumped in between,
+         * so such a reader sees it changed and retries from the root, where
+         * it finds the copy.
+         */
+        moved = _bt_node_copy(tree, right_min);
+        if (!moved) return _MAP_FAILURE;
+
+        moved->left = node->left;
+        moved->right = node->right;
+        BT_STORE(*link, moved);
+        __atomic_add_fetch(&tree->moves, 1, __ATOMIC_RELEASE);
+        BT_STORE(parent->left, right_min->right);
+
+        // The copy took over the key and data
+        MAP_STAT_INC(tree->stats, frees);
+        ebr_retire(tree->ebr, right_min, _bt_data_destroy, (void *)tree->alloc);
+    }
+
+    _bt_node_free(tree, node);
+    return _MAP_SUCCESS;
+}
+
+// Removes the entry for `k` from the subtree at `*link`
+void _bt_remove(BinTree *tree, bt_node **link, const bt_key *k, int *status) {
+    bt_node *node;
+    int cmp;
+
+    assert(k);
+    assert(status);
+
+    while ((node = *link)) {
+        MAP_STATS_ONLY(tree->depth++);
+        cmp = _bt_cmp(tree, node, k);
+        if (cmp > 0) {
+            // node key > target key, go left
+            link = &node->left;
+        } else if (cmp < 0) {
+            // node key < target key, go right
+            link = &node->right;
+        } else if (node->left && node->right) {
+            *status = _bt_remove_inner(tree, link);
+            return;
+        } else {
+            // Node has at most one child, which takes its place
+            BT_STORE(*link, node->left ? node->left : node->right);
+            *status = _MAP_SUCCESS;
+            _bt_node_free(tree, node);
+            return;
+        }
+    }
+
+    // Key not found
+    *status = _MAP_FAILURE;
+}
+
+int bt_remove_bytes(BinTree *tree, const void *key, size_t keylen) {
+    int status = _MAP_FAILURE;
+    bt_key k;
+
+    if (!tree || (!key && keylen)) return _MAP_FAILURE;
+
+    k = _bt_key(key, keylen);
+    MAP_STATS_ONLY(tree->depth = 0);
+    if (!_bt_bloom_skip(tree, &k)) {
+        _bt_remove(tree, &tree->root, &k, &status);
+        if (status) _bt_reshaped(tree);
+        if (tree->bloom && status) _bt_bloom_remove(tree);
+    }
+
+    MAP_STAT_INC(tree->stats, removes);
+    MAP_STAT_ADD(tree->stats, key_cmps, tree->depth);
+    MAP_STAT_ADD(tree->stats, nodes_visited, tree->depth);
+    MAP_STAT_DEPTH(tree->stats, remove_depth, tree->depth);
+
+    return status;
+}
+
+int bt_remove(BinTree *tree, char *key) {
+    if (!key) return _MAP_FAILURE;
+
+    return bt_remove_bytes(tree, key, strlen(key));
+}
+
+// ================================== MIN/MAX ==================================
+
+bt_node *_bt_min(bt_node *node) {
+    bt_node *left;
+
+    if (!node) return NULL;
+
+    // The smallest entry is the left-most node
+    while ((left = BT_LOAD(node->left))) node = left;
+
+    return node;
+}
+
+void *bt_min(BinTree *tree) {
+    if (!tree) return NULL;
+
+    bt_node *min = _bt_min(BT_LOAD(tree->root));
+
+    return min ? _bt_data(tree, min) : NULL;
+}
+
+bt_node *_bt_max(bt_node *node) {
+    bt_node *right;
+
+    if (!node) return NULL;
+
+    // The largest entry is the right-most node
+    while ((right = BT_LOAD(node->right))) node = right;
+
+    return node;
+}
+
+void *bt_max(BinTree *tree) {
+    if (!tree) return NULL;
+
+    bt_node *max = _bt_max(BT_LOAD(tree->root));
+
+    return max ? _bt_data(tree, max) : NULL;
+}
+
+// ================================= ITERATION =================================
+
+// Calls a visitor on a node's entry, with its data and size read together
+static inline int _bt_visit(bt_node *node, map_visit_fn fn, void *ctx) {
+    bt_value *v = BT_LOAD(node->value);
+
+    return fn(node->key, node->keylen, v->data, v->size, ctx);
+}
+
+int _bt_for_each(bt_node *node, map_visit_fn fn, void *ctx) {
+    if (!node) return _MAP_SUCCESS;
+
+    // In-order traversal
+    if (!_bt_for_each(BT_LOAD(node->left), fn, ctx)) return _MAP_FAILURE;
+    if (_bt_visit(node, fn, ctx)) return _MAP_FAILURE;
+    return _bt_for_each(BT_LOAD(node->right), fn, ctx);
+}
+
+int bt_for_each(BinTree *tree, map_visit_fn fn, void *ctx) {
+    if (!tree || !fn) return _MAP_FAILURE;
+
+    return _bt_for_each(BT_LOAD(tree->root), fn, ctx);
+}
+
+/*
+ * Compares the start of a node's key with a prefix. A key shorter than the
+ * prefix that matches as far as it goes sorts before every match.
+ */
+static inline int _bt_prefix_cmp(const bt_node *node, const char *prefix, size_t plen) {
+    int cmp = memcmp(node->key, prefix, node->keylen < plen ? node->keylen : plen);
+
+    return cmp ? cmp : (node->keylen < plen ? -1 : 0);
+}
+
+/*
+ * Keys starting with the prefix form one contiguous run in key order. A node
+ * whose key sorts before the run can only have matches in its right subtree,
+ * and one that sorts after it only in its left subtree, so apart from the
+ * matches themselves only the two paths bounding the run are visited.
+ */
+int _bt_prefix_scan(bt_node *node, const char *prefix, size_t plen, map_visit_fn fn, void *ctx) {
+    while (node) {
+        int cmp = _bt_prefix_cmp(node, prefix, plen);
+
+        if (cmp < 0) {
+            // node key < prefix, matches can only be to the right
+            node = BT_LOAD(node->right);
+        } else if (cmp > 0) {
+            // node key > prefix, matches can only be to the left
+            node = BT_LOAD(node->left);
+        } else {
+            // node key matches, so keys on either side may match too
+            if (!_bt_prefix_scan(BT_LOAD(node->left), prefix, plen, fn, ctx)) return _MAP_FAILURE;
+            if (_bt_visit(node, fn, ctx)) return _MAP_FAILURE;
+            node = BT_LOAD(node->right);
+        }
+    }
+
+    return _MAP_SUCCESS;
+}
+
+int bt_prefix_scan(BinTree *tree, const char *prefix, map_visit_fn fn, void *ctx) {
+    // Matches are only contiguous in memcmp order
+    if (!tree || tree->cmp || !prefix || !fn) return _MAP_FAILURE;
+
+    return _bt_prefix_scan(BT_LOAD(tree->root), prefix, strlen(prefix), fn, ctx);
+}
+
+int _bt_prefix_count(bt_node *node, const char *prefix, size_t plen) {
+    int count = 0;
+
+    while (node) {
+        int cmp = _bt_prefix_cmp(node, prefix, plen);
+
+        if (cmp < 0) {
+            node = BT_LOAD(node->right);
+        } else if (cmp > 0) {
+            node = BT_LOAD(node->left);
+        } else {
+            count += 1 + _bt_prefix_count(BT_LOAD(node->left), prefix, plen);
+            node = BT_LOAD(node->right);
+        }
+    }
+
+    return count;
+}
+
+int bt_prefix_count(BinTree *tree, const char *prefix) {
+    if (!tree || tree->cmp || !prefix) return 0;
+
+    return _bt_prefix_count(BT_LOAD(tree->root), prefix, strlen(prefix));
+}
+
+// ================================== PARALLEL =================================
+
+// Partial results of a reduction are this far apart, so threads updating
+// their own never share a cache line
+#define BT_PARALLEL_STRIDE(size) (((size) + 63) & ~(size_t)63)
+
+// A bt_parallel_for_each() or bt_parallel_reduce() in progress
+typedef struct bt_parallel {
+    BinTree *tree;
+    map_visit_fn visit;   // called per entry by bt_parallel_for_each()
+    bt_reduce_fn reduce;  // called per entry by bt_parallel_reduce()
+    void *ctx;            // passed to either
+    char *parts;          // one partial result per thread, for reductions
+    size_t stride;        // distance between partial results
+    int stopped;          // set once `visit` asks to stop, or on failure
+} bt_parallel;
+
+void _bt_parallel_task(PoolWorker *worker, PoolTask *task);
+
+/*
+ * Visits a subtree, in no particular order. While another thread is idle,
+ * left subtrees are handed to it instead of being walked, which balances the
+ * load whatever the shape of the tree.
+ */
+void _bt_parallel_walk(PoolWorker *worker, bt_parallel *p, bt_node *node) {
+    void *part = p->parts ? p->parts + pool_worker_index(worker) * p->stride : NULL;
+
+    while (node && !__atomic_load_n(&p->stopped, __ATOMIC_RELAXED)) {
+        bt_node *left = BT_LOAD(node->left);
+
+        if (left && pool_hungry(worker)) {
+            PoolTask task = {_bt_parallel_task, p, left, 0, 0};
+            pool_spawn(worker, &task);
+        } else if (left) {
+            _bt_parallel_walk(worker, p, left);
+        }
+
+        if (p->reduce) {
+            bt_value *v = BT_LOAD(node->value);
+
+            p->reduce(part, node->key, node->keylen, v->data, v->size, p->ctx);
+        } else if (_bt_visit(node, p->visit, p->ctx)) {
+            __atomic_store_n(&p->stopped, 1, __ATOMIC_RELAXED);
+        }
+        node = BT_LOAD(node->right);
+    }
+}
+
+void _bt_parallel_task(PoolWorker *worker, PoolTask *task) {
+    bt_parallel *p = task->ctx;
+
+    // Pool threads read under their own critical section, as any reader would
+    if (p->tree->ebr && !ebr_enter(p->tree->ebr)) {
+        __atomic_store_n(&p->stopped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    _bt_parallel_walk(worker, p, task->arg);
+    if (p->tree->ebr) ebr_exit(p->tree->ebr);
+}
+
+// Walks the whole tree on a pool of `threads`, returning 0 if it stopped early
+int _bt_parallel_run(bt_parallel *p, unsigned threads) {
+    PoolTask task = {_bt_parallel_task, p, NULL, 0, 0};
+    WorkPool *pool = NULL;
+
+    task.arg = BT_LOAD(p->tree->root);
+    if (!pool_init(&pool, threads ? threads : 1)) return _MAP_FAILURE;
+    pool_run(pool, &task);
+    pool_free(&pool);
+
+    return !p->stopped;
+}
+
+int bt_parallel_for_each(BinTree *tree, map_visit_fn fn, void *ctx, unsigned threads) {
+    bt_parallel p = {0};
+
+    if (!tree || !fn) return _MAP_FAILURE;
+
+    p.tree = tree;
+    p.visit = fn;
+    p.ctx = ctx;
+
+    return _bt_parallel_run(&p, threads);
+}
+
+int bt_parallel_reduce(BinTree *tree, bt_reduce_fn fn, pool_combine_fn combine, void *acc, size_t acc_size, void *ctx,
+                       unsigned threads) {
+    bt_parallel p = {0};
+    int status;
+
+    if (!tree || !fn || !combine || !acc || !acc_size) return _MAP_FAILURE;
+    if (!threads) threads = 1;
+
+    p.tree = tree;
+    p.reduce = fn;
+    p.ctx = ctx;
+    p.stride = BT_PARALLEL_STRIDE(acc_size);
+    p.parts = malloc(threads * p.stride);
+    if (!p.parts) return _MAP_FAILURE;
+
+    // Each thread starts from the identity in `acc`
+    for (unsigned i = 0; i < threads; i++) memcpy(p.parts + i * p.stride, acc, acc_size);
+
+    status = _bt_parallel_run(&p, threads);
+    if (status) {
+        for (unsigned i = 0; i < threads; i++) combine(acc, p.parts + i * p.stride, ctx);
+    }
+
+    free(p.parts);
+    return status;
+}
+
+// =============================== SET OPERATIONS ==============================
+
+// Which set operation a bt_set_job runs
+typedef enum { BT_UNION, BT_INTERSECT, BT_DIFFERENCE } bt_set_op;
+
+/*
+ * One recursive step of a set operation, combining the subtree `a` of the
+ * target tree with the subtree `b` of the other one. Halves may run on their
+ * own thread, so each job keeps its own count of freed entries.
+ */
+typedef struct bt_set_job {
+    BinTree *tree;     // the target tree, which owns the result
+    bt_set_op op;      // operation to run
+    bt_node *a, *b;    // subtrees of the target and the other tree
+    unsigned threads;  // threads this job may start, besides its own
+    size_t dropped;    // entries of the target freed by this job
+    bt_node *result;   // subtree replacing `a`
+} bt_set_job;
+
+// A node's own key, as if it were being searched for
+static inline bt_key _bt_node_key(const bt_node *node) {
+    bt_key k;
+
+    k.bytes = (const unsigned char *)node->key;
+    k.len = node->keylen;
+    k.prefix = node->prefix;
+
+    return k;
+}
+
+/*
+ * Splits a subtree into the keys below `k` and those above it, relinking the
+ * nodes along the search path. The node holding `k`, if any, is detached and
+ * returned. Neither half is deeper than the subtree was.
+ */
+bt_node *_bt_split(BinTree *tree, bt_node *node, const bt_key *k, bt_node **left, bt_node **right) {
+    size_t depth = 0;
+
+    while (node) {
+        int cmp = _bt_cmp(tree, node, k);
+
+        depth++;
+        if (cmp < 0) {
+            // node key < target key, so it and its left subtree go left
+            *left = node;
+            left = &node->right;
+            node = node->right;
+        } else if (cmp > 0) {
+            *right = node;
+            right = &node->left;
+            node = node->left;
+        } else {
+            *left = node->left;
+            *right = node->right;
+            node->left = node->right = NULL;
+            break;
+        }
+    }
+    if (!node) *left = *right = NULL;
+
+    MAP_STAT_ADD(tree->stats, key_cmps, depth);
+    MAP_STAT_ADD(tree->stats, nodes_visited, depth);
+    return node;
+}
+
+/*
+ * Joins two subtrees, every key of `left` being below every key of `right`.
+ * The largest node of `left` becomes the root.
+ */
+bt_node *_bt_join(bt_node *left, bt_node *right) {
+    bt_node **link = &left, *max;
+
+    if (!left) return right;
+    if (!right) return left;
+
+    while ((*link)->right) link = &(*link)->right;
+    max = *link;
+    *link = max->left;
+    max->left = left;
+    max->right = right;
+
+    return max;
+}
+
+// Frees a whole subtree, returning the number of entries freed
+size_t _bt_node_free_tree(BinTree *tree, bt_node *node) {
+    size_t count = 0;
+
+    // Rotate left children up, as _bt_node_free_all() does
+    while (node) {
+        bt_node *next;
+
+        if (node->left) {
+            next = node->left;
+            node->left = next->right;
+            next->right = node;
+            node = next;
+            continue;
+        }
+        next = node->right;
+        _bt_node_free(tree, node);
+        node = next;
+        count++;
+    }
+
+    return count;
+}
+
+void _bt_set_job(bt_set_job *job);
+
+void *_bt_set_thread(void *job) {
+    _bt_set_job(job);
+    return NULL;
+}
+
+/*
+ * Runs the jobs for both sides of a node. While the parent may start threads,
+ * the left side is handed to a new one along with half of the rest.
+ */
+void _bt_set_fork(const bt_set_job *parent, bt_set_job *left, bt_set_job *right) {
+    pthread_t thread;
+
+    left->tree = right->tree = parent->tree;
+    left->op = right->op = parent->op;
+    left->dropped = right->dropped = 0;
+    left->threads = right->threads = 0;
+
+    // Jobs with an empty side finish at once, and are not worth a thread
+    if (parent->threads && left->a && left->b) {
+        left->threads = (parent->threads - 1) / 2;
+        right->threads = parent->threads - 1 - left->threads;
+        if (!pthread_create(&thread, NULL, _bt_set_thread, left)) {
+            _bt_set_job(right);
+            pthread_join(thread, NULL);
+            return;
+        }
+
+        // Carry on in this thread, with the same budget
+        left->threads = parent->threads / 2;
+        right->threads = parent->threads - left->threads;
+    }
+
+    _bt_set_job(left);
+    _bt_set_job(right);
+}
+
+/*
+ * The join-based algorithms of Blelloch, Ferizovic and Sun ("Just Join for
+ * Parallel Ordered Sets"). Each step splits one tree around the root key of
+ * the other, recurses on both sides, and joins the results back around that
+ * node, relinking nodes without copying them. Recursion stops as soon as
+ * either side is empty, so the work is spent around the keys of the smaller
+ * tree.
+ */
+void _bt_set_job(bt_set_job *job) {
+    bt_set_job left, right;
+    bt_node *a = job->a, *b = job->b, *found;
+    bt_key k;
+
+    if (!a || !b) {
+        // Union keeps whichever side is left, difference keeps `a` as is,
+        // and intersection drops it
+        if (job->op == BT_UNION) {
+            job->result = a ? a : b;
+        } else if (job->op == BT_DIFFERENCE) {
+            job->result = a;
+        } else {
+            job->dropped += _bt_node_free_tree(job->tree, a);
+            job->result = NULL;
+        }
+        return;
+    }
+
+    if (job->op == BT_UNION) {
+        // Both trees are consumed, so the other one is split around each node
+        // of the target, whose shape is kept
+        k = _bt_node_key(a);
+        found = _bt_split(job->tree, b, &k, &left.b, &right.b);
+        if (found) {
+            // The other tree's data wins, as with bt_add()
+            bt_value *value = a->value;
+
+            a->value = found->value;
+            found->value = value;
+            _bt_node_free(job->tree, found);
+        }
+        left.a = a->left;
+        right.a = a->right;
+        _bt_set_fork(job, &left, &right);
+        a->left = left.result;
+        a->right = right.result;
+        job->result = a;
+    } else {
+        // The other tree is only read, so the target is split around each of
+        // its nodes instead
+        k = _bt_node_key(b);
+        found = _bt_split(job->tree, a, &k, &left.a, &right.a);
+        left.b = b->left;
+        right.b = b->right;
+        _bt_set_fork(job, &left, &right);
+
+        if (found && job->op == BT_INTERSECT) {
+            found->left = left.result;
+            found->right = right.result;
+            job->result = found;
+        } else {
+            if (found) {
+                _bt_node_free(job->tree, found);
+                job->dropped++;
+            }
+            job->result = _bt_join(left.result, right.result);
+        }
+    }
+    job->dropped += left.dropped + right.dropped;
+}
+
+// Runs a set operation over two whole trees, and updates the target's filter
+size_t _bt_set_run(BinTree *tree, bt_set_op op, bt_node *other) {
+    bt_set_job job;
+
+    job.tree = tree;
+    job.op = op;
+    job.a = tree->root;
+    job.b = other;
+    job.dropped = 0;
+    // Only the C heap may be freed to from several threads
+    job.threads = tree->alloc ? 0 : tree->threads - 1;
+
+    _bt_reshaped(tree);
+    _bt_set_job(&job);
+    tree->root = job.result;
+
+    if (tree->bloom && job.dropped) {
+        tree->bloom->removed += job.dropped;
+        if (tree->bloom->removed > tree->bloom->keys / 2) _bt_bloom_rebuild(tree, tree->bloom->expected);
+    }
+
+    return job.dropped;
+}
+
+int bt_set_parallel(BinTree *tree, unsigned threads) {
+    if (!tree) return _MAP_FAILURE;
+
+    tree->threads = threads ? threads : 1;
+
+    return _MAP_SUCCESS;
+}
+
+int bt_union(BinTree *tree, BinTree *other) {
+    bt_bloom *b;
+
+    // Nodes move between the trees, so their entries must be owned the same
+    // way, and readers of either tree would miss entries
+    if (!tree || !other || tree->ebr || other->ebr) return _MAP_FAILURE;
+    if (tree->alloc != other->alloc || tree->cmp != other->cmp || tree->intern != other->intern ||
+        tree->borrow != other->borrow) {
+        return _MAP_FAILURE;
+    }
+    if (tree == other || !other->root) return _MAP_SUCCESS;
+
+    // The filter takes in the other tree's keys up front. Keys in both trees
+    // are counted twice, which only makes it grow a little early.
+    if ((b = tree->bloom)) {
+        _bt_bloom_fill(b, other->root);
+        b->keys += (size_t)_bt_size(other->root);
+    }
+
+#ifdef MAP_STATS
+    MAP_STAT_ADD(tree->stats, bytes, __atomic_exchange_n(&other->stats.bytes, 0, __ATOMIC_RELAXED));
+#endif
+    _bt_set_run(tree, BT_UNION, other->root);
+    other->root = NULL;
+    _bt_reshaped(other);
+
+    if (b && b->keys > b->capacity) _bt_bloom_rebuild(tree, 2 * b->keys);
+
+    return _MAP_SUCCESS;
+}
+
+int bt_intersect(BinTree *tree, BinTree *other) {
+    // The other tree is only read, but must order keys the same way
+    if (!tree || !other || tree->ebr || tree->cmp != other->cmp) return _MAP_FAILURE;
+    if (tree == other) return _MAP_SUCCESS;
+
+    _bt_set_run(tree, BT_INTERSECT, BT_LOAD(other->root));
+
+    return _MAP_SUCCESS;
+}
+
+int bt_difference(BinTree *tree, BinTree *other) {
+    if (!tree || !other || tree->ebr || tree->cmp != other->cmp) return _MAP_FAILURE;
+
+    if (tree == other) {
+        _bt_reshaped(tree);
+        _bt_node_free_tree(tree, tree->root);
+        tree->root = NULL;
+        if (tree->bloom) _bt_bloom_rebuild(tree, tree->bloom->expected);
+        return _MAP_SUCCESS;
+    }
+
+    _bt_set_run(tree, BT_DIFFERENCE, BT_LOAD(other->root));
+
+    return _MAP_SUCCESS;
+}
+
+// =============================== OPTIMIZATION ================================
+
+/*
+ * Straightens a subtree into a "vine", a list linked through right children,
+ * by rotating every left child up. Returns the number of nodes.
+ */
+size_t _bt_vine(bt_node **link) {
+    size_t count = 0;
+
+    while (*link) {
+        bt_node *node = *link;
+
+        if (node->left) {
+            bt_node *left = node->left;
+            node->left = left->right;
+            left->right = node;
+            *link = left;
+        } else {
+            link = &node->right;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*
+ * Links nodes[lo, hi) into a subtree, picking as root the node that holds the
+ * weighted median of the range: the one where the weights before it and after
+ * it are closest to even. This is Mehlhorn's bisection rule, which keeps the
+ * expected search cost within a constant of the optimal BST's, and every node
+ * within O(log(total / weight)) of the root. `sums[i]` is the total weight of
+ * nodes[0, i).
+ */
+bt_node *_bt_weighted(bt_node **nodes, const uint64_t *sums, size_t lo, size_t hi) {
+    uint64_t half;
+    size_t a, b;
+    bt_node *root;
+
+    if (lo >= hi) return NULL;
+
+    // Find the first node whose weight reaches past the middle of the range
+    half = sums[lo] + (sums[hi] - sums[lo]) / 2;
+    a = lo;
+    b = hi - 1;
+    while (a < b) {
+        size_t mid = a + (b - a) / 2;
+        if (sums[mid + 1] <= half)
+            a = mid + 1;
+        else
+            b = mid;
+    }
+
+    root = nodes[a];
+    root->left = _bt_weighted(nodes, sums, lo, a);
+    root->right = _bt_weighted(nodes, sums, a + 1, hi);
+
+    return root;
+}
+
+int bt_optimize(BinTree *tree) {
+    bt_node **nodes, *node;
+    uint64_t *sums, hits = 0, scale;
+    size_t count, i;
+
+    // Readers would miss entries while the tree is rebuilt
+    if (!tree || tree->ebr) return _MAP_FAILURE;
+
+    _bt_reshaped(tree);
+    count = _bt_vine(&tree->root);
+    if (!count) return _MAP_SUCCESS;
+
+    nodes = malloc(count * sizeof(bt_node *));
+    sums = malloc((count + 1) * sizeof(uint64_t));
+    if (!nodes || !sums) {
+        // The vine is still a valid tree
+        free(nodes);
+        free(sums);
+        return _MAP_FAILURE;
+    }
+
+    // Every entry weighs at least 1, so keys never looked up still get a
+    // balanced subtree. Counters are halved so older traffic fades.
+    for (node = tree->root; node; node = node->right) hits += node->hits;
+    scale = hits ? MAX(1, BT_OPTIMIZE_SCALE * count / hits) : 1;
+    sums[0] = 0;
+    for (i = 0, node = tree->root; node; node = node->right, i++) {
+        nodes[i] = node;
+        sums[i + 1] = sums[i] + node->hits * scale + 1;
+        node->hits /= 2;
+    }
+
+    tree->root = _bt_weighted(nodes, sums, 0, count);
+
+    free(nodes);
+    free(sums);
+    return _MAP_SUCCESS;
+}
+
+int bt_rebalance_step(BinTree *tree, size_t budget) {
+    bt_rebuild *r;
+
+    // Readers would miss entries while nodes are rotated
+    if (!tree || tree->ebr) return _MAP_FAILURE;
+
+    r = &tree->rebalance;
+    if (r->balanced) return _MAP_SUCCESS;
+    if (!r->link) *r = (bt_rebuild){.link = &tree->root};
+
+    // Each rotation, and each step down the vine, is one unit of work
+    while (budget) {
+        bt_node *node = *r->link;
+
+        if (!r->straight) {
+            // Straighten the tree, as _bt_vine() does
+            if (node && node->left) {
+                bt_node *left = node->left;
+                node->left = left->right;
+                left->right = node;
+                *r->link = left;
+            } else if (node) {
+                r->link = &node->right;
+                r->count++;
+            } else {
+                // The first pass leaves the vine one less than a power of two
+                // long, so that the following ones halve it evenly
+                size_t full = r->count ? 1 : 0;
+                while (full && full <= (r->count - 1) / 2) full = full * 2 + 1;
+                r->pass = r->count - full;
+                r->next = full;
+                r->straight = true;
+                r->link = &tree->root;
+                continue;
+            }
+        } else if (r->pass) {
+            // Rotate every other vine node left, over its successor
+            bt_node *right = node->right;
+            node->right = right->left;
+            right->left = node;
+            *r->link = right;
+            r->link = &right->right;
+            r->pass--;
+        } else if (r->next > 1) {
+            r->next /= 2;
+            r->pass = r->next;
+            r->link = &tree->root;
+            continue;
+        } else {
+            r->link = NULL;
+            r->balanced = true;
+            return _MAP_SUCCESS;
+        }
+
+        budget--;
+    }
+
+    return BT_REBALANCE_PENDING;
+}
+
+int bt_rebalance(BinTree *tree) {
+    if (!tree) return _MAP_FAILURE;
+
+    // A partial rebuild started earlier is simply finished
+    return bt_rebalance_step(tree, BT_REBALANCE_ALL);
+}
+
+// ================================= STATISTICS ================================
+
+int bt_bloom_stats(BinTree *tree, BloomStats *out) {
+    bt_bloom *b;
+
+    if (!out) return _MAP_FAILURE;
+
+    memset(out, 0, sizeof(BloomStats));
+    if (!tree || !tree->bloom) return _MAP_FAILURE;
+    b = tree->bloom;
+
+    out->bytes = b->nblocks * BT_BLOOM_BLOCK;
+    out->capacity = b->capacity;
+    out->keys = b->keys;
+    out->hashes = b->hashes;
+    out->rebuilds = b->rebuilds;
+#ifdef MAP_STATS
+    out->checks = __atomic_load_n(&b->checks, __ATOMIC_RELAXED);
+    out->negatives = __atomic_load_n(&b->negatives, __ATOMIC_RELAXED);
+    out->false_positives = __atomic_load_n(&b->false_positives, __ATOMIC_RELAXED);
+#endif
+
+    return _MAP_SUCCESS;
+}
+
+int bt_stats(BinTree *tree, MapStats *out) {
+    if (!out) return _MAP_FAILURE;
+
+    memset(out, 0, sizeof(MapStats));
+    if (!tree) return _MAP_FAILURE;
+
+#ifdef MAP_STATS
+    map_stats_load(out, &tree->stats);
+    return _MAP_SUCCESS;
+#else
+    return _MAP_FAILURE;
+#endif
 }
@@ -14,12 +14,22 @@
  * Note that this tree is only able to store one entry per unique key. Inserting
  * with a duplicate key will cause the existing entry to be overwritten.
  * Keys are compared using `strcmp`.
+ *
+ * Keys may also be arbitrary byte strings, such as UUIDs or packed integers,
+ * through the `_bytes` variants of each function. These keys carry their own
+ * length and may contain null bytes. They are ordered by `memcmp`, with a key
+ * sorting before any longer key it is a prefix of, which for strings is the
+ * same order as `strcmp`. Both kinds of key can be mixed in one tree.
  */
 #ifndef __BINTREE_H__
 #define __BINTREE_H__
 
 #include <stdlib.h>
 
+#include "../util/epoch.h"
+#include "../util/pool.h"
+#include "allocator.h"
+#include "intern.h"
 #include "map.h"
 
 /**
@@ -37,10 +47,38 @@
  * pointers long-term is ill-advised. Prefer entry retrieval (`bt_get`) over
  * pointer storage.
  *
+ * BinTrees are not thread-safe. However, a tree attached to an EpochDomain
+ * with `bt_set_epoch()` may be read by any number of threads while a single
+ * thread (or several serialized by a lock) writes to it. See `bt_set_epoch()`.
+ *
  * @ingroup bt
  */
 typedef struct bt_bintree BinTree;
 
+/**
+ * @brief Orders the keys of a BinTree constructed with `bt_init_with_cmp()`.
+ *
+ * Keys are passed as they were given to the `_bytes` functions, or without
+ * their null terminator if they were given as strings.
+ *
+ * @ingroup bt
+ *
+ * @return int Less than, equal to, or greater than 0 if `a` sorts before, the
+ * same as, or after `b`.
+ */
+typedef int (*bt_cmp_fn)(const void *a, size_t alen, const void *b, size_t blen);
+
+/**
+ * @brief Modifies an entry's data in place, see `bt_update()`.
+ *
+ * @ingroup bt
+ *
+ * @param data The entry data to modify.
+ * @param size The size of `data`.
+ * @param ctx  The context pointer passed to `bt_update()`.
+ */
+typedef void (*bt_update_fn)(void *data, size_t size, void *ctx);
+
 /**
  * @brief Constructs a new BinTree.
  *
@@ -52,6 +90,320 @@ typedef struct bt_bintree BinTree;
  */
 int bt_init(BinTree **tree);
 
+/**
+ * @brief Constructs a new BinTree whose nodes, keys and data are allocated
+ * through `alloc`.
+ *
+ * If `alloc` is a region (such as `arena_allocator()`), `bt_free()` does not
+ * visit the tree's nodes and the memory is only released when the region is,
+ * e.g. by `arena_reset()`. Throwing away such a tree therefore costs O(1).
+ *
+ * `alloc` must outlive the tree, as well as any of its entries still waiting
+ * in an attached EpochDomain.
+ *
+ * @ingroup bt
+ *
+ * @param tree  A pointer to the tree to construct.
+ * @param alloc The allocator to use, or `NULL` for the C heap.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_init_with_allocator(BinTree **tree, const Allocator *alloc);
+
+/**
+ * @brief Constructs a new BinTree that orders its keys with `cmp`.
+ *
+ * This lets a tree be keyed by anything that can be passed to the `_bytes`
+ * functions, such as integers or structs, in the order that suits them.
+ * `bt_for_each()` visits entries in `cmp` order, while `bt_prefix_scan()` and
+ * `bt_prefix_count()` fail, since matches need not be contiguous.
+ *
+ * Calling `cmp` through a pointer costs more than the default comparison. For
+ * 64-bit integer keys, prefer a U64Tree (`u64tree.h`), which inlines it.
+ *
+ * @ingroup bt
+ *
+ * @param tree A pointer to the tree to construct.
+ * @param cmp  The key order.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_init_with_cmp(BinTree **tree, bt_cmp_fn cmp);
+
+/**
+ * @brief Makes a BinTree store interned keys from `pool` instead of private
+ * copies.
+ *
+ * Each entry then holds a reference to the pool's copy of its key, which is
+ * released when the entry is removed. Trees that share a pool share the memory
+ * of their common keys, and lookups with an interned key (as returned by
+ * `intern_acquire()`, with its `intern_len()`) recognize the matching entry by
+ * pointer without comparing its bytes. Other keys are compared as usual.
+ *
+ * The pool can only be set while the tree is empty, and must outlive the tree
+ * as well as any of its entries still waiting in an attached EpochDomain.
+ *
+ * @ingroup bt
+ *
+ * @param tree The target tree.
+ * @param pool The pool to intern keys in, or `NULL` to copy keys.
+ *
+ * @return int 1 on success, 0 on failure or if the tree is not empty.
+ */
+int bt_set_intern_pool(BinTree *tree, InternPool *pool);
+
+/**
+ * @brief Flag for `bt_set_borrowed()`: the tree stores pointers to the keys it
+ * is given instead of copying them.
+ *
+ * @ingroup bt
+ */
+#define BT_BORROW_KEYS 0x1
+
+/**
+ * @brief Flag for `bt_set_borrowed()`: the tree stores pointers to the data it
+ * is given instead of copying it.
+ *
+ * @ingroup bt
+ */
+#define BT_BORROW_DATA 0x2
+
+/**
+ * @brief Makes a BinTree point into caller-owned memory instead of copying
+ * entry keys, data, or both.
+ *
+ * This suits trees that index a buffer that outlives them, such as a
+ * memory-mapped file: each entry then costs a node and a small record holding
+ * the data pointer and size, and none of the buffer's bytes. The tree never frees borrowed memory.
+ *
+ * Borrowed memory must stay valid and unchanged while the tree, or an attached
+ * EpochDomain, may still read it. A borrowed key is the one passed when its
+ * entry was first added; replacing the entry keeps the original key pointer.
+ * Replacing an entry with borrowed data just points it at the new data.
+ *
+ * Ownership can only be set while the tree is empty. Keys can't be both
+ * borrowed and interned (see `bt_set_intern_pool()`).
+ *
+ * @ingroup bt
+ *
+ * @param tree  The target tree.
+ * @param flags A combination of `BT_BORROW_KEYS` and `BT_BORROW_DATA`, or 0 for
+ * the tree to copy everything.
+ *
+ * @return int 1 on success, 0 on failure or if the tree is not empty.
+ */
+int bt_set_borrowed(BinTree *tree, int flags);
+
+/**
+ * @brief Attaches an EpochDomain to a BinTree, enabling lock-free readers.
+ *
+ * While a domain is attached, entries that are removed or replaced are
+ * retired to the domain instead of being freed immediately. Readers that call
+ * `bt_get()`, `bt_has()`, `bt_min()` or `bt_max()` between `ebr_enter()` and
+ * `ebr_exit()` may then keep using the returned data pointer until they call
+ * `ebr_exit()`, even while another thread writes to the tree. The size that
+ * `bt_get_bytes()` reports is always that of the buffer it returns. Writers
+ * must still be serialized with each other.
+ *
+ * Removing an entry may move another one within the tree. The moved entry is
+ * published in its new place before it leaves the old one, and lookups that
+ * miss while it moves retry from the root, so they always find it.
+ *
+ * `bt_free()` frees all entries immediately, so no readers may be active when
+ * it is called.
+ *
+ * @ingroup bt
+ *
+ * @param tree The target tree.
+ * @param ebr  The domain readers of this tree use, or `NULL` to detach.
+ *
+ * @return int 1 on success, 0 on failure or if the tree has a Bloom filter or
+ * is in splay mode.
+ */
+int bt_set_epoch(BinTree *tree, EpochDomain *ebr);
+
+/**
+ * @brief Makes a BinTree adjust its shape to the keys being used.
+ *
+ * In splay mode, `bt_get()`, `bt_has()` and `bt_add()` (and their variants)
+ * move the entry they access to the root of the tree, halving the depth of
+ * the nodes on the way there. Keys that are used often thus stay near the root
+ * and are found after a few comparisons, however large the tree, which suits
+ * skewed workloads where a small set of keys takes most of the traffic. On
+ * uniform workloads the extra writes make lookups slower.
+ *
+ * Since lookups modify the tree, a tree in splay mode can't be read by
+ * several threads at once, and can't have an EpochDomain. Splay mode is off
+ * by default, and can be switched on or off at any time.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The target tree.
+ * @param enabled 1 to splay on access, 0 for plain lookups.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_set_splay(BinTree *tree, int enabled);
+
+/**
+ * @brief Makes a BinTree count how often each entry is looked up.
+ *
+ * One in every `rate` successful lookups (rounded up to a power of 2) is
+ * counted towards the entry it found, which keeps the overhead low while still
+ * tracking which keys are popular. The counts are used by `bt_optimize()`.
+ *
+ * @ingroup bt
+ *
+ * @param tree The target tree.
+ * @param rate Count one in this many lookups, or 0 to stop counting. Counts
+ * gathered so far are kept.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_set_sampling(BinTree *tree, unsigned rate);
+
+/**
+ * @brief Rebuilds a BinTree around its most used entries.
+ *
+ * The tree is reshaped into a near-optimal BST for the lookups counted since
+ * `bt_set_sampling()` was called: popular keys move near the root, and the
+ * expected number of comparisons per lookup is within a small constant of the
+ * best any BST could do for the same traffic. Entries that were never counted
+ * are kept balanced among themselves. Counts are halved afterwards, so a
+ * later call gives more weight to recent traffic.
+ *
+ * Nodes are only relinked, never copied, so pointers to entry data stay valid.
+ * This takes O(n) time and memory for two arrays of n entries, and suits maps
+ * that are read far more than they are modified. A tree that was never
+ * sampled is simply balanced.
+ *
+ * Readers would miss entries while the tree is rebuilt, so a tree with an
+ * EpochDomain can't be optimized.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to rebuild.
+ *
+ * @return int 1 on success, 0 on failure. On failure the tree keeps all of its
+ * entries, but may be left unbalanced.
+ */
+int bt_optimize(BinTree *tree);
+
+/**
+ * @brief Returned by `bt_rebalance_step()` while a rebalance is unfinished.
+ *
+ * @ingroup bt
+ */
+#define BT_REBALANCE_PENDING 3
+
+/**
+ * @brief Rebuilds a BinTree into a complete binary tree.
+ *
+ * Uses the Day-Stout-Warren algorithm: the tree is straightened into a sorted
+ * list by right rotations, then folded back by passes of left rotations. It
+ * runs in place in O(n) time, allocating nothing, and leaves a height of
+ * floor(log2(n)) + 1. Nodes are only relinked, so pointers to entry data stay
+ * valid. Any rebuild left unfinished by `bt_rebalance_step()` is completed.
+ *
+ * Rotations would hide entries from concurrent readers, so a tree with an
+ * EpochDomain can't be rebalanced.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to rebuild.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_rebalance(BinTree *tree);
+
+/**
+ * @brief Does a bounded part of the work of `bt_rebalance()`.
+ *
+ * Each call performs at most `budget` rotations or steps along the tree and
+ * saves its position, so a rebuild can be spread over idle moments without a
+ * pause proportional to the tree's size. A full rebuild of n entries takes
+ * about 3n units. Once the tree is balanced, further calls return at once
+ * until it changes again.
+ *
+ * Lookups stay correct between steps, but get slower until the rebuild ends:
+ * the first half of the work lines the tree up into a list. Adding or
+ * removing an entry, or a lookup in a splaying tree (see `bt_set_splay()`),
+ * discards the saved position, and the next step starts over.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to rebuild.
+ * @param budget Most units of work to do in this call.
+ *
+ * @return int 1 if the tree is balanced, `BT_REBALANCE_PENDING` if more steps
+ * are needed, 0 on failure.
+ */
+int bt_rebalance_step(BinTree *tree, size_t budget);
+
+/**
+ * @brief The state of a BinTree's Bloom filter, see `bt_set_bloom()`.
+ *
+ * The lookup counters are only kept when the tree is compiled with
+ * `MAP_STATS` defined (`make STATS=1`), and are 0 otherwise.
+ *
+ * @ingroup bt
+ */
+typedef struct bloom_stats {
+    size_t bytes;              // memory held by the filter's bits
+    size_t capacity;           // number of keys the filter is sized for
+    size_t keys;               // keys added since the last rebuild, including removed ones
+    unsigned hashes;           // bits set per key
+    uint64_t rebuilds;         // times the filter was rebuilt to grow or drop removed keys
+    uint64_t checks;           // lookups that consulted the filter
+    uint64_t negatives;        // lookups answered by the filter alone
+    uint64_t false_positives;  // lookups the filter let through that missed
+} BloomStats;
+
+/**
+ * @brief Puts a Bloom filter in front of a BinTree's lookups.
+ *
+ * A lookup of a missing key normally descends the whole height of the tree.
+ * With a filter, most such lookups are answered after probing a single cache
+ * line instead, while lookups of present keys pay one extra probe. This pays
+ * off when most lookups miss.
+ *
+ * The filter is kept up to date by insertions. Removed keys can't be taken
+ * out of it, so it is rebuilt from the tree once half of the keys it holds are
+ * gone; it is also rebuilt twice as large when it holds more keys than it was
+ * sized for. Both cost a walk over the whole tree.
+ *
+ * `bt_get()`, `bt_has()`, `bt_get_many()` and `bt_remove()`, and their `_bytes`
+ * variants, consult the filter. It needs about `1.44 * log2(1 / fp_rate)` bits
+ * per key, e.g. 10 bits per key for a 1% false positive rate.
+ *
+ * Filters hash key bytes, so they can't be used with a custom comparator. They
+ * can't be used with an EpochDomain either, as readers would race with
+ * rebuilds.
+ *
+ * @ingroup bt
+ *
+ * @param tree     The target tree.
+ * @param expected The number of keys to size the filter for, or 0 to remove
+ * the filter.
+ * @param fp_rate  The rate of false positives to size the filter for, between 0
+ * and 1 exclusive.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_set_bloom(BinTree *tree, size_t expected, double fp_rate);
+
+/**
+ * @brief Reads the state of a BinTree's Bloom filter.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to read the filter of.
+ * @param out  Set to the filter's state. Zeroed if the tree has no filter.
+ *
+ * @return int 1 on success, 0 if the tree has no filter or on failure.
+ */
+int bt_bloom_stats(BinTree *tree, BloomStats *out);
+
 /**
  * @brief Destroys an existing Bintree and frees all resources associated with it.
  *
@@ -133,6 +485,67 @@ void *bt_max(BinTree *tree);
  */
 int bt_add(BinTree *tree, char *key, void *data, size_t size);
 
+/**
+ * @brief Inserts an entry under a binary key.
+ *
+ * Behaves like `bt_add()`, except that the key is `keylen` bytes long and may
+ * contain null bytes. A string key is equivalent to the binary key made of its
+ * characters, without the null terminator.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The BST to insert into.
+ * @param key    The entry key.
+ * @param keylen The length of `key` in bytes. `key` may be `NULL` if this is 0.
+ * @param data   The data stored in the entry.
+ * @param size   The size of `data`
+ *
+ * @return int A positive number on success, 0 on failure. If an existing entry
+ * is replaced, 2 is returned.
+ */
+int bt_add_bytes(BinTree *tree, const void *key, size_t keylen, void *data, size_t size);
+
+/**
+ * @brief Inserts a batch of entries.
+ *
+ * Equivalent to calling `bt_add()` for each entry in order, so that of several
+ * entries with the same key the last one wins. The batch is sorted by key
+ * first, unless it already is, and then merged into the tree in a single
+ * pass: each entry is placed starting from where the previous one went, rather
+ * than from the root. Batches of clustered keys are added at a fraction of the
+ * cost of the loop.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The BST to insert into.
+ * @param keys   The entry keys.
+ * @param values The data stored in each entry.
+ * @param sizes  The size of each entry's data.
+ * @param n      The number of entries.
+ *
+ * @return int 1 on success, 0 on failure. Nothing is inserted if a key or value
+ * is `NULL`. If memory runs out midway, some of the entries may have been
+ * inserted.
+ */
+int bt_add_many(BinTree *tree, char *const *keys, void *const *values, const size_t *sizes, size_t n);
+
+/**
+ * @brief Inserts a batch of entries under binary keys. See `bt_add_many()`.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The BST to insert into.
+ * @param keys    The entry keys.
+ * @param keylens The length of each key in bytes.
+ * @param values  The data stored in each entry.
+ * @param sizes   The size of each entry's data.
+ * @param n       The number of entries.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_add_many_bytes(BinTree *tree, const void *const *keys, const size_t *keylens, void *const *values,
+                      const size_t *sizes, size_t n);
+
 /**
  * @brief Searches the BinTree for an entry.
  *
@@ -153,6 +566,119 @@ int bt_add(BinTree *tree, char *key, void *data, size_t size);
  */
 void *bt_get(BinTree *tree, char *key);
 
+/**
+ * @brief Searches the BinTree for an entry and reports the size of its data.
+ *
+ * The same lifetime rules as `bt_get()` apply to the returned pointer.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to search.
+ * @param key  The key the entry is stored under.
+ * @param size Set to the size of the entry's data if the entry exists. May be
+ * `NULL`.
+ *
+ * @return void* A pointer to the data stored in the entry, or `NULL` if no
+ * entry exists for the given key.
+ */
+void *bt_get_with_size(BinTree *tree, char *key, size_t *size);
+
+/**
+ * @brief Searches the BinTree for an entry under a binary key.
+ *
+ * The same lifetime rules as `bt_get()` apply to the returned pointer.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The tree to search.
+ * @param key    The key the entry is stored under.
+ * @param keylen The length of `key` in bytes.
+ * @param size   Set to the size of the entry's data if the entry exists. May be
+ * `NULL`.
+ *
+ * @return void* A pointer to the data stored in the entry, or `NULL` if no
+ * entry exists for the given key.
+ */
+void *bt_get_bytes(BinTree *tree, const void *key, size_t keylen, size_t *size);
+
+/**
+ * @brief Finds or creates the entry under `key`, and returns its data for the
+ * caller to fill in.
+ *
+ * Unlike a `bt_get()` followed by a `bt_add()`, this descends the tree once
+ * and copies nothing. A new entry gets `size` zeroed bytes. An existing entry
+ * keeps its contents, and its buffer is reused when `size` fits in it;
+ * otherwise it grows, with the added bytes zeroed.
+ *
+ * The same lifetime rules as `bt_get()` apply to the returned pointer. Not
+ * available while an EpochDomain is attached, since readers could see the
+ * data mid-write (use `bt_update()` instead), or when data is borrowed.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The tree to insert into.
+ * @param key     The entry key.
+ * @param size    The size of the entry's data.
+ * @param created Set to 1 if the entry was created, 0 if it existed. May be
+ * `NULL`.
+ *
+ * @return void* The entry's `size` bytes of data, or `NULL` on failure.
+ */
+void *bt_emplace(BinTree *tree, char *key, size_t size, int *created);
+
+/**
+ * @brief Finds or creates the entry under a binary key, and returns its data
+ * for the caller to fill in. See `bt_emplace()`.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The tree to insert into.
+ * @param key     The entry key.
+ * @param keylen  The length of `key` in bytes.
+ * @param size    The size of the entry's data.
+ * @param created Set to 1 if the entry was created, 0 if it existed. May be
+ * `NULL`.
+ *
+ * @return void* The entry's `size` bytes of data, or `NULL` on failure.
+ */
+void *bt_emplace_bytes(BinTree *tree, const void *key, size_t keylen, size_t size, int *created);
+
+/**
+ * @brief Modifies the data of an existing entry with `fn`.
+ *
+ * The entry is found with a single descent, and `fn` is handed its data to
+ * modify in place. If an EpochDomain is attached, `fn` modifies a copy
+ * instead, which then replaces the entry's data so readers never see a
+ * partial update. Trees with borrowed data can't be updated that way, so this
+ * fails for them while an EpochDomain is attached.
+ *
+ * @ingroup bt
+ *
+ * @param tree The target tree.
+ * @param key  The entry key.
+ * @param fn   Called once with the entry's data.
+ * @param ctx  Passed to `fn`.
+ *
+ * @return int 1 if the entry was updated, 0 if it does not exist or on failure.
+ */
+int bt_update(BinTree *tree, char *key, bt_update_fn fn, void *ctx);
+
+/**
+ * @brief Modifies the data of the entry under a binary key with `fn`. See
+ * `bt_update()`.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The target tree.
+ * @param key    The entry key.
+ * @param keylen The length of `key` in bytes.
+ * @param fn     Called once with the entry's data.
+ * @param ctx    Passed to `fn`.
+ *
+ * @return int 1 if the entry was updated, 0 if it does not exist or on failure.
+ */
+int bt_update_bytes(BinTree *tree, const void *key, size_t keylen, bt_update_fn fn, void *ctx);
+
 // void *bt_get_min(BinTree *tree);
 // void *bt_get_max(BinTree *tree);
 
@@ -168,6 +694,60 @@ void *bt_get(BinTree *tree, char *key);
  */
 int bt_has(BinTree *tree, char *key);
 
+/**
+ * @brief Checks if an entry exists under a binary key.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The tree to search.
+ * @param key    The entry key to check.
+ * @param keylen The length of `key` in bytes.
+ *
+ * @return int 1 if an entry exists for `key`, 0 if one does not.
+ */
+int bt_has_bytes(BinTree *tree, const void *key, size_t keylen);
+
+/**
+ * @brief Looks up a batch of keys at once.
+ *
+ * Equivalent to calling `bt_get()` for each key, but faster on trees too large
+ * for the CPU caches: several lookups descend the tree together, and each
+ * prefetches its next node while the others are compared, so their cache
+ * misses overlap instead of being paid one after another. Batches of a few
+ * dozen keys or more benefit most.
+ *
+ * The same lifetime rules as `bt_get()` apply to the returned pointers.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to search.
+ * @param keys The keys to look up.
+ * @param n    The number of keys.
+ * @param out  Receives, at the same index as its key, a pointer to each entry's
+ * data or `NULL` if there is no entry for the key. Must hold `n` pointers.
+ *
+ * @return int The number of keys that were found. 0 on failure, in which case
+ * `out` is not written to.
+ */
+int bt_get_many(BinTree *tree, char *const *keys, size_t n, void **out);
+
+/**
+ * @brief Looks up a batch of binary keys at once. See `bt_get_many()`.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The tree to search.
+ * @param keys    The keys to look up.
+ * @param keylens The length of each key in bytes.
+ * @param n       The number of keys.
+ * @param out     Receives a pointer to each entry's data, or `NULL`. Must hold
+ * `n` pointers.
+ *
+ * @return int The number of keys that were found. 0 on failure, in which case
+ * `out` is not written to.
+ */
+int bt_get_many_bytes(BinTree *tree, const void *const *keys, const size_t *keylens, size_t n, void **out);
+
 /**
  * @brief Removes an entry from a BinTree, freeing its memory resources.
  *
@@ -181,4 +761,243 @@ int bt_has(BinTree *tree, char *key);
  * is set.
  */
 int bt_remove(BinTree *tree, char *key);
+
+/**
+ * @brief Removes the entry under a binary key, freeing its memory resources.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The tree to remove the entry from.
+ * @param key    The entry key.
+ * @param keylen The length of `key` in bytes.
+ *
+ * @return int 1 if the entry existed and was removed, 0 otherwise.
+ */
+int bt_remove_bytes(BinTree *tree, const void *key, size_t keylen);
+
+/**
+ * @brief Visits every entry of a BinTree in key order.
+ *
+ * The tree must not be modified during iteration, except by writers to a tree
+ * with an attached EpochDomain (see `bt_set_epoch()`).
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to iterate over.
+ * @param fn   Called once per entry. Returning non-zero stops the iteration.
+ * @param ctx  Passed to `fn`.
+ *
+ * @return int 1 if every entry was visited, 0 if `fn` stopped the iteration or
+ * on failure.
+ */
+int bt_for_each(BinTree *tree, map_visit_fn fn, void *ctx);
+
+/**
+ * @brief Folds one entry into a partial result, see `bt_parallel_reduce()`.
+ *
+ * @ingroup bt
+ *
+ * @param acc    The partial result of the calling thread.
+ * @param key    The entry key.
+ * @param keylen The length of `key` in bytes.
+ * @param data   The entry data.
+ * @param size   The size of `data`.
+ * @param ctx    The context pointer given to `bt_parallel_reduce()`.
+ */
+typedef void (*bt_reduce_fn)(void *acc, const char *key, size_t keylen, void *data, size_t size, void *ctx);
+
+/**
+ * @brief Visits every entry of a BinTree on several threads.
+ *
+ * The walk runs on a WorkPool (see `pool.h`) started for the call. Each thread
+ * walks a subtree, and hands the left subtrees it reaches to other threads
+ * while any of them is idle, so the load stays even however unbalanced the
+ * tree is. Entries are visited in no particular order, and `fn` runs on
+ * several threads at once.
+ *
+ * Starting the threads costs tens of microseconds, so this pays off for trees
+ * of many thousands of entries, or for costly visits. As with `bt_for_each()`,
+ * only writers to a tree with an EpochDomain may modify it meanwhile; the
+ * pool's threads then read from inside their own critical sections.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The tree to iterate over.
+ * @param fn      Called once per entry. Returning non-zero stops the
+ * iteration, though entries being visited by other threads still finish.
+ * @param ctx     Passed to `fn`.
+ * @param threads Number of threads to use, including the calling one.
+ *
+ * @return int 1 if every entry was visited, 0 if `fn` stopped the iteration or
+ * on failure.
+ */
+int bt_parallel_for_each(BinTree *tree, map_visit_fn fn, void *ctx, unsigned threads);
+
+/**
+ * @brief Folds every entry of a BinTree into one result, on several threads.
+ *
+ * Walks the tree as `bt_parallel_for_each()` does. Each thread folds the
+ * entries it visits into its own copy of `acc`, without any locking, and the
+ * copies are merged into `acc` with `combine` at the end. For example, a sum
+ * starts from 0 and `combine` adds, and a histogram starts from zeroed bins
+ * and `combine` adds them bin by bin.
+ *
+ * @ingroup bt
+ *
+ * @param tree     The tree to reduce.
+ * @param fn       Folds one entry into a partial result.
+ * @param combine  Merges one partial result into another. It must be
+ * associative and commutative.
+ * @param acc      Holds the identity of `combine` on entry, such as 0 for a
+ * sum, and the result on success.
+ * @param acc_size The size of the result.
+ * @param ctx      Passed to `fn` and `combine`.
+ * @param threads  Number of threads to use, including the calling one.
+ *
+ * @return int 1 on success, 0 on failure, in which case `acc` doesn't change.
+ */
+int bt_parallel_reduce(BinTree *tree, bt_reduce_fn fn, pool_combine_fn combine, void *acc, size_t acc_size, void *ctx,
+                       unsigned threads);
+
+/**
+ * @brief Visits every entry whose key starts with `prefix`, in key order.
+ *
+ * Subtrees that cannot contain a matching key are skipped, so on a balanced
+ * tree the cost is O(log n + k) for k matching entries. This is much cheaper
+ * than filtering the output of `bt_for_each()`.
+ *
+ * Readers of a tree with an attached EpochDomain may scan from inside an
+ * `ebr_enter()`/`ebr_exit()` section. As with lookups, an entry that a
+ * concurrent removal moves within the tree may be missed or visited twice.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The tree to search.
+ * @param prefix The key prefix. An empty prefix matches every entry.
+ * @param fn     Called once per matching entry. Returning non-zero stops the
+ * iteration.
+ * @param ctx    Passed to `fn`.
+ *
+ * @return int 1 if every matching entry was visited, 0 if `fn` stopped the
+ * iteration or on failure.
+ */
+int bt_prefix_scan(BinTree *tree, const char *prefix, map_visit_fn fn, void *ctx);
+
+/**
+ * @brief Counts the entries whose key starts with `prefix`.
+ *
+ * Costs the same as `bt_prefix_scan()`.
+ *
+ * @ingroup bt
+ *
+ * @param tree   The tree to search.
+ * @param prefix The key prefix. An empty prefix matches every entry.
+ *
+ * @return int The number of matching entries, or 0 on failure.
+ */
+int bt_prefix_count(BinTree *tree, const char *prefix);
+
+/**
+ * @brief Lets set operations on a BinTree run on several threads.
+ *
+ * `bt_union()`, `bt_intersect()` and `bt_difference()` split their work in
+ * two at every node they visit. With more than one thread, the top levels of
+ * that recursion hand one half to a new thread, until `threads` are running.
+ * Starting a thread costs tens of microseconds, so this only pays off when
+ * both trees hold something like 100K entries or more.
+ *
+ * Freed entries go back to the tree's allocator from several threads at once,
+ * so a tree with an Allocator (see `bt_init_with_allocator()`) always runs
+ * set operations on the calling thread.
+ *
+ * @ingroup bt
+ *
+ * @param tree    The target tree.
+ * @param threads Most threads a set operation may use, including the calling
+ * one. 0 or 1 runs set operations on the calling thread only, the default.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bt_set_parallel(BinTree *tree, unsigned threads);
+
+/**
+ * @brief Moves every entry of `other` into `tree`.
+ *
+ * Entries of `other` whose key is also in `tree` replace the entry of `tree`,
+ * as `bt_add()` would. `other` is left empty, but is still to be freed with
+ * `bt_free()`.
+ *
+ * Nodes are moved rather than copied: `other` is split around each node of
+ * `tree` that its keys reach, and the pieces are linked in below that node.
+ * Recursion stops wherever either side runs out of keys, so merging m entries
+ * into a balanced tree of n takes O(m log(n / m + 1)) comparisons,
+ * against O(m log n) comparisons, allocations and key copies for calling
+ * `bt_add()` m times. Pointers to the data of `other` stay valid. The result
+ * may be as deep as both trees together; see `bt_rebalance()`.
+ *
+ * Both trees must own their keys and data the same way, with the same
+ * allocator, comparator and Intern Pool. Neither may have an EpochDomain, as
+ * their readers would miss entries.
+ *
+ * @ingroup bt
+ *
+ * @param tree  The tree to merge into.
+ * @param other The tree to take entries from.
+ *
+ * @return int 1 on success, 0 on failure, in which case neither tree changes.
+ */
+int bt_union(BinTree *tree, BinTree *other);
+
+/**
+ * @brief Removes every entry of `tree` whose key is not in `other`.
+ *
+ * `tree` is split around each key of `other`, recursing into both sides until
+ * either runs out of keys, and the remaining pieces are joined back together.
+ * No entry is allocated or copied. `other` is only read, and may use a
+ * different allocator, Intern Pool or EpochDomain, but must order keys the
+ * same way.
+ *
+ * @ingroup bt
+ *
+ * @param tree  The tree to remove entries from. It can't have an EpochDomain.
+ * @param other The tree holding the keys to keep.
+ *
+ * @return int 1 on success, 0 on failure, in which case `tree` doesn't change.
+ */
+int bt_intersect(BinTree *tree, BinTree *other);
+
+/**
+ * @brief Removes every entry of `tree` whose key is in `other`.
+ *
+ * Works as `bt_intersect()` does, and has the same requirements.
+ *
+ * @ingroup bt
+ *
+ * @param tree  The tree to remove entries from. It can't have an EpochDomain.
+ * @param other The tree holding the keys to remove.
+ *
+ * @return int 1 on success, 0 on failure, in which case `tree` doesn't change.
+ */
+int bt_difference(BinTree *tree, BinTree *other);
+
+/**
+ * @brief Reads a BinTree's operation counters.
+ *
+ * Counters are only kept when the tree is compiled with `MAP_STATS` defined
+ * (`make STATS=1`). Every key comparison visits one node, so `key_cmps` and
+ * `nodes_visited` are always equal for a BinTree. Entries that are retired to
+ * an EpochDomain stop counting towards `bytes` as soon as they are unlinked.
+ *
+ * May be called while other threads read or write the tree. The counters are
+ * then read individually, so they may be slightly inconsistent with each
+ * other.
+ *
+ * @ingroup bt
+ *
+ * @param tree The tree to read counters from.
+ * @param out  Set to the counters. Zeroed if stats are not compiled in.
+ *
+ * @return int 1 on success, 0 if stats are not compiled in or on failure.
+ */
+int bt_stats(BinTree *tree, MapStats *out);
 #endif
@@ -0,0 +1,257 @@
+/**
+ * @file bintree_gen.h
+ * @brief Generates Binary Search Trees specialized for a fixed key type.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup bt_gen Typed Binary Search Trees
+ * A BinTree takes its keys as strings or byte buffers, and compares them byte
+ * by byte or through a `bt_cmp_fn`. When every key has the same fixed-size
+ * type, such as an integer, a tree generated by these macros instead stores
+ * the key by value in each node and compares it with an expression that the
+ * compiler inlines into every lookup.
+ *
+ * `BT_GENERATE_PROTOTYPES(name, Type, key_t)` declares, typically in a header:
+ *
+ * - `Type`, the tree, and `name_visit_fn`, its visitor
+ * - `int name_init(Type **tree)`
+ * - `void name_free(Type **tree)`
+ * - `int name_size(Type *tree)`
+ * - `int name_add(Type *tree, key_t key, void *data, size_t size)`
+ * - `void *name_get(Type *tree, key_t key)`
+ * - `void *name_get_with_size(Type *tree, key_t key, size_t *size)`
+ * - `int name_has(Type *tree, key_t key)`
+ * - `int name_remove(Type *tree, key_t key)`
+ * - `int name_for_each(Type *tree, name_visit_fn fn, void *ctx)`
+ *
+ * `BT_GENERATE(name, Type, key_t, cmp)` defines them in one translation unit.
+ * `cmp(a, b)` must evaluate to less than, equal to, or greater than 0 when key
+ * `a` sorts before, the same as, or after key `b`; `BT_CMP_NUMERIC` suits any
+ * arithmetic key type.
+ *
+ * These functions behave like their `bt_` counterparts: the tree stores one
+ * entry per key, owns a copy of each entry's data, and replaces the entry on
+ * a duplicate insertion. Each entry takes a single allocation holding the
+ * node and its data. Generated trees are not thread-safe and do not support
+ * epochs or custom allocators.
+ */
+#ifndef __BINTREE_GEN_H__
+#define __BINTREE_GEN_H__
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "map.h"
+
+/**
+ * @brief Orders arithmetic keys by value.
+ *
+ * @ingroup bt_gen
+ */
+#define BT_CMP_NUMERIC(a, b) (((a) > (b)) - ((a) < (b)))
+
+// Entry data is stored right after the node, aligned to this boundary
+#define _BT_GEN_ALIGN (2 * sizeof(void *))
+#define _BT_GEN_DATA_OFFSET(node_t) ((sizeof(node_t) + _BT_GEN_ALIGN - 1) / _BT_GEN_ALIGN * _BT_GEN_ALIGN)
+#define _BT_GEN_DATA(node) ((void *)((char *)(node) + _BT_GEN_DATA_OFFSET(*(node))))
+
+/**
+ * @brief Declares a Binary Search Tree type keyed by `key_t`, and the
+ * functions operating on it.
+ *
+ * @ingroup bt_gen
+ */
+#define BT_GENERATE_PROTOTYPES(name, Type, key_t)                                  \
+    typedef struct name##_tree Type;                                               \
+    typedef int (*name##_visit_fn)(key_t key, void *data, size_t size, void *ctx); \
+    int name##_init(Type **tree);                                                  \
+    void name##_free(Type **tree);                                                 \
+    int name##_size(Type *tree);                                                   \
+    int name##_add(Type *tree, key_t key, void *data, size_t size);                \
+    void *name##_get(Type *tree, key_t key);                                       \
+    void *name##_get_with_size(Type *tree, key_t key, size_t *size);               \
+    int name##_has(Type *tree, key_t key);                                         \
+    int name##_remove(Type *tree, key_t key);                                      \
+    int name##_for_each(Type *tree, name##_visit_fn fn, void *ctx);
+
+/**
+ * @brief Defines the functions declared by `BT_GENERATE_PROTOTYPES()`, with
+ * keys ordered by `cmp`.
+ *
+ * @ingroup bt_gen
+ */
+#define BT_GENERATE(name, Type, key_t, cmp)                                                \
+    typedef struct name##_node {                                                           \
+        key_t key;                          /* entry lookup key */                         \
+        size_t size;                        /* size of data, stored after the node */      \
+        struct name##_node *left, *right;   /* child nodes */                              \
+    } name##_node;                                                                         \
+                                                                                           \
+    struct name##_tree {                                                                   \
+        name##_node *root;                                                                 \
+        size_t count; /* number of entries */                                              \
+    };                                                                                     \
+                                                                                           \
+    static name##_node *_##name##_node_init(key_t key, void *data, size_t size) {          \
+        name##_node *n = malloc(_BT_GEN_DATA_OFFSET(name##_node) + size);                  \
+        if (!n) return NULL;                                                               \
+                                                                                           \
+        n->key = key;                                                                      \
+        n->size = size;                                                                    \
+        n->left = n->right = NULL;                                                         \
+        memcpy(_BT_GEN_DATA(n), data, size);                                               \
+                                                                                           \
+        return n;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    /* The link pointing at the node holding `key`, or the empty one it would go in */     \
+    static name##_node **_##name##_find(Type *tree, key_t key) {                           \
+        name##_node **link = &tree->root;                                                  \
+                                                                                           \
+        while (*link) {                                                                    \
+            int c = cmp((*link)->key, key);                                                \
+            if (!c) break;                                                                 \
+            link = c > 0 ? &(*link)->left : &(*link)->right;                               \
+        }                                                                                  \
+                                                                                           \
+        return link;                                                                       \
+    }                                                                                      \
+                                                                                           \
+    int name##_init(Type **tree) {                                                         \
+        Type *t = NULL;                                                                    \
+                                                                                           \
+        if (!tree) return _MAP_FAILURE;                                                    \
+                                                                                           \
+        t = *tree = malloc(sizeof(Type));                                                  \
+        if (!t) return _MAP_FAILURE;                                                       \
+                                                                                           \
+        t->root = NULL;                                                                    \
+        t->count = 0;                                                                      \
+                                                                                           \
+        return _MAP_SUCCESS;                                                               \
+    }                                                                                      \
+                                                                                           \
+    void name##_free(Type **tree) {                                                        \
+        name##_node *node;                                                                 \
+                                                                                           \
+        if (!tree || !(*tree)) return;                                                     \
+                                                                                           \
+        /* Rotate left children up so the tree is freed without recursion */               \
+        node = (*tree)->root;                                                              \
+        while (node) {                                                                     \
+            name##_node *next;                                                             \
+            if (node->left) {                                                              \
+                next = node->left;                                                         \
+                node->left = next->right;                                                  \
+                next->right = node;                                                        \
+            } else {                                                                       \
+                next = node->right;                                                        \
+                free(node);                                                                \
+            }                                                                              \
+            node = next;                                                                   \
+        }                                                                                  \
+                                                                                           \
+        free(*tree);                                                                       \
+        *tree = NULL;                                                                      \
+    }                                                                                      \
+                                                                                           \
+    int name##_size(Type *tree) {                                                          \
+        if (!tree) return _MAP_FAILURE;                                                    \
+                                                                                           \
+        return (int)tree->count;                                                           \
+    }                                                                                      \
+                                                                                           \
+    int name##_add(Type *tree, key_t key, void *data, size_t size) {                       \
+        name##_node **link, *n;                                                            \
+                                                                                           \
+        if (!tree || !data) return _MAP_FAILURE;                                           \
+                                                                                           \
+        link = _##name##_find(tree, key);                                                  \
+        n = _##name##_node_init(key, data, size);                                          \
+        if (!n) return _MAP_FAILURE;                                                       \
+                                                                                           \
+        if (*link) {                                                                       \
+            /* Entry with key already exists, replace its node */                          \
+            n->left = (*link)->left;                                                       \
+            n->right = (*link)->right;                                                     \
+            free(*link);                                                                   \
+            *link = n;                                                                     \
+            return _MAP_SUCCESS_REPLACED;                                                  \
+        }                                                                                  \
+                                                                                           \
+        *link = n;                                                                         \
+        tree->count++;                                                                     \
+        return _MAP_SUCCESS;                                                               \
+    }                                                                                      \
+                                                                                           \
+    void *name##_get_with_size(Type *tree, key_t key, size_t *size) {                      \
+        name##_node *node;                                                                 \
+                                                                                           \
+        if (!tree) return NULL;                                                            \
+                                                                                           \
+        node = *_##name##_find(tree, key);                                                 \
+        if (!node) return NULL;                                                            \
+                                                                                           \
+        if (size) *size = node->size;                                                      \
+        return _BT_GEN_DATA(node);                                                         \
+    }                                                                                      \
+                                                                                           \
+    void *name##_get(Type *tree, key_t key) {                                              \
+        return name##_get_with_size(tree, key, NULL);                                      \
+    }                                                                                      \
+                                                                                           \
+    int name##_has(Type *tree, key_t key) {                                                \
+        if (!tree) return 0;                                                               \
+                                                                                           \
+        return *_##name##_find(tree, key) ? 1 : 0;                                         \
+    }                                                                                      \
+                                                                                           \
+    int name##_remove(Type *tree, key_t key) {                                             \
+        name##_node **link, *node;                                                         \
+                                                                                           \
+        if (!tree) return _MAP_FAILURE;                                                    \
+                                                                                           \
+        link = _##name##_find(tree, key);                                                  \
+        node = *link;                                                                      \
+        if (!node) return _MAP_FAILURE;                                                    \
+                                                                                           \
+        if (!node->left) {                                                                 \
+            *link = node->right;                                                           \
+        } else if (!node->right) {                                                         \
+            *link = node->left;                                                            \
+        } else {                                                                           \
+            /* Node has two children, move right subtree's min into its place */           \
+            name##_node **min_link = &node->right, *min;                                   \
+            while ((*min_link)->left) min_link = &(*min_link)->left;                       \
+            min = *min_link;                                                               \
+            *min_link = min->right;                                                        \
+            min->left = node->left;                                                        \
+            min->right = node->right;                                                      \
+            *link = min;                                                                   \
+        }                                                                                  \
+                                                                                           \
+        free(node);                                                                        \
+        tree->count--;                                                                     \
+        return _MAP_SUCCESS;                                                               \
+    }                                                                                      \
+                                                                                           \
+    static int _##name##_for_each(name##_node *node, name##_visit_fn fn, void *ctx) {      \
+        while (node) {                                                                     \
+            /* In-order traversal, looping down right children */                          \
+            if (!_##name##_for_each(node->left, fn, ctx)) return _MAP_FAILURE;             \
+            if (fn(node->key, _BT_GEN_DATA(node), node->size, ctx)) return _MAP_FAILURE;   \
+            node = node->right;                                                            \
+        }                                                                                  \
+                                                                                           \
+        return _MAP_SUCCESS;                                                               \
+    }                                                                                      \
+                                                                                           \
+    int name##_for_each(Type *tree, name##_visit_fn fn, void *ctx) {                       \
+        if (!tree || !fn) return _MAP_FAILURE;                                             \
+                                                                                           \
+        return _##name##_for_each(tree->root, fn, ctx);                                    \
+    }
+
+#endif
@@ -0,0 +1,766 @@
+// SPDX-License-Identifier: MIT
+#include "bplustree.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../util/stats.h"
+
+// Entry data is stored after the key, aligned to this boundary
+#define _BP_ALIGN (2 * sizeof(void *))
+
+// Fewest keys a node other than the root is left with by a removal
+#define _BP_MIN_KEYS(tree) ((tree)->order / 2)
+
+/*
+ * An entry, or a copy of an entry's key used as a separator in an inner node.
+ * Both are a single allocation, with the entry's data following its key.
+ */
+typedef struct bp_entry {
+    void *data;     // entry value, points into key. NULL for separators.
+    size_t size;    // size of data
+    size_t keylen;  // length of key, without null terminator
+    char key[];     // null-terminated key, followed by data
+} bp_entry;
+
+/*
+ * A node, followed by arrays sized for one key more than the tree's order, so
+ * that a key can be added to a full node before it is split:
+ *
+ *   uint64_t prefix[order + 1];       prefixes of keys, see _bp_prefix()
+ *   bp_entry *keys[order + 1];        entries in leaves, separators otherwise
+ *   bp_node *children[order + 2];     inner nodes only
+ *
+ * Child `i` of an inner node holds the keys from separator `i - 1` up to, but
+ * not including, separator `i`.
+ */
+typedef struct bp_node {
+    uint16_t count;        // keys in use
+    bool leaf;             // whether the node holds entries rather than children
+    uint32_t skip;         // leading bytes that every key reaching the node shares
+    struct bp_node *next;  // next leaf in key order, leaves only
+    uint64_t prefix[];
+} bp_node;
+
+struct bp_tree {
+    bp_node *root;      // an empty leaf when the tree is empty
+    size_t count;       // number of entries
+    size_t height;      // levels, including the leaves
+    unsigned order;     // most keys per node
+    char *shared;       // leading bytes of every key in the tree, NULL when empty
+    size_t shared_len;  // length of shared
+#ifdef MAP_STATS
+    MapStats stats;
+#endif
+};
+
+// A key being searched for
+typedef struct bp_key {
+    const char *bytes;
+    size_t len;
+    size_t nodes;  // nodes searched so far, counted by MAP_STATS
+    size_t reads;  // stored keys read so far, counted by MAP_STATS
+} bp_key;
+
+// =============================== PRIVATE UTILS ===============================
+
+static inline bp_entry **_bp_keys(const BPlusTree *tree, bp_node *n) {
+    return (bp_entry **)(n->prefix + tree->order + 1);
+}
+
+static inline bp_node **_bp_children(const BPlusTree *tree, bp_node *n) {
+    return (bp_node **)(_bp_keys(tree, n) + tree->order + 1);
+}
+
+static inline bp_key _bp_key(const char *key) {
+    bp_key k = {key, strlen(key), 0, 0};
+    return k;
+}
+
+// Offset of an entry's data from its start
+static inline size_t _bp_data_offset(size_t keylen) {
+    size_t offset = offsetof(bp_entry, key) + keylen + 1;
+    return (offset + _BP_ALIGN - 1) / _BP_ALIGN * _BP_ALIGN;
+}
+
+/*
+ * The 8 key bytes after the first `skip` as a big-endian integer, zero padded.
+ * For keys that share their first `skip` bytes, comparing prefixes as integers
+ * orders the keys the same way `strcmp` would, unless the prefixes are equal.
+ */
+static inline uint64_t _bp_prefix(const char *key, size_t len, size_t skip) {
+    const unsigned char *k = (const unsigned char *)key;
+    uint64_t prefix = 0;
+
+    for (size_t i = skip; i < skip + 8; i++) prefix = (prefix << 8) | (i < len ? k[i] : 0);
+
+    return prefix;
+}
+
+// Length of the prefix two keys share
+static inline size_t _bp_common(const char *a, size_t alen, const char *b, size_t blen) {
+    size_t i = 0;
+
+    while (i < alen && i < blen && a[i] == b[i]) i++;
+
+    return i;
+}
+
+/*
+ * Length of the prefix shared by every key in [lo, hi). Any key between two
+ * strings starts with the bytes those two share. A missing bound leaves the
+ * range open on that side, which then only holds keys with the tree's shared
+ * prefix.
+ */
+size_t _bp_shared(const BPlusTree *tree, const bp_entry *lo, const bp_entry *hi) {
+    size_t shared = lo && hi ? _bp_common(lo->key, lo->keylen, hi->key, hi->keylen) : tree->shared_len;
+
+    return shared < UINT32_MAX ? shared : UINT32_MAX;
+}
+
+/*
+ * Whether a key starts with the tree's shared prefix. Nodes skip those bytes,
+ * so only such keys can be searched for. Any other key is not in the tree.
+ */
+static inline bool _bp_in_range(const BPlusTree *tree, const bp_key *k) {
+    return tree->shared && k->len >= tree->shared_len && !memcmp(k->bytes, tree->shared, tree->shared_len);
+}
+
+/*
+ * Compares a searched key to key `i` of `n`, given the searched key's prefix
+ * at `n->skip`. The stored key is only read if the prefixes are equal.
+ */
+static inline int _bp_cmp(const BPlusTree *tree, bp_node *n, bp_key *k, uint64_t prefix, int i) {
+    const bp_entry *e;
+    size_t from, len;
+    int cmp;
+
+    if (prefix != n->prefix[i]) return prefix < n->prefix[i] ? -1 : 1;
+
+    // A key without NUL bytes that ends inside the prefix is equal to any key
+    // with the same prefix, so only longer keys are read
+    from = n->skip + (size_t)8;
+    if (k->len < from) return 0;
+
+    e = _bp_keys(tree, n)[i];
+    MAP_STATS_ONLY(k->reads++);
+    len = k->len < e->keylen ? k->len : e->keylen;
+    cmp = len > from ? memcmp(k->bytes + from, e->key + from, len - from) : 0;
+    if (cmp) return cmp;
+
+    return (k->len > e->keylen) - (k->len < e->keylen);
+}
+
+/*
+ * Finds the first key of `n` that is not less than `k`, and sets `*found` if
+ * it is equal. In an inner node, `k` then lies in child `i + *found`.
+ */
+int _bp_search(const BPlusTree *tree, bp_node *n, bp_key *k, bool *found) {
+    uint64_t prefix = _bp_prefix(k->bytes, k->len, n->skip);
+    int lo = 0, hi = n->count;
+
+    MAP_STATS_ONLY(k->nodes++);
+    *found = false;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2, cmp = _bp_cmp(tree, n, k, prefix, mid);
+
+        if (!cmp) {
+            *found = true;
+            return mid;
+        }
+        if (cmp > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// =============================== INIT/DESTROY ================================
+
+// Creates an entry, or a separator when `data` is NULL
+bp_entry *_bp_entry_init(const char *key, size_t keylen, void *data, size_t size) {
+    size_t offset = _bp_data_offset(keylen);
+    bp_entry *e = malloc(data ? offset + size : offsetof(bp_entry, key) + keylen + 1);
+
+    if (!e) return NULL;
+
+    e->size = data ? size : 0;
+    e->keylen = keylen;
+    memcpy(e->key, key, keylen);
+    e->key[keylen] = '\0';
+    e->data = data ? (char *)e + offset : NULL;
+    if (data && size) memcpy(e->data, data, size);
+
+    return e;
+}
+
+bp_node *_bp_node_init(const BPlusTree *tree, bool leaf) {
+    size_t slots = tree->order + (size_t)1;
+    size_t bytes = sizeof(bp_node) + slots * (sizeof(uint64_t) + sizeof(bp_entry *));
+    bp_node *n;
+
+    if (!leaf) bytes += (slots + 1) * sizeof(bp_node *);
+    n = malloc(bytes);
+    if (!n) return NULL;
+
+    n->count = 0;
+    n->leaf = leaf;
+    n->skip = 0;
+    n->next = NULL;
+
+    return n;
+}
+
+void _bp_node_free(BPlusTree *tree, bp_node *n) {
+    bp_entry **keys = _bp_keys(tree, n);
+
+    if (!n->leaf) {
+        for (int i = 0; i <= n->count; i++) _bp_node_free(tree, _bp_children(tree, n)[i]);
+    }
+    for (int i = 0; i < n->count; i++) free(keys[i]);
+
+    free(n);
+}
+
+int bp_init_with_order(BPlusTree **tree, unsigned order) {
+    BPlusTree *t = NULL;
+
+    if (!tree || order < BP_MIN_ORDER || order > BP_MAX_ORDER) return _MAP_FAILURE;
+
+    t = *tree = malloc(sizeof(BPlusTree));
+    if (!t) return _MAP_FAILURE;
+
+    t->order = order;
+    t->count = 0;
+    t->height = 1;
+    t->shared = NULL;
+    t->shared_len = 0;
+    MAP_STATS_ONLY(memset(&t->stats, 0, sizeof(MapStats)));
+    t->root = _bp_node_init(t, true);
+    if (!t->root) {
+        free(t);
+        *tree = NULL;
+        return _MAP_FAILURE;
+    }
+
+    return _MAP_SUCCESS;
+}
+
+int bp_init(BPlusTree **tree) {
+    return bp_init_with_order(tree, BP_DEFAULT_ORDER);
+}
+
+void bp_free(BPlusTree **tree) {
+    if (!tree || !(*tree)) return;
+
+    _bp_node_free(*tree, (*tree)->root);
+
+    free((*tree)->shared);
+    free(*tree);
+    *tree = NULL;
+}
+
+// ================================ HEIGHT/SIZE ================================
+
+int bp_size(BPlusTree *tree) {
+    if (!tree) return _MAP_FAILURE;
+
+    return (int)tree->count;
+}
+
+int bp_height(BPlusTree *tree) {
+    if (!tree || !tree->count) return 0;
+
+    return (int)tree->height;
+}
+
+// =============================== NODE CHANGES ================================
+
+// Recomputes every prefix of `n`, whose keys now lie in [lo, hi)
+void _bp_reprefix(BPlusTree *tree, bp_node *n, const bp_entry *lo, const bp_entry *hi) {
+    bp_entry **keys = _bp_keys(tree, n);
+
+    n->skip = (uint32_t)_bp_shared(tree, lo, hi);
+    for (int i = 0; i < n->count; i++) n->prefix[i] = _bp_prefix(keys[i]->key, keys[i]->keylen, n->skip);
+}
+
+// Inserts key `e` at index `i` of `n`, and in an inner node `child` after it
+void _bp_insert_at(BPlusTree *tree, bp_node *n, int i, bp_entry *e, bp_node *child) {
+    bp_entry **keys = _bp_keys(tree, n);
+    size_t tail = (size_t)(n->count - i);
+
+    memmove(&n->prefix[i + 1], &n->prefix[i], tail * sizeof(uint64_t));
+    memmove(&keys[i + 1], &keys[i], tail * sizeof(bp_entry *));
+    if (!n->leaf) {
+        bp_node **children = _bp_children(tree, n);
+        memmove(&children[i + 2], &children[i + 1], tail * sizeof(bp_node *));
+        children[i + 1] = child;
+    }
+
+    n->prefix[i] = _bp_prefix(e->key, e->keylen, n->skip);
+    keys[i] = e;
+    n->count++;
+}
+
+// Removes key `i` of `n`, and in an inner node the child after it
+void _bp_remove_at(BPlusTree *tree, bp_node *n, int i) {
+    bp_entry **keys = _bp_keys(tree, n);
+    size_t tail = (size_t)(n->count - i - 1);
+
+    memmove(&n->prefix[i], &n->prefix[i + 1], tail * sizeof(uint64_t));
+    memmove(&keys[i], &keys[i + 1], tail * sizeof(bp_entry *));
+    if (!n->leaf) {
+        bp_node **children = _bp_children(tree, n);
+        memmove(&children[i + 1], &children[i + 2], tail * sizeof(bp_node *));
+    }
+
+    n->count--;
+}
+
+/*
+ * Moves the upper half of the overfull node `n`, whose keys lie in [lo, hi),
+ * into the empty node `right`. Returns the separator between the halves, or
+ * NULL if it could not be allocated, in which case nothing changed.
+ */
+bp_entry *_bp_split(BPlusTree *tree, bp_node *n, bp_node *right, const bp_entry *lo, const bp_entry *hi) {
+    bp_entry **keys = _bp_keys(tree, n), **rkeys = _bp_keys(tree, right), *sep;
+    int mid = n->count / 2, moved;
+
+    if (n->leaf) {
+        // Leaves keep all of their entries, so the separator is a copy of the
+        // first key moved right
+        sep = _bp_entry_init(keys[mid]->key, keys[mid]->keylen, NULL, 0);
+        if (!sep) return NULL;
+
+        moved = n->count - mid;
+        memcpy(rkeys, keys + mid, (size_t)moved * sizeof(bp_entry *));
+        right->next = n->next;
+        n->next = right;
+    } else {
+        // The middle separator moves up, between the halves
+        sep = keys[mid];
+        moved = n->count - mid - 1;
+        memcpy(rkeys, keys + mid + 1, (size_t)moved * sizeof(bp_entry *));
+        memcpy(_bp_children(tree, right), _bp_children(tree, n) + mid + 1, (size_t)(moved + 1) * sizeof(bp_node *));
+    }
+
+    n->count = (uint16_t)mid;
+    right->count = (uint16_t)moved;
+
+    // Both halves cover narrower ranges, whose keys may share more bytes
+    _bp_reprefix(tree, n, lo, sep);
+    _bp_reprefix(tree, right, sep, hi);
+
+    return sep;
+}
+
+/*
+ * Refills child `c` of `n` after a removal left it less than half full. It is
+ * merged with a neighbor if both fit in one node, and otherwise takes one key
+ * from the neighbor. The keys of `n` lie in [lo, hi).
+ */
+void _bp_refill(BPlusTree *tree, bp_node *n, int c, const bp_entry *lo, const bp_entry *hi) {
+    bp_entry **keys = _bp_keys(tree, n), *sep;
+    bp_node **children = _bp_children(tree, n);
+    int s = c ? c - 1 : 0;  // separator between the child and its neighbor
+    bp_node *left = children[s], *right = children[s + 1];
+    bp_entry **lkeys = _bp_keys(tree, left), **rkeys = _bp_keys(tree, right);
+    const bp_entry *llo = s ? keys[s - 1] : lo, *rhi = s + 1 < n->count ? keys[s + 1] : hi;
+    int total = left->count + right->count + !left->leaf;
+
+    if (total <= (int)tree->order) {
+        // Inner nodes take the separator between them down into the merged node
+        if (left->leaf) {
+            memcpy(lkeys + left->count, rkeys, right->count * sizeof(bp_entry *));
+            left->next = right->next;
+            free(keys[s]);
+        } else {
+            bp_node **lchildren = _bp_children(tree, left);
+            lkeys[left->count] = keys[s];
+            memcpy(lkeys + left->count + 1, rkeys, right->count * sizeof(bp_entry *));
+            memcpy(lchildren + left->count + 1, _bp_children(tree, right), (right->count + (size_t)1) * sizeof(bp_node *));
+        }
+
+        left->count = (uint16_t)total;
+        free(right);
+        _bp_remove_at(tree, n, s);
+        _bp_reprefix(tree, left, llo, rhi);
+        return;
+    }
+
+    if (c > s) {
+        // Move the left neighbor's last key to the front of the child
+        bp_entry *last = lkeys[left->count - 1];
+
+        if (left->leaf) {
+            // The child stays underfull if this fails, which is still valid
+            sep = _bp_entry_init(last->key, last->keylen, NULL, 0);
+            if (!sep) return;
+            free(keys[s]);
+            memmove(rkeys + 1, rkeys, right->count * sizeof(bp_entry *));
+            rkeys[0] = last;
+        } else {
+            bp_node **rchildren = _bp_children(tree, right);
+            memmove(rkeys + 1, rkeys, right->count * sizeof(bp_entry *));
+            memmove(rchildren + 1, rchildren, (right->count + (size_t)1) * sizeof(bp_node *));
+            rchildren[0] = _bp_children(tree, left)[left->count];
+            rkeys[0] = keys[s];
+            sep = last;
+        }
+        left->count--;
+        right->count++;
+    } else {
+        // Move the right neighbor's first key to the end of the child
+        if (left->leaf) {
+            sep = _bp_entry_init(rkeys[1]->key, rkeys[1]->keylen, NULL, 0);
+            if (!sep) return;
+            free(keys[s]);
+            lkeys[left->count] = rkeys[0];
+        } else {
+            bp_node **rchildren = _bp_children(tree, right);
+            lkeys[left->count] = keys[s];
+            _bp_children(tree, left)[left->count + 1] = rchildren[0];
+            memmove(rchildren, rchildren + 1, right->count * sizeof(bp_node *));
+            sep = rkeys[0];
+        }
+        memmove(rkeys, rkeys + 1, (right->count - (size_t)1) * sizeof(bp_entry *));
+        left->count++;
+        right->count--;
+    }
+
+    keys[s] = sep;
+    n->prefix[s] = _bp_prefix(sep->key, sep->keylen, n->skip);
+    _bp_reprefix(tree, left, llo, sep);
+    _bp_reprefix(tree, right, sep, rhi);
+}
+
+// ================================= INSERTION =================================
+
+/*
+ * Shortens the tree's shared prefix to one that `k` also starts with, before
+ * `k` is added. Only nodes along the leftmost and rightmost paths have an open
+ * bound and skip exactly the shared prefix, so only those are updated.
+ */
+int _bp_widen(BPlusTree *tree, const bp_key *k) {
+    bp_node *n;
+
+    if (!tree->shared) {
+        // The first key is all that the tree's keys share so far
+        tree->shared = malloc(k->len + 1);
+        if (!tree->shared) return _MAP_FAILURE;
+        memcpy(tree->shared, k->bytes, k->len);
+        tree->shared_len = k->len;
+    } else {
+        tree->shared_len = _bp_common(tree->shared, tree->shared_len, k->bytes, k->len);
+    }
+
+    for (n = tree->root;; n = _bp_children(tree, n)[0]) {
+        _bp_reprefix(tree, n, NULL, NULL);
+        if (n->leaf) break;
+    }
+    for (n = tree->root; !n->leaf;) {
+        n = _bp_children(tree, n)[n->count];
+        _bp_reprefix(tree, n, NULL, NULL);
+    }
+
+    return _MAP_SUCCESS;
+}
+
+/*
+ * Adds entry `e` below `n`, whose keys lie in [lo, hi). If `n` overflows it is
+ * split, and the new right half and its separator are returned through
+ * `right` and `sep`. A full node allocates its right half before anything
+ * changes, so a failed allocation leaves the tree as it was.
+ */
+int _bp_add(BPlusTree *tree, bp_node *n, bp_key *k, const bp_entry *lo, const bp_entry *hi, bp_entry *e,
+            bp_node **right, bp_entry **sep) {
+    bp_entry **keys = _bp_keys(tree, n);
+    bp_node *spare = NULL;
+    bool found;
+    int i = _bp_search(tree, n, k, &found), status;
+
+    if (n->leaf && found) {
+        bp_entry *old = keys[i];
+
+        // Equal keys have equal prefixes
+        keys[i] = e;
+        MAP_STAT_INC(tree->stats, frees);
+        MAP_STAT_SUB(tree->stats, bytes, _bp_data_offset(old->keylen) + old->size);
+        free(old);
+        return _MAP_SUCCESS_REPLACED;
+    }
+
+    if (n->count == tree->order) {
+        spare = _bp_node_init(tree, n->leaf);
+        if (!spare) return _MAP_FAILURE;
+    }
+
+    if (n->leaf) {
+        _bp_insert_at(tree, n, i, e, NULL);
+        status = _MAP_SUCCESS;
+    } else {
+        bp_node *child_right = NULL;
+        bp_entry *child_sep = NULL;
+        int c = i + found;
+
+        status = _bp_add(tree, _bp_children(tree, n)[c], k, c ? keys[c - 1] : lo, c < n->count ? keys[c] : hi, e,
+                         &child_right, &child_sep);
+        if (child_right) _bp_insert_at(tree, n, c, child_sep, child_right);
+    }
+
+    if (n->count <= tree->order) {
+        free(spare);
+        return status;
+    }
+
+    *sep = _bp_split(tree, n, spare, lo, hi);
+    if (!*sep) {
+        // Only leaves allocate when split, so undo the insertion
+        assert(n->leaf);
+        _bp_remove_at(tree, n, i);
+        free(spare);
+        return _MAP_FAILURE;
+    }
+    *right = spare;
+
+    return status;
+}
+
+int bp_add(BPlusTree *tree, char *key, void *data, size_t size) {
+    bp_node *root = NULL, *right = NULL;
+    bp_entry *e, *sep = NULL;
+    bp_key k;
+    int status;
+
+    if (!tree || !key || !data) return _MAP_FAILURE;
+
+    k = _bp_key(key);
+    e = _bp_entry_init(key, k.len, data, size);
+    if (!e) return _MAP_FAILURE;
+    if (!_bp_in_range(tree, &k) && !_bp_widen(tree, &k)) {
+        free(e);
+        return _MAP_FAILURE;
+    }
+
+    // A full root may split, and then needs a parent
+    if (tree->root->count == tree->order) {
+        root = _bp_node_init(tree, false);
+        if (!root) {
+            free(e);
+            return _MAP_FAILURE;
+        }
+    }
+
+    status = _bp_add(tree, tree->root, &k, NULL, NULL, e, &right, &sep);
+    if (right) {
+        _bp_children(tree, root)[0] = tree->root;
+        root->skip = (uint32_t)_bp_shared(tree, NULL, NULL);
+        _bp_insert_at(tree, root, 0, sep, right);
+        tree->root = root;
+        tree->height++;
+    } else {
+        free(root);
+    }
+
+    if (!status) {
+        free(e);
+        return _MAP_FAILURE;
+    }
+    if (status == _MAP_SUCCESS) tree->count++;
+
+    MAP_STAT_INC(tree->stats, adds);
+    MAP_STAT_INC(tree->stats, mallocs);
+    MAP_STAT_ADD(tree->stats, bytes, _bp_data_offset(k.len) + size);
+    MAP_STAT_ADD(tree->stats, key_cmps, k.reads);
+    MAP_STAT_ADD(tree->stats, nodes_visited, k.nodes);
+    MAP_STAT_DEPTH(tree->stats, add_depth, k.nodes);
+
+    return status;
+}
+
+// =================================== READ ====================================
+
+// Finds the leaf that holds `k` if any entry does, and the index `k` has or would have in it
+bp_node *_bp_find(BPlusTree *tree, bp_key *k, int *index, bool *found) {
+    bp_node *n = tree->root;
+
+    for (;;) {
+        *index = _bp_search(tree, n, k, found);
+        if (n->leaf) return n;
+        n = _bp_children(tree, n)[*index + *found];
+    }
+}
+
+bp_entry *_bp_get(BPlusTree *tree, const char *key) {
+    bp_key k = _bp_key(key);
+    bool found = false;
+    bp_node *n = NULL;
+    int i = 0;
+
+    if (_bp_in_range(tree, &k)) n = _bp_find(tree, &k, &i, &found);
+
+    MAP_STAT_INC(tree->stats, gets);
+    MAP_STAT_ADD(tree->stats, key_cmps, k.reads);
+    MAP_STAT_ADD(tree->stats, nodes_visited, k.nodes);
+    MAP_STAT_DEPTH(tree->stats, get_depth, k.nodes);
+
+    return found ? _bp_keys(tree, n)[i] : NULL;
+}
+
+void *bp_get(BPlusTree *tree, char *key) {
+    bp_entry *e;
+
+    if (!tree || !key) return NULL;
+
+    e = _bp_get(tree, key);
+    return e ? e->data : NULL;
+}
+
+int bp_has(BPlusTree *tree, char *key) {
+    if (!tree || !key) return false;
+
+    return _bp_get(tree, key) ? true : false;
+}
+
+// ================================= DELETION ==================================
+
+// Removes `k` from below `n`, whose keys lie in [lo, hi)
+int _bp_remove(BPlusTree *tree, bp_node *n, bp_key *k, const bp_entry *lo, const bp_entry *hi) {
+    bp_entry **keys = _bp_keys(tree, n);
+    bool found;
+    int i = _bp_search(tree, n, k, &found), c, status;
+
+    if (n->leaf) {
+        if (!found) return _MAP_FAILURE;
+
+        MAP_STAT_INC(tree->stats, frees);
+        MAP_STAT_SUB(tree->stats, bytes, _bp_data_offset(keys[i]->keylen) + keys[i]->size);
+        free(keys[i]);
+        _bp_remove_at(tree, n, i);
+        return _MAP_SUCCESS;
+    }
+
+    c = i + found;
+    status = _bp_remove(tree, _bp_children(tree, n)[c], k, c ? keys[c - 1] : lo, c < n->count ? keys[c] : hi);
+    if (status && _bp_children(tree, n)[c]->count < _BP_MIN_KEYS(tree)) _bp_refill(tree, n, c, lo, hi);
+
+    return status;
+}
+
+int bp_remove(BPlusTree *tree, char *key) {
+    bp_key k;
+    int status;
+
+    if (!tree || !key) return _MAP_FAILURE;
+
+    k = _bp_key(key);
+    status = _bp_in_range(tree, &k) ? _bp_remove(tree, tree->root, &k, NULL, NULL) : _MAP_FAILURE;
+    if (status && !--tree->count) {
+        // The next key starts a new shared prefix
+        free(tree->shared);
+        tree->shared = NULL;
+        tree->shared_len = 0;
+    }
+
+    // A root left with a single child is replaced by it
+    while (!tree->root->leaf && !tree->root->count) {
+        bp_node *old = tree->root;
+        tree->root = _bp_children(tree, old)[0];
+        tree->height--;
+        free(old);
+    }
+
+    MAP_STAT_INC(tree->stats, removes);
+    MAP_STAT_ADD(tree->stats, key_cmps, k.reads);
+    MAP_STAT_ADD(tree->stats, nodes_visited, k.nodes);
+    MAP_STAT_DEPTH(tree->stats, remove_depth, k.nodes);
+
+    return status;
+}
+
+// ================================== MIN/MAX ==================================
+
+void *bp_min(BPlusTree *tree) {
+    bp_node *n;
+
+    if (!tree) return NULL;
+
+    for (n = tree->root; !n->leaf; n = _bp_children(tree, n)[0]) continue;
+    return n->count ? _bp_keys(tree, n)[0]->data : NULL;
+}
+
+void *bp_max(BPlusTree *tree) {
+    bp_node *n;
+
+    if (!tree) return NULL;
+
+    for (n = tree->root; !n->leaf; n = _bp_children(tree, n)[n->count]) continue;
+    return n->count ? _bp_keys(tree, n)[n->count - 1]->data : NULL;
+}
+
+// ================================= ITERATION =================================
+
+/*
+ * Visits entries from index `i` of leaf `n` onwards, until one is not less
+ * than `to`. Returns 1 if the end was reached, 0 if `fn` asked to stop.
+ */
+int _bp_scan(BPlusTree *tree, bp_node *n, int i, const char *to, map_visit_fn fn, void *ctx) {
+    for (; n; n = n->next, i = 0) {
+        bp_entry **keys = _bp_keys(tree, n);
+
+        for (; i < n->count; i++) {
+            if (to && strcmp(keys[i]->key, to) >= 0) return 1;
+            if (fn(keys[i]->key, keys[i]->keylen, keys[i]->data, keys[i]->size, ctx)) return 0;
+        }
+    }
+
+    return 1;
+}
+
+int bp_for_each(BPlusTree *tree, map_visit_fn fn, void *ctx) {
+    return bp_range_scan(tree, NULL, NULL, fn, ctx);
+}
+
+int bp_range_scan(BPlusTree *tree, const char *from, const char *to, map_visit_fn fn, void *ctx) {
+    bp_node *n;
+    bool found;
+    int i = 0;
+
+    if (!tree || !fn) return _MAP_FAILURE;
+
+    if (from) {
+        bp_key k = _bp_key(from);
+
+        if (_bp_in_range(tree, &k)) {
+            n = _bp_find(tree, &k, &i, &found);
+            return _bp_scan(tree, n, i, to, fn, ctx);
+        }
+
+        // Keys without the shared prefix sort before or after every entry
+        if (tree->shared && strncmp(from, tree->shared, tree->shared_len) > 0) return 1;
+    }
+
+    for (n = tree->root; !n->leaf; n = _bp_children(tree, n)[0]) continue;
+
+    return _bp_scan(tree, n, i, to, fn, ctx);
+}
+
+// ================================= STATISTICS ================================
+
+int bp_stats(BPlusTree *tree, MapStats *out) {
+    if (!out) return _MAP_FAILURE;
+
+    memset(out, 0, sizeof(MapStats));
+    if (!tree) return _MAP_FAILURE;
+
+#ifdef MAP_STATS
+    map_stats_load(out, &tree->stats);
+    return _MAP_SUCCESS;
+#else
+    return _MAP_FAILURE;
+#endif
+}
@@ -0,0 +1,264 @@
+/**
+ * @file bplustree.h
+ * @brief A key/value map implemented as a B+tree.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup bp B+tree
+ * A B+tree over string keys. Each node holds up to `order` keys, so a lookup
+ * visits a handful of wide nodes instead of one node per key compared, and
+ * every entry lives in a leaf.
+ *
+ * Nodes keep an 8-byte prefix of every key in a contiguous array, and lookups
+ * binary search those before reading any key. Prefixes start after the bytes
+ * that every key reaching the node shares (its keys all lie between the two
+ * separators above it), so keys like "user/000123" and "user/000124" still
+ * differ within their prefixes once the tree is deep enough.
+ *
+ * Leaves are linked in key order, so in-order iteration and range scans read
+ * leaves sequentially instead of walking back up the tree.
+ */
+#ifndef __BPLUSTREE_H__
+#define __BPLUSTREE_H__
+
+#include <stdlib.h>
+
+#include "map.h"
+
+/**
+ * @brief Keys per node used by `bp_init()`. Leaves then take 4 cache lines and
+ * inner nodes 6.
+ *
+ * @ingroup bp
+ */
+#define BP_DEFAULT_ORDER 16
+
+/**
+ * @brief Smallest order accepted by `bp_init_with_order()`.
+ *
+ * @ingroup bp
+ */
+#define BP_MIN_ORDER 4
+
+/**
+ * @brief Largest order accepted by `bp_init_with_order()`.
+ *
+ * @ingroup bp
+ */
+#define BP_MAX_ORDER 1024
+
+/**
+ * @brief A B+tree storing key/value pairs.
+ *
+ * Like a BinTree, this tree stores one entry per unique key and owns copies of
+ * both keys and data. Inserting with a duplicate key replaces the existing
+ * entry. Keys are ordered as by `strcmp`.
+ *
+ * @ingroup bp
+ */
+typedef struct bp_tree BPlusTree;
+
+/**
+ * @brief Constructs a new BPlusTree with `BP_DEFAULT_ORDER` keys per node.
+ *
+ * @ingroup bp
+ *
+ * @param tree A pointer to the tree to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bp_init(BPlusTree **tree);
+
+/**
+ * @brief Constructs a new BPlusTree with a chosen number of keys per node.
+ *
+ * A node takes 16 bytes per key in a leaf and 24 in an inner node, plus a
+ * small header. Wider nodes make the tree shallower, but each lookup then
+ * binary searches more cache lines per node.
+ *
+ * @ingroup bp
+ *
+ * @param tree  A pointer to the tree to construct.
+ * @param order Most keys per node, from `BP_MIN_ORDER` to `BP_MAX_ORDER`.
+ *
+ * @return int 1 on success, 0 on failure or if `order` is out of range.
+ */
+int bp_init_with_order(BPlusTree **tree, unsigned order);
+
+/**
+ * @brief Destroys a BPlusTree and frees all resources associated with it.
+ *
+ * After destruction, the tree will be set to `NULL`.
+ *
+ * @ingroup bp
+ *
+ * @param tree A pointer to the tree to destroy.
+ */
+void bp_free(BPlusTree **tree);
+
+/**
+ * @brief Gets the number of key/value entries in a BPlusTree.
+ *
+ * @ingroup bp
+ *
+ * @param tree The target tree.
+ *
+ * @return int The number of entries in the tree, or 0 on failure.
+ */
+int bp_size(BPlusTree *tree);
+
+/**
+ * @brief Gets the number of levels in a BPlusTree, which every lookup visits.
+ *
+ * @ingroup bp
+ *
+ * @param tree The target tree.
+ *
+ * @return int The height of the tree, 0 if it is empty or on failure.
+ */
+int bp_height(BPlusTree *tree);
+
+/**
+ * @brief Gets the value stored in the smallest entry.
+ *
+ * @ingroup bp
+ *
+ * @param tree The target tree.
+ *
+ * @return The smallest entry's stored data. If the tree is empty, `NULL` is
+ * returned.
+ */
+void *bp_min(BPlusTree *tree);
+
+/**
+ * @brief Gets the value stored in the largest entry.
+ *
+ * @ingroup bp
+ *
+ * @param tree The target tree.
+ *
+ * @return The largest entry's stored data. If the tree is empty, `NULL` is
+ * returned.
+ */
+void *bp_max(BPlusTree *tree);
+
+/**
+ * @brief Inserts an entry into a BPlusTree.
+ *
+ * If an entry under `key` already exists, it is replaced and its memory is
+ * freed. Both the key and data are copied into the tree, in one allocation.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to insert into.
+ * @param key  The entry key.
+ * @param data The data stored in the entry.
+ * @param size The size of `data`.
+ *
+ * @return int A positive number on success, 0 on failure. If an existing entry
+ * is replaced, 2 is returned.
+ */
+int bp_add(BPlusTree *tree, char *key, void *data, size_t size);
+
+/**
+ * @brief Searches a BPlusTree for an entry.
+ *
+ * As with `bt_get()`, the returned pointer is only valid until the entry is
+ * replaced or removed.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to search.
+ * @param key  The entry key.
+ *
+ * @return void* A pointer to the entry data, or `NULL` if no entry exists for
+ * the given key.
+ */
+void *bp_get(BPlusTree *tree, char *key);
+
+/**
+ * @brief Checks if an entry exists under a key.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to search.
+ * @param key  The entry key.
+ *
+ * @return int 1 if an entry exists for `key`, 0 if one does not.
+ */
+int bp_has(BPlusTree *tree, char *key);
+
+/**
+ * @brief Removes an entry from a BPlusTree, freeing its memory resources.
+ *
+ * Nodes left less than half full borrow keys from a neighbor, or are merged
+ * into it, so the tree stays as shallow as its size allows.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to remove the entry from.
+ * @param key  The entry key.
+ *
+ * @return int 1 if the entry existed and was removed, 0 otherwise.
+ */
+int bp_remove(BPlusTree *tree, char *key);
+
+/**
+ * @brief Visits every entry of a BPlusTree in key order.
+ *
+ * The tree must not be modified during iteration.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to iterate over.
+ * @param fn   Called once per entry. Returning non-zero stops the iteration.
+ * @param ctx  Passed to `fn`.
+ *
+ * @return int 1 if every entry was visited, 0 if `fn` stopped the iteration or
+ * on failure.
+ */
+int bp_for_each(BPlusTree *tree, map_visit_fn fn, void *ctx);
+
+/**
+ * @brief Visits every entry with a key in [`from`, `to`), in key order.
+ *
+ * The tree is descended once to find `from`, then leaves are read along their
+ * links, so the cost is O(log n) plus the number of entries visited.
+ *
+ * The tree must not be modified during iteration.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to search.
+ * @param from The smallest key to visit, or `NULL` to start at the first entry.
+ * @param to   The key to stop before, or `NULL` to continue to the last entry.
+ * @param fn   Called once per entry in range. Returning non-zero stops the
+ * iteration.
+ * @param ctx  Passed to `fn`.
+ *
+ * @return int 1 if every entry in range was visited, 0 if `fn` stopped the
+ * iteration or on failure.
+ */
+int bp_range_scan(BPlusTree *tree, const char *from, const char *to, map_visit_fn fn, void *ctx);
+
+/**
+ * @brief Copies a BPlusTree's operation counters.
+ *
+ * `nodes_visited` counts nodes searched by lookups, insertions and removals,
+ * and the depth histograms count operations by nodes visited. `key_cmps` only
+ * counts comparisons that read a stored key, because the searched and stored
+ * prefixes tied. Comparisons of prefixes alone touch no memory outside the
+ * node, and are not counted.
+ *
+ * @ingroup bp
+ *
+ * @param tree The tree to read.
+ * @param out  Where to copy the counters.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int bp_stats(BPlusTree *tree, MapStats *out);
+
+#endif
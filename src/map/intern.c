@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: MIT
+#define _POSIX_C_SOURCE 200809L
+
+#include "intern.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Initial number of hash buckets, must be a power of 2
+#define _INTERN_MIN_BUCKETS 64
+
+typedef struct intern_entry {
+    struct intern_entry *next;  // next entry in the same bucket
+    uint64_t hash;              // hash of key
+    size_t refs;                // number of references handed out
+    size_t len;                 // length of key, without null terminator
+    char key[];                 // the interned key, null-terminated
+} intern_entry;
+
+struct intern_pool {
+    pthread_mutex_t lock;    // guards the buckets and count
+    intern_entry **buckets;  // hash table, chained
+    size_t nbuckets;         // number of buckets, a power of 2
+    size_t count;            // number of interned keys
+};
+
+// The entry holding an interned key
+#define _INTERN_ENTRY(key) ((intern_entry *)((char *)(key) - offsetof(intern_entry, key)))
+
+// =============================== PRIVATE UTILS ===============================
+
+// 64-bit FNV-1a, as used by the sharded map
+uint64_t _intern_hash(const unsigned char *key, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= key[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+// Doubles the number of buckets. Called with the pool locked.
+void _intern_grow(InternPool *pool) {
+    size_t nbuckets = pool->nbuckets * 2;
+    intern_entry **buckets = calloc(nbuckets, sizeof(intern_entry *));
+
+    // Chains just get longer if memory is short
+    if (!buckets) return;
+
+    for (size_t i = 0; i < pool->nbuckets; i++) {
+        intern_entry *e = pool->buckets[i];
+        while (e) {
+            intern_entry *next = e->next;
+            size_t b = e->hash & (nbuckets - 1);
+
+            e->next = buckets[b];
+            buckets[b] = e;
+            e = next;
+        }
+    }
+
+    free(pool->buckets);
+    pool->buckets = buckets;
+    pool->nbuckets = nbuckets;
+}
+
+// =============================== INIT/DESTROY  ===============================
+
+int intern_init(InternPool **pool) {
+    InternPool *p = NULL;
+
+    if (!pool) return _MAP_FAILURE;
+
+    p = malloc(sizeof(InternPool));
+    if (!p) return _MAP_FAILURE;
+
+    p->buckets = calloc(_INTERN_MIN_BUCKETS, sizeof(intern_entry *));
+    if (!p->buckets || pthread_mutex_init(&p->lock, NULL)) {
+        free(p->buckets);
+        free(p);
+        return _MAP_FAILURE;
+    }
+    p->nbuckets = _INTERN_MIN_BUCKETS;
+    p->count = 0;
+
+    *pool = p;
+    return _MAP_SUCCESS;
+}
+
+void intern_free(InternPool **pool) {
+    InternPool *p;
+
+    if (!pool || !(*pool)) return;
+    p = *pool;
+
+    for (size_t i = 0; i < p->nbuckets; i++) {
+        intern_entry *e = p->buckets[i];
+        while (e) {
+            intern_entry *next = e->next;
+            free(e);
+            e = next;
+        }
+    }
+
+    pthread_mutex_destroy(&p->lock);
+    free(p->buckets);
+    free(p);
+    *pool = NULL;
+}
+
+// ================================= INTERNING =================================
+
+const char *intern_acquire(InternPool *pool, const void *key, size_t len) {
+    uint64_t hash;
+    intern_entry *e;
+
+    if (!pool || (!key && len)) return NULL;
+
+    hash = _intern_hash(key, len);
+    pthread_mutex_lock(&pool->lock);
+
+    for (e = pool->buckets[hash & (pool->nbuckets - 1)]; e; e = e->next) {
+        if (e->hash == hash && e->len == len && !memcmp(e->key, key, len)) {
+            __atomic_fetch_add(&e->refs, 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&pool->lock);
+            return e->key;
+        }
+    }
+
+    // Not interned yet, add a new entry
+    e = malloc(sizeof(intern_entry) + len + 1);
+    if (e) {
+        size_t b;
+
+        if (pool->count >= pool->nbuckets) _intern_grow(pool);
+        b = hash & (pool->nbuckets - 1);
+
+        e->hash = hash;
+        e->refs = 1;
+        e->len = len;
+        if (len) memcpy(e->key, key, len);
+        e->key[len] = '\0';
+        e->next = pool->buckets[b];
+        pool->buckets[b] = e;
+        pool->count++;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return e ? e->key : NULL;
+}
+
+const char *intern_retain(const char *key) {
+    // The caller's reference keeps the count above 0, so no lock is needed
+    if (key) __atomic_fetch_add(&_INTERN_ENTRY(key)->refs, 1, __ATOMIC_RELAXED);
+
+    return key;
+}
+
+void intern_release(InternPool *pool, const char *key) {
+    intern_entry *e, **link;
+    size_t refs;
+
+    if (!pool || !key) return;
+    e = _INTERN_ENTRY(key);
+
+    // Dropping a reference that is not the last one needs no lock
+    refs = __atomic_load_n(&e->refs, __ATOMIC_RELAXED);
+    while (refs > 1) {
+        if (__atomic_compare_exchange_n(&e->refs, &refs, refs - 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) return;
+    }
+
+    // Possibly the last reference. Decide under the lock, so a concurrent
+    // intern_acquire() can't revive the key while it is being freed.
+    pthread_mutex_lock(&pool->lock);
+    if (__atomic_fetch_sub(&e->refs, 1, __ATOMIC_ACQ_REL) != 1) {
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+
+    for (link = &pool->buckets[e->hash & (pool->nbuckets - 1)]; *link != e; link = &(*link)->next) {
+        assert(*link);
+    }
+    *link = e->next;
+    pool->count--;
+
+    pthread_mutex_unlock(&pool->lock);
+    free(e);
+}
+
+size_t intern_len(const char *key) {
+    return key ? _INTERN_ENTRY(key)->len : 0;
+}
+
+int intern_size(InternPool *pool) {
+    size_t count;
+
+    if (!pool) return 0;
+
+    pthread_mutex_lock(&pool->lock);
+    count = pool->count;
+    pthread_mutex_unlock(&pool->lock);
+
+    return (int)count;
+}
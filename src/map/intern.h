@@ -0,0 +1,121 @@
+/**
+ * @file intern.h
+ * @brief A thread-safe pool of canonical, reference-counted keys.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup intern Intern Pool
+ * Interning a key returns the pool's single copy of it, so every holder of
+ * equal keys holds the same pointer. Maps sharing a pool store that pointer
+ * instead of a private copy of the key (see `bt_set_intern_pool()`), which
+ * saves memory when the same keys live in many maps, and lets equal keys be
+ * recognized by pointer comparison alone.
+ *
+ * Interned keys are reference counted: each `intern_acquire()` or
+ * `intern_retain()` must be paired with an `intern_release()`, and a key is
+ * freed when its last reference is released.
+ *
+ * All functions may be called from any thread.
+ */
+#ifndef __INTERN_H__
+#define __INTERN_H__
+
+#include <stdlib.h>
+
+#include "map.h"
+
+/**
+ * @brief A set of interned keys.
+ *
+ * @ingroup intern
+ */
+typedef struct intern_pool InternPool;
+
+/**
+ * @brief Constructs a new, empty InternPool.
+ *
+ * @ingroup intern
+ *
+ * @param pool A pointer to the pool to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int intern_init(InternPool **pool);
+
+/**
+ * @brief Destroys an InternPool.
+ *
+ * Every key should have been released beforehand. Keys that are still held
+ * are freed along with the pool. After destruction, the pool will be set to
+ * `NULL`.
+ *
+ * @ingroup intern
+ *
+ * @param pool A pointer to the pool to destroy.
+ */
+void intern_free(InternPool **pool);
+
+/**
+ * @brief Gets the canonical copy of a key, adding it to the pool if needed.
+ *
+ * The returned key holds a new reference, which must be released with
+ * `intern_release()`. It stays valid and unchanged until then, and is
+ * null-terminated, so string keys may be used as strings.
+ *
+ * @ingroup intern
+ *
+ * @param pool The pool to intern the key in.
+ * @param key  The key bytes. May contain null bytes.
+ * @param len  The length of `key` in bytes. `key` may be `NULL` if this is 0.
+ *
+ * @return const char* The interned key, or `NULL` on failure.
+ */
+const char *intern_acquire(InternPool *pool, const void *key, size_t len);
+
+/**
+ * @brief Takes another reference to an interned key.
+ *
+ * @ingroup intern
+ *
+ * @param key A key returned by `intern_acquire()` that the caller holds.
+ *
+ * @return const char* `key`.
+ */
+const char *intern_retain(const char *key);
+
+/**
+ * @brief Releases a reference to an interned key, freeing it if this was the
+ * last one.
+ *
+ * @ingroup intern
+ *
+ * @param pool The pool `key` was interned in.
+ * @param key  The key to release. Does nothing if `NULL`.
+ */
+void intern_release(InternPool *pool, const char *key);
+
+/**
+ * @brief Gets the length of an interned key.
+ *
+ * @ingroup intern
+ *
+ * @param key An interned key.
+ *
+ * @return size_t The length of `key` in bytes, without the null terminator.
+ */
+size_t intern_len(const char *key);
+
+/**
+ * @brief Gets the number of distinct keys in an InternPool.
+ *
+ * @ingroup intern
+ *
+ * @param pool The target pool.
+ *
+ * @return int The number of keys currently interned, or 0 on failure.
+ */
+int intern_size(InternPool *pool);
+
+#endif
@@ -0,0 +1,430 @@
+// SPDX-License-Identifier: MIT
+#include "pbintree.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Entry data is stored after the key, aligned to this boundary
+#define _PBT_ALIGN (2 * sizeof(void *))
+
+/*
+ * An immutable key/value pair. Entries are shared by every node copy that
+ * refers to them, and key and data live in the same allocation.
+ */
+typedef struct pbt_entry {
+    size_t refs;    // number of nodes using this entry
+    size_t size;    // size of data
+    size_t keylen;  // length of key, without null terminator
+    void *data;     // entry value, points into buf
+    char key[];     // null-terminated key, followed by data
+} pbt_entry;
+
+typedef struct pbt_node {
+    size_t refs;            // number of parents, trees and snapshots using this node
+    pbt_entry *entry;       // entry stored in this node
+    struct pbt_node *left,  // left child node
+        *right;             // right child node
+} pbt_node;
+
+struct pbt_tree {
+    pbt_node *root;  // current version
+    size_t count;    // number of entries in the current version
+};
+
+struct pbt_snapshot {
+    pbt_node *root;  // version captured by the snapshot
+    size_t count;    // number of entries in that version
+};
+
+// ============================== REFERENCE COUNTS =============================
+
+pbt_entry *_pbt_entry_retain(pbt_entry *entry) {
+    __atomic_fetch_add(&entry->refs, 1, __ATOMIC_RELAXED);
+    return entry;
+}
+
+void _pbt_entry_release(pbt_entry *entry) {
+    if (__atomic_fetch_sub(&entry->refs, 1, __ATOMIC_ACQ_REL) == 1) free(entry);
+}
+
+pbt_node *_pbt_node_retain(pbt_node *node) {
+    if (node) __atomic_fetch_add(&node->refs, 1, __ATOMIC_RELAXED);
+    return node;
+}
+
+void _pbt_node_release(pbt_node *node) {
+    // Iterate down the right spine so long chains don't recurse as deeply
+    while (node && __atomic_fetch_sub(&node->refs, 1, __ATOMIC_ACQ_REL) == 1) {
+        pbt_node *right = node->right;
+
+        _pbt_node_release(node->left);
+        _pbt_entry_release(node->entry);
+        free(node);
+        node = right;
+    }
+}
+
+/*
+ * A node may be modified in place only if nothing but the version being
+ * written refers to it. Snapshots release their references from other
+ * threads, hence the acquire load.
+ */
+bool _pbt_node_exclusive(pbt_node *node) {
+    return __atomic_load_n(&node->refs, __ATOMIC_ACQUIRE) == 1;
+}
+
+// =============================== INIT/DESTROY  ===============================
+
+pbt_entry *_pbt_entry_init(char *key, void *data, size_t size) {
+    size_t keylen = strlen(key);
+    size_t offset = offsetof(pbt_entry, key) + keylen + 1;
+    pbt_entry *e;
+
+    // Round up so data is suitably aligned for any type
+    offset = (offset + _PBT_ALIGN - 1) / _PBT_ALIGN * _PBT_ALIGN;
+
+    e = malloc(offset + size);
+    if (!e) return NULL;
+
+    e->refs = 1;
+    e->size = size;
+    e->keylen = keylen;
+    e->data = (char *)e + offset;
+    memcpy(e->key, key, keylen + 1);
+    memcpy(e->data, data, size);
+
+    return e;
+}
+
+// Creates a node that takes over the caller's references to its arguments
+pbt_node *_pbt_node_init(pbt_entry *entry, pbt_node *left, pbt_node *right) {
+    pbt_node *n = malloc(sizeof(pbt_node));
+    if (!n) return NULL;
+
+    n->refs = 1;
+    n->entry = entry;
+    n->left = left;
+    n->right = right;
+
+    return n;
+}
+
+// Copies a shared node. The copy shares the original's entry and children.
+pbt_node *_pbt_node_copy(pbt_node *node) {
+    pbt_node *copy = _pbt_node_init(node->entry, node->left, node->right);
+    if (!copy) return NULL;
+
+    _pbt_entry_retain(copy->entry);
+    _pbt_node_retain(copy->left);
+    _pbt_node_retain(copy->right);
+
+    return copy;
+}
+
+int pbt_init(PBinTree **tree) {
+    PBinTree *t = NULL;
+
+    if (!tree) return _MAP_FAILURE;
+
+    t = *tree = malloc(sizeof(PBinTree));
+    if (!t) return _MAP_FAILURE;
+
+    t->root = NULL;
+    t->count = 0;
+
+    return _MAP_SUCCESS;
+}
+
+void pbt_free(PBinTree **tree) {
+    if (!tree || !(*tree)) return;
+
+    _pbt_node_release((*tree)->root);
+
+    free(*tree);
+    *tree = NULL;
+}
+
+int pbt_size(PBinTree *tree) {
+    if (!tree) return _MAP_FAILURE;
+
+    return (int)tree->count;
+}
+
+// ================================= INSERTION =================================
+
+/*
+ * Inserts into the subtree rooted at `node`, consuming the caller's reference
+ * to it and returning a reference to the new version of the subtree. On
+ * failure, the subtree is returned unchanged.
+ */
+pbt_node *_pbt_add(pbt_node *node, char *key, void *data, size_t size, int *status) {
+    pbt_node *target;
+    int cmp;
+
+    if (!node) {
+        // base case: empty subtree, create new leaf node
+        pbt_entry *e = _pbt_entry_init(key, data, size);
+        pbt_node *leaf = e ? _pbt_node_init(e, NULL, NULL) : NULL;
+
+        if (!leaf) {
+            if (e) _pbt_entry_release(e);
+            *status = _MAP_FAILURE;
+            return NULL;
+        }
+
+        *status = _MAP_SUCCESS;
+        return leaf;
+    }
+
+    // Copy the node unless this version is the only one using it
+    if (_pbt_node_exclusive(node)) {
+        target = node;
+    } else {
+        target = _pbt_node_copy(node);
+        if (!target) {
+            *status = _MAP_FAILURE;
+            return node;
+        }
+        _pbt_node_release(node);
+    }
+
+    cmp = strcmp(target->entry->key, key);
+    if (!cmp) {
+        // Entry with key already exists, replace it
+        pbt_entry *e = _pbt_entry_init(key, data, size);
+        if (!e) {
+            *status = _MAP_FAILURE;
+            return target;
+        }
+
+        _pbt_entry_release(target->entry);
+        target->entry = e;
+        *status = _MAP_SUCCESS_REPLACED;
+
+    } else if (cmp > 0) {
+        // node key > target key, so go left
+        target->left = _pbt_add(target->left, key, data, size, status);
+    } else {
+        // node key < target key, so go right
+        target->right = _pbt_add(target->right, key, data, size, status);
+    }
+
+    return target;
+}
+
+int pbt_add(PBinTree *tree, char *key, void *data, size_t size) {
+    int status = _MAP_FAILURE;
+
+    if (!tree || !key || !data) return _MAP_FAILURE;
+
+    tree->root = _pbt_add(tree->root, key, data, size, &status);
+    if (status == _MAP_SUCCESS) tree->count++;
+
+    return status;
+}
+
+// =================================== READ ====================================
+
+pbt_node *_pbt_get(pbt_node *node, char *key) {
+    while (node) {
+        int cmp = strcmp(node->entry->key, key);
+
+        if (!cmp)
+            return node;
+        else if (cmp > 0)
+            node = node->left;
+        else
+            node = node->right;
+    }
+
+    return NULL;
+}
+
+void *pbt_get(PBinTree *tree, char *key) {
+    pbt_node *node;
+
+    if (!tree || !key) return NULL;
+
+    node = _pbt_get(tree->root, key);
+    return node ? node->entry->data : NULL;
+}
+
+int pbt_has(PBinTree *tree, char *key) {
+    if (!tree || !key) return false;
+
+    return _pbt_get(tree->root, key) ? true : false;
+}
+
+// ================================= DELETION ==================================
+
+/*
+ * Removes the smallest entry from the subtree rooted at `node`, consuming the
+ * caller's reference to it. A reference to the removed entry is stored in
+ * `min`, which is left `NULL` on failure.
+ */
+pbt_node *_pbt_remove_min(pbt_node *node, pbt_entry **min) {
+    pbt_node *target;
+
+    assert(node);
+
+    if (!node->left) {
+        // Base case: node is the minimum, replace it with its right subtree
+        pbt_node *right = _pbt_node_retain(node->right);
+
+        *min = _pbt_entry_retain(node->entry);
+        _pbt_node_release(node);
+        return right;
+    }
+
+    if (_pbt_node_exclusive(node)) {
+        target = node;
+    } else {
+        target = _pbt_node_copy(node);
+        if (!target) {
+            *min = NULL;
+            return node;
+        }
+        _pbt_node_release(node);
+    }
+
+    target->left = _pbt_remove_min(target->left, min);
+    return target;
+}
+
+/*
+ * Removes `key` from the subtree rooted at `node`, consuming the caller's
+ * reference to it and returning a reference to the new version of the
+ * subtree. The key must exist in the subtree.
+ */
+pbt_node *_pbt_remove(pbt_node *node, char *key, int *status) {
+    pbt_node *target;
+    int cmp;
+
+    assert(node);
+
+    cmp = strcmp(node->entry->key, key);
+    if (!cmp && (!node->left || !node->right)) {
+        // Base case: leaf or only 1 child, replace node with its child subtree
+        pbt_node *child = _pbt_node_retain(node->left ? node->left : node->right);
+
+        _pbt_node_release(node);
+        *status = _MAP_SUCCESS;
+        return child;
+    }
+
+    // Copy the node unless this version is the only one using it
+    if (_pbt_node_exclusive(node)) {
+        target = node;
+    } else {
+        target = _pbt_node_copy(node);
+        if (!target) {
+            *status = _MAP_FAILURE;
+            return node;
+        }
+        _pbt_node_release(node);
+    }
+
+    if (!cmp) {
+        // Node has two children, replace its entry with right child's min entry
+        pbt_entry *min = NULL;
+
+        target->right = _pbt_remove_min(target->right, &min);
+        if (!min) {
+            *status = _MAP_FAILURE;
+            return target;
+        }
+
+        _pbt_entry_release(target->entry);
+        target->entry = min;
+        *status = _MAP_SUCCESS;
+
+    } else if (cmp > 0) {
+        // node key > target key, go left
+        target->left = _pbt_remove(target->left, key, status);
+    } else {
+        // node key < target key, go right
+        target->right = _pbt_remove(target->right, key, status);
+    }
+
+    return target;
+}
+
+int pbt_remove(PBinTree *tree, char *key) {
+    int status = _MAP_FAILURE;
+
+    if (!tree || !key) return _MAP_FAILURE;
+
+    // Check first, so a miss doesn't copy the search path for nothing
+    if (!_pbt_get(tree->root, key)) return _MAP_FAILURE;
+
+    tree->root = _pbt_remove(tree->root, key, &status);
+    if (status == _MAP_SUCCESS) tree->count--;
+
+    return status;
+}
+
+// ================================= SNAPSHOTS =================================
+
+int pbt_snapshot(PBinTree *tree, PBtSnapshot **snap) {
+    PBtSnapshot *s = NULL;
+
+    if (!tree || !snap) return _MAP_FAILURE;
+
+    s = malloc(sizeof(PBtSnapshot));
+    if (!s) return _MAP_FAILURE;
+
+    // Sharing the root marks the whole version as shared, so the next write
+    // copies its path instead of modifying it in place
+    s->root = _pbt_node_retain(tree->root);
+    s->count = tree->count;
+
+    *snap = s;
+    return _MAP_SUCCESS;
+}
+
+void pbt_snapshot_free(PBtSnapshot **snap) {
+    if (!snap || !(*snap)) return;
+
+    _pbt_node_release((*snap)->root);
+
+    free(*snap);
+    *snap = NULL;
+}
+
+int pbt_snapshot_size(PBtSnapshot *snap) {
+    if (!snap) return _MAP_FAILURE;
+
+    return (int)snap->count;
+}
+
+void *pbt_snapshot_get(PBtSnapshot *snap, char *key) {
+    pbt_node *node;
+
+    if (!snap || !key) return NULL;
+
+    node = _pbt_get(snap->root, key);
+    return node ? node->entry->data : NULL;
+}
+
+int pbt_snapshot_has(PBtSnapshot *snap, char *key) {
+    if (!snap || !key) return false;
+
+    return _pbt_get(snap->root, key) ? true : false;
+}
+
+int _pbt_for_each(pbt_node *node, map_visit_fn fn, void *ctx) {
+    if (!node) return _MAP_SUCCESS;
+
+    // In-order traversal
+    if (!_pbt_for_each(node->left, fn, ctx)) return _MAP_FAILURE;
+    if (fn(node->entry->key, node->entry->keylen, node->entry->data, node->entry->size, ctx)) return _MAP_FAILURE;
+    return _pbt_for_each(node->right, fn, ctx);
+}
+
+int pbt_snapshot_for_each(PBtSnapshot *snap, map_visit_fn fn, void *ctx) {
+    if (!snap || !fn) return _MAP_FAILURE;
+
+    return _pbt_for_each(snap->root, fn, ctx);
+}
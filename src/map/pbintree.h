@@ -0,0 +1,219 @@
+/**
+ * @file pbintree.h
+ * @brief A persistent Binary Search Tree with O(1) snapshots.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup pbt Persistent Binary Search Tree
+ * A key/value map with the same semantics as `bintree.h`, except that older
+ * versions of the tree can be kept alive as immutable snapshots.
+ *
+ * Insertions and removals copy only the nodes on the path from the root to the
+ * modified entry and share every other node with the previous version. Nodes
+ * and entries are reference counted and freed once no version of the tree uses
+ * them. When no snapshot shares a node, it is modified in place instead of
+ * being copied, so a tree without snapshots behaves like a BinTree.
+ */
+#ifndef __PBINTREE_H__
+#define __PBINTREE_H__
+
+#include <stdlib.h>
+
+#include "map.h"
+
+/**
+ * @brief A persistent Binary Search Tree storing key/value pairs.
+ *
+ * Keys are compared using `strcmp`. Both keys and data are copied into the
+ * tree.
+ *
+ * Writes and `pbt_snapshot()` must be serialized, just like for a BinTree.
+ * Snapshots, however, may be read and released from any thread without
+ * synchronizing with the writer.
+ *
+ * @ingroup pbt
+ */
+typedef struct pbt_tree PBinTree;
+
+/**
+ * @brief An immutable, point-in-time view of a PBinTree.
+ *
+ * @ingroup pbt
+ */
+typedef struct pbt_snapshot PBtSnapshot;
+
+/**
+ * @brief Constructs a new PBinTree.
+ *
+ * @ingroup pbt
+ *
+ * @param tree A pointer to the tree to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int pbt_init(PBinTree **tree);
+
+/**
+ * @brief Destroys a PBinTree.
+ *
+ * Nodes that are still used by a snapshot stay alive until the snapshot is
+ * released. After destruction, the tree will be set to `NULL`.
+ *
+ * @ingroup pbt
+ *
+ * @param tree A pointer to the tree to destroy.
+ */
+void pbt_free(PBinTree **tree);
+
+/**
+ * @brief Gets the number of entries in a PBinTree.
+ *
+ * @ingroup pbt
+ *
+ * @param tree The target tree.
+ *
+ * @return int The number of entries in the tree, or 0 on failure.
+ */
+int pbt_size(PBinTree *tree);
+
+/**
+ * @brief Inserts an entry into a PBinTree.
+ *
+ * If an entry under `key` already exists, it is replaced. Snapshots taken
+ * before the call still see the old entry.
+ *
+ * @ingroup pbt
+ *
+ * @param tree The tree to insert into.
+ * @param key  The entry key.
+ * @param data The data stored in the entry.
+ * @param size The size of `data`.
+ *
+ * @return int A positive number on success, 0 on failure. If an existing entry
+ * is replaced, 2 is returned.
+ */
+int pbt_add(PBinTree *tree, char *key, void *data, size_t size);
+
+/**
+ * @brief Searches the current version of a PBinTree for an entry.
+ *
+ * The returned pointer stays valid until the entry is replaced or removed, or
+ * as long as a snapshot that contains the entry is alive.
+ *
+ * @ingroup pbt
+ *
+ * @param tree The tree to search.
+ * @param key  The entry key.
+ *
+ * @return void* A pointer to the entry data, or `NULL` if no entry exists for
+ * the given key.
+ */
+void *pbt_get(PBinTree *tree, char *key);
+
+/**
+ * @brief Checks if an entry exists in the current version of a PBinTree.
+ *
+ * @ingroup pbt
+ *
+ * @param tree The tree to search.
+ * @param key  The entry key.
+ *
+ * @return int 1 if an entry exists for `key`, 0 if one does not.
+ */
+int pbt_has(PBinTree *tree, char *key);
+
+/**
+ * @brief Removes an entry from a PBinTree.
+ *
+ * Snapshots taken before the call still see the entry.
+ *
+ * @ingroup pbt
+ *
+ * @param tree The tree to remove the entry from.
+ * @param key  The entry key.
+ *
+ * @return int 1 if the entry existed and was removed, 0 otherwise.
+ */
+int pbt_remove(PBinTree *tree, char *key);
+
+/**
+ * @brief Takes a snapshot of the current version of a PBinTree in O(1).
+ *
+ * The snapshot is unaffected by later writes to the tree and outlives it. It
+ * must be released with `pbt_snapshot_free()`.
+ *
+ * @ingroup pbt
+ *
+ * @param tree The tree to snapshot.
+ * @param snap Set to the new snapshot.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int pbt_snapshot(PBinTree *tree, PBtSnapshot **snap);
+
+/**
+ * @brief Releases a snapshot, freeing nodes no other version uses.
+ *
+ * After release, the snapshot will be set to `NULL`.
+ *
+ * @ingroup pbt
+ *
+ * @param snap A pointer to the snapshot to release.
+ */
+void pbt_snapshot_free(PBtSnapshot **snap);
+
+/**
+ * @brief Gets the number of entries in a snapshot.
+ *
+ * @ingroup pbt
+ *
+ * @param snap The target snapshot.
+ *
+ * @return int The number of entries in the snapshot, or 0 on failure.
+ */
+int pbt_snapshot_size(PBtSnapshot *snap);
+
+/**
+ * @brief Searches a snapshot for an entry.
+ *
+ * The returned pointer is valid until the snapshot is released.
+ *
+ * @ingroup pbt
+ *
+ * @param snap The snapshot to search.
+ * @param key  The entry key.
+ *
+ * @return void* A pointer to the entry data, or `NULL` if no entry exists for
+ * the given key.
+ */
+void *pbt_snapshot_get(PBtSnapshot *snap, char *key);
+
+/**
+ * @brief Checks if an entry exists in a snapshot.
+ *
+ * @ingroup pbt
+ *
+ * @param snap The snapshot to search.
+ * @param key  The entry key.
+ *
+ * @return int 1 if an entry exists for `key`, 0 if one does not.
+ */
+int pbt_snapshot_has(PBtSnapshot *snap, char *key);
+
+/**
+ * @brief Visits every entry of a snapshot in key order.
+ *
+ * @ingroup pbt
+ *
+ * @param snap The snapshot to iterate over.
+ * @param fn   Called once per entry. Returning non-zero stops the iteration.
+ * @param ctx  Passed to `fn`.
+ *
+ * @return int 1 if every entry was visited, 0 if `fn` stopped the iteration or
+ * on failure.
+ */
+int pbt_snapshot_for_each(PBtSnapshot *snap, map_visit_fn fn, void *ctx);
+
+#endif
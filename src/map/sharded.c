@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: MIT
+#define _POSIX_C_SOURCE 200809L
+
+#include "sharded.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../util/stats.h"
+#include "bintree.h"
+
+// Assumed size of a cache line. Shards are padded to a multiple of this so
+// that two shard locks never share a line.
+#define _SHARDED_CACHE_LINE 64
+
+typedef struct sharded_shard {
+    pthread_mutex_t lock;  // guards tree
+    BinTree *tree;         // entries hashed to this shard
+    size_t count;          // number of entries; written under lock, read without
+} sharded_shard;
+
+// A shard padded out to a whole number of cache lines
+typedef union sharded_slot {
+    sharded_shard shard;
+    char pad[((sizeof(sharded_shard) + _SHARDED_CACHE_LINE - 1) / _SHARDED_CACHE_LINE) * _SHARDED_CACHE_LINE];
+} sharded_slot;
+
+struct sharded_map {
+    sharded_slot *slots;  // cache-line aligned shard array
+    size_t nshards;       // number of shards in `slots`
+};
+
+// =============================== PRIVATE UTILS ===============================
+
+/*
+ * 64-bit FNV-1a. Cheap, and good enough to spread string keys evenly across a
+ * handful of shards.
+ */
+uint64_t _sharded_hash(const char *key) {
+    uint64_t h = 14695981039346656037ULL;
+
+    while (*key) {
+        h ^= (unsigned char)*key++;
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+sharded_shard *_sharded_shard_for(ShardedMap *map, const char *key) {
+    assert(map);
+    assert(key);
+
+    return &map->slots[_sharded_hash(key) % map->nshards].shard;
+}
+
+// =============================== INIT/DESTROY  ===============================
+
+int sharded_init_with_shards(ShardedMap **map, size_t nshards) {
+    ShardedMap *m = NULL;
+    void *slots = NULL;
+    size_t i;
+
+    if (!map || !nshards) return _MAP_FAILURE;
+
+    m = malloc(sizeof(ShardedMap));
+    if (!m) return _MAP_FAILURE;
+
+    // posix_memalign() returns an error code instead of setting errno
+    errno = posix_memalign(&slots, _SHARDED_CACHE_LINE, nshards * sizeof(sharded_slot));
+    if (errno) {
+        free(m);
+        return _MAP_FAILURE;
+    }
+    m->slots = slots;
+    m->nshards = nshards;
+
+    for (i = 0; i < nshards; i++) {
+        sharded_shard *s = &m->slots[i].shard;
+        s->count = 0;
+        if (!bt_init(&s->tree)) goto sharded_init_err;
+        if ((errno = pthread_mutex_init(&s->lock, NULL))) {
+            bt_free(&s->tree);
+            goto sharded_init_err;
+        }
+    }
+
+    *map = m;
+    return _MAP_SUCCESS;
+
+sharded_init_err:
+    // Tear down the shards that were fully initialized
+    while (i--) {
+        pthread_mutex_destroy(&m->slots[i].shard.lock);
+        bt_free(&m->slots[i].shard.tree);
+    }
+    free(m->slots);
+    free(m);
+    return _MAP_FAILURE;
+}
+
+int sharded_init(ShardedMap **map) {
+    return sharded_init_with_shards(map, SHARDED_DEFAULT_SHARDS);
+}
+
+void sharded_free(ShardedMap **map) {
+    size_t i;
+
+    if (!map || !(*map)) return;
+
+    for (i = 0; i < (*map)->nshards; i++) {
+        sharded_shard *s = &(*map)->slots[i].shard;
+        pthread_mutex_destroy(&s->lock);
+        bt_free(&s->tree);
+    }
+
+    free((*map)->slots);
+    free(*map);
+    *map = NULL;
+}
+
+size_t sharded_shards(ShardedMap *map) {
+    return map ? map->nshards : 0;
+}
+
+// ================================= INSERTION =================================
+
+int sharded_add(ShardedMap *map, char *key, void *data, size_t size) {
+    sharded_shard *s;
+    int ret;
+
+    if (!map || !key || !data) return _MAP_FAILURE;
+
+    s = _sharded_shard_for(map, key);
+    pthread_mutex_lock(&s->lock);
+    ret = bt_add(s->tree, key, data, size);
+    if (ret == _MAP_SUCCESS) __atomic_store_n(&s->count, s->count + 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
+
+// =================================== READ ====================================
+
+int sharded_get(ShardedMap *map, char *key, void *dst, size_t *size) {
+    sharded_shard *s;
+    void *data;
+    size_t stored = 0;
+    int fits;
+
+    if (!map || !key || !dst || !size) return _MAP_FAILURE;
+
+    s = _sharded_shard_for(map, key);
+    pthread_mutex_lock(&s->lock);
+    data = bt_get_with_size(s->tree, key, &stored);
+    fits = data && stored <= *size;
+    if (fits) memcpy(dst, data, stored);
+    pthread_mutex_unlock(&s->lock);
+
+    *size = data ? stored : 0;
+    return fits ? _MAP_SUCCESS : _MAP_FAILURE;
+}
+
+int sharded_has(ShardedMap *map, char *key) {
+    sharded_shard *s;
+    int ret;
+
+    if (!map || !key) return _MAP_FAILURE;
+
+    s = _sharded_shard_for(map, key);
+    pthread_mutex_lock(&s->lock);
+    ret = bt_has(s->tree, key);
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
+
+size_t sharded_size(ShardedMap *map) {
+    size_t i, total = 0;
+
+    if (!map) return 0;
+
+    for (i = 0; i < map->nshards; i++) {
+        total += __atomic_load_n(&map->slots[i].shard.count, __ATOMIC_RELAXED);
+    }
+
+    return total;
+}
+
+int sharded_stats(ShardedMap *map, MapStats *out) {
+    MapStats shard;
+    size_t i;
+
+    if (!out) return _MAP_FAILURE;
+
+    memset(out, 0, sizeof(MapStats));
+    if (!map) return _MAP_FAILURE;
+
+    for (i = 0; i < map->nshards; i++) {
+        if (!bt_stats(map->slots[i].shard.tree, &shard)) return _MAP_FAILURE;
+        map_stats_merge(out, &shard);
+    }
+
+    return _MAP_SUCCESS;
+}
+
+// ================================= DELETION ==================================
+
+int sharded_remove(ShardedMap *map, char *key) {
+    sharded_shard *s;
+    int ret;
+
+    if (!map || !key) return _MAP_FAILURE;
+
+    s = _sharded_shard_for(map, key);
+    pthread_mutex_lock(&s->lock);
+    ret = bt_remove(s->tree, key);
+    if (ret == _MAP_SUCCESS) __atomic_store_n(&s->count, s->count - 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
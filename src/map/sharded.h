@@ -0,0 +1,182 @@
+/**
+ * @file sharded.h
+ * @brief A thread-safe key/value map that spreads entries across several
+ * independently locked BinTrees.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup sharded Sharded Map
+ * Each key is hashed to one of N shards. Every shard is a BinTree guarded by
+ * its own lock, and shards are padded to separate cache lines so that threads
+ * working on different shards do not contend with each other.
+ *
+ * Operations on different shards run in parallel; operations on the same shard
+ * are serialized. Return codes follow `map.h`.
+ */
+#ifndef __SHARDED_H__
+#define __SHARDED_H__
+
+#include <stdlib.h>
+
+#include "map.h"
+
+/**
+ * @brief The number of shards used by `sharded_init()`.
+ *
+ * @ingroup sharded
+ */
+#define SHARDED_DEFAULT_SHARDS 16
+
+/**
+ * @brief A concurrent map made of independently locked BinTree shards.
+ *
+ * Unlike a BinTree, entry data is never handed out by pointer, since another
+ * thread may replace or remove the entry as soon as the shard lock is
+ * released. `sharded_get()` copies entry data into caller memory instead.
+ *
+ * @ingroup sharded
+ */
+typedef struct sharded_map ShardedMap;
+
+/**
+ * @brief Constructs a new ShardedMap with `SHARDED_DEFAULT_SHARDS` shards.
+ *
+ * @ingroup sharded
+ *
+ * @param map A pointer to the map to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int sharded_init(ShardedMap **map);
+
+/**
+ * @brief Constructs a new ShardedMap with a specific number of shards.
+ *
+ * @ingroup sharded
+ *
+ * @param map     A pointer to the map to construct.
+ * @param nshards The number of shards. Must be greater than 0.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int sharded_init_with_shards(ShardedMap **map, size_t nshards);
+
+/**
+ * @brief Destroys a ShardedMap and frees all resources associated with it.
+ *
+ * No other thread may be using the map. After destruction, the map will be
+ * set to `NULL`.
+ *
+ * @ingroup sharded
+ *
+ * @param map A pointer to the map to destroy.
+ */
+void sharded_free(ShardedMap **map);
+
+/**
+ * @brief Gets the number of shards in a ShardedMap.
+ *
+ * @ingroup sharded
+ *
+ * @param map The target map.
+ *
+ * @return size_t The shard count, or 0 if `map` is `NULL`.
+ */
+size_t sharded_shards(ShardedMap *map);
+
+/**
+ * @brief Inserts an entry into a ShardedMap.
+ *
+ * Behaves like `bt_add()`: both the key and data are copied, and an existing
+ * entry under `key` is replaced.
+ *
+ * @ingroup sharded
+ *
+ * @param map  The map to insert into.
+ * @param key  The entry key.
+ * @param data The data stored in the entry.
+ * @param size The size of `data`.
+ *
+ * @return int A positive number on success, 0 on failure. If an existing entry
+ * is replaced, 2 is returned.
+ */
+int sharded_add(ShardedMap *map, char *key, void *data, size_t size);
+
+/**
+ * @brief Copies the data stored under a key into `dst`.
+ *
+ * On entry `*size` is the capacity of `dst`. On return it is the size of the
+ * stored entry, or 0 if there is none. Only the stored bytes are copied, so
+ * the rest of a larger `dst` is left as it was. An entry larger than `dst` is
+ * not copied at all and the call fails, and the caller can tell this apart
+ * from a missing key by the nonzero `*size`, then retry with a buffer that
+ * large.
+ *
+ * @ingroup sharded
+ *
+ * @param map  The map to search.
+ * @param key  The entry key.
+ * @param dst  Where to copy the entry data.
+ * @param size The capacity of `dst`, replaced by the size of the entry.
+ *
+ * @return int 1 if the entry exists and was copied, 0 if it does not exist,
+ * does not fit in `dst`, or on error.
+ */
+int sharded_get(ShardedMap *map, char *key, void *dst, size_t *size);
+
+/**
+ * @brief Checks if an entry exists under a key.
+ *
+ * @ingroup sharded
+ *
+ * @param map The map to search.
+ * @param key The entry key.
+ *
+ * @return int 1 if an entry exists for `key`, 0 if one does not.
+ */
+int sharded_has(ShardedMap *map, char *key);
+
+/**
+ * @brief Removes an entry from a ShardedMap, freeing its memory resources.
+ *
+ * @ingroup sharded
+ *
+ * @param map The map to remove the entry from.
+ * @param key The entry key.
+ *
+ * @return int 1 if the entry existed and was removed, 0 otherwise.
+ */
+int sharded_remove(ShardedMap *map, char *key);
+
+/**
+ * @brief Gets the number of entries in a ShardedMap.
+ *
+ * Per-shard counts are summed without taking any locks. While other threads
+ * are writing, the result is a point-in-time estimate that may be off by the
+ * number of in-flight insertions and removals.
+ *
+ * @ingroup sharded
+ *
+ * @param map The target map.
+ *
+ * @return size_t The number of entries in the map.
+ */
+size_t sharded_size(ShardedMap *map);
+
+/**
+ * @brief Reads a ShardedMap's operation counters, summed over every shard.
+ *
+ * See `bt_stats()`. Like `sharded_size()`, this takes no locks.
+ *
+ * @ingroup sharded
+ *
+ * @param map The target map.
+ * @param out Set to the counters. Zeroed if stats are not compiled in.
+ *
+ * @return int 1 on success, 0 if stats are not compiled in or on failure.
+ */
+int sharded_stats(ShardedMap *map, MapStats *out);
+
+#endif
@@ -0,0 +1,4 @@
+// SPDX-License-Identifier: MIT
+#include "u64tree.h"
+
+BT_GENERATE(u64t, U64Tree, uint64_t, BT_CMP_NUMERIC)
@@ -0,0 +1,27 @@
+/**
+ * @file u64tree.h
+ * @brief A Binary Search Tree keyed by 64-bit unsigned integers.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup u64t U64Tree
+ * A BinTree specialization generated by `BT_GENERATE()` (see `bintree_gen.h`)
+ * for `uint64_t` keys. Keys are stored by value and compared numerically with
+ * inlined comparisons, so integer-keyed maps need neither formatting keys into
+ * strings nor copying them, and entries are visited in numeric order.
+ *
+ * Functions are prefixed with `u64t_` and otherwise match those listed in
+ * `bintree_gen.h`, e.g. `u64t_add(tree, 42, &value, sizeof(value))`.
+ */
+#ifndef __U64TREE_H__
+#define __U64TREE_H__
+
+#include <stdint.h>
+
+#include "bintree_gen.h"
+
+BT_GENERATE_PROTOTYPES(u64t, U64Tree, uint64_t)
+
+#endif
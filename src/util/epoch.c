@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: MIT
+#define _POSIX_C_SOURCE 200809L
+
+#include "epoch.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Number of retirements between automatic collection attempts
+#define _EBR_COLLECT_INTERVAL 64
+// Initial capacity of a limbo list
+#define _EBR_LIMBO_INIT 16
+
+typedef struct ebr_entry {
+    void *ptr;               // retired object
+    ebr_reclaim_fn reclaim;  // frees ptr
+    void *ctx;               // passed to reclaim
+} ebr_entry;
+
+/*
+ * Objects retired during one epoch. An object retired in epoch e is safe to
+ * reclaim once the global epoch reaches e + 2, so three lists per thread are
+ * enough.
+ */
+typedef struct ebr_limbo {
+    ebr_entry *items;
+    size_t len, cap;
+    uint64_t epoch;  // epoch the items were retired in
+} ebr_limbo;
+
+typedef struct ebr_thread {
+    uint64_t state;             // (local epoch << 1) | active, read by other threads
+    unsigned nesting;           // critical section nesting depth
+    size_t retired;             // retirements since the last collection
+    int orphaned;               // set once the owning thread has exited
+    ebr_limbo limbo[3];         // objects waiting to be reclaimed
+    EpochDomain *domain;        // owning domain
+    struct ebr_thread *next;    // next registered thread
+} ebr_thread;
+
+struct ebr_domain {
+    uint64_t epoch;         // global epoch
+    pthread_mutex_t lock;   // guards threads
+    ebr_thread *threads;    // every thread that has used this domain
+    pthread_key_t key;      // the calling thread's ebr_thread
+};
+
+// =============================== PRIVATE UTILS ===============================
+
+void _ebr_limbo_reclaim(ebr_limbo *limbo) {
+    for (size_t i = 0; i < limbo->len; i++) {
+        limbo->items[i].reclaim(limbo->items[i].ptr, limbo->items[i].ctx);
+    }
+    limbo->len = 0;
+}
+
+// Reclaims every limbo list that is two or more epochs behind `epoch`
+void _ebr_thread_reclaim(ebr_thread *t, uint64_t epoch) {
+    for (int i = 0; i < 3; i++) {
+        if (t->limbo[i].len && t->limbo[i].epoch + 2 <= epoch) {
+            _ebr_limbo_reclaim(&t->limbo[i]);
+        }
+    }
+}
+
+// Reclaims everything a thread still holds, and frees its record
+void _ebr_thread_destroy(ebr_thread *t) {
+    for (int i = 0; i < 3; i++) {
+        _ebr_limbo_reclaim(&t->limbo[i]);
+        free(t->limbo[i].items);
+    }
+    free(t);
+}
+
+/*
+ * Reclaims for threads that have exited, since nobody else will, and unlinks
+ * their records once nothing is left in limbo. Otherwise every short-lived
+ * thread would leave a record behind for the life of the domain. Called with
+ * the lock held.
+ */
+void _ebr_prune(EpochDomain *ebr, uint64_t epoch) {
+    ebr_thread **link = &ebr->threads, *t;
+
+    while ((t = *link)) {
+        if (!t->orphaned) {
+            link = &t->next;
+            continue;
+        }
+
+        _ebr_thread_reclaim(t, epoch);
+        if (t->limbo[0].len || t->limbo[1].len || t->limbo[2].len) {
+            link = &t->next;
+            continue;
+        }
+
+        *link = t->next;
+        _ebr_thread_destroy(t);
+    }
+}
+
+// pthread key destructor; runs when a registered thread exits
+void _ebr_thread_exit(void *arg) {
+    ebr_thread *t = arg;
+    EpochDomain *ebr = t->domain;
+
+    // A thread exiting inside a critical section must not stall the domain
+    __atomic_store_n(&t->state, 0, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&ebr->lock);
+    t->orphaned = 1;
+    _ebr_prune(ebr, __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST));
+    pthread_mutex_unlock(&ebr->lock);
+}
+
+ebr_thread *_ebr_thread(EpochDomain *ebr) {
+    ebr_thread *t = pthread_getspecific(ebr->key);
+
+    if (t) return t;
+
+    // First use by this thread, register it
+    t = calloc(1, sizeof(ebr_thread));
+    if (!t) return NULL;
+    t->domain = ebr;
+
+    if (pthread_setspecific(ebr->key, t)) {
+        free(t);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&ebr->lock);
+    t->next = ebr->threads;
+    ebr->threads = t;
+    pthread_mutex_unlock(&ebr->lock);
+
+    return t;
+}
+
+/*
+ * Advances the global epoch if every active reader has observed the current
+ * one, then reclaims for exited threads at the new epoch. Returns the global
+ * epoch after the attempt.
+ */
+uint64_t _ebr_try_advance(EpochDomain *ebr) {
+    uint64_t epoch = __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST);
+    ebr_thread *t;
+
+    pthread_mutex_lock(&ebr->lock);
+    for (t = ebr->threads; t; t = t->next) {
+        uint64_t state = __atomic_load_n(&t->state, __ATOMIC_SEQ_CST);
+        if ((state & 1) && (state >> 1) != epoch) {
+            // A reader is still in the previous epoch
+            pthread_mutex_unlock(&ebr->lock);
+            return epoch;
+        }
+    }
+
+    // Losing this race is fine, someone else advanced the epoch for us
+    __atomic_compare_exchange_n(&ebr->epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST);
+
+    _ebr_prune(ebr, epoch);
+    pthread_mutex_unlock(&ebr->lock);
+    return epoch;
+}
+
+// =============================== INIT/DESTROY  ===============================
+
+int ebr_init(EpochDomain **ebr) {
+    EpochDomain *d = NULL;
+
+    if (!ebr) return 0;
+
+    d = malloc(sizeof(EpochDomain));
+    if (!d) return 0;
+
+    d->epoch = 0;
+    d->threads = NULL;
+    if (pthread_mutex_init(&d->lock, NULL)) {
+        free(d);
+        return 0;
+    }
+    if (pthread_key_create(&d->key, _ebr_thread_exit)) {
+        pthread_mutex_destroy(&d->lock);
+        free(d);
+        return 0;
+    }
+
+    *ebr = d;
+    return 1;
+}
+
+void ebr_free(EpochDomain **ebr) {
+    ebr_thread *t, *next;
+
+    if (!ebr || !(*ebr)) return;
+
+    // Stops destructors from running for threads that exit later
+    pthread_key_delete((*ebr)->key);
+
+    for (t = (*ebr)->threads; t; t = next) {
+        next = t->next;
+        _ebr_thread_destroy(t);
+    }
+
+    pthread_mutex_destroy(&(*ebr)->lock);
+    free(*ebr);
+    *ebr = NULL;
+}
+
+// ============================ CRITICAL SECTIONS ==============================
+
+int ebr_enter(EpochDomain *ebr) {
+    ebr_thread *t;
+    uint64_t epoch;
+
+    if (!ebr) return 0;
+
+    t = _ebr_thread(ebr);
+    if (!t) return 0;
+
+    if (t->nesting++) return 1;
+
+    /*
+     * Publish the epoch we are entering, then make sure it is still current.
+     * Otherwise the global epoch could have moved on twice between reading it
+     * and announcing it, and objects retired in our stale epoch could be freed
+     * while we read them.
+     */
+    do {
+        epoch = __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&t->state, (epoch << 1) | 1, __ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST) != epoch);
+
+    return 1;
+}
+
+void ebr_exit(EpochDomain *ebr) {
+    ebr_thread *t;
+
+    if (!ebr) return;
+
+    t = pthread_getspecific(ebr->key);
+    assert(t && t->nesting);
+    if (!t || !t->nesting) return;
+
+    if (!--t->nesting) __atomic_store_n(&t->state, 0, __ATOMIC_RELEASE);
+}
+
+// ================================ RECLAMATION ================================
+
+void ebr_retire(EpochDomain *ebr, void *ptr, ebr_reclaim_fn reclaim, void *ctx) {
+    ebr_thread *t;
+    ebr_limbo *limbo;
+    uint64_t epoch;
+
+    assert(ebr);
+    assert(reclaim);
+
+    /*
+     * Read the epoch with a read-modify-write, which also orders the caller's
+     * unlinking store before the read. A plain load could be satisfied before
+     * that store becomes visible to readers.
+     */
+    epoch = __atomic_fetch_add(&ebr->epoch, 0, __ATOMIC_SEQ_CST);
+
+    t = _ebr_thread(ebr);
+    limbo = t ? &t->limbo[epoch % 3] : NULL;
+
+    if (limbo && limbo->epoch != epoch) {
+        // The list holds objects from epoch - 3 or earlier, which are now safe
+        _ebr_limbo_reclaim(limbo);
+        limbo->epoch = epoch;
+    }
+
+    if (limbo && limbo->len == limbo->cap) {
+        size_t cap = limbo->cap ? limbo->cap * 2 : _EBR_LIMBO_INIT;
+        ebr_entry *items = realloc(limbo->items, cap * sizeof(ebr_entry));
+        if (items) {
+            limbo->items = items;
+            limbo->cap = cap;
+        }
+    }
+
+    if (!limbo || limbo->len == limbo->cap) {
+        // Out of memory. Wait out the grace period and reclaim synchronously.
+        while (_ebr_try_advance(ebr) < epoch + 2) sched_yield();
+        reclaim(ptr, ctx);
+        return;
+    }
+
+    limbo->items[limbo->len++] = (ebr_entry){ptr, reclaim, ctx};
+
+    if (++t->retired >= _EBR_COLLECT_INTERVAL) ebr_collect(ebr);
+}
+
+void ebr_collect(EpochDomain *ebr) {
+    ebr_thread *t;
+    uint64_t epoch;
+
+    if (!ebr) return;
+
+    t = _ebr_thread(ebr);
+    epoch = _ebr_try_advance(ebr);
+    if (!t) return;
+
+    t->retired = 0;
+    _ebr_thread_reclaim(t, epoch);
+}
+
+void ebr_synchronize(EpochDomain *ebr) {
+    ebr_thread *t;
+    uint64_t target;
+
+    if (!ebr) return;
+
+    t = _ebr_thread(ebr);
+    if (!t) return;
+    assert(!t->nesting);
+
+    // Everything retired so far was retired in an epoch <= target - 2
+    target = __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST) + 2;
+    while (_ebr_try_advance(ebr) < target) sched_yield();
+
+    t->retired = 0;
+    _ebr_thread_reclaim(t, target);
+}
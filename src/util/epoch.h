@@ -0,0 +1,136 @@
+/**
+ * @file epoch.h
+ * @brief Epoch-based memory reclamation.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup ebr Epoch-Based Reclamation
+ * Lets readers use memory that writers concurrently unlink without taking any
+ * locks.
+ *
+ * Readers bracket their accesses with `ebr_enter()` and `ebr_exit()`. Writers
+ * unlink an object so that no new reader can reach it, then hand it to
+ * `ebr_retire()` instead of freeing it. Retired objects are kept on per-thread
+ * limbo lists and are only reclaimed after every reader that was active when
+ * the object was retired has exited.
+ *
+ * Threads are registered with a domain automatically on first use, and
+ * unregistered once they have exited and everything they retired has been
+ * reclaimed, so a domain can outlive any number of short-lived threads.
+ */
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include <stdlib.h>
+
+/**
+ * @brief A reclamation domain shared by a set of readers and writers.
+ *
+ * @ingroup ebr
+ */
+typedef struct ebr_domain EpochDomain;
+
+/**
+ * @brief Frees a retired object.
+ *
+ * @ingroup ebr
+ *
+ * @param ptr The retired object.
+ * @param ctx The context pointer passed to `ebr_retire()`.
+ */
+typedef void (*ebr_reclaim_fn)(void *ptr, void *ctx);
+
+/**
+ * @brief Constructs a new EpochDomain.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr A pointer to the domain to construct.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int ebr_init(EpochDomain **ebr);
+
+/**
+ * @brief Destroys an EpochDomain, reclaiming every object that is still
+ * retired.
+ *
+ * No other thread may be inside a critical section or use the domain again.
+ * After destruction, the domain will be set to `NULL`.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr A pointer to the domain to destroy.
+ */
+void ebr_free(EpochDomain **ebr);
+
+/**
+ * @brief Enters a read-side critical section.
+ *
+ * Memory reachable from a shared structure when this is called stays valid
+ * until the matching `ebr_exit()`. Critical sections may be nested.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr The domain to enter.
+ *
+ * @return int 1 on success, 0 if the calling thread could not be registered.
+ */
+int ebr_enter(EpochDomain *ebr);
+
+/**
+ * @brief Exits a read-side critical section.
+ *
+ * Pointers obtained inside the critical section must not be used afterwards.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr The domain to exit.
+ */
+void ebr_exit(EpochDomain *ebr);
+
+/**
+ * @brief Schedules an unlinked object to be reclaimed once no reader can
+ * still be using it.
+ *
+ * The object must already be unreachable for readers that enter after this
+ * call. `reclaim` is invoked exactly once, possibly from a different thread.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr     The domain readers of the object are using.
+ * @param ptr     The object to retire.
+ * @param reclaim Frees the object.
+ * @param ctx     Passed to `reclaim` alongside `ptr`.
+ */
+void ebr_retire(EpochDomain *ebr, void *ptr, ebr_reclaim_fn reclaim, void *ctx);
+
+/**
+ * @brief Tries to advance the global epoch and reclaims retired objects that
+ * have become safe to free.
+ *
+ * This is called periodically by `ebr_retire()`, so calling it directly is
+ * rarely needed. It never blocks on readers.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr The target domain.
+ */
+void ebr_collect(EpochDomain *ebr);
+
+/**
+ * @brief Waits until every object retired by the calling thread has been
+ * reclaimed.
+ *
+ * Blocks until all readers that were active at the time of the call have
+ * exited. Must not be called from inside a critical section.
+ *
+ * @ingroup ebr
+ *
+ * @param ebr The target domain.
+ */
+void ebr_synchronize(EpochDomain *ebr);
+
+#endif
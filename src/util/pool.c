@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: MIT
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tasks a thread can have queued. Lazily split tasks rarely queue more than a
+// few, so a full deque means spawning is not worth it anyway.
+#define _POOL_DEQUE_SIZE 256
+
+struct pool_worker {
+    WorkPool *pool;
+    unsigned index;        // position in the pool's workers array
+    pthread_t thread;      // unused for worker 0, the caller of pool_run()
+    pthread_mutex_t lock;  // guards the deque
+    size_t top, bottom;    // queued tasks are tasks[top, bottom), modulo the size
+    PoolTask tasks[_POOL_DEQUE_SIZE];
+};
+
+struct work_pool {
+    PoolWorker *workers;    // threads, the caller of pool_run() first
+    unsigned threads;       // number of workers
+    size_t pending;         // tasks queued or running in the current computation
+    unsigned idle;          // workers looking for a task to steal
+    uint64_t generation;    // computations started, wakes sleeping workers
+    bool stop;              // set to make workers exit
+    pthread_mutex_t lock;   // guards generation and stop
+    pthread_cond_t wake;    // signalled when either changes
+    unsigned started;       // threads started so far, for cleanup
+};
+
+// =================================== DEQUE ===================================
+
+// Pops the newest task queued by this thread
+static bool _pool_pop(PoolWorker *w, PoolTask *out) {
+    bool found = false;
+
+    if (__atomic_load_n(&w->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&w->top, __ATOMIC_RELAXED)) return false;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom > w->top) {
+        __atomic_store_n(&w->bottom, w->bottom - 1, __ATOMIC_RELAXED);
+        *out = w->tasks[w->bottom % _POOL_DEQUE_SIZE];
+        found = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return found;
+}
+
+// Takes the oldest task queued by another thread
+static bool _pool_steal(PoolWorker *victim, PoolTask *out) {
+    bool found = false;
+
+    // Check before locking, so idle threads don't contend with busy ones
+    if (__atomic_load_n(&victim->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&victim->top, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&victim->lock);
+    if (victim->bottom > victim->top) {
+        *out = victim->tasks[victim->top % _POOL_DEQUE_SIZE];
+        __atomic_store_n(&victim->top, victim->top + 1, __ATOMIC_RELAXED);
+        found = true;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    return found;
+}
+
+void pool_spawn(PoolWorker *worker, const PoolTask *task) {
+    PoolTask inline_task;
+    bool queued = false;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->bottom - worker->top < _POOL_DEQUE_SIZE) {
+        // The spawning task is still pending, so the count can't reach 0 here
+        __atomic_fetch_add(&worker->pool->pending, 1, __ATOMIC_RELAXED);
+        worker->tasks[worker->bottom % _POOL_DEQUE_SIZE] = *task;
+        __atomic_store_n(&worker->bottom, worker->bottom + 1, __ATOMIC_RELAXED);
+        queued = true;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    if (!queued) {
+        inline_task = *task;
+        inline_task.fn(worker, &inline_task);
+    }
+}
+
+int pool_hungry(PoolWorker *worker) {
+    return __atomic_load_n(&worker->pool->idle, __ATOMIC_RELAXED) &&
+           __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&worker->top, __ATOMIC_RELAXED);
+}
+
+unsigned pool_worker_index(PoolWorker *worker) {
+    return worker->index;
+}
+
+// ================================== WORKERS ==================================
+
+// Runs this thread's tasks, then other threads' ones, until none are pending
+static void _pool_work(PoolWorker *w) {
+    WorkPool *pool = w->pool;
+    bool idle = false;
+    PoolTask task;
+
+    while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE)) {
+        bool found = _pool_pop(w, &task);
+
+        for (unsigned i = 1; !found && i < pool->threads; i++) {
+            found = _pool_steal(&pool->workers[(w->index + i) % pool->threads], &task);
+        }
+
+        if (!found) {
+            if (!idle) __atomic_fetch_add(&pool->idle, 1, __ATOMIC_RELAXED);
+            idle = true;
+            sched_yield();
+            continue;
+        }
+
+        if (idle) __atomic_fetch_sub(&pool->idle, 1, __ATOMIC_RELAXED);
+        idle = false;
+        task.fn(w, &task);
+        // Publishes the task's writes to whoever sees the count reach 0
+        __atomic_fetch_sub(&pool->pending, 1, __ATOMIC_ACQ_REL);
+    }
+
+    if (idle) __atomic_fetch_sub(&pool->idle, 1, __ATOMIC_RELAXED);
+}
+
+static void *_pool_thread(void *arg) {
+    PoolWorker *w = arg;
+    WorkPool *pool = w->pool;
+    uint64_t seen = 0;
+
+    for (;;) {
+        // Sleep until the next computation starts
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && pool->generation == seen) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        _pool_work(w);
+    }
+}
+
+// =============================== INIT/DESTROY ================================
+
+void pool_free(WorkPool **pool) {
+    WorkPool *p;
+
+    if (!pool || !*pool) return;
+    p = *pool;
+
+    pthread_mutex_lock(&p->lock);
+    p->stop = true;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+
+    for (unsigned i = 1; i <= p->started; i++) pthread_join(p->workers[i].thread, NULL);
+    for (unsigned i = 0; i < p->threads; i++) pthread_mutex_destroy(&p->workers[i].lock);
+    pthread_cond_destroy(&p->wake);
+    pthread_mutex_destroy(&p->lock);
+
+    free(p->workers);
+    free(p);
+    *pool = NULL;
+}
+
+int pool_init(WorkPool **pool, unsigned threads) {
+    WorkPool *p;
+
+    if (!pool || !threads) return 0;
+
+    p = *pool = calloc(1, sizeof(WorkPool));
+    if (!p) return 0;
+
+    p->workers = calloc(threads, sizeof(PoolWorker));
+    if (!p->workers || pthread_mutex_init(&p->lock, NULL)) goto pool_init_err_lock;
+    if (pthread_cond_init(&p->wake, NULL)) goto pool_init_err_cond;
+
+    p->threads = threads;
+    for (unsigned i = 0; i < threads; i++) {
+        p->workers[i].pool = p;
+        p->workers[i].index = i;
+        pthread_mutex_init(&p->workers[i].lock, NULL);
+    }
+
+    for (unsigned i = 1; i < threads; i++) {
+        if (pthread_create(&p->workers[i].thread, NULL, _pool_thread, &p->workers[i])) {
+            pool_free(pool);
+            return 0;
+        }
+        p->started++;
+    }
+
+    return 1;
+
+pool_init_err_cond:
+    pthread_mutex_destroy(&p->lock);
+pool_init_err_lock:
+    free(p->workers);
+    free(p);
+    *pool = NULL;
+    return 0;
+}
+
+unsigned pool_size(WorkPool *pool) {
+    return pool ? pool->threads : 0;
+}
+
+// ==================================== RUN ====================================
+
+int pool_run(WorkPool *pool, const PoolTask *task) {
+    PoolTask first;
+
+    if (!pool || !task || !task->fn) return 0;
+
+    // The first task counts as pending until it returns, so threads that wake
+    // before it spawns anything keep looking
+    __atomic_store_n(&pool->pending, 1, __ATOMIC_RELEASE);
+    if (pool->threads > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->generation++;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    first = *task;
+    first.fn(&pool->workers[0], &first);
+    __atomic_fetch_sub(&pool->pending, 1, __ATOMIC_ACQ_REL);
+    _pool_work(&pool->workers[0]);
+
+    return 1;
+}
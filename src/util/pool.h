@@ -0,0 +1,170 @@
+/**
+ * @file pool.h
+ * @brief A fork-join thread pool with work stealing.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * @defgroup pool Work-Stealing Pool
+ * Runs a recursive computation on several threads.
+ *
+ * `pool_run()` starts one task on the calling thread. Tasks may split off
+ * parts of their work with `pool_spawn()`, which pushes them onto the bottom
+ * of the running thread's own deque. Each thread pops its newest tasks first,
+ * which keeps its working set warm in cache, and a thread that runs out of
+ * work steals the oldest task of another, which tends to be the largest.
+ *
+ * Spawning has a cost, so tasks should split lazily: keep working through
+ * their input, and only hand off part of what is left when `pool_hungry()`
+ * says that another thread is idle. Work then spreads out within a few steals
+ * of any thread running dry, whatever the shape of the input.
+ */
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdlib.h>
+
+/**
+ * @brief A set of threads that runs fork-join computations.
+ *
+ * @ingroup pool
+ */
+typedef struct work_pool WorkPool;
+
+/**
+ * @brief One of a pool's threads, as seen by the tasks it runs.
+ *
+ * @ingroup pool
+ */
+typedef struct pool_worker PoolWorker;
+
+/**
+ * @brief A unit of work. Tasks are copied when spawned.
+ *
+ * @ingroup pool
+ */
+typedef struct pool_task {
+    /** @brief Runs the task, on the thread `worker`. */
+    void (*fn)(PoolWorker *worker, struct pool_task *task);
+    /** @brief State shared by all the tasks of a computation. */
+    void *ctx;
+    /** @brief This task's own input, e.g. a subtree. */
+    void *arg;
+    /** @brief This task's own range of indices, e.g. of an array. */
+    size_t lo, hi;
+} PoolTask;
+
+/**
+ * @brief Merges a partial result into another, for parallel reductions.
+ *
+ * Partial results cover arbitrary subsets of the input, and are merged in no
+ * particular order, so merging must be associative and commutative, as sums,
+ * counts, histograms, minimums and maximums are.
+ *
+ * @ingroup pool
+ *
+ * @param acc  The partial result to merge into.
+ * @param part The partial result to merge.
+ * @param ctx  The context pointer given with the reduction.
+ */
+typedef void (*pool_combine_fn)(void *acc, const void *part, void *ctx);
+
+/**
+ * @brief Constructs a new WorkPool.
+ *
+ * The calling thread takes part in `pool_run()`, so `threads - 1` threads are
+ * started. They sleep between computations.
+ *
+ * @ingroup pool
+ *
+ * @param pool    A pointer to the pool to construct.
+ * @param threads Number of threads to run tasks on, including the one
+ * calling `pool_run()`. At least 1.
+ *
+ * @return int 1 on success, 0 on failure.
+ */
+int pool_init(WorkPool **pool, unsigned threads);
+
+/**
+ * @brief Stops a WorkPool's threads and frees it.
+ *
+ * No computation may be running. After destruction, the pool will be set to
+ * `NULL`.
+ *
+ * @ingroup pool
+ *
+ * @param pool A pointer to the pool to destroy.
+ */
+void pool_free(WorkPool **pool);
+
+/**
+ * @brief Gets the number of threads a WorkPool runs tasks on.
+ *
+ * @ingroup pool
+ *
+ * @param pool The target pool.
+ *
+ * @return unsigned The number of threads, including the one calling
+ * `pool_run()`, or 0 on failure.
+ */
+unsigned pool_size(WorkPool *pool);
+
+/**
+ * @brief Runs a task, and every task it spawns, to completion.
+ *
+ * The calling thread runs `task` itself, then helps with the tasks spawned
+ * from it until all of them are done. Only one thread may call this at a
+ * time, and not from inside a task.
+ *
+ * @ingroup pool
+ *
+ * @param pool The pool to run on.
+ * @param task The task to run. It is copied.
+ *
+ * @return int 1 once every task has run, 0 on failure.
+ */
+int pool_run(WorkPool *pool, const PoolTask *task);
+
+/**
+ * @brief Hands a task over to the pool, from inside another task.
+ *
+ * The task runs later on this thread, or on another one that steals it.
+ * If the thread's deque is full, it runs at once instead.
+ *
+ * @ingroup pool
+ *
+ * @param worker The thread running the current task.
+ * @param task   The task to spawn. It is copied.
+ */
+void pool_spawn(PoolWorker *worker, const PoolTask *task);
+
+/**
+ * @brief Checks whether splitting off work would keep another thread busy.
+ *
+ * This is the case when some thread is looking for work and this one has
+ * nothing queued for it to steal. It costs two atomic loads.
+ *
+ * @ingroup pool
+ *
+ * @param worker The thread running the current task.
+ *
+ * @return int 1 if the current task should spawn part of its work, 0 if not.
+ */
+int pool_hungry(PoolWorker *worker);
+
+/**
+ * @brief Gets the index of a pool thread, from 0 to `pool_size() - 1`.
+ *
+ * The thread calling `pool_run()` has index 0. Tasks can use the index to
+ * pick a per-thread slot, e.g. a partial result that needs no locking.
+ *
+ * @ingroup pool
+ *
+ * @param worker The thread running the current task.
+ *
+ * @return unsigned The thread's index.
+ */
+unsigned pool_worker_index(PoolWorker *worker);
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file stats.h
+ * @brief Counting helpers for maps built with `MAP_STATS`.
+ *
+ * @version 0.0.1
+ * @date 2026-10-19
+ * @copyright MIT License
+ *
+ * Maps keep a `MapStats` and update it through these macros. Without
+ * `MAP_STATS` they expand to nothing and their arguments are not evaluated,
+ * so instrumentation costs nothing when it is compiled out.
+ *
+ * Counters are updated with relaxed atomics, since lookups may run
+ * concurrently with each other (and, for epoch-protected trees, with a
+ * writer).
+ */
+#ifndef __MAP_STATS_H__
+#define __MAP_STATS_H__
+
+#include "map.h"
+
+#ifdef MAP_STATS
+
+#define MAP_STATS_ONLY(...) __VA_ARGS__
+#define MAP_STAT_ADD(stats, field, n) __atomic_fetch_add(&(stats).field, (uint64_t)(n), __ATOMIC_RELAXED)
+#define MAP_STAT_SUB(stats, field, n) __atomic_fetch_sub(&(stats).field, (uint64_t)(n), __ATOMIC_RELAXED)
+#define MAP_STAT_INC(stats, field) MAP_STAT_ADD(stats, field, 1)
+// Counts an operation that visited `depth` nodes in histogram `hist`
+#define MAP_STAT_DEPTH(stats, hist, depth) \
+    MAP_STAT_INC(stats, hist[(depth) < MAP_STATS_DEPTHS ? (depth) : MAP_STATS_DEPTHS - 1])
+
+#else
+
+#define MAP_STATS_ONLY(...)
+#define MAP_STAT_ADD(stats, field, n) ((void)0)
+#define MAP_STAT_SUB(stats, field, n) ((void)0)
+#define MAP_STAT_INC(stats, field) ((void)0)
+#define MAP_STAT_DEPTH(stats, hist, depth) ((void)0)
+
+#endif
+
+/**
+ * @brief Copies counters that may be concurrently updated.
+ *
+ * @param dst Where to copy the counters to.
+ * @param src The counters to copy.
+ */
+static inline void map_stats_load(MapStats *dst, MapStats *src) {
+    uint64_t *d = (uint64_t *)dst, *s = (uint64_t *)src;
+
+    for (size_t i = 0; i < sizeof(MapStats) / sizeof(uint64_t); i++) d[i] = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Adds one set of counters to another.
+ *
+ * @param dst The running total.
+ * @param src The counters to add.
+ */
+static inline void map_stats_merge(MapStats *dst, const MapStats *src) {
+    uint64_t *d = (uint64_t *)dst;
+    const uint64_t *s = (const uint64_t *)src;
+
+    for (size_t i = 0; i < sizeof(MapStats) / sizeof(uint64_t); i++) d[i] += s[i];
+}
+
+#endif
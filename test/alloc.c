@@ -0,0 +1,186 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/alloc/arena.h"
+#include "../src/alloc/slab.h"
+#include "../src/lists/vector.h"
+#include "../src/map/bintree.h"
+#include "minunit.h"
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+#define _ALIGNED(p) ((uintptr_t)(p) % (2 * sizeof(void *)) == 0)
+
+mu_test(test_arena_alloc) {
+    Arena *arena = NULL;
+    const Allocator *a;
+    char *p, *q, *big;
+
+    mu_assert("Failed to initialize arena.", arena_init_with_chunk(&arena, 256));
+    a = arena_allocator(arena);
+    mu_assert("Arena allocator should be a region.", mem_is_region(a));
+
+    p = mem_alloc(a, 3);
+    q = mem_alloc(a, 5);
+    mu_assert("Arena allocation failed.", p && q);
+    mu_assert("Arena allocations are not aligned.", _ALIGNED(p) && _ALIGNED(q));
+    mu_assert("Arena allocations overlap.", q >= p + 3);
+    memcpy(q, "abcd", 5);
+
+    // The latest allocation grows in place
+    mu_assert("Latest allocation did not grow in place.", mem_realloc(a, q, 5, 40) == q);
+    mu_assert("Growing lost the contents.", !strcmp(q, "abcd"));
+
+    // Anything else is copied
+    p = mem_realloc(a, p, 3, 16);
+    mu_assert("Realloc of an older allocation failed.", p && p != q);
+
+    // Bigger than a chunk
+    big = mem_alloc(a, 1000);
+    mu_assert("Oversized allocation failed.", big && _ALIGNED(big));
+    memset(big, 0xAB, 1000);
+    mu_assert("Small allocation after an oversized one failed.", mem_alloc(a, 8) != NULL);
+    mu_assert("arena_used() is too small.", arena_used(arena) >= 1000 + 3 + 40 + 16 + 8);
+
+    arena_reset(arena);
+    mu_assert("arena_used() should be 0 after a reset.", arena_used(arena) == 0);
+    mu_assert("Allocation after a reset failed.", mem_alloc(a, 100) != NULL);
+
+    arena_free(&arena);
+    mu_assert("After arena_free(), arena should be NULL.", arena == NULL);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_slab_alloc) {
+    Slab *slab = NULL;
+    const Allocator *a;
+    void *objs[10];
+
+    mu_assert("Failed to initialize slab.", slab_init_with_page(&slab, 24, 4));
+    a = slab_allocator(slab);
+    mu_assert("Slab allocator should not be a region.", !mem_is_region(a));
+
+    // Spans several pages
+    for (int i = 0; i < 10; i++) {
+        objs[i] = mem_alloc(a, 24);
+        mu_assert("Slab allocation failed.", objs[i] && _ALIGNED(objs[i]));
+        memset(objs[i], i, 24);
+    }
+    mu_assert("Wrong number of live objects.", slab_live(slab) == 10);
+    mu_assert("Oversized request should fail.", mem_alloc(a, 64) == NULL);
+    mu_assert("Realloc within the object size should stay in place.", mem_realloc(a, objs[0], 24, 20) == objs[0]);
+
+    // Released objects are reused
+    mem_free(a, objs[3]);
+    mu_assert("Wrong number of live objects after a free.", slab_live(slab) == 9);
+    mu_assert("Released object was not reused.", mem_alloc(a, 8) == objs[3]);
+
+    for (int i = 0; i < 10; i++) mem_free(a, objs[i]);
+    mu_assert("Every object should have been released.", slab_live(slab) == 0);
+
+    slab_free(&slab);
+    mu_assert("After slab_free(), slab should be NULL.", slab == NULL);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bintree_arena) {
+    Arena *arena = NULL;
+    BinTree *tree = NULL;
+    char key[32];
+
+    arena_init(&arena);
+    mu_assert("Failed to initialize tree in arena.", bt_init_with_allocator(&tree, arena_allocator(arena)));
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key/%d", (i * 7919) % 1000);
+        mu_assert("Insertion failed.", bt_add(tree, key, &i, sizeof(int)) == _MAP_SUCCESS);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        sprintf(key, "key/%d", (i * 7919) % 1000);
+        mu_assert("Removal failed.", bt_remove(tree, key) == _MAP_SUCCESS);
+    }
+    sprintf(key, "key/%d", 7919 % 1000);
+    mu_assert("Entry has the wrong value.", *(int *)bt_get(tree, key) == 1);
+    mu_assert("Incorrect size.", bt_size(tree) == 500);
+
+    // Freeing the tree skips the nodes, resetting the arena releases them
+    bt_free(&tree);
+    mu_assert("After bt_free(), tree should be NULL.", tree == NULL);
+    arena_reset(arena);
+
+    arena_free(&arena);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bintree_slab) {
+    Slab *slab = NULL;
+    BinTree *tree = NULL;
+    char key[16];
+    int value;
+
+    // Every allocation the tree makes fits in one object: its nodes with their
+    // short keys inline, and int data
+    slab_init(&slab, 64);
+    mu_assert("Failed to initialize tree in slab.", bt_init_with_allocator(&tree, slab_allocator(slab)));
+    for (int i = 0; i < 100; i++) {
+        sprintf(key, "%d", (i * 37) % 100);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    value = -1;
+    bt_add(tree, "0", &value, sizeof(int));
+    mu_assert("Replaced entry has the wrong value.", *(int *)bt_get(tree, "0") == -1);
+    mu_assert("Wrong number of live objects.", slab_live(slab) == 2 * 100);
+
+    for (int i = 0; i < 50; i++) {
+        sprintf(key, "%d", i);
+        bt_remove(tree, key);
+    }
+    mu_assert("Removed entries were not released.", slab_live(slab) == 2 * 50);
+
+    bt_free(&tree);
+    mu_assert("bt_free() did not release every object.", slab_live(slab) == 0);
+
+    slab_free(&slab);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_vector_arena) {
+    Arena *arena = NULL;
+    Vector v;
+
+    arena_init_with_chunk(&arena, 128);
+    vector_init_with_allocator(&v, 4, sizeof(size_t), NULL, arena_allocator(arena));
+    for (size_t i = 0; i < 1000; i++) vector_pushback(&v, &i);
+    for (size_t i = 0; i < 1000; i++) {
+        mu_assert("Vector lost an element while growing.", *(size_t *)vector_get(&v, i) == i);
+    }
+    mu_assert("Unused slots should be zeroed.", *(size_t *)vector_get(&v, v.capacity - 1) == 0);
+
+    vector_free(&v);
+    arena_free(&arena);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_arena_alloc);
+    mu_run_test(test_slab_alloc);
+    mu_run_test(test_bintree_arena);
+    mu_run_test(test_bintree_slab);
+    mu_run_test(test_vector_arena);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
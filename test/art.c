@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/art.h"
+#include "minunit.h"
+
+#define _ART_TEST_KEYS 3000
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+mu_test(test_art_empty) {
+    ArtTree *tree = NULL;
+
+    mu_assert("Failed to initialize tree.", art_init(&tree) == _MAP_SUCCESS);
+    mu_assert("Empty tree's size is not 0.", art_size(tree) == 0);
+    mu_assert("Empty tree should have no min.", art_min(tree) == NULL);
+    mu_assert("Empty tree should have no max.", art_max(tree) == NULL);
+    mu_assert("Empty tree should not contain any keys.", !art_has(tree, "foo"));
+    mu_assert("Removing from an empty tree should return 0.", !art_remove(tree, "foo"));
+
+    art_free(&tree);
+    mu_assert("After art_free(), tree should be NULL.", tree == NULL);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_art_add_get_remove) {
+    ArtTree *tree = NULL;
+    // Keys that are prefixes of each other, and the empty key
+    char *keys[] = {"a", "ab", "abc", "", "b", "abd", "abcdef"};
+    int data[] = {1, 2, 3, 4, 5, 6, 7};
+    int replaced = 42;
+
+    art_init(&tree);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Insertion failed.", art_add(tree, keys[i], &data[i], sizeof(int)) == _MAP_SUCCESS);
+    }
+    mu_assert("Incorrect size after 7 insertions.", art_size(tree) == 7);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Entry has the wrong value after insertion.", *(int *)art_get(tree, keys[i]) == data[i]);
+    }
+    mu_assert("Missing key should not be found.", !art_has(tree, "abcd"));
+    mu_assert("Min should be the empty key.", *(int *)art_min(tree) == 4);
+    mu_assert("Max should be 'b'.", *(int *)art_max(tree) == 5);
+
+    mu_assert("Replacing an entry should return _MAP_SUCCESS_REPLACED.", art_add(tree, "ab", &replaced, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry has the wrong value.", *(int *)art_get(tree, "ab") == replaced);
+    mu_assert("Replacing should not change the size.", art_size(tree) == 7);
+
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Removal failed.", art_remove(tree, keys[i]) == _MAP_SUCCESS);
+        mu_assert("Removed key is still present.", !art_has(tree, keys[i]));
+        for (int j = i + 1; j < 7; j++) {
+            mu_assert("Removal lost another key.", art_has(tree, keys[j]));
+        }
+    }
+    mu_assert("Tree should be empty after removing every key.", art_size(tree) == 0);
+
+    art_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_art_node_growth) {
+    ArtTree *tree = NULL;
+    char key[4] = {'x', 0, 'y', 0};
+
+    // Every byte value under the same parent forces Node4 -> 16 -> 48 -> 256
+    art_init(&tree);
+    for (int c = 1; c < 256; c++) {
+        key[1] = (char)c;
+        mu_assert("Insertion failed.", art_add(tree, key, &c, sizeof(int)) == _MAP_SUCCESS);
+    }
+    for (int c = 1; c < 256; c++) {
+        key[1] = (char)c;
+        int *value = art_get(tree, key);
+        mu_assert("Entry missing after growth.", value && *value == c);
+    }
+
+    // And shrinking back down through every layout
+    for (int c = 255; c > 1; c--) {
+        key[1] = (char)c;
+        mu_assert("Removal failed.", art_remove(tree, key) == _MAP_SUCCESS);
+        key[1] = 1;
+        mu_assert("Remaining entry lost while shrinking.", art_has(tree, key));
+    }
+    mu_assert("Incorrect size after shrinking.", art_size(tree) == 1);
+
+    art_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_art_long_prefixes) {
+    ArtTree *tree = NULL;
+    char key[64];
+    int i;
+
+    // Shared prefixes much longer than what inner nodes store inline
+    art_init(&tree);
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "tenant/0000001234/session/%d/%s", i % 10, i % 2 ? "read" : "write");
+        sprintf(key + strlen(key), "/%d", i);
+        mu_assert("Insertion failed.", art_add(tree, key, &i, sizeof(int)) == _MAP_SUCCESS);
+    }
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "tenant/0000001234/session/%d/%s", i % 10, i % 2 ? "read" : "write");
+        sprintf(key + strlen(key), "/%d", i);
+        int *value = art_get(tree, key);
+        mu_assert("Entry with long prefix missing.", value && *value == i);
+    }
+    mu_assert("Key diverging inside a compressed path should be missing.", !art_has(tree, "tenant/0000001235/session/1/read/1"));
+    mu_assert("Key ending inside a compressed path should be missing.", !art_has(tree, "tenant/00000012"));
+
+    // Splitting a long compressed path
+    i = -1;
+    mu_assert("Insertion diverging in a compressed path failed.", art_add(tree, "tenant/0000009/x", &i, sizeof(int)) == _MAP_SUCCESS);
+    mu_assert("Existing keys lost after path split.", art_has(tree, "tenant/0000001234/session/3/read/3"));
+    mu_assert("New key missing after path split.", *(int *)art_get(tree, "tenant/0000009/x") == -1);
+
+    for (i = 0; i < 200; i += 2) {
+        sprintf(key, "tenant/0000001234/session/%d/write/%d", i % 10, i);
+        mu_assert("Removal failed.", art_remove(tree, key) == _MAP_SUCCESS);
+    }
+    for (i = 1; i < 200; i += 2) {
+        sprintf(key, "tenant/0000001234/session/%d/read/%d", i % 10, i);
+        mu_assert("Entry lost after collapsing paths.", art_has(tree, key));
+    }
+    mu_assert("Incorrect size after removals.", art_size(tree) == 101);
+
+    art_free(&tree);
+    return MU_TEST_PASS;
+}
+
+typedef struct {
+    char last[64];
+    int count;
+    int unordered;
+} order_check;
+
+static int check_order(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    order_check *c = ctx;
+    (void)data;
+    (void)size;
+
+    if (c->count && strcmp(c->last, key) >= 0) c->unordered++;
+    memcpy(c->last, key, keylen + 1);
+    c->count++;
+    return 0;
+}
+
+static int stop_after_3(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)data;
+    (void)size;
+    return ++*(int *)ctx == 3;
+}
+
+mu_test(test_art_iteration) {
+    ArtTree *tree = NULL;
+    order_check check;
+    char key[32];
+    unsigned rng = 7;
+    int stopped = 0, inserted = 0;
+
+    art_init(&tree);
+    for (int i = 0; i < _ART_TEST_KEYS; i++) {
+        rng = rng * 1103515245 + 12345;
+        sprintf(key, "%u/%u", (rng >> 16) % 50, rng % 1000);
+        if (art_add(tree, key, &i, sizeof(int)) == _MAP_SUCCESS) inserted++;
+    }
+    mu_assert("Size does not match the number of distinct keys.", art_size(tree) == inserted);
+
+    memset(&check, 0, sizeof(check));
+    mu_assert("art_for_each() should visit every entry.", art_for_each(tree, check_order, &check));
+    mu_assert("art_for_each() visited the wrong number of entries.", check.count == inserted);
+    mu_assert("art_for_each() is not in strcmp order.", check.unordered == 0);
+
+    mu_assert("art_for_each() should report being stopped.", !art_for_each(tree, stop_after_3, &stopped));
+    mu_assert("art_for_each() did not stop when asked.", stopped == 3);
+
+    art_free(&tree);
+    return MU_TEST_PASS;
+}
+
+static int count_prefixed(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)data;
+    (void)size;
+    if (keylen >= 10 && !strncmp(key, "tenant/42/", 10)) ++*(int *)ctx;
+    else *(int *)ctx = -1000;
+    return 0;
+}
+
+mu_test(test_art_prefix_scan) {
+    ArtTree *tree = NULL;
+    char key[32];
+    int matched = 0, none = 0;
+
+    art_init(&tree);
+    for (int t = 40; t < 45; t++) {
+        for (int s = 0; s < 30; s++) {
+            sprintf(key, "tenant/%d/%d", t, s);
+            art_add(tree, key, &s, sizeof(int));
+        }
+    }
+    art_add(tree, "tenant/42", &none, sizeof(int));  // shorter than the prefix
+    art_add(tree, "tenant/420/0", &none, sizeof(int));  // not a match
+
+    mu_assert("art_prefix_scan() failed.", art_prefix_scan(tree, "tenant/42/", count_prefixed, &matched));
+    mu_assert("art_prefix_scan() visited the wrong entries.", matched == 30);
+
+    matched = 0;
+    art_prefix_scan(tree, "tenant/42/1", count_prefixed, &matched);
+    mu_assert("art_prefix_scan() with a longer prefix visited the wrong entries.", matched == 11);
+
+    art_prefix_scan(tree, "tenant/9", count_prefixed, &none);
+    mu_assert("art_prefix_scan() should not visit anything for a missing prefix.", none == 0);
+
+    matched = 0;
+    art_prefix_scan(tree, "", stop_after_3, &matched);
+    mu_assert("art_prefix_scan() with an empty prefix should visit every entry.", matched == 3);
+
+    art_free(&tree);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_art_empty);
+    mu_run_test(test_art_add_get_remove);
+    mu_run_test(test_art_node_growth);
+    mu_run_test(test_art_long_prefixes);
+    mu_run_test(test_art_iteration);
+    mu_run_test(test_art_prefix_scan);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
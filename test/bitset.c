@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/lists/bitset.h"
+#include "minunit.h"
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+static uint64_t next_rand(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Fills a set and its model with random bits, about one in `one_in`
+static void fill_random(Bitset *set, char *model, size_t size, uint64_t seed, unsigned one_in) {
+    uint64_t rng = seed;
+
+    for (size_t i = 0; i < size; i++) {
+        model[i] = next_rand(&rng) % one_in == 0;
+        if (model[i]) bitset_set(set, i);
+    }
+}
+
+// Checks a set against its model, bit by bit and through every query
+static int matches(Bitset *set, const char *model, size_t size) {
+    size_t rank = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        if (bitset_test(set, i) != model[i]) return 0;
+        if (bitset_rank(set, i) != rank) return 0;
+        if (model[i] && bitset_select(set, rank++) != i) return 0;
+    }
+
+    return bitset_count(set) == rank && bitset_rank(set, size) == rank && bitset_select(set, rank) == BITSET_NONE;
+}
+
+static int collect(size_t bit, void *ctx) {
+    size_t **next = ctx;
+    *(*next)++ = bit;
+    return 0;
+}
+
+static int stop_after_3(size_t bit, void *ctx) {
+    (void)bit;
+    return ++*(int *)ctx == 3;
+}
+
+mu_test(test_bitset_init_free) {
+    Bitset *set = NULL;
+
+    mu_assert("A NULL set can't be constructed.", !bitset_init(NULL, 10));
+    mu_assert("Failed to construct set.", bitset_init(&set, 0));
+    mu_assert("An empty set has no bits.", bitset_size(set) == 0 && !bitset_set(set, 0) && !bitset_test(set, 0));
+    mu_assert("An empty set has no set bits.", bitset_count(set) == 0 && bitset_select(set, 0) == BITSET_NONE);
+    bitset_free(&set);
+    mu_assert("Freed set should be NULL.", set == NULL);
+    bitset_free(&set);
+    bitset_free(NULL);
+
+    mu_assert("Failed to construct set.", bitset_init(&set, 1000));
+    mu_assert("Set has the wrong size.", bitset_size(set) == 1000 && bitset_size(NULL) == 0);
+    mu_assert("NULL sets should be refused.", !bitset_set(NULL, 0) && !bitset_count(NULL) && !bitset_and(set, NULL));
+    bitset_free(&set);
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bitset_bits) {
+    Bitset *set = NULL;
+
+    bitset_init(&set, 130);
+    mu_assert("bitset_set() failed.", bitset_set(set, 0) && bitset_set(set, 63) && bitset_set(set, 64));
+    mu_assert("bitset_set() failed.", bitset_set(set, 129));
+    mu_assert("Bits past the end should be refused.", !bitset_set(set, 130) && !bitset_test(set, 130));
+    mu_assert("Set bits should test as set.", bitset_test(set, 0) && bitset_test(set, 63) && bitset_test(set, 129));
+    mu_assert("Other bits should test as clear.", !bitset_test(set, 1) && !bitset_test(set, 65));
+    mu_assert("Set has the wrong count.", bitset_count(set) == 4);
+
+    mu_assert("bitset_clear() failed.", bitset_clear(set, 63) && !bitset_test(set, 63));
+    mu_assert("Clearing a clear bit should succeed.", bitset_clear(set, 63) && !bitset_clear(set, 130));
+    mu_assert("Set has the wrong count.", bitset_count(set) == 3);
+
+    bitset_clear_all(set);
+    mu_assert("A cleared set has no set bits.", bitset_count(set) == 0 && bitset_next(set, 0) == BITSET_NONE);
+
+    bitset_free(&set);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bitset_bulk) {
+    size_t size = 100003;
+    Bitset *a = NULL, *b = NULL, *c = NULL;
+    char *ma = malloc(size), *mb = malloc(size), *expected = malloc(size);
+
+    bitset_init(&a, size);
+    bitset_init(&b, size);
+    bitset_init(&c, size + 1);
+    fill_random(a, ma, size, 1, 3);
+    fill_random(b, mb, size, 2, 2);
+    mu_assert("Random set doesn't match its model.", matches(a, ma, size) && matches(b, mb, size));
+    mu_assert("Sets of different sizes can't be combined.", !bitset_or(a, c) && !bitset_xor(c, a));
+
+    // Each operation is checked against the model, then undone with another
+    for (size_t i = 0; i < size; i++) expected[i] = ma[i] | mb[i];
+    mu_assert("bitset_or() failed.", bitset_or(a, b) && matches(a, expected, size));
+    for (size_t i = 0; i < size; i++) expected[i] = (char)(expected[i] & !mb[i]);
+    mu_assert("bitset_andnot() failed.", bitset_andnot(a, b) && matches(a, expected, size));
+    for (size_t i = 0; i < size; i++) expected[i] ^= mb[i];
+    mu_assert("bitset_xor() failed.", bitset_xor(a, b) && matches(a, expected, size));
+    for (size_t i = 0; i < size; i++) expected[i] = (char)(expected[i] & mb[i]);
+    mu_assert("bitset_and() failed.", bitset_and(a, b) && matches(a, expected, size));
+
+    mu_assert("A set xor itself is empty.", bitset_xor(b, b) && bitset_count(b) == 0);
+
+    bitset_free(&a);
+    bitset_free(&b);
+    bitset_free(&c);
+    free(ma);
+    free(mb);
+    free(expected);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bitset_rank_select) {
+    size_t size = 300000;
+    Bitset *set = NULL;
+    char *model = calloc(size, 1);
+
+    // Sparse bits, across several superblocks
+    bitset_init(&set, size);
+    fill_random(set, model, size, 3, 97);
+    mu_assert("Sparse set doesn't match its model.", matches(set, model, size));
+
+    // Updates are seen by the next query
+    bitset_set(set, size - 1);
+    model[size - 1] = 1;
+    bitset_clear(set, bitset_select(set, 0));
+    for (size_t i = 0; i < size; i++) {
+        if (model[i]) {
+            model[i] = 0;
+            break;
+        }
+    }
+    mu_assert("Updated set doesn't match its model.", matches(set, model, size));
+
+    // Every bit set
+    for (size_t i = 0; i < size; i++) bitset_set(set, i);
+    mu_assert("Full set has the wrong count.", bitset_count(set) == size);
+    for (size_t i = 0; i < size; i += 4099) {
+        mu_assert("Full set has the wrong rank.", bitset_rank(set, i) == i);
+        mu_assert("Full set has the wrong select.", bitset_select(set, i) == i);
+    }
+    mu_assert("Ranks past the end count every bit.", bitset_rank(set, size * 2) == size);
+
+    bitset_free(&set);
+    free(model);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bitset_iterate) {
+    size_t size = 5000, found[64], *next = found, count = 0;
+    size_t bits[] = {3, 64, 65, 511, 512, 1000, 4095, 4999};
+    Bitset *set = NULL;
+    int visited = 0;
+
+    bitset_init(&set, size);
+    for (size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); i++) bitset_set(set, bits[i]);
+
+    for (size_t b = bitset_next(set, 0); b != BITSET_NONE; b = bitset_next(set, b + 1)) {
+        mu_assert("bitset_next() found the wrong bit.", b == bits[count++]);
+    }
+    mu_assert("bitset_next() missed bits.", count == 8);
+    mu_assert("bitset_next() should start at its position.", bitset_next(set, 65) == 65 && bitset_next(set, 66) == 511);
+    mu_assert("bitset_next() should stop at the end.", bitset_next(set, 5000) == BITSET_NONE);
+
+    mu_assert("bitset_for_each() failed.", bitset_for_each(set, collect, &next));
+    mu_assert("bitset_for_each() visited the wrong bits.", next - found == 8 && !memcmp(found, bits, sizeof(bits)));
+    mu_assert("Stopping should fail the iteration.", !bitset_for_each(set, stop_after_3, &visited) && visited == 3);
+
+    bitset_free(&set);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_bitset_init_free);
+    mu_run_test(test_bitset_bits);
+    mu_run_test(test_bitset_bulk);
+    mu_run_test(test_bitset_rank_select);
+    mu_run_test(test_bitset_iterate);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
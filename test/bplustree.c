@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/bplustree.h"
+#include "minunit.h"
+
+#define _BP_TEST_KEYS 20000
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+static const unsigned orders[] = {BP_MIN_ORDER, 5, BP_DEFAULT_ORDER, 64};
+
+// Checks that keys arrive in strictly increasing order, counting them
+typedef struct {
+    char last[64];
+    int count;
+    int sorted;
+    int stop_after;
+} visit_state;
+
+static int visit(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    visit_state *s = ctx;
+    (void)data;
+    (void)size;
+
+    if (s->count && strcmp(s->last, key) >= 0) s->sorted = 0;
+    memcpy(s->last, key, keylen + 1);
+    s->count++;
+
+    return s->stop_after && s->count == s->stop_after;
+}
+
+// A key of the i-th of a shuffled sequence, sharing a long prefix with the others
+static void test_key(char *key, int i) {
+    sprintf(key, "tenant/0042/user/%08d", (int)((unsigned)i * 7919u % _BP_TEST_KEYS));
+}
+
+mu_test(test_bp_empty) {
+    BPlusTree *tree = NULL;
+    visit_state s = {{0}, 0, 1, 0};
+
+    mu_assert("Orders below the minimum should be refused.", !bp_init_with_order(&tree, BP_MIN_ORDER - 1));
+    mu_assert("Orders above the maximum should be refused.", !bp_init_with_order(&tree, BP_MAX_ORDER + 1));
+    mu_assert("Failed to initialize tree.", bp_init(&tree) == _MAP_SUCCESS);
+    mu_assert("Empty tree's size is not 0.", bp_size(tree) == 0);
+    mu_assert("Empty tree's height is not 0.", bp_height(tree) == 0);
+    mu_assert("Empty tree should have no min.", bp_min(tree) == NULL);
+    mu_assert("Empty tree should have no max.", bp_max(tree) == NULL);
+    mu_assert("Empty tree should not contain any keys.", !bp_has(tree, "foo"));
+    mu_assert("Removing from an empty tree should return 0.", !bp_remove(tree, "foo"));
+    mu_assert("Iterating an empty tree should visit nothing.", bp_for_each(tree, visit, &s) && s.count == 0);
+
+    bp_free(&tree);
+    mu_assert("After bp_free(), tree should be NULL.", tree == NULL);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bp_add_get_remove) {
+    BPlusTree *tree = NULL;
+    // Keys that are prefixes of each other, and the empty key
+    char *keys[] = {"a", "ab", "abc", "", "b", "abd", "abcdefghijklmnop"};
+    int data[] = {1, 2, 3, 4, 5, 6, 7};
+    int replaced = 42;
+
+    bp_init_with_order(&tree, BP_MIN_ORDER);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Insertion failed.", bp_add(tree, keys[i], &data[i], sizeof(int)) == _MAP_SUCCESS);
+    }
+    mu_assert("Incorrect size after 7 insertions.", bp_size(tree) == 7);
+    mu_assert("7 keys should not fit in one node.", bp_height(tree) == 2);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Entry has the wrong value after insertion.", *(int *)bp_get(tree, keys[i]) == data[i]);
+    }
+    mu_assert("Missing key should not be found.", !bp_has(tree, "abcd"));
+    mu_assert("Min should be the empty key.", *(int *)bp_min(tree) == 4);
+    mu_assert("Max should be 'b'.", *(int *)bp_max(tree) == 5);
+
+    mu_assert("Replacing an entry should return _MAP_SUCCESS_REPLACED.",
+              bp_add(tree, "ab", &replaced, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry has the wrong value.", *(int *)bp_get(tree, "ab") == replaced);
+    mu_assert("Replacing should not change the size.", bp_size(tree) == 7);
+
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Removal failed.", bp_remove(tree, keys[i]) == _MAP_SUCCESS);
+        mu_assert("Removed key is still present.", !bp_has(tree, keys[i]));
+        for (int j = i + 1; j < 7; j++) {
+            mu_assert("Removal lost another key.", bp_has(tree, keys[j]));
+        }
+    }
+    mu_assert("Tree should be empty after removing every key.", bp_size(tree) == 0);
+    mu_assert("Tree should have no height after removing every key.", bp_height(tree) == 0);
+
+    bp_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bp_many) {
+    char key[64];
+
+    for (size_t o = 0; o < sizeof(orders) / sizeof(*orders); o++) {
+        BPlusTree *tree = NULL;
+        visit_state s = {{0}, 0, 1, 0};
+
+        mu_assert("Failed to initialize tree.", bp_init_with_order(&tree, orders[o]));
+        for (int i = 0; i < _BP_TEST_KEYS; i++) {
+            test_key(key, i);
+            mu_assert("Insertion failed.", bp_add(tree, key, &i, sizeof(int)) == _MAP_SUCCESS);
+        }
+        mu_assert("Incorrect size after insertions.", bp_size(tree) == _BP_TEST_KEYS);
+        mu_assert("Nodes should be at least half full.", bp_height(tree) <= (orders[o] < 8 ? 16 : 5));
+        for (int i = 0; i < _BP_TEST_KEYS; i++) {
+            test_key(key, i);
+            mu_assert("Entry has the wrong value after insertion.", *(int *)bp_get(tree, key) == i);
+        }
+        mu_assert("Iteration failed.", bp_for_each(tree, visit, &s));
+        mu_assert("Iteration should visit every entry in order.", s.count == _BP_TEST_KEYS && s.sorted);
+
+        // Remove every other key, then the rest, so nodes both borrow and merge
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = pass; i < _BP_TEST_KEYS; i += 2) {
+                test_key(key, i);
+                mu_assert("Removal failed.", bp_remove(tree, key) == _MAP_SUCCESS);
+            }
+            for (int i = 0; i < _BP_TEST_KEYS; i++) {
+                test_key(key, i);
+                mu_assert("Removal lost or kept the wrong entries.", bp_has(tree, key) == (i % 2 && !pass));
+            }
+        }
+        mu_assert("Tree should be empty after removing every key.", bp_size(tree) == 0 && bp_height(tree) == 0);
+        mu_assert("An emptied tree should still take entries.", bp_add(tree, "a", &s, sizeof(s)) == _MAP_SUCCESS);
+        mu_assert("An emptied tree should hold one level.", bp_height(tree) == 1);
+
+        bp_free(&tree);
+    }
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bp_range_scan) {
+    BPlusTree *tree = NULL;
+    visit_state s = {{0}, 0, 1, 0};
+    char key[64];
+
+    bp_init_with_order(&tree, 8);
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%04d", i);
+        bp_add(tree, key, &i, sizeof(int));
+    }
+
+    mu_assert("Range scan failed.", bp_range_scan(tree, "0100", "0200", visit, &s));
+    mu_assert("Range should hold 100 keys.", s.count == 100 && s.sorted && !strcmp(s.last, "0199"));
+
+    // Bounds need not be keys in the tree
+    memset(&s, 0, sizeof(s));
+    s.sorted = 1;
+    mu_assert("Range scan failed.", bp_range_scan(tree, "0099x", "1", visit, &s));
+    mu_assert("Range should hold the keys between the bounds.", s.count == 900 && s.sorted && !strcmp(s.last, "0999"));
+
+    memset(&s, 0, sizeof(s));
+    mu_assert("Open ranges should visit every entry.", bp_range_scan(tree, NULL, NULL, visit, &s) && s.count == 1000);
+    memset(&s, 0, sizeof(s));
+    mu_assert("Ranges past the last key should be empty.", bp_range_scan(tree, "1", NULL, visit, &s) && !s.count);
+    memset(&s, 0, sizeof(s));
+    mu_assert("Empty ranges should visit nothing.", bp_range_scan(tree, "0500", "0500", visit, &s) && !s.count);
+
+    memset(&s, 0, sizeof(s));
+    s.stop_after = 10;
+    mu_assert("Stopping should return 0.", !bp_range_scan(tree, "0900", NULL, visit, &s));
+    memset(&s, 0, sizeof(s));
+    s.stop_after = 10;
+    mu_assert("Stopping should end the scan.", !bp_range_scan(tree, "0300", NULL, visit, &s) && !strcmp(s.last, "0309"));
+
+    bp_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bp_prefixes) {
+    BPlusTree *tree = NULL;
+    MapStats stats;
+    char key[64];
+
+    // Keys that only differ far past their first 8 bytes are told apart by
+    // the prefixes of nodes deep enough in the tree
+    bp_init(&tree);
+    for (int i = 0; i < _BP_TEST_KEYS; i++) {
+        test_key(key, i);
+        bp_add(tree, key, &i, sizeof(int));
+    }
+    bp_stats(tree, &stats);
+    for (int i = 0; i < _BP_TEST_KEYS; i++) {
+        test_key(key, i);
+        mu_assert("Entry has the wrong value.", *(int *)bp_get(tree, key) == i);
+    }
+    key[strlen(key) - 1] = 'x';
+    mu_assert("Missing key should not be found.", !bp_has(tree, key));
+
+#ifdef MAP_STATS
+    {
+        MapStats after;
+
+        bp_stats(tree, &after);
+        mu_assert("Lookups should be counted.", after.gets == stats.gets + _BP_TEST_KEYS + 1);
+        mu_assert("Lookups should visit every level.", after.nodes_visited - stats.nodes_visited ==
+                                                            (uint64_t)(_BP_TEST_KEYS + 1) * (uint64_t)bp_height(tree));
+        mu_assert("Lookups should hardly read stored keys.", after.key_cmps - stats.key_cmps < _BP_TEST_KEYS / 10);
+        mu_assert("Entry bytes should be counted.", after.bytes > 0 && after.mallocs == _BP_TEST_KEYS);
+    }
+#else
+    (void)stats;
+#endif
+
+    // Keys without the prefix every entry shares sort before or after them all
+    mu_assert("Keys outside the shared prefix should not be found.", !bp_has(tree, "tenant/0043/user/00000001"));
+    mu_assert("Keys outside the shared prefix should not be removed.", !bp_remove(tree, "tenant/"));
+    {
+        visit_state s = {{0}, 0, 1, 0};
+        mu_assert("Scans from before every key should visit them all.", bp_range_scan(tree, "a", NULL, visit, &s));
+        mu_assert("Scans from before every key should visit them all.", s.count == _BP_TEST_KEYS && s.sorted);
+        s.count = 0;
+        mu_assert("Scans from after every key should be empty.", bp_range_scan(tree, "tenant/1", NULL, visit, &s) && !s.count);
+    }
+
+    // A key that shares less with the others shortens what nodes skip
+    mu_assert("Insertion failed.", bp_add(tree, "tenant/0041", key, 1) == _MAP_SUCCESS);
+    mu_assert("Shorter shared prefixes should keep entries reachable.", bp_has(tree, "tenant/0041") && bp_min(tree) != NULL);
+    for (int i = 0; i < _BP_TEST_KEYS; i++) {
+        test_key(key, i);
+        mu_assert("Entry has the wrong value.", *(int *)bp_get(tree, key) == i);
+    }
+
+    bp_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bp_random) {
+    static char present[1000];
+    char key[64];
+    uint64_t rng = 7;
+
+    // Random insertions and removals in narrow nodes, checked against a table
+    for (unsigned order = BP_MIN_ORDER; order <= 6; order++) {
+        BPlusTree *tree = NULL;
+        int count = 0;
+
+        memset(present, 0, sizeof(present));
+        bp_init_with_order(&tree, order);
+        for (int op = 0; op < 20000; op++) {
+            int i;
+
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            i = (int)((rng >> 33) % 1000);
+            sprintf(key, i < 500 ? "key/%d" : "%d", i);
+            if ((rng >> 20) & 1) {
+                mu_assert("Insertion failed.", bp_add(tree, key, &i, sizeof(int)) == (present[i] ? 2 : 1));
+                count += !present[i];
+                present[i] = 1;
+            } else {
+                mu_assert("Removal returned the wrong status.", bp_remove(tree, key) == present[i]);
+                count -= present[i];
+                present[i] = 0;
+            }
+
+            if (op % 1000 == 0) {
+                visit_state s = {{0}, 0, 1, 0};
+                bp_for_each(tree, visit, &s);
+                mu_assert("Iteration should visit every entry in order.", s.count == count && s.sorted);
+                for (int j = 0; j < 1000; j++) {
+                    sprintf(key, j < 500 ? "key/%d" : "%d", j);
+                    mu_assert("Lookup disagrees with the table.", bp_has(tree, key) == present[j]);
+                }
+            }
+        }
+        mu_assert("Incorrect size after random operations.", bp_size(tree) == count);
+        bp_free(&tree);
+    }
+
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_bp_empty);
+    mu_run_test(test_bp_add_get_remove);
+    mu_run_test(test_bp_many);
+    mu_run_test(test_bp_range_scan);
+    mu_run_test(test_bp_prefixes);
+    mu_run_test(test_bp_random);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
@@ -300,6 +300,876 @@ mu_test(test_bst_min_max) {
     return MU_TEST_PASS;
 }
 
+typedef struct {
+    char last[_BST_TEST_STRLEN];
+    int count;
+    int unordered;
+    int mismatched;
+    const char *prefix;
+} prefix_check;
+
+static int check_prefixed(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    prefix_check *c = ctx;
+    (void)data;
+    (void)size;
+
+    if (strncmp(key, c->prefix, strlen(c->prefix))) c->mismatched++;
+    if (c->count && strcmp(c->last, key) >= 0) c->unordered++;
+    memcpy(c->last, key, keylen + 1);
+    c->count++;
+    return 0;
+}
+
+static int stop_after_3(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)data;
+    (void)size;
+    return ++*(int *)ctx == 3;
+}
+
+mu_test(test_bst_prefix_scan) {
+    BinTree *tree = NULL;
+    prefix_check check;
+    char key[_BST_TEST_STRLEN];
+    int stopped = 0;
+
+    bt_init(&tree);
+    // Insert in a scrambled order so matches are spread over the tree
+    for (int i = 0; i < 250; i++) {
+        int n = (i * 37) % 250;
+        sprintf(key, "tenant/%d/%d", 40 + n % 5, n / 5);
+        bt_add(tree, key, &n, sizeof(int));
+    }
+    bt_add(tree, "tenant/42", &stopped, sizeof(int));    // shorter than the prefix
+    bt_add(tree, "tenant/420/0", &stopped, sizeof(int));  // not a match
+
+    memset(&check, 0, sizeof(check));
+    check.prefix = "tenant/42/";
+    mu_assert("bt_prefix_scan() failed.", bt_prefix_scan(tree, check.prefix, check_prefixed, &check));
+    mu_assert("bt_prefix_scan() visited the wrong number of entries.", check.count == 50);
+    mu_assert("bt_prefix_scan() visited a key without the prefix.", check.mismatched == 0);
+    mu_assert("bt_prefix_scan() is not in key order.", check.unordered == 0);
+    mu_assert("bt_prefix_count() disagrees with bt_prefix_scan().", bt_prefix_count(tree, "tenant/42/") == 50);
+
+    mu_assert("bt_prefix_count() with a longer prefix is wrong.", bt_prefix_count(tree, "tenant/42/1") == 11);
+    mu_assert("bt_prefix_count() of a missing prefix should be 0.", bt_prefix_count(tree, "tenant/9") == 0);
+    mu_assert("bt_prefix_count() of an empty prefix should count every entry.", bt_prefix_count(tree, "") == bt_size(tree));
+
+    memset(&check, 0, sizeof(check));
+    check.prefix = "";
+    mu_assert("bt_for_each() should visit every entry.", bt_for_each(tree, check_prefixed, &check));
+    mu_assert("bt_for_each() visited the wrong number of entries.", check.count == bt_size(tree));
+    mu_assert("bt_for_each() is not in key order.", check.unordered == 0);
+
+    mu_assert("bt_prefix_scan() should report being stopped.", !bt_prefix_scan(tree, "tenant/4", stop_after_3, &stopped));
+    mu_assert("bt_prefix_scan() did not stop when asked.", stopped == 3);
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+static int check_bytes_order(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    prefix_check *c = ctx;
+    (void)size;
+
+    // Entries were inserted with their rank as data
+    if (*(int *)data != c->count) c->unordered++;
+    if (key[keylen] != '\0') c->mismatched++;
+    c->count++;
+    return 0;
+}
+
+mu_test(test_bst_bytes_keys) {
+    BinTree *tree = NULL;
+    prefix_check check;
+    // In key order. Null bytes, shared 8-byte prefixes and keys that are
+    // prefixes of each other
+    const unsigned char keys[][17] = {
+        {0},
+        {0, 0},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0},
+        {1, 2, 3, 4, 5, 6, 7, 8},
+        {1, 2, 3, 4, 5, 6, 7, 8, 0, 0, 0, 0, 0, 0, 0, 0},
+        {1, 2, 3, 4, 5, 6, 7, 8, 0, 0, 0, 0, 0, 0, 0, 1},
+        {1, 2, 3, 4, 5, 6, 7, 8, 9},
+        {'a'},
+        {'a', 0, 'b'},
+        {'a', 'b'},
+        {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+    };
+    size_t lens[] = {1, 2, 9, 8, 16, 16, 9, 1, 3, 2, 9};
+    int order[] = {5, 0, 9, 3, 10, 1, 7, 4, 2, 8, 6};
+    int n = 11, value;
+    size_t size = 0;
+
+    bt_init(&tree);
+    for (int i = 0; i < n; i++) {
+        int k = order[i];
+        mu_assert("Insertion with a binary key failed.", bt_add_bytes(tree, keys[k], lens[k], &k, sizeof(int)) == _MAP_SUCCESS);
+    }
+    mu_assert("Incorrect size after insertions.", bt_size(tree) == n);
+    mu_assert("Inserting the empty key failed.", bt_add_bytes(tree, NULL, 0, &n, sizeof(int)) == _MAP_SUCCESS);
+
+    for (int k = 0; k < n; k++) {
+        int *found = bt_get_bytes(tree, keys[k], lens[k], &size);
+        mu_assert("Entry with a binary key is missing.", found && *found == k && size == sizeof(int));
+    }
+    mu_assert("Key that is a prefix of stored keys should be missing.", !bt_has_bytes(tree, keys[3], 4));
+    mu_assert("Key extending a stored key should be missing.", !bt_has_bytes(tree, keys[1], 3));
+    mu_assert("String keys should match binary keys without the terminator.", *(int *)bt_get(tree, "ab") == 9);
+    mu_assert("Empty string key should match the empty binary key.", *(int *)bt_get(tree, "") == n);
+    value = -1;
+    mu_assert("Replacing an entry by its string key should work.", bt_add(tree, "a", &value, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry has the wrong value.", *(int *)bt_get_bytes(tree, "a", 1, NULL) == -1);
+    value = 7;
+    bt_add_bytes(tree, "a", 1, &value, sizeof(int));
+    bt_remove_bytes(tree, NULL, 0);
+
+    memset(&check, 0, sizeof(check));
+    mu_assert("bt_for_each() should visit every entry.", bt_for_each(tree, check_bytes_order, &check));
+    mu_assert("bt_for_each() visited the wrong number of entries.", check.count == n);
+    mu_assert("bt_for_each() is not in memcmp order.", check.unordered == 0);
+    mu_assert("Binary keys should be null-terminated when visited.", check.mismatched == 0);
+    mu_assert("bt_prefix_count() should not stop at null bytes.", bt_prefix_count(tree, "a") == 3);
+
+    for (int i = 0; i < n; i++) {
+        int k = order[(i * 3) % n];
+        mu_assert("Removal with a binary key failed.", bt_remove_bytes(tree, keys[k], lens[k]) == _MAP_SUCCESS);
+        mu_assert("Removed binary key is still present.", !bt_has_bytes(tree, keys[k], lens[k]));
+    }
+    mu_assert("Tree should be empty after removing every key.", bt_size(tree) == 0);
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+// Orders int keys by value, largest first
+static int cmp_int_desc(const void *a, size_t alen, const void *b, size_t blen) {
+    int x, y;
+
+    (void)alen;
+    (void)blen;
+    memcpy(&x, a, sizeof(int));
+    memcpy(&y, b, sizeof(int));
+    return (x < y) - (x > y);
+}
+
+static int check_desc(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    prefix_check *c = ctx;
+    int k;
+    (void)size;
+
+    memcpy(&k, key, sizeof(int));
+    if (keylen != sizeof(int) || *(int *)data != k) c->mismatched++;
+    if (k != 49 - c->count) c->unordered++;
+    c->count++;
+    return 0;
+}
+
+mu_test(test_bst_custom_cmp) {
+    BinTree *tree = NULL;
+    prefix_check check;
+
+    mu_assert("bt_init_with_cmp() should require a comparator.", !bt_init_with_cmp(&tree, NULL));
+    mu_assert("bt_init_with_cmp() failed.", bt_init_with_cmp(&tree, cmp_int_desc) == _MAP_SUCCESS);
+    for (int i = 0; i < 100; i++) {
+        int k = (i * 37) % 100 - 50;
+        mu_assert("Insertion failed.", bt_add_bytes(tree, &k, sizeof(int), &k, sizeof(int)) == _MAP_SUCCESS);
+    }
+    for (int k = -50; k < 50; k++) {
+        int *found = bt_get_bytes(tree, &k, sizeof(int), NULL);
+        mu_assert("Entry is missing.", found && *found == k);
+    }
+
+    memset(&check, 0, sizeof(check));
+    mu_assert("bt_for_each() should visit every entry.", bt_for_each(tree, check_desc, &check));
+    mu_assert("bt_for_each() visited the wrong number of entries.", check.count == 100);
+    mu_assert("bt_for_each() is not in comparator order.", check.unordered == 0 && check.mismatched == 0);
+    mu_assert("Prefix scans should fail with a custom order.", !bt_prefix_scan(tree, "", check_desc, &check));
+
+    for (int k = -50; k < 50; k += 2) {
+        mu_assert("Removal failed.", bt_remove_bytes(tree, &k, sizeof(int)) == _MAP_SUCCESS);
+    }
+    mu_assert("Incorrect size after removals.", bt_size(tree) == 50);
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bst_borrowed) {
+    BinTree *tree = NULL;
+    // Stands in for a read-only buffer that outlives the tree
+    char records[] = "alpha\0bravo\0charlie\0delta";
+    const char *keys[] = {records, records + 6, records + 12, records + 20};
+    int values[] = {1, 2, 3, 4}, other = 42;
+    size_t size = 0;
+
+    bt_init(&tree);
+    mu_assert("Unknown ownership flags should be rejected.", !bt_set_borrowed(tree, 0x10));
+    mu_assert("bt_set_borrowed() failed.", bt_set_borrowed(tree, BT_BORROW_KEYS | BT_BORROW_DATA));
+    for (int i = 0; i < 4; i++) {
+        bt_add_bytes(tree, keys[i], strlen(keys[i]), &values[i], sizeof(int));
+    }
+    mu_assert("Ownership can't change once the tree has entries.", !bt_set_borrowed(tree, 0));
+
+    mu_assert("Borrowed data should be returned as is.", bt_get(tree, "charlie") == &values[2]);
+    values[2] = 33;
+    mu_assert("Borrowed data should not be a copy.", *(int *)bt_get(tree, "charlie") == 33);
+    mu_assert("Replacing borrowed data failed.", bt_add(tree, "bravo", &other, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry should point at the new data.", bt_get_with_size(tree, "bravo", &size) == &other && size == sizeof(int));
+    mu_assert("Removing a borrowed entry failed.", bt_remove(tree, "alpha") == _MAP_SUCCESS);
+    mu_assert("Borrowed data should survive its entry.", values[0] == 1);
+    bt_free(&tree);
+
+    // Borrowing only keys still copies data
+    bt_init(&tree);
+    bt_set_borrowed(tree, BT_BORROW_KEYS);
+    bt_add_bytes(tree, keys[3], 5, &values[3], sizeof(int));
+    values[3] = 44;
+    mu_assert("Data should be copied when only keys are borrowed.", *(int *)bt_get(tree, "delta") == 4);
+
+    // Keys at the same address are only equal if they have the same length
+    bt_add_bytes(tree, records + 12, 4, &values[0], sizeof(int));
+    bt_add_bytes(tree, records + 12, 7, &values[2], sizeof(int));
+    mu_assert("Keys sharing a start should be distinct entries.", bt_size(tree) == 3);
+    mu_assert("The shorter key should keep its data.", *(int *)bt_get_bytes(tree, records + 12, 4, NULL) == 1);
+    mu_assert("The longer key should have its own data.", *(int *)bt_get(tree, "charlie") == 33);
+    mu_assert("Removing the shorter key failed.", bt_remove_bytes(tree, records + 12, 4) == _MAP_SUCCESS);
+    mu_assert("Removing the shorter key should keep the longer one.", bt_has(tree, "charlie") && bt_size(tree) == 2);
+    bt_free(&tree);
+
+    return MU_TEST_PASS;
+}
+
+static void increment(void *data, size_t size, void *ctx) {
+    (void)size;
+    *(int *)data += *(int *)ctx;
+}
+
+mu_test(test_bst_emplace_update) {
+    BinTree *tree = NULL;
+    int created = -1, step = 5;
+    int *value, *again;
+    char *text;
+
+    bt_init(&tree);
+    value = bt_emplace(tree, "counter", sizeof(int), &created);
+    mu_assert("Emplacing a new entry failed.", value && created == 1);
+    mu_assert("New entry's data should be zeroed.", *value == 0);
+    *value = 10;
+
+    again = bt_emplace(tree, "counter", sizeof(int), &created);
+    mu_assert("Emplacing an existing entry should find it.", again && created == 0);
+    mu_assert("Buffer of the same size should be reused.", again == value && *again == 10);
+
+    mu_assert("bt_update() failed.", bt_update(tree, "counter", increment, &step) == _MAP_SUCCESS);
+    mu_assert("bt_update() did not modify the entry.", *(int *)bt_get(tree, "counter") == 15);
+    mu_assert("bt_update() of a missing key should fail.", !bt_update(tree, "missing", increment, &step));
+
+    // Growing keeps the contents and zeroes the rest
+    text = bt_emplace(tree, "text", 4, NULL);
+    memcpy(text, "abc", 4);
+    text = bt_emplace(tree, "text", 8, NULL);
+    mu_assert("Growing an entry should keep its contents.", !strcmp(text, "abc") && !memcmp(text + 4, "\0\0\0\0", 4));
+    again = bt_emplace(tree, "text", 2, NULL);
+    mu_assert("A smaller size should reuse the buffer.", (char *)again == text);
+    size_t size = 0;
+    bt_get_with_size(tree, "text", &size);
+    mu_assert("Emplacing should set the entry's size.", size == 2);
+    mu_assert("Wrong number of entries.", bt_size(tree) == 2);
+    bt_free(&tree);
+
+    // Borrowed data isn't the tree's to hand out
+    bt_init(&tree);
+    bt_set_borrowed(tree, BT_BORROW_DATA);
+    mu_assert("Emplacing into borrowed data should fail.", bt_emplace(tree, "counter", sizeof(int), NULL) == NULL);
+    bt_free(&tree);
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bst_get_many) {
+    BinTree *tree = NULL;
+    char storage[300][16], *keys[300];
+    void *out[300];
+    size_t lens[300];
+    int found;
+
+    bt_init(&tree);
+    for (int i = 0; i < 1000; i++) {
+        int n = (i * 37) % 1000;
+        sprintf(storage[0], "%d", n);
+        bt_add(tree, storage[0], &n, sizeof(int));
+    }
+
+    // Every third key is missing, and more keys than lookups run at once
+    for (int i = 0; i < 300; i++) {
+        sprintf(storage[i], i % 3 ? "%d" : "x%d", i * 3);
+        keys[i] = storage[i];
+        lens[i] = strlen(storage[i]);
+    }
+    found = bt_get_many(tree, keys, 300, out);
+    mu_assert("bt_get_many() found the wrong number of keys.", found == 200);
+    for (int i = 0; i < 300; i++) {
+        mu_assert("bt_get_many() disagrees with bt_get().", out[i] == bt_get(tree, keys[i]));
+        mu_assert("bt_get_many() returned the wrong entry.", !out[i] || *(int *)out[i] == i * 3);
+    }
+
+    memset(out, 0, sizeof(out));
+    found = bt_get_many_bytes(tree, (const void *const *)keys, lens, 5, out);
+    mu_assert("bt_get_many_bytes() found the wrong number of keys.", found == 3 && !out[0] && *(int *)out[4] == 12);
+    mu_assert("bt_get_many_bytes() wrote past the batch.", out[5] == NULL);
+    mu_assert("An empty batch finds nothing.", bt_get_many(tree, keys, 0, out) == 0);
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+// Appends "key=value;" for each entry
+static int dump_entries(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    char *out = ctx;
+    (void)size;
+
+    sprintf(out + strlen(out), "%.*s=%d;", (int)keylen, key, *(int *)data);
+    return 0;
+}
+
+mu_test(test_bst_add_many) {
+    BinTree *batched = NULL, *looped = NULL;
+    static char storage[1000][16], got[16384], want[16384];
+    char *keys[1000];
+    void *values[1000];
+    size_t sizes[1000];
+    int data[1000];
+    unsigned rng = 3;
+
+    bt_init(&batched);
+    bt_init(&looped);
+    for (int i = 0; i < 100; i++) {
+        sprintf(storage[0], "%d", i * 7);
+        bt_add(batched, storage[0], &i, sizeof(int));
+        bt_add(looped, storage[0], &i, sizeof(int));
+    }
+
+    // Unsorted, with keys repeated within the batch and already in the tree
+    for (int i = 0; i < 1000; i++) {
+        rng = rng * 1103515245 + 12345;
+        sprintf(storage[i], "%u", (rng >> 16) % 700);
+        data[i] = 1000 + i;
+        keys[i] = storage[i];
+        values[i] = &data[i];
+        sizes[i] = sizeof(int);
+        bt_add(looped, keys[i], values[i], sizes[i]);
+    }
+    mu_assert("bt_add_many() failed.", bt_add_many(batched, keys, values, sizes, 1000) == _MAP_SUCCESS);
+    mu_assert("bt_add_many() added the wrong number of entries.", bt_size(batched) == bt_size(looped));
+    got[0] = want[0] = '\0';
+    bt_for_each(batched, dump_entries, got);
+    bt_for_each(looped, dump_entries, want);
+    mu_assert("bt_add_many() disagrees with a bt_add() loop.", !strcmp(got, want));
+
+    // A sorted batch of binary keys past the end of the tree
+    for (int i = 0; i < 50; i++) {
+        sprintf(storage[i], "z%03d", i);
+        sizes[i] = 4;
+    }
+    mu_assert("bt_add_many_bytes() failed.",
+              bt_add_many_bytes(batched, (const void *const *)keys, sizes, values, sizes, 50) == _MAP_SUCCESS);
+    mu_assert("bt_add_many_bytes() lost entries.", *(int *)bt_get(batched, "z049") == 1049 && bt_has(batched, "z000"));
+
+    values[10] = NULL;
+    mu_assert("A batch with a NULL value should be refused.", !bt_add_many(batched, keys, values, sizes, 20));
+    mu_assert("A refused batch should not be added.", *(int *)bt_get(batched, "z005") == 1005);
+    mu_assert("An empty batch should succeed.", bt_add_many(batched, keys, values, sizes, 0) == _MAP_SUCCESS);
+
+    bt_free(&batched);
+    bt_free(&looped);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bst_bloom) {
+    BinTree *tree = NULL, *sorted = NULL;
+    BloomStats bloom;
+    char key[16];
+    int found = 0;
+
+    bt_init(&tree);
+    for (int i = 0; i < 500; i++) {
+        sprintf(key, "in/%d", i);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    mu_assert("Failed to set the Bloom filter.", bt_set_bloom(tree, 1000, 0.01) == _MAP_SUCCESS);
+    mu_assert("bt_bloom_stats() failed.", bt_bloom_stats(tree, &bloom) == _MAP_SUCCESS);
+    mu_assert("Filter has the wrong size.", bloom.hashes == 7 && bloom.capacity == 1000 && bloom.keys == 500);
+    mu_assert("Filter is smaller than its false positive rate needs.", bloom.bytes * 8 >= 9 * 1000);
+
+    // Keys added before and after the filter are all found
+    for (int i = 500; i < 3000; i++) {
+        sprintf(key, "in/%d", i);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    for (int i = 0; i < 3000; i++) {
+        sprintf(key, "in/%d", i);
+        int *value = bt_get(tree, key);
+        mu_assert("Filter hid an entry.", value && *value == i);
+    }
+    bt_bloom_stats(tree, &bloom);
+    mu_assert("Filter did not grow with the tree.", bloom.capacity >= 3000 && bloom.rebuilds >= 1);
+
+    for (int i = 0; i < 3000; i++) {
+        sprintf(key, "out/%d", i);
+        found += bt_has(tree, key);
+    }
+    mu_assert("Missing keys were found.", found == 0);
+#ifdef MAP_STATS
+    bt_bloom_stats(tree, &bloom);
+    mu_assert("Filter counted the wrong number of checks.", bloom.checks == 6000);
+    // 1% is expected, allow for some bad luck
+    mu_assert("Too many false positives.", bloom.false_positives < 90 && bloom.negatives + bloom.false_positives == 3000);
+#endif
+
+    // Removals eventually rebuild the filter, without losing entries
+    found = (int)bloom.rebuilds;
+    for (int i = 0; i < 3000; i++) {
+        if (i % 4 == 3) continue;
+        sprintf(key, "in/%d", i);
+        mu_assert("Removal failed.", bt_remove(tree, key) == _MAP_SUCCESS);
+    }
+    mu_assert("Removing a missing key should fail.", !bt_remove(tree, "out/1"));
+    for (int i = 0; i < 3000; i++) {
+        sprintf(key, "in/%d", i);
+        mu_assert("Filter disagrees with the tree after removals.", bt_has(tree, key) == (i % 4 == 3));
+    }
+    bt_bloom_stats(tree, &bloom);
+    mu_assert("Filter was not rebuilt after removals.", (int)bloom.rebuilds == found + 1 && bloom.keys < 1500);
+
+    mu_assert("Filter was not removed.", bt_set_bloom(tree, 0, 0) && !bt_bloom_stats(tree, &bloom));
+    mu_assert("Entries lost with the filter.", *(int *)bt_get(tree, "in/2999") == 2999);
+    mu_assert("A false positive rate of 1 should be refused.", !bt_set_bloom(tree, 10, 1));
+
+    bt_init_with_cmp(&sorted, cmp_int_desc);
+    mu_assert("Filter should be refused with a comparator.", !bt_set_bloom(sorted, 10, 0.01));
+
+    bt_free(&sorted);
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+// Fails the iteration if keys are out of order, ctx holds the last key seen
+static int check_sorted(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    char *last = ctx;
+    (void)data;
+    (void)size;
+
+    if (strcmp(last, key) >= 0) return 1;
+    memcpy(last, key, keylen + 1);
+    return 0;
+}
+
+mu_test(test_bst_splay) {
+    BinTree *tree = NULL;
+    MapStats stats;
+    char key[16], last[16] = {0};
+    int data, height;
+
+    bt_init(&tree);
+    mu_assert("Failed to enable splay mode.", bt_set_splay(tree, 1) == _MAP_SUCCESS);
+
+    // Inserting in key order leaves a chain, which accesses then fold up
+    for (int i = 0; i < 2000; i++) {
+        sprintf(key, "%05d", i);
+        mu_assert("Insertion failed.", bt_add(tree, key, &i, sizeof(int)) == _MAP_SUCCESS);
+    }
+    height = bt_height(tree);
+    mu_assert("Entry has the wrong value.", *(int *)bt_get(tree, "00000") == 0);
+    mu_assert("Splaying the deepest key should halve the height.", bt_height(tree) <= height / 2 + 2);
+    for (int i = 0; i < 2000; i++) {
+        sprintf(key, "%05d", (i * 7) % 2000);
+        int *value = bt_get(tree, key);
+        mu_assert("Entry has the wrong value.", value && *value == (i * 7) % 2000);
+    }
+    mu_assert("Missing key should not be found.", !bt_has(tree, "x") && !bt_has(tree, "00000x"));
+
+    data = -1;
+    mu_assert("Replacing should return _MAP_SUCCESS_REPLACED.", bt_add(tree, "01000", &data, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry has the wrong value.", *(int *)bt_get(tree, "01000") == -1);
+    mu_assert("Wrong size after splaying.", bt_size(tree) == 2000);
+
+    for (int i = 0; i < 2000; i += 3) {
+        sprintf(key, "%05d", i);
+        mu_assert("Removal failed.", bt_remove(tree, key) == _MAP_SUCCESS);
+    }
+    for (int i = 0; i < 2000; i++) {
+        sprintf(key, "%05d", i);
+        mu_assert("Removal disagrees with splaying.", bt_has(tree, key) == (i % 3 != 0));
+    }
+    mu_assert("Splaying broke the key order.", bt_for_each(tree, check_sorted, last));
+
+    // A key that was just used is found at the root
+    bt_get(tree, "01234");
+    bt_stats(tree, &stats);
+    height = (int)stats.get_depth[1];
+    bt_get(tree, "01234");
+    bt_stats(tree, &stats);
+#ifdef MAP_STATS
+    mu_assert("Recently used key is not at the root.", (int)stats.get_depth[1] == height + 1);
+#endif
+
+    mu_assert("Splay mode can be switched off.", bt_set_splay(tree, 0) && *(int *)bt_get(tree, "01235") == 1235);
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bst_optimize) {
+    BinTree *tree = NULL;
+    MapStats before, after;
+    char key[16], last[16] = {0};
+    int *hot;
+
+    bt_init(&tree);
+    mu_assert("An empty tree should optimize.", bt_optimize(tree) == _MAP_SUCCESS);
+
+    // Inserting in key order leaves a chain
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%05d", i);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    mu_assert("Failed to enable sampling.", bt_set_sampling(tree, 1) == _MAP_SUCCESS);
+    hot = bt_get(tree, "00999");
+    for (int i = 0; i < 3000; i++) bt_get(tree, "00999");
+    for (int i = 0; i < 1000; i += 10) {
+        sprintf(key, "%05d", i);
+        bt_get(tree, key);
+    }
+
+    mu_assert("bt_optimize() failed.", bt_optimize(tree) == _MAP_SUCCESS);
+    mu_assert("Optimized tree should be about balanced.", bt_height(tree) <= 16);
+    mu_assert("Optimizing should not move entry data.", bt_get(tree, "00999") == hot && *hot == 999);
+    mu_assert("Optimizing lost entries.", bt_size(tree) == 1000);
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%05d", i);
+        mu_assert("Entry has the wrong value after optimizing.", *(int *)bt_get(tree, key) == i);
+    }
+    mu_assert("Optimizing broke the key order.", bt_for_each(tree, check_sorted, last));
+
+    // Most of the weight was on one key, which is now the root
+    bt_stats(tree, &before);
+    bt_get(tree, "00999");
+    bt_stats(tree, &after);
+#ifdef MAP_STATS
+    mu_assert("The hottest key should be at the root.", after.get_depth[1] == before.get_depth[1] + 1);
+#endif
+
+    // Counts halve on every call, once they are gone the tree is balanced
+    bt_set_sampling(tree, 0);
+    for (int i = 0; i < 12; i++) bt_optimize(tree);
+    mu_assert("Optimizing without samples should balance the tree.", bt_height(tree) == 10);
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bst_rebalance) {
+    BinTree *tree = NULL;
+    char key[16], last[16] = {0};
+    int status, steps = 0, *first;
+
+    bt_init(&tree);
+    mu_assert("An empty tree should rebalance.", bt_rebalance(tree) == _MAP_SUCCESS);
+    bt_add(tree, "a", &steps, sizeof(int));
+    mu_assert("A single entry should rebalance.", bt_rebalance(tree) == _MAP_SUCCESS && bt_height(tree) == 1);
+    bt_remove(tree, "a");
+
+    // Inserting in key order leaves a chain
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%05d", i);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    first = bt_get(tree, "00000");
+
+    // Small steps add up to one rebuild
+    while ((status = bt_rebalance_step(tree, 64)) == BT_REBALANCE_PENDING) steps++;
+    mu_assert("bt_rebalance_step() failed.", status == _MAP_SUCCESS);
+    mu_assert("Rebalancing should take several steps.", steps > 10 && steps <= 3000 / 64 + 1);
+    mu_assert("Rebalanced tree should be complete.", bt_height(tree) == 10);
+    mu_assert("A balanced tree should need no more steps.", bt_rebalance_step(tree, 1) == _MAP_SUCCESS);
+    mu_assert("Rebalancing should not move entry data.", bt_get(tree, "00000") == first && *first == 0);
+    mu_assert("Rebalancing lost entries.", bt_size(tree) == 1000);
+    mu_assert("Rebalancing broke the key order.", bt_for_each(tree, check_sorted, last));
+
+    // Changes between steps restart the rebuild, which still completes
+    for (int i = 1000; i < 1500; i++) {
+        sprintf(key, "%05d", i);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    mu_assert("A changed tree should need steps.", bt_rebalance_step(tree, 100) == BT_REBALANCE_PENDING);
+    bt_remove(tree, "00500");
+    bt_add(tree, "01500", &steps, sizeof(int));
+    mu_assert("bt_rebalance_step() failed.", bt_rebalance_step(tree, 700) == BT_REBALANCE_PENDING);
+    mu_assert("bt_rebalance() failed.", bt_rebalance(tree) == _MAP_SUCCESS);
+    mu_assert("Rebalanced tree should be complete.", bt_height(tree) == 11);
+    mu_assert("Rebalancing lost entries.", bt_size(tree) == 1500);
+    for (int i = 0; i < 1500; i++) {
+        sprintf(key, "%05d", i);
+        mu_assert("Entry has the wrong value after rebalancing.", i == 500 ? !bt_has(tree, key) : *(int *)bt_get(tree, key) == i);
+    }
+    memset(last, 0, sizeof(last));
+    mu_assert("Rebalancing broke the key order.", bt_for_each(tree, check_sorted, last));
+
+    mu_assert("A NULL tree can't be rebalanced.", bt_rebalance_step(NULL, 1) == _MAP_FAILURE);
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+// Adds the keys i * step for i in [0, count), in a scrambled order, each
+// storing i * step + tag
+static void add_multiples(BinTree *tree, int count, int step, int tag) {
+    char key[16];
+
+    for (int i = 0; i < count; i++) {
+        int n = (int)(((long)i * 7919) % count) * step, value = n + tag;
+        sprintf(key, "%06d", n);
+        bt_add(tree, key, &value, sizeof(int));
+    }
+}
+
+// Checks a tree holds exactly the keys in [0, max) that `keep` accepts, with
+// data n + tag
+static int check_set(BinTree *tree, int max, int (*keep)(int), int tag) {
+    char key[16], last[16] = {0};
+    int size = 0;
+
+    for (int n = 0; n < max; n++) {
+        int *data;
+
+        sprintf(key, "%06d", n);
+        data = bt_get(tree, key);
+        if (keep(n) ? !data || *data != n + tag : data != NULL) return 0;
+        size += keep(n);
+    }
+
+    return bt_size(tree) == size && bt_for_each(tree, check_sorted, last);
+}
+
+static int even_or_third(int n) { return n % 2 == 0 || n % 3 == 0; }
+static int even_and_third(int n) { return n % 6 == 0; }
+static int even_not_third(int n) { return n % 2 == 0 && n % 3 != 0; }
+static int multiple_of_3(int n) { return n % 3 == 0; }
+
+mu_test(test_bst_set_ops) {
+    BinTree *tree = NULL, *other = NULL, *desc = NULL;
+#ifdef MAP_STATS
+    MapStats stats;
+#endif
+    int *moved;
+
+    // Union moves the other tree's entries in, and its data wins
+    bt_init(&tree);
+    bt_init(&other);
+    add_multiples(tree, 3000, 2, 0);
+    add_multiples(other, 2000, 3, 0);
+    moved = bt_get(other, "000003");
+    mu_assert("bt_union() failed.", bt_union(tree, other) == _MAP_SUCCESS);
+    mu_assert("Union has the wrong entries.", check_set(tree, 6000, even_or_third, 0));
+    mu_assert("Union should empty the other tree.", bt_size(other) == 0 && !bt_has(other, "000003"));
+    mu_assert("Union should move entry data.", bt_get(tree, "000003") == moved);
+#ifdef MAP_STATS
+    bt_stats(other, &stats);
+    mu_assert("Union should move the other tree's bytes.", stats.bytes == 0);
+#endif
+    mu_assert("Union with an empty tree should succeed.", bt_union(tree, other) && bt_union(other, other));
+
+    // The emptied tree can be reused, and merged the other way
+    add_multiples(other, 2000, 3, 1);
+    mu_assert("bt_union() failed.", bt_union(other, tree) == _MAP_SUCCESS);
+    mu_assert("Union has the wrong entries.", check_set(other, 6000, even_or_third, 0));
+    mu_assert("Union should empty the other tree.", bt_size(tree) == 0);
+    bt_free(&tree);
+    bt_free(&other);
+
+    // Intersection and difference only read the other tree
+    bt_init(&tree);
+    bt_init(&other);
+    add_multiples(tree, 3000, 2, 0);
+    add_multiples(other, 2000, 3, 7);
+    mu_assert("bt_intersect() failed.", bt_intersect(tree, other) == _MAP_SUCCESS);
+    mu_assert("Intersection has the wrong entries.", check_set(tree, 6000, even_and_third, 0));
+    mu_assert("Intersection changed the other tree.", check_set(other, 6000, multiple_of_3, 7));
+    bt_free(&tree);
+    bt_init(&tree);
+    add_multiples(tree, 3000, 2, 0);
+    mu_assert("bt_difference() failed.", bt_difference(tree, other) == _MAP_SUCCESS);
+    mu_assert("Difference has the wrong entries.", check_set(tree, 6000, even_not_third, 0));
+    mu_assert("Difference changed the other tree.", check_set(other, 6000, multiple_of_3, 7));
+    mu_assert("Intersecting a tree with itself should keep it.", bt_intersect(other, other) && bt_size(other) == 2000);
+    mu_assert("Subtracting a tree from itself should empty it.", bt_difference(other, other) && bt_size(other) == 0);
+    mu_assert("Intersecting with an empty tree should empty it.", bt_intersect(tree, other) && bt_size(tree) == 0);
+
+    // Parallel runs give the same results
+    bt_set_parallel(tree, 4);
+    add_multiples(tree, 30000, 2, 0);
+    add_multiples(other, 20000, 3, 0);
+    mu_assert("bt_intersect() failed.", bt_intersect(tree, other) == _MAP_SUCCESS);
+    mu_assert("Parallel intersection has the wrong entries.", check_set(tree, 60000, even_and_third, 0));
+    add_multiples(tree, 30000, 2, 0);
+    mu_assert("bt_difference() failed.", bt_difference(tree, other) == _MAP_SUCCESS);
+    mu_assert("Parallel difference has the wrong entries.", check_set(tree, 60000, even_not_third, 0));
+    mu_assert("bt_union() failed.", bt_union(tree, other) == _MAP_SUCCESS);
+    mu_assert("Parallel union has the wrong entries.", check_set(tree, 60000, even_or_third, 0));
+    bt_free(&tree);
+
+    // A filter learns the keys moved in
+    bt_init(&tree);
+    bt_set_bloom(tree, 100, 0.01);
+    add_multiples(tree, 3000, 2, 0);
+    add_multiples(other, 2000, 3, 0);
+    mu_assert("bt_union() failed.", bt_union(tree, other) == _MAP_SUCCESS);
+    mu_assert("Union with a filter has the wrong entries.", check_set(tree, 6000, even_or_third, 0));
+    add_multiples(other, 2000, 3, 0);
+    mu_assert("bt_difference() failed.", bt_difference(tree, other) == _MAP_SUCCESS);
+    mu_assert("Difference with a filter has the wrong entries.", check_set(tree, 6000, even_not_third, 0));
+
+    // Trees must agree on the key order, and on entry ownership to move nodes
+    bt_init_with_cmp(&desc, cmp_int_desc);
+    mu_assert("Union should require the same order.", !bt_union(tree, desc) && !bt_intersect(tree, desc));
+    bt_free(&desc);
+    bt_init(&desc);
+    bt_set_borrowed(desc, BT_BORROW_KEYS);
+    mu_assert("Union should require the same ownership.", !bt_union(tree, desc));
+    mu_assert("Difference should not require the same ownership.", bt_difference(tree, desc));
+    mu_assert("NULL trees should be refused.", !bt_union(NULL, tree) && !bt_intersect(tree, NULL));
+
+    bt_free(&desc);
+    bt_free(&other);
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+static int count_entry(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)size;
+    __atomic_fetch_add((long *)ctx, *(int *)data, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int stop_at_zero(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)size;
+    (void)ctx;
+    return *(int *)data == 0;
+}
+
+// Counts entries by the last digit of their key, and sums their data
+typedef struct digit_histogram {
+    long bins[10];
+    long sum;
+} digit_histogram;
+
+static void fold_entry(void *acc, const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    digit_histogram *h = acc;
+    (void)size;
+    (void)ctx;
+    h->bins[key[keylen - 1] - '0']++;
+    h->sum += *(int *)data;
+}
+
+static void combine_histograms(void *acc, const void *part, void *ctx) {
+    digit_histogram *h = acc;
+    const digit_histogram *p = part;
+    (void)ctx;
+    for (int i = 0; i < 10; i++) h->bins[i] += p->bins[i];
+    h->sum += p->sum;
+}
+
+mu_test(test_bst_parallel) {
+    BinTree *tree = NULL;
+    digit_histogram h;
+    long sum = 0;
+
+    bt_init(&tree);
+    mu_assert("An empty tree should be visited.", bt_parallel_for_each(tree, count_entry, &sum, 4) && sum == 0);
+    add_multiples(tree, 50000, 1, 0);
+
+    for (unsigned threads = 0; threads <= 8; threads += 4) {
+        sum = 0;
+        mu_assert("bt_parallel_for_each() failed.", bt_parallel_for_each(tree, count_entry, &sum, threads));
+        mu_assert("Parallel visit missed entries.", sum == 50000L * 49999 / 2);
+
+        memset(&h, 0, sizeof(h));
+        mu_assert("bt_parallel_reduce() failed.",
+                  bt_parallel_reduce(tree, fold_entry, combine_histograms, &h, sizeof(h), NULL, threads));
+        mu_assert("Parallel reduction has the wrong sum.", h.sum == 50000L * 49999 / 2);
+        for (int i = 0; i < 10; i++) mu_assert("Parallel reduction has the wrong bins.", h.bins[i] == 5000);
+    }
+
+    // Degenerate trees are split up too
+    bt_free(&tree);
+    bt_init(&tree);
+    add_multiples(tree, 1, 1, 0);
+    for (int i = 1; i < 3000; i++) {
+        char key[16];
+        sprintf(key, "%06d", i);
+        bt_add(tree, key, &i, sizeof(int));
+    }
+    sum = 0;
+    mu_assert("bt_parallel_for_each() failed.", bt_parallel_for_each(tree, count_entry, &sum, 4));
+    mu_assert("Parallel visit missed entries.", sum == 3000L * 2999 / 2);
+
+    mu_assert("Stopping should fail the visit.", !bt_parallel_for_each(tree, stop_at_zero, NULL, 4));
+    mu_assert("A reduction needs a result.", !bt_parallel_reduce(tree, fold_entry, combine_histograms, NULL, 0, NULL, 4));
+    mu_assert("A NULL tree can't be visited.", !bt_parallel_for_each(NULL, count_entry, &sum, 4));
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_bst_stats) {
+    BinTree *tree = NULL;
+    MapStats stats;
+    int data = 1;
+
+    bt_init(&tree);
+    bt_add(tree, "b", &data, sizeof(int));
+    bt_add(tree, "a", &data, sizeof(int));
+    bt_add(tree, "c", &data, sizeof(int));
+    bt_add(tree, "c", &data, sizeof(int));  // replaced
+    bt_get(tree, "c");
+    bt_has(tree, "d");  // miss
+    bt_remove(tree, "a");
+
+#ifdef MAP_STATS
+    mu_assert("bt_stats() failed.", bt_stats(tree, &stats) == _MAP_SUCCESS);
+    mu_assert("Wrong number of gets.", stats.gets == 2);
+    mu_assert("Wrong number of adds.", stats.adds == 4);
+    mu_assert("Wrong number of removes.", stats.removes == 1);
+    // adds visit 0, 1, 1 and 2 nodes, gets 2 and 2, the remove 2
+    mu_assert("Wrong number of nodes visited.", stats.nodes_visited == 10);
+    mu_assert("Wrong number of key comparisons.", stats.key_cmps == 10);
+    mu_assert("Wrong add depth histogram.", stats.add_depth[0] == 1 && stats.add_depth[1] == 2 && stats.add_depth[2] == 1);
+    mu_assert("Wrong get depth histogram.", stats.get_depth[2] == 2);
+    mu_assert("Wrong remove depth histogram.", stats.remove_depth[2] == 1);
+    mu_assert("Wrong number of mallocs.", stats.mallocs == 7);
+    mu_assert("Wrong number of frees.", stats.frees == 3);
+    mu_assert("Entries should still hold memory.", stats.bytes > 0);
+
+    bt_remove(tree, "b");
+    bt_remove(tree, "c");
+    bt_stats(tree, &stats);
+    mu_assert("An empty tree should hold no entry memory.", stats.bytes == 0);
+    mu_assert("Every allocation should have been freed.", stats.mallocs == stats.frees);
+#else
+    mu_assert("bt_stats() should fail when stats are compiled out.", bt_stats(tree, &stats) == _MAP_FAILURE);
+    mu_assert("Counters should be zero when stats are compiled out.", stats.adds == 0 && stats.bytes == 0);
+#endif
+
+    bt_free(&tree);
+    return MU_TEST_PASS;
+}
+
 void all_tests() {
     mu_run_test(test_bst_empty);
     mu_run_test(test_bst_add_and_remove_1);
@@ -308,6 +1178,20 @@ void all_tests() {
     mu_run_test(test_bst_remove_empty);
     mu_run_test(tst_bst_remove_multiple);
     mu_run_test(test_bst_min_max);
+    mu_run_test(test_bst_prefix_scan);
+    mu_run_test(test_bst_bytes_keys);
+    mu_run_test(test_bst_custom_cmp);
+    mu_run_test(test_bst_borrowed);
+    mu_run_test(test_bst_emplace_update);
+    mu_run_test(test_bst_get_many);
+    mu_run_test(test_bst_add_many);
+    mu_run_test(test_bst_bloom);
+    mu_run_test(test_bst_splay);
+    mu_run_test(test_bst_optimize);
+    mu_run_test(test_bst_rebalance);
+    mu_run_test(test_bst_set_ops);
+    mu_run_test(test_bst_parallel);
+    mu_run_test(test_bst_stats);
 }
 
 int main() {
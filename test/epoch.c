@@ -0,0 +1,376 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/bintree.h"
+#include "../src/util/epoch.h"
+#include "minunit.h"
+
+#define _EPOCH_TEST_READERS 4
+#define _EPOCH_TEST_WRITERS 2
+#define _EPOCH_TEST_KEYS 64
+#define _EPOCH_TEST_WRITES 20000
+#define _EPOCH_TEST_VALUE_WORDS 8
+#define _EPOCH_EXIT_THREADS 100
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+static int reclaimed = 0;
+
+static void count_reclaim(void *ptr, void *ctx) {
+    (void)ctx;
+    free(ptr);
+    reclaimed++;
+}
+
+mu_test(test_epoch_init_free) {
+    EpochDomain *ebr = NULL;
+
+    mu_assert("Failed to initialize domain.", ebr_init(&ebr));
+    mu_assert("Failed to enter domain.", ebr_enter(ebr));
+    mu_assert("Failed to enter nested critical section.", ebr_enter(ebr));
+    ebr_exit(ebr);
+    ebr_exit(ebr);
+
+    ebr_free(&ebr);
+    mu_assert("After ebr_free(), domain should be NULL.", ebr == NULL);
+    ebr_free(&ebr);
+
+    return MU_TEST_PASS;
+}
+
+static void *exit_reader(void *arg) {
+    EpochDomain *ebr = arg;
+
+    ebr_enter(ebr);
+    ebr_exit(ebr);
+    return NULL;
+}
+
+static void *exit_retirer(void *arg) {
+    EpochDomain *ebr = arg;
+
+    ebr_retire(ebr, malloc(16), count_reclaim, NULL);
+    return NULL;
+}
+
+static int count_visit(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)keylen;
+    (void)data;
+    (void)size;
+    __atomic_add_fetch((size_t *)ctx, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/*
+ * Threads that exit hand their records back to the domain: right away if they
+ * retired nothing, and once their limbo lists are reclaimed otherwise. Parallel
+ * walks start new threads on every call, so this runs many of them.
+ */
+mu_test(test_epoch_exited_threads) {
+    EpochDomain *ebr = NULL;
+    BinTree *tree = NULL;
+    pthread_t thread;
+    size_t visited = 0;
+    char key[32];
+
+    reclaimed = 0;
+    mu_assert("Failed to initialize domain.", ebr_init(&ebr));
+
+    // An exited thread's retired objects are still reclaimed, by someone else
+    pthread_create(&thread, NULL, exit_retirer, ebr);
+    pthread_join(thread, NULL);
+    for (int i = 0; i < _EPOCH_EXIT_THREADS; i++) {
+        pthread_create(&thread, NULL, exit_reader, ebr);
+        pthread_join(thread, NULL);
+    }
+    mu_assert("Object was reclaimed too early.", reclaimed == 0);
+    ebr_synchronize(ebr);
+    mu_assert("An exited thread's object was not reclaimed.", reclaimed == 1);
+
+    mu_assert("Failed to initialize tree.", bt_init(&tree) && bt_set_epoch(tree, ebr));
+    for (unsigned i = 0; i < _EPOCH_TEST_KEYS; i++) {
+        sprintf(key, "key/%u", i);
+        bt_add(tree, key, &i, sizeof(i));
+    }
+    for (int i = 0; i < _EPOCH_EXIT_THREADS; i++) bt_parallel_for_each(tree, count_visit, &visited, 4);
+    mu_assert("Parallel walks should visit every entry.", visited == _EPOCH_EXIT_THREADS * _EPOCH_TEST_KEYS);
+
+    bt_free(&tree);
+    ebr_free(&ebr);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_epoch_retire_waits_for_readers) {
+    EpochDomain *ebr = NULL;
+
+    reclaimed = 0;
+    ebr_init(&ebr);
+
+    // A reader is active, so nothing retired now may be reclaimed yet
+    ebr_enter(ebr);
+    ebr_retire(ebr, malloc(16), count_reclaim, NULL);
+    ebr_collect(ebr);
+    ebr_collect(ebr);
+    ebr_collect(ebr);
+    mu_assert("Object was reclaimed while a reader was active.", reclaimed == 0);
+    ebr_exit(ebr);
+
+    ebr_synchronize(ebr);
+    mu_assert("ebr_synchronize() did not reclaim the retired object.", reclaimed == 1);
+
+    // Objects still in limbo are reclaimed when the domain is destroyed
+    ebr_retire(ebr, malloc(16), count_reclaim, NULL);
+    ebr_free(&ebr);
+    mu_assert("ebr_free() did not reclaim the retired object.", reclaimed == 2);
+
+    return MU_TEST_PASS;
+}
+
+/*
+ * Stress test: readers look up entries without locks while writers replace
+ * and remove them. Every value is filled with a single word derived from its
+ * key, so a reader that sees freed or torn memory notices a mismatch. Values
+ * have from 1 to _EPOCH_TEST_VALUE_WORDS words, and readers read as many as
+ * `bt_get_bytes()` reports, so a size paired with the wrong buffer reads past
+ * its end. Run
+ * under ASan and TSan with `make epoch SANITIZE=address` and
+ * `make epoch SANITIZE=thread`.
+ */
+typedef struct {
+    BinTree *tree;
+    EpochDomain *ebr;
+    pthread_mutex_t *write_lock;
+    int done;
+    int errors;
+    unsigned id;
+} epoch_stress;
+
+static void stress_key(char *buf, unsigned i) {
+    sprintf(buf, "key/%u", i % _EPOCH_TEST_KEYS);
+}
+
+// Rewrites every word of a value. Under an epoch this happens on a copy, so
+// readers never see it half done, and TSan would flag an in-place write.
+static void stress_update(void *data, size_t size, void *ctx) {
+    size_t *value = data;
+
+    for (size_t w = 0; w < size / sizeof(size_t); w++) value[w] = *(unsigned *)ctx;
+}
+
+static void *stress_writer(void *arg) {
+    epoch_stress *st = arg;
+    size_t value[_EPOCH_TEST_VALUE_WORDS];
+    char key[32];
+    unsigned rng = st->id * 7919 + 1;
+
+    for (unsigned i = 0; i < _EPOCH_TEST_WRITES; i++) {
+        rng = rng * 1103515245 + 12345;
+        unsigned k = (rng >> 8) % _EPOCH_TEST_KEYS;
+        stress_key(key, k);
+        for (int w = 0; w < _EPOCH_TEST_VALUE_WORDS; w++) value[w] = k;
+
+        pthread_mutex_lock(st->write_lock);
+        if (rng & 1)
+            bt_add(st->tree, key, value, (1 + (rng >> 16) % _EPOCH_TEST_VALUE_WORDS) * sizeof(size_t));
+        else if (rng & 2)
+            bt_update(st->tree, key, stress_update, &k);
+        else
+            bt_remove(st->tree, key);
+        pthread_mutex_unlock(st->write_lock);
+    }
+
+    return NULL;
+}
+
+static void *stress_reader(void *arg) {
+    epoch_stress *st = arg;
+    char key[32];
+    unsigned i = st->id;
+
+    while (!__atomic_load_n(&st->done, __ATOMIC_ACQUIRE)) {
+        unsigned k = i++ % _EPOCH_TEST_KEYS;
+        stress_key(key, k);
+
+        ebr_enter(st->ebr);
+        size_t size = 0, *value = bt_get_bytes(st->tree, key, strlen(key), &size);
+        if (value) {
+            if (!size || size % sizeof(size_t) || size > _EPOCH_TEST_VALUE_WORDS * sizeof(size_t)) st->errors++;
+            for (size_t w = 0; w < size / sizeof(size_t); w++) {
+                if (value[w] != k) st->errors++;
+            }
+        }
+        ebr_exit(st->ebr);
+    }
+
+    return NULL;
+}
+
+mu_test(test_epoch_bintree_stress) {
+    BinTree *tree = NULL;
+    EpochDomain *ebr = NULL;
+    pthread_mutex_t write_lock;
+    pthread_t readers[_EPOCH_TEST_READERS], writers[_EPOCH_TEST_WRITERS];
+    epoch_stress rs[_EPOCH_TEST_READERS], ws[_EPOCH_TEST_WRITERS];
+    int errors = 0;
+
+    mu_assert("Failed to initialize domain.", ebr_init(&ebr));
+    mu_assert("Failed to initialize tree.", bt_init(&tree));
+    mu_assert("Failed to attach domain to tree.", bt_set_epoch(tree, ebr));
+    mu_assert("bt_emplace() should be refused under an epoch.", !bt_emplace(tree, "key/0", 8, NULL));
+    mu_assert("A Bloom filter should be refused under an epoch.", !bt_set_bloom(tree, 100, 0.01));
+    mu_assert("Splay mode should be refused under an epoch.", !bt_set_splay(tree, 1));
+    mu_assert("Rebalancing should be refused under an epoch.", !bt_rebalance(tree) && !bt_rebalance_step(tree, 1));
+    pthread_mutex_init(&write_lock, NULL);
+
+    for (unsigned t = 0; t < _EPOCH_TEST_READERS; t++) {
+        rs[t] = (epoch_stress){tree, ebr, &write_lock, 0, 0, t};
+        pthread_create(&readers[t], NULL, stress_reader, &rs[t]);
+    }
+    for (unsigned t = 0; t < _EPOCH_TEST_WRITERS; t++) {
+        ws[t] = (epoch_stress){tree, ebr, &write_lock, 0, 0, t + 1};
+        pthread_create(&writers[t], NULL, stress_writer, &ws[t]);
+    }
+
+    for (unsigned t = 0; t < _EPOCH_TEST_WRITERS; t++) pthread_join(writers[t], NULL);
+    for (unsigned t = 0; t < _EPOCH_TEST_READERS; t++) {
+        __atomic_store_n(&rs[t].done, 1, __ATOMIC_RELEASE);
+        pthread_join(readers[t], NULL);
+        errors += rs[t].errors;
+    }
+
+    mu_assert("Readers observed freed or inconsistent entry data.", errors == 0);
+    mu_assert("Tree has more entries than keys.", bt_size(tree) <= _EPOCH_TEST_KEYS);
+
+    pthread_mutex_destroy(&write_lock);
+    bt_free(&tree);
+    ebr_free(&ebr);
+    return MU_TEST_PASS;
+}
+
+/*
+ * Removing an entry with two children moves the smallest entry of its right
+ * subtree into its place. Readers must find that entry throughout the move.
+ *
+ * Each round builds a tree whose upper levels are keys that get removed,
+ * inserted in balanced order, and whose lower levels are keys that stay,
+ * interleaved with them. Readers look up the keys that stay while the upper
+ * levels are removed, so most removals move one of them.
+ */
+#define _EPOCH_MOVE_KEYS 64
+#define _EPOCH_MOVE_ROUNDS 50
+
+static void move_key(char *buf, unsigned i) {
+    sprintf(buf, "move/%05u", i);
+}
+
+// Adds keys 2 * lo to 2 * (hi - 1), parents before their children
+static void move_add_balanced(BinTree *tree, unsigned lo, unsigned hi) {
+    char key[32];
+    unsigned mid = lo + (hi - lo) / 2;
+
+    if (lo >= hi) return;
+    move_key(key, 2 * mid);
+    bt_add(tree, key, &mid, sizeof(mid));
+    move_add_balanced(tree, lo, mid);
+    move_add_balanced(tree, mid + 1, hi);
+}
+
+static void *move_reader(void *arg) {
+    epoch_stress *st = arg;
+    char key[32];
+    unsigned i = st->id;
+
+    while (!__atomic_load_n(&st->done, __ATOMIC_ACQUIRE)) {
+        move_key(key, 2 * (i++ % _EPOCH_MOVE_KEYS) + 1);
+
+        ebr_enter(st->ebr);
+        if (!bt_has(st->tree, key)) st->errors++;
+        ebr_exit(st->ebr);
+    }
+
+    return NULL;
+}
+
+mu_test(test_epoch_bintree_moves) {
+    EpochDomain *ebr = NULL;
+    pthread_t readers[_EPOCH_TEST_READERS];
+    epoch_stress rs[_EPOCH_TEST_READERS];
+    unsigned order[_EPOCH_MOVE_KEYS], rng = 1;
+    char key[32];
+    int misses = 0;
+
+    mu_assert("Failed to initialize domain.", ebr_init(&ebr));
+
+    for (int round = 0; round < _EPOCH_MOVE_ROUNDS; round++) {
+        BinTree *tree = NULL;
+
+        mu_assert("Failed to initialize tree.", bt_init(&tree) && bt_set_epoch(tree, ebr));
+        move_add_balanced(tree, 0, _EPOCH_MOVE_KEYS);
+        for (unsigned i = 0; i < _EPOCH_MOVE_KEYS; i++) {
+            move_key(key, 2 * i + 1);
+            bt_add(tree, key, &i, sizeof(i));
+            order[i] = i;
+        }
+
+        for (unsigned t = 0; t < _EPOCH_TEST_READERS; t++) {
+            rs[t] = (epoch_stress){tree, ebr, NULL, 0, 0, t};
+            pthread_create(&readers[t], NULL, move_reader, &rs[t]);
+        }
+
+        // Remove the upper levels in random order
+        for (unsigned i = _EPOCH_MOVE_KEYS - 1; i > 0; i--) {
+            unsigned j, swap;
+
+            rng = rng * 1103515245 + 12345;
+            j = (rng >> 8) % (i + 1);
+            swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        for (unsigned i = 0; i < _EPOCH_MOVE_KEYS; i++) {
+            move_key(key, 2 * order[i]);
+            bt_remove(tree, key);
+        }
+
+        for (unsigned t = 0; t < _EPOCH_TEST_READERS; t++) {
+            __atomic_store_n(&rs[t].done, 1, __ATOMIC_RELEASE);
+            pthread_join(readers[t], NULL);
+            misses += rs[t].errors;
+        }
+        mu_assert("Every removed key should be gone.", bt_size(tree) == _EPOCH_MOVE_KEYS);
+        bt_free(&tree);
+    }
+
+    mu_assert("Readers missed keys that were never removed.", misses == 0);
+
+    ebr_free(&ebr);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_epoch_init_free);
+    mu_run_test(test_epoch_retire_waits_for_readers);
+    mu_run_test(test_epoch_exited_threads);
+    mu_run_test(test_epoch_bintree_stress);
+    mu_run_test(test_epoch_bintree_moves);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/lists/heap.h"
+#include "minunit.h"
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+// A pending timer, ordered by deadline
+typedef struct timer {
+    uint64_t deadline;
+    int id;
+} timer;
+
+static int cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_timer(const void *a, const void *b) {
+    uint64_t x = ((const timer *)a)->deadline, y = ((const timer *)b)->deadline;
+    return (x > y) - (x < y);
+}
+
+static int cmp_name(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void free_name(void *element) {
+    free(*(char **)element);
+}
+
+static uint64_t next_rand(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Pops every element, checking that they come out in order
+static int pops_sorted(Heap *heap, size_t expected) {
+    int prev = 0, value;
+    size_t count = 0;
+
+    while (heap_pop(heap, &value)) {
+        if (count++ && value < prev) return 0;
+        prev = value;
+    }
+    return count == expected;
+}
+
+mu_test(test_heap_init_free) {
+    Heap *heap = NULL;
+    int value = 1;
+
+    mu_assert("A NULL heap can't be constructed.", !heap_init(NULL, sizeof(int), cmp_int));
+    mu_assert("A heap needs a comparator.", !heap_init(&heap, sizeof(int), NULL) && !heap);
+    mu_assert("A heap needs elements of some size.", !heap_init(&heap, 0, cmp_int) && !heap);
+    mu_assert("A heap needs at least 2 children per node.", !heap_init_with_arity(&heap, sizeof(int), cmp_int, 1));
+    mu_assert("Failed to construct heap.", heap_init(&heap, sizeof(int), cmp_int));
+    mu_assert("A new heap should be empty.", heap_size(heap) == 0 && !heap_peek(heap) && !heap_pop(heap, &value));
+
+    mu_assert("NULL heaps should be refused.", !heap_push(NULL, &value, NULL) && !heap_size(NULL) && !heap_peek(NULL));
+    mu_assert("NULL elements should be refused.", !heap_push(heap, NULL, NULL));
+
+    heap_free(&heap);
+    mu_assert("Freed heap should be NULL.", heap == NULL);
+    heap_free(&heap);
+    heap_free(NULL);
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_heap_push_pop) {
+    uint64_t rng = 7;
+
+    // Pops come out sorted whatever the arity, duplicates included
+    for (unsigned arity = 2; arity <= 8; arity++) {
+        Heap *heap = NULL;
+
+        heap_init_with_arity(&heap, sizeof(int), cmp_int, arity);
+        for (int i = 0; i < 5000; i++) {
+            int value = (int)(next_rand(&rng) % 1000);
+            mu_assert("heap_push() failed.", heap_push(heap, &value, NULL));
+        }
+        mu_assert("Heap has the wrong size.", heap_size(heap) == 5000);
+        mu_assert("Pops should come out sorted.", pops_sorted(heap, 5000));
+        mu_assert("A drained heap should be empty.", heap_size(heap) == 0 && !heap_peek(heap));
+        heap_free(&heap);
+    }
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_heap_handles) {
+    Heap *heap = NULL;
+    HeapHandle handles[100], handle;
+    timer t, *found;
+
+    heap_init(&heap, sizeof(timer), cmp_timer);
+    for (int i = 0; i < 100; i++) {
+        t.deadline = (uint64_t)(1000 + i * 10);
+        t.id = i;
+        heap_push(heap, &t, &handles[i]);
+    }
+    mu_assert("The earliest timer should come first.", ((timer *)heap_peek(heap))->id == 0);
+
+    // Each handle keeps finding its timer as timers move around
+    for (int i = 0; i < 100; i++) {
+        found = heap_get(heap, handles[i]);
+        mu_assert("Handle lost its element.", found && found->id == i);
+    }
+
+    // Bring a timer forward, then push one back
+    found = heap_get(heap, handles[50]);
+    found->deadline = 1;
+    mu_assert("heap_update() failed.", heap_update(heap, handles[50]));
+    mu_assert("A decreased key should come first.", ((timer *)heap_peek(heap))->id == 50);
+    found = heap_get(heap, handles[0]);
+    found->deadline = 5000;
+    heap_update(heap, handles[0]);
+    mu_assert("An increased key should move down.", ((timer *)heap_get(heap, handles[0]))->deadline == 5000);
+
+    // Cancel a few timers
+    mu_assert("heap_remove() failed.", heap_remove(heap, handles[20], &t) && t.id == 20);
+    mu_assert("heap_remove() failed.", heap_remove(heap, handles[99], NULL));
+    mu_assert("Removed timers should be gone.", !heap_get(heap, handles[20]) && !heap_remove(heap, handles[20], NULL));
+    mu_assert("Unknown handles should be refused.", !heap_update(heap, HEAP_NO_HANDLE) && !heap_get(heap, 1000));
+
+    // Handles are reused once their timers are gone
+    t.deadline = 2;
+    t.id = 100;
+    heap_push(heap, &t, &handle);
+    mu_assert("A handle should be reused.", handle == handles[20] || handle == handles[99]);
+
+    mu_assert("heap_pop() failed.", heap_pop(heap, &t) && t.id == 50);
+    mu_assert("heap_pop() failed.", heap_pop(heap, &t) && t.id == 100);
+    mu_assert("heap_pop() failed.", heap_pop(heap, &t) && t.id == 1);
+    mu_assert("Popped timers should be gone.", !heap_get(heap, handles[50]));
+    for (int i = 2; i < 99; i++) {
+        if (i == 20 || i == 50) continue;
+        heap_pop(heap, &t);
+        mu_assert("Timers came out of order.", t.id == i);
+    }
+    mu_assert("heap_pop() failed.", heap_pop(heap, &t) && t.id == 0 && !heap_size(heap));
+
+    heap_free(&heap);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_heap_random) {
+    Heap *heap = NULL;
+    HeapHandle handles[512];
+    int values[512], live[512] = {0};
+    uint64_t rng = 3;
+
+    // Random operations, checked against a plain array
+    heap_init_with_arity(&heap, sizeof(int), cmp_int, 3);
+    for (int op = 0; op < 50000; op++) {
+        int slot = (int)(next_rand(&rng) % 512), value, min = -1;
+
+        switch (next_rand(&rng) % 4) {
+        case 0:
+            if (live[slot]) break;
+            values[slot] = (int)(next_rand(&rng) % 10000);
+            heap_push(heap, &values[slot], &handles[slot]);
+            live[slot] = 1;
+            break;
+        case 1:
+            if (!live[slot]) break;
+            values[slot] = (int)(next_rand(&rng) % 10000);
+            *(int *)heap_get(heap, handles[slot]) = values[slot];
+            mu_assert("heap_update() failed.", heap_update(heap, handles[slot]));
+            break;
+        case 2:
+            if (!live[slot]) break;
+            mu_assert("heap_remove() failed.", heap_remove(heap, handles[slot], &value) && value == values[slot]);
+            live[slot] = 0;
+            break;
+        default:
+            for (int i = 0; i < 512; i++) {
+                if (live[i] && (min < 0 || values[i] < values[min])) min = i;
+            }
+            if (min < 0) {
+                mu_assert("An empty heap should not pop.", !heap_pop(heap, &value));
+                break;
+            }
+            mu_assert("heap_pop() failed.", heap_pop(heap, &value) && value == values[min]);
+            // Ties may come out in any order
+            for (int i = 0; i < 512; i++) {
+                if (live[i] && values[i] == value && !heap_get(heap, handles[i])) {
+                    live[i] = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    heap_free(&heap);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_heap_from_vector) {
+    Heap *heap = NULL;
+    Vector v;
+    char *name;
+    uint64_t rng = 11;
+
+    vector_init(&v, 4, sizeof(int), NULL);
+    for (int i = 0; i < 10000; i++) {
+        int value = (int)(next_rand(&rng) % 100000);
+        vector_pushback(&v, &value);
+    }
+
+    mu_assert("A heap needs a vector.", !heap_init_from_vector(&heap, NULL, cmp_int, 4));
+    mu_assert("Failed to heapify.", heap_init_from_vector(&heap, &v, cmp_int, 4));
+    mu_assert("The vector should be left empty.", v.size == 0 && !v.data);
+    mu_assert("Heap has the wrong size.", heap_size(heap) == 10000);
+
+    // Handles are the original indices
+    rng = 11;
+    for (HeapHandle i = 0; i < 10000; i++) {
+        mu_assert("Handle doesn't match index.", *(int *)heap_get(heap, i) == (int)(next_rand(&rng) % 100000));
+    }
+    mu_assert("Heapified pops should come out sorted.", pops_sorted(heap, 10000));
+    heap_free(&heap);
+
+    // Small vectors are grown before the heap pushes to them, and the heap
+    // frees elements with the vector's function
+    vector_init(&v, 3, sizeof(char *), free_name);
+    name = malloc(8);
+    strcpy(name, "delta");
+    vector_set(&v, &name, 0);
+    v.size = 1;
+    heap_init_from_vector(&heap, &v, cmp_name, 2);
+    for (int i = 0; i < 3; i++) {
+        name = malloc(8);
+        strcpy(name, i == 0 ? "alpha" : i == 1 ? "echo" : "charlie");
+        heap_push(heap, &name, NULL);
+    }
+    mu_assert("heap_pop() failed.", heap_pop(heap, &name) && !strcmp(name, "alpha"));
+    free(name);
+    mu_assert("heap_pop() failed.", heap_pop(heap, NULL) && !strcmp(*(char **)heap_peek(heap), "delta"));
+
+    heap_free(&heap);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_heap_init_free);
+    mu_run_test(test_heap_push_pop);
+    mu_run_test(test_heap_handles);
+    mu_run_test(test_heap_random);
+    mu_run_test(test_heap_from_vector);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
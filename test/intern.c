@@ -0,0 +1,215 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/bintree.h"
+#include "../src/map/intern.h"
+#include "../src/util/epoch.h"
+#include "minunit.h"
+
+#define _INTERN_TEST_KEYS 5000
+#define _INTERN_TEST_THREADS 4
+#define _INTERN_TEST_ROUNDS 2000
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+mu_test(test_intern_acquire_release) {
+    InternPool *pool = NULL;
+    const char *a, *b, *c, *bin;
+    const char bytes[] = {'x', 0, 'y'};
+
+    mu_assert("Failed to initialize pool.", intern_init(&pool) == _MAP_SUCCESS);
+    mu_assert("Empty pool's size is not 0.", intern_size(pool) == 0);
+
+    a = intern_acquire(pool, "foo", 3);
+    b = intern_acquire(pool, "foobar", 3);  // only "foo"
+    c = intern_acquire(pool, "bar", 3);
+    mu_assert("Interning failed.", a && b && c);
+    mu_assert("Equal keys should be interned to the same pointer.", a == b);
+    mu_assert("Different keys should be interned separately.", a != c);
+    mu_assert("Interned key has the wrong contents.", !strcmp(a, "foo") && intern_len(a) == 3);
+    mu_assert("Wrong number of interned keys.", intern_size(pool) == 2);
+
+    bin = intern_acquire(pool, bytes, sizeof(bytes));
+    mu_assert("Binary key has the wrong contents.", !memcmp(bin, bytes, 3) && intern_len(bin) == 3);
+    mu_assert("Binary key should not match a string key.", bin != intern_acquire(pool, "x", 1));
+
+    // "foo" holds 2 references, plus one more
+    mu_assert("intern_retain() should return its key.", intern_retain(a) == a);
+    intern_release(pool, a);
+    intern_release(pool, a);
+    mu_assert("Key freed while still referenced.", intern_size(pool) == 4 && !strcmp(b, "foo"));
+    intern_release(pool, b);
+    mu_assert("Key not freed after its last release.", intern_size(pool) == 3);
+
+    // Keys freed from the pool can be interned again
+    a = intern_acquire(pool, "foo", 3);
+    mu_assert("Re-interning a freed key failed.", a && intern_size(pool) == 4);
+    intern_release(pool, a);
+    intern_release(pool, NULL);
+
+    // Leftover keys are freed with the pool
+    intern_free(&pool);
+    mu_assert("After intern_free(), pool should be NULL.", pool == NULL);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_intern_many) {
+    InternPool *pool = NULL;
+    const char **keys = malloc(_INTERN_TEST_KEYS * sizeof(char *));
+    char key[32];
+
+    intern_init(&pool);
+    for (int i = 0; i < _INTERN_TEST_KEYS; i++) {
+        sprintf(key, "key/%d", i);
+        keys[i] = intern_acquire(pool, key, strlen(key));
+    }
+    mu_assert("Wrong number of interned keys after growing.", intern_size(pool) == _INTERN_TEST_KEYS);
+    for (int i = 0; i < _INTERN_TEST_KEYS; i++) {
+        sprintf(key, "key/%d", i);
+        const char *again = intern_acquire(pool, key, strlen(key));
+        mu_assert("Key lost its identity after growing.", again == keys[i]);
+        intern_release(pool, again);
+        intern_release(pool, keys[i]);
+    }
+    mu_assert("Every key should have been freed.", intern_size(pool) == 0);
+
+    intern_free(&pool);
+    free(keys);
+    return MU_TEST_PASS;
+}
+
+static void *churn_keys(void *arg) {
+    InternPool *pool = arg;
+    char key[16];
+
+    for (int i = 0; i < _INTERN_TEST_ROUNDS; i++) {
+        sprintf(key, "%d", i % 50);
+        const char *k = intern_acquire(pool, key, strlen(key));
+        if (strcmp(k, key)) abort();
+        intern_release(pool, intern_retain(k));
+        intern_release(pool, k);
+    }
+
+    return NULL;
+}
+
+mu_test(test_intern_concurrent) {
+    InternPool *pool = NULL;
+    pthread_t threads[_INTERN_TEST_THREADS];
+
+    intern_init(&pool);
+    for (int i = 0; i < _INTERN_TEST_THREADS; i++) pthread_create(&threads[i], NULL, churn_keys, pool);
+    for (int i = 0; i < _INTERN_TEST_THREADS; i++) pthread_join(threads[i], NULL);
+    mu_assert("Keys were leaked by concurrent releases.", intern_size(pool) == 0);
+
+    intern_free(&pool);
+    return MU_TEST_PASS;
+}
+
+static int collect_keys(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)data;
+    (void)size;
+    strncat(ctx, key, keylen);
+    return 0;
+}
+
+mu_test(test_intern_bintrees) {
+    InternPool *pool = NULL;
+    BinTree *a = NULL, *b = NULL;
+    const char *key;
+    char keys[32] = {0};
+    int one = 1, two = 2;
+
+    intern_init(&pool);
+    bt_init(&a);
+    bt_init(&b);
+    mu_assert("Failed to set the intern pool.", bt_set_intern_pool(a, pool) && bt_set_intern_pool(b, pool));
+
+    bt_add(a, "x", &one, sizeof(int));
+    bt_add(a, "y", &one, sizeof(int));
+    bt_add(b, "y", &two, sizeof(int));
+    bt_add(b, "z", &two, sizeof(int));
+    bt_add(b, "z", &one, sizeof(int));  // replacing keeps the key
+    mu_assert("Trees should share their common keys.", intern_size(pool) == 3);
+    mu_assert("The pool can't change once a tree has entries.", !bt_set_intern_pool(a, NULL));
+
+    // Lookups by interned key and by plain key agree
+    key = intern_acquire(pool, "y", 1);
+    mu_assert("Lookup by interned key failed.", *(int *)bt_get_bytes(a, key, intern_len(key), NULL) == one);
+    mu_assert("Lookup by interned key failed.", *(int *)bt_get_bytes(b, key, intern_len(key), NULL) == two);
+    mu_assert("Lookup by plain key failed.", *(int *)bt_get(b, "y") == two && *(int *)bt_get(b, "z") == one);
+    intern_release(pool, key);
+
+    bt_for_each(b, collect_keys, keys);
+    mu_assert("Interned keys should be visited in key order.", !strcmp(keys, "yz"));
+
+    mu_assert("Removal failed.", bt_remove(a, "y") == _MAP_SUCCESS);
+    mu_assert("A key still held by another tree was freed.", intern_size(pool) == 3);
+    mu_assert("Removal failed.", bt_remove(b, "y") == _MAP_SUCCESS);
+    mu_assert("A key held by no tree was not freed.", intern_size(pool) == 2);
+
+    bt_free(&a);
+    mu_assert("bt_free() did not release its keys.", intern_size(pool) == 1);
+    bt_free(&b);
+    mu_assert("bt_free() did not release its keys.", intern_size(pool) == 0);
+
+    intern_free(&pool);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_intern_bintree_epoch) {
+    InternPool *pool = NULL;
+    EpochDomain *ebr = NULL;
+    BinTree *tree = NULL;
+    int one = 1;
+
+    intern_init(&pool);
+    ebr_init(&ebr);
+    bt_init(&tree);
+    bt_set_intern_pool(tree, pool);
+    bt_set_epoch(tree, ebr);
+
+    bt_add(tree, "k", &one, sizeof(int));
+    ebr_enter(ebr);
+    mu_assert("Entry is missing.", bt_get(tree, "k") != NULL);
+    bt_remove(tree, "k");
+    // A reader may still be comparing against the key
+    ebr_collect(ebr);
+    ebr_collect(ebr);
+    mu_assert("Key released while a reader was active.", intern_size(pool) == 1);
+    ebr_exit(ebr);
+    ebr_synchronize(ebr);
+    mu_assert("Retired key was never released.", intern_size(pool) == 0);
+
+    bt_free(&tree);
+    ebr_free(&ebr);
+    intern_free(&pool);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_intern_acquire_release);
+    mu_run_test(test_intern_many);
+    mu_run_test(test_intern_concurrent);
+    mu_run_test(test_intern_bintrees);
+    mu_run_test(test_intern_bintree_epoch);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
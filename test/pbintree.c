@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/pbintree.h"
+#include "minunit.h"
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+mu_test(test_pbt_empty) {
+    PBinTree *tree = NULL;
+    PBtSnapshot *snap = NULL;
+
+    mu_assert("Failed to initialize tree.", pbt_init(&tree) == _MAP_SUCCESS);
+    mu_assert("Empty tree's size is not 0.", pbt_size(tree) == 0);
+    mu_assert("Removing from an empty tree should return 0.", !pbt_remove(tree, "foo"));
+
+    mu_assert("Failed to snapshot an empty tree.", pbt_snapshot(tree, &snap));
+    mu_assert("Empty snapshot's size is not 0.", pbt_snapshot_size(snap) == 0);
+    mu_assert("Empty snapshot should not contain any keys.", !pbt_snapshot_has(snap, "foo"));
+
+    pbt_snapshot_free(&snap);
+    mu_assert("After pbt_snapshot_free(), snapshot should be NULL.", snap == NULL);
+    pbt_free(&tree);
+    mu_assert("After pbt_free(), tree should be NULL.", tree == NULL);
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_pbt_add_get_remove) {
+    PBinTree *tree = NULL;
+    char *keys[] = {"d", "b", "a", "g", "h", "e", "f"};
+    int data[] = {1, 2, 3, 4, 5, 6, 7};
+    int replaced = 42;
+
+    pbt_init(&tree);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Insertion failed.", pbt_add(tree, keys[i], &data[i], sizeof(int)) == _MAP_SUCCESS);
+    }
+    mu_assert("Incorrect size after 7 insertions.", pbt_size(tree) == 7);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Entry has the wrong value after insertion.", *(int *)pbt_get(tree, keys[i]) == data[i]);
+    }
+
+    mu_assert("Replacing an entry should return _MAP_SUCCESS_REPLACED.", pbt_add(tree, "e", &replaced, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry has the wrong value.", *(int *)pbt_get(tree, "e") == replaced);
+
+    // "d" has two children, "b" one, "h" none
+    mu_assert("Failed to remove 'd'.", pbt_remove(tree, "d") == _MAP_SUCCESS);
+    mu_assert("Failed to remove 'b'.", pbt_remove(tree, "b") == _MAP_SUCCESS);
+    mu_assert("Failed to remove 'h'.", pbt_remove(tree, "h") == _MAP_SUCCESS);
+    mu_assert("Removing a missing key should return 0.", !pbt_remove(tree, "d"));
+    mu_assert("Incorrect size after removals.", pbt_size(tree) == 4);
+    mu_assert("Removed key is still present.", !pbt_has(tree, "d") && !pbt_has(tree, "b") && !pbt_has(tree, "h"));
+    mu_assert("Remaining key is missing.", pbt_has(tree, "a") && pbt_has(tree, "e") && pbt_has(tree, "f") && pbt_has(tree, "g"));
+
+    pbt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+static int collect_keys(const char *key, size_t keylen, void *data, size_t size, void *ctx) {
+    (void)data;
+    (void)size;
+    strncat(ctx, key, keylen);
+    return 0;
+}
+
+mu_test(test_pbt_snapshot_isolation) {
+    PBinTree *tree = NULL;
+    PBtSnapshot *before = NULL, *after = NULL;
+    char keys[32] = {0};
+    int one = 1, two = 2;
+
+    pbt_init(&tree);
+    pbt_add(tree, "b", &one, sizeof(int));
+    pbt_add(tree, "a", &one, sizeof(int));
+    pbt_add(tree, "c", &one, sizeof(int));
+    mu_assert("Failed to take snapshot.", pbt_snapshot(tree, &before));
+
+    // Writes after the snapshot must not be visible through it
+    pbt_add(tree, "b", &two, sizeof(int));
+    pbt_add(tree, "d", &two, sizeof(int));
+    pbt_remove(tree, "a");
+    pbt_snapshot(tree, &after);
+
+    mu_assert("Snapshot size changed after writes.", pbt_snapshot_size(before) == 3);
+    mu_assert("Snapshot sees a replaced value.", *(int *)pbt_snapshot_get(before, "b") == one);
+    mu_assert("Snapshot lost a removed key.", pbt_snapshot_has(before, "a"));
+    mu_assert("Snapshot sees an inserted key.", !pbt_snapshot_has(before, "d"));
+
+    mu_assert("Tree does not see the replaced value.", *(int *)pbt_get(tree, "b") == two);
+    mu_assert("Second snapshot has the wrong size.", pbt_snapshot_size(after) == 3);
+
+    pbt_snapshot_for_each(before, collect_keys, keys);
+    mu_assert("Snapshot iteration is not in key order.", !strcmp(keys, "abc"));
+
+    // Snapshots outlive the tree
+    pbt_free(&tree);
+    keys[0] = '\0';
+    pbt_snapshot_for_each(after, collect_keys, keys);
+    mu_assert("Snapshot did not survive pbt_free().", !strcmp(keys, "bcd"));
+
+    pbt_snapshot_free(&before);
+    pbt_snapshot_free(&after);
+    return MU_TEST_PASS;
+}
+
+typedef struct {
+    PBtSnapshot *snap;
+    int errors;
+} snapshot_reader;
+
+static void *read_snapshot(void *arg) {
+    snapshot_reader *r = arg;
+    char key[16];
+
+    for (int i = 0; i < 500; i++) {
+        sprintf(key, "%03d", i);
+        int *value = pbt_snapshot_get(r->snap, key);
+        if (!value || *value != i) r->errors++;
+    }
+
+    pbt_snapshot_free(&r->snap);
+    return NULL;
+}
+
+mu_test(test_pbt_snapshot_concurrent_reader) {
+    PBinTree *tree = NULL;
+    snapshot_reader reader = {NULL, 0};
+    pthread_t thread;
+    char key[16];
+
+    pbt_init(&tree);
+    for (int i = 0; i < 500; i++) {
+        sprintf(key, "%03d", (i * 7) % 500);
+        int value = (i * 7) % 500;
+        pbt_add(tree, key, &value, sizeof(int));
+    }
+
+    // Export a snapshot on another thread while the writer keeps going
+    pbt_snapshot(tree, &reader.snap);
+    pthread_create(&thread, NULL, read_snapshot, &reader);
+    for (int i = 0; i < 500; i++) {
+        int value = -1;
+        sprintf(key, "%03d", i);
+        if (i % 2)
+            pbt_remove(tree, key);
+        else
+            pbt_add(tree, key, &value, sizeof(int));
+    }
+    pthread_join(thread, NULL);
+
+    mu_assert("Reader saw writes made after the snapshot.", reader.errors == 0);
+    mu_assert("Tree has the wrong size after writes.", pbt_size(tree) == 250);
+
+    pbt_free(&tree);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_pbt_empty);
+    mu_run_test(test_pbt_add_get_remove);
+    mu_run_test(test_pbt_snapshot_isolation);
+    mu_run_test(test_pbt_snapshot_concurrent_reader);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
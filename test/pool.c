@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/util/pool.h"
+#include "minunit.h"
+
+#define _POOL_TEST_THREADS 4
+#define _POOL_TEST_LEAF 64
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+// Shared state of a test computation, with one sum per thread
+typedef struct pool_test {
+    unsigned long long sums[_POOL_TEST_THREADS];
+    unsigned long long tasks;
+    unsigned bad_index;
+} pool_test;
+
+// Sums the indices in [lo, hi), always splitting ranges in two
+static void sum_eager(PoolWorker *worker, PoolTask *task) {
+    pool_test *t = task->ctx;
+    unsigned index = pool_worker_index(worker);
+
+    __atomic_fetch_add(&t->tasks, 1, __ATOMIC_RELAXED);
+    if (index >= _POOL_TEST_THREADS) t->bad_index = 1;
+
+    while (task->hi - task->lo > _POOL_TEST_LEAF) {
+        PoolTask half = *task;
+        half.lo = task->lo + (task->hi - task->lo) / 2;
+        pool_spawn(worker, &half);
+        task->hi = half.lo;
+    }
+    for (size_t i = task->lo; i < task->hi; i++) t->sums[index] += i;
+}
+
+// Sums the indices in [lo, hi), only splitting while another thread is idle
+static void sum_lazy(PoolWorker *worker, PoolTask *task) {
+    pool_test *t = task->ctx;
+    unsigned index = pool_worker_index(worker);
+
+    __atomic_fetch_add(&t->tasks, 1, __ATOMIC_RELAXED);
+    while (task->lo < task->hi) {
+        if (task->hi - task->lo > 2 * _POOL_TEST_LEAF && pool_hungry(worker)) {
+            PoolTask half = *task;
+            half.lo = task->lo + (task->hi - task->lo) / 2;
+            pool_spawn(worker, &half);
+            task->hi = half.lo;
+        }
+        t->sums[index] += task->lo++;
+    }
+}
+
+// Spawns `hi` leaf tasks at once, more than a deque holds
+static void count_leaf(PoolWorker *worker, PoolTask *task) {
+    pool_test *t = task->ctx;
+    (void)worker;
+    __atomic_fetch_add(&t->tasks, 1, __ATOMIC_RELAXED);
+}
+
+static void spawn_many(PoolWorker *worker, PoolTask *task) {
+    PoolTask leaf = {count_leaf, task->ctx, NULL, 0, 0};
+
+    for (size_t i = 0; i < task->hi; i++) pool_spawn(worker, &leaf);
+}
+
+static unsigned long long total(const pool_test *t) {
+    unsigned long long sum = 0;
+
+    for (int i = 0; i < _POOL_TEST_THREADS; i++) sum += t->sums[i];
+    return sum;
+}
+
+mu_test(test_pool_init_free) {
+    WorkPool *pool = NULL;
+
+    mu_assert("A pool needs at least one thread.", !pool_init(&pool, 0) && !pool);
+    mu_assert("A NULL pool can't be constructed.", !pool_init(NULL, 1));
+    mu_assert("Failed to construct pool.", pool_init(&pool, _POOL_TEST_THREADS));
+    mu_assert("Pool has the wrong size.", pool_size(pool) == _POOL_TEST_THREADS);
+    mu_assert("A NULL pool has no threads.", pool_size(NULL) == 0);
+    mu_assert("A NULL task can't run.", !pool_run(pool, NULL));
+
+    pool_free(&pool);
+    mu_assert("Freed pool should be NULL.", pool == NULL);
+    pool_free(&pool);
+    pool_free(NULL);
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_pool_run) {
+    WorkPool *pool = NULL;
+    pool_test t;
+    PoolTask task = {sum_eager, &t, NULL, 0, 100000};
+    unsigned long long expected = 100000ULL * 99999 / 2;
+
+    pool_init(&pool, _POOL_TEST_THREADS);
+
+    // Each computation waits for every task it spawned, and a pool can run
+    // any number of them
+    for (int round = 0; round < 20; round++) {
+        memset(&t, 0, sizeof(t));
+        task.fn = round % 2 ? sum_lazy : sum_eager;
+        mu_assert("pool_run() failed.", pool_run(pool, &task));
+        mu_assert("Computation missed part of its range.", total(&t) == expected);
+        mu_assert("Worker index out of range.", !t.bad_index);
+        if (!(round % 2)) mu_assert("Eager splitting should spawn tasks.", t.tasks >= 100000 / _POOL_TEST_LEAF);
+    }
+
+    // Tasks that don't fit in a deque run at once
+    memset(&t, 0, sizeof(t));
+    task.fn = spawn_many;
+    task.hi = 1000;
+    mu_assert("pool_run() failed.", pool_run(pool, &task));
+    mu_assert("Every spawned task should run.", t.tasks == 1000);
+
+    pool_free(&pool);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_pool_single_thread) {
+    WorkPool *pool = NULL;
+    pool_test t;
+    PoolTask task = {sum_lazy, &t, NULL, 0, 10000};
+
+    // With no other thread to help, lazy tasks never split
+    pool_init(&pool, 1);
+    memset(&t, 0, sizeof(t));
+    mu_assert("pool_run() failed.", pool_run(pool, &task));
+    mu_assert("Computation missed part of its range.", total(&t) == 10000ULL * 9999 / 2);
+    mu_assert("A lone thread should never be hungry.", t.tasks == 1);
+
+    // Spawned tasks still run
+    memset(&t, 0, sizeof(t));
+    task.fn = sum_eager;
+    mu_assert("pool_run() failed.", pool_run(pool, &task));
+    mu_assert("Computation missed part of its range.", t.sums[0] == 10000ULL * 9999 / 2);
+
+    pool_free(&pool);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_pool_init_free);
+    mu_run_test(test_pool_run);
+    mu_run_test(test_pool_single_thread);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/sharded.h"
+#include "minunit.h"
+
+#define _SHARDED_TEST_THREADS 8
+#define _SHARDED_TEST_KEYS 2000
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+mu_test(test_sharded_empty) {
+    ShardedMap *map = NULL;
+
+    mu_assert("Failed to initialize map.", sharded_init(&map) == _MAP_SUCCESS);
+    mu_assert("Default map should use SHARDED_DEFAULT_SHARDS shards.", sharded_shards(map) == SHARDED_DEFAULT_SHARDS);
+    mu_assert("Empty map's size is not 0.", sharded_size(map) == 0);
+    mu_assert("Empty map should not contain any keys.", !sharded_has(map, "foo"));
+    mu_assert("Removing from an empty map should return 0.", !sharded_remove(map, "foo"));
+
+    sharded_free(&map);
+    mu_assert("After sharded_free(), map should be NULL.", map == NULL);
+
+    mu_assert("A map with 0 shards should not be created.", sharded_init_with_shards(&map, 0) == _MAP_FAILURE);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_sharded_add_get_remove) {
+    ShardedMap *map = NULL;
+    int data1 = 10, data2 = 5, out = 0;
+    size_t size = sizeof(int);
+
+    mu_assert("Failed to initialize map.", sharded_init_with_shards(&map, 3) == _MAP_SUCCESS);
+    mu_assert("Map should have 3 shards.", sharded_shards(map) == 3);
+
+    mu_assert("Failed to insert entry.", sharded_add(map, "key", &data1, sizeof(int)) == _MAP_SUCCESS);
+    mu_assert("Map should have a size of 1 after insertion.", sharded_size(map) == 1);
+    mu_assert("sharded_has() should return true after insertion.", sharded_has(map, "key"));
+    mu_assert("sharded_get() should find the entry.", sharded_get(map, "key", &out, &size) == _MAP_SUCCESS);
+    mu_assert("sharded_get() copied the wrong value.", out == data1 && size == sizeof(int));
+
+    mu_assert("Replacing an entry should return _MAP_SUCCESS_REPLACED.", sharded_add(map, "key", &data2, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replacing an entry should not change the size.", sharded_size(map) == 1);
+    sharded_get(map, "key", &out, &size);
+    mu_assert("sharded_get() should return the replaced value.", out == data2);
+
+    mu_assert("Removing an existing entry should succeed.", sharded_remove(map, "key") == _MAP_SUCCESS);
+    mu_assert("Map should be empty after removal.", sharded_size(map) == 0);
+    mu_assert("sharded_get() should fail after removal.", sharded_get(map, "key", &out, &size) == _MAP_FAILURE);
+    mu_assert("A missing entry should have size 0.", size == 0);
+
+    sharded_free(&map);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_sharded_get_short_entry) {
+    ShardedMap *map = NULL;
+    char small = 'x', large[16] = "0123456789abcde";
+    char out[8];
+    size_t size = sizeof(out);
+
+    sharded_init(&map);
+    memset(out, 0, sizeof(out));
+    sharded_add(map, "small", &small, sizeof(small));
+    sharded_add(map, "large", large, sizeof(large));
+
+    // Only the stored byte may be copied, even though dst is larger
+    mu_assert("sharded_get() should find the entry.", sharded_get(map, "small", out, &size));
+    mu_assert("sharded_get() copied the wrong value.", out[0] == 'x' && size == 1);
+    mu_assert("sharded_get() copied past the end of the entry.", out[1] == 0);
+
+    // An entry that doesn't fit is reported with its size instead of truncated
+    size = sizeof(out);
+    mu_assert("sharded_get() should refuse an entry larger than dst.", !sharded_get(map, "large", out, &size));
+    mu_assert("sharded_get() should report the size of the entry.", size == sizeof(large));
+    mu_assert("sharded_get() should not copy an entry that doesn't fit.", out[0] == 'x' && out[1] == 0);
+    mu_assert("sharded_get() should copy the entry into a large enough dst.",
+              sharded_get(map, "large", large, &size) && !strcmp(large, "0123456789abcde"));
+    mu_assert("sharded_get() should refuse a NULL size.", !sharded_get(map, "small", out, NULL));
+
+    sharded_free(&map);
+    return MU_TEST_PASS;
+}
+
+typedef struct {
+    ShardedMap *map;
+    int id;
+} sharded_worker;
+
+static void *sharded_test_worker(void *arg) {
+    sharded_worker *w = arg;
+    char key[32];
+
+    for (int i = 0; i < _SHARDED_TEST_KEYS; i++) {
+        int value = w->id * _SHARDED_TEST_KEYS + i;
+        sprintf(key, "%d/%d", w->id, i);
+        sharded_add(w->map, key, &value, sizeof(int));
+    }
+
+    // Remove every other key again
+    for (int i = 0; i < _SHARDED_TEST_KEYS; i += 2) {
+        sprintf(key, "%d/%d", w->id, i);
+        sharded_remove(w->map, key);
+    }
+
+    return NULL;
+}
+
+mu_test(test_sharded_concurrent) {
+    ShardedMap *map = NULL;
+    pthread_t threads[_SHARDED_TEST_THREADS];
+    sharded_worker workers[_SHARDED_TEST_THREADS];
+    char key[32];
+    int out;
+    size_t size;
+
+    sharded_init_with_shards(&map, 7);
+
+    for (int t = 0; t < _SHARDED_TEST_THREADS; t++) {
+        workers[t].map = map;
+        workers[t].id = t;
+        pthread_create(&threads[t], NULL, sharded_test_worker, &workers[t]);
+    }
+    for (int t = 0; t < _SHARDED_TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    mu_assert("Incorrect size after concurrent writes.", sharded_size(map) == _SHARDED_TEST_THREADS * _SHARDED_TEST_KEYS / 2);
+
+    for (int t = 0; t < _SHARDED_TEST_THREADS; t++) {
+        for (int i = 0; i < _SHARDED_TEST_KEYS; i++) {
+            sprintf(key, "%d/%d", t, i);
+            if (i % 2) {
+                size = sizeof(int);
+                mu_assert("Key written by a worker is missing.", sharded_get(map, key, &out, &size));
+                mu_assert("Key written by a worker has the wrong value.", out == t * _SHARDED_TEST_KEYS + i);
+            } else {
+                mu_assert("Key removed by a worker is still present.", !sharded_has(map, key));
+            }
+        }
+    }
+
+    sharded_free(&map);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_sharded_empty);
+    mu_run_test(test_sharded_add_get_remove);
+    mu_run_test(test_sharded_get_short_entry);
+    mu_run_test(test_sharded_concurrent);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
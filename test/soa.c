@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/lists/soa.h"
+#include "minunit.h"
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+// A record with fields of several sizes, and padding between them
+typedef struct order {
+    uint64_t id;
+    char side;
+    double price;
+    uint32_t qty;
+    char venue[5];
+} order;
+
+static const SoaField order_fields[] = {SOA_FIELD(order, id), SOA_FIELD(order, side), SOA_FIELD(order, price),
+                                        SOA_FIELD(order, qty), SOA_FIELD(order, venue)};
+
+#define ORDER_FIELDS (sizeof(order_fields) / sizeof(order_fields[0]))
+
+static order make_order(size_t i) {
+    order o;
+
+    memset(&o, 0, sizeof(o));
+    o.id = i * 7919;
+    o.side = i % 2 ? 'B' : 'S';
+    o.price = (double)i / 4;
+    o.qty = (uint32_t)(i % 1000);
+    snprintf(o.venue, sizeof(o.venue), "V%03u", (unsigned)(i % 1000));
+    return o;
+}
+
+static int same_order(const order *a, const order *b) {
+    return a->id == b->id && a->side == b->side && a->price == b->price && a->qty == b->qty &&
+           !memcmp(a->venue, b->venue, sizeof(a->venue));
+}
+
+mu_test(test_soa_init_free) {
+    SoaVector *soa = NULL;
+    const SoaField empty[] = {{0, 4}, {4, 0}};
+    order o = make_order(1);
+
+    mu_assert("A NULL SoaVector can't be constructed.", !soa_init(NULL, order_fields, ORDER_FIELDS));
+    mu_assert("A SoaVector needs fields.", !soa_init(&soa, NULL, 1) && !soa_init(&soa, order_fields, 0) && !soa);
+    mu_assert("Fields need a size.", !soa_init(&soa, empty, 2) && !soa);
+    mu_assert("Failed to construct SoaVector.", soa_init(&soa, order_fields, ORDER_FIELDS));
+    mu_assert("A new SoaVector should be empty.", soa_size(soa) == 0 && !soa_get(soa, 0, &o) && !soa_pop(soa, &o));
+
+    mu_assert("NULL SoaVectors should be refused.",
+              !soa_push(NULL, &o) && !soa_size(NULL) && !soa_column(NULL, 0) && !soa_set(NULL, 0, &o));
+    mu_assert("NULL records should be refused.", !soa_push(soa, NULL));
+    mu_assert("Columns past the last field don't exist.", soa_column(soa, 0) && !soa_column(soa, ORDER_FIELDS));
+
+    soa_free(&soa);
+    mu_assert("Freed SoaVector should be NULL.", soa == NULL);
+    soa_free(&soa);
+    soa_free(NULL);
+
+    return MU_TEST_PASS;
+}
+
+mu_test(test_soa_records) {
+    SoaVector *soa = NULL;
+    order o, expected;
+    size_t n = 10000;
+
+    mu_assert("Failed to construct SoaVector.", soa_init(&soa, order_fields, ORDER_FIELDS));
+
+    // Records come back whole across the columns growing
+    for (size_t i = 0; i < n; i++) {
+        o = make_order(i);
+        mu_assert("soa_push() failed.", soa_push(soa, &o));
+    }
+    mu_assert("Every record should be counted.", soa_size(soa) == n);
+    for (size_t i = 0; i < n; i++) {
+        expected = make_order(i);
+        mu_assert("soa_get() failed.", soa_get(soa, i, &o) && same_order(&o, &expected));
+    }
+    mu_assert("Records past the end don't exist.", !soa_get(soa, n, &o) && !soa_set(soa, n, &o));
+
+    // Overwriting a record changes every field, and only that record
+    expected = make_order(n + 1);
+    mu_assert("soa_set() failed.", soa_set(soa, 5, &expected));
+    mu_assert("soa_set() should overwrite the record.", soa_get(soa, 5, &o) && same_order(&o, &expected));
+    expected = make_order(6);
+    mu_assert("soa_set() should leave neighbours alone.", soa_get(soa, 6, &o) && same_order(&o, &expected));
+
+    // Pops come from the end
+    expected = make_order(n - 1);
+    mu_assert("soa_pop() failed.", soa_pop(soa, &o) && same_order(&o, &expected));
+    mu_assert("soa_pop() without a record failed.", soa_pop(soa, NULL) && soa_size(soa) == n - 2);
+    while (soa_pop(soa, NULL));
+    mu_assert("Popping everything should empty the SoaVector.", soa_size(soa) == 0 && !soa_get(soa, 0, &o));
+
+    soa_free(&soa);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_soa_columns) {
+    SoaVector *soa = NULL;
+    order o;
+    size_t n = 5000;
+    const uint64_t *id;
+    const double *price;
+    const char *venue;
+    double total = 0;
+
+    mu_assert("Failed to construct SoaVector.", soa_init(&soa, order_fields, ORDER_FIELDS));
+    for (size_t i = 0; i < n; i++) {
+        o = make_order(i);
+        soa_push(soa, &o);
+    }
+
+    // Each column holds one field of every record, back to back
+    id = soa_column(soa, 0);
+    price = soa_column(soa, 2);
+    venue = soa_column(soa, 4);
+    for (size_t i = 0; i < n; i++) {
+        o = make_order(i);
+        mu_assert("The id column should hold every id.", id[i] == o.id);
+        mu_assert("The venue column should hold every venue.", !memcmp(venue + i * sizeof(o.venue), o.venue, 5));
+        total += price[i];
+    }
+    mu_assert("The price column should sum every price.", total == (double)(n - 1) * (double)n / 8);
+
+    // Writes through a column show in the records
+    ((uint32_t *)soa_column(soa, 3))[42] = 123456;
+    mu_assert("Column writes should show in records.", soa_get(soa, 42, &o) && o.qty == 123456);
+
+    soa_free(&soa);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_soa_init_free);
+    mu_run_test(test_soa_records);
+    mu_run_test(test_soa_columns);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
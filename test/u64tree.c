@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/map/u64tree.h"
+#include "minunit.h"
+
+#define _U64_TEST_KEYS 2000
+
+int tests_failed = 0;
+int tests_run = 0;
+int num_assertions = 0;
+
+mu_test(test_u64t_empty) {
+    U64Tree *tree = NULL;
+
+    mu_assert("Failed to initialize tree.", u64t_init(&tree) == _MAP_SUCCESS);
+    mu_assert("Empty tree's size is not 0.", u64t_size(tree) == 0);
+    mu_assert("Empty tree should not contain any keys.", !u64t_has(tree, 0));
+    mu_assert("Empty tree should return NULL for any key.", u64t_get(tree, 42) == NULL);
+    mu_assert("Removing from an empty tree should return 0.", !u64t_remove(tree, 42));
+
+    u64t_free(&tree);
+    mu_assert("After u64t_free(), tree should be NULL.", tree == NULL);
+    return MU_TEST_PASS;
+}
+
+mu_test(test_u64t_add_get_remove) {
+    U64Tree *tree = NULL;
+    // Extremes of the key range, which a subtracting comparison would get wrong
+    uint64_t keys[] = {1ULL << 63, 0, UINT64_MAX, 7, (1ULL << 63) - 1, 8, 6};
+    int data[] = {1, 2, 3, 4, 5, 6, 7};
+    int replaced = 42;
+    size_t size = 0;
+
+    u64t_init(&tree);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Insertion failed.", u64t_add(tree, keys[i], &data[i], sizeof(int)) == _MAP_SUCCESS);
+    }
+    mu_assert("Incorrect size after 7 insertions.", u64t_size(tree) == 7);
+    for (int i = 0; i < 7; i++) {
+        mu_assert("Entry has the wrong value after insertion.", *(int *)u64t_get(tree, keys[i]) == data[i]);
+    }
+    mu_assert("Missing key should not be found.", !u64t_has(tree, 5));
+
+    mu_assert("Replacing an entry should return _MAP_SUCCESS_REPLACED.", u64t_add(tree, 0, &replaced, sizeof(int)) == _MAP_SUCCESS_REPLACED);
+    mu_assert("Replaced entry has the wrong value.", *(int *)u64t_get_with_size(tree, 0, &size) == replaced);
+    mu_assert("Replaced entry has the wrong size.", size == sizeof(int));
+    mu_assert("Replacing should not change the size.", u64t_size(tree) == 7);
+
+    // The root has two children, 7 has two, 8 none
+    mu_assert("Failed to remove the root.", u64t_remove(tree, 1ULL << 63) == _MAP_SUCCESS);
+    mu_assert("Failed to remove 7.", u64t_remove(tree, 7) == _MAP_SUCCESS);
+    mu_assert("Failed to remove 8.", u64t_remove(tree, 8) == _MAP_SUCCESS);
+    mu_assert("Removing a missing key should return 0.", !u64t_remove(tree, 7));
+    mu_assert("Incorrect size after removals.", u64t_size(tree) == 4);
+    mu_assert("Remaining key is missing.", u64t_has(tree, 0) && u64t_has(tree, 6) && u64t_has(tree, UINT64_MAX) && u64t_has(tree, (1ULL << 63) - 1));
+
+    u64t_free(&tree);
+    return MU_TEST_PASS;
+}
+
+typedef struct {
+    uint64_t last;
+    int count;
+    int unordered;
+} order_check;
+
+static int check_order(uint64_t key, void *data, size_t size, void *ctx) {
+    order_check *c = ctx;
+    (void)size;
+
+    if (c->count && c->last >= key) c->unordered++;
+    if (*(uint64_t *)data != key) c->unordered++;
+    c->last = key;
+    c->count++;
+    return 0;
+}
+
+static int stop_after_3(uint64_t key, void *data, size_t size, void *ctx) {
+    (void)key;
+    (void)data;
+    (void)size;
+    return ++*(int *)ctx == 3;
+}
+
+mu_test(test_u64t_many) {
+    U64Tree *tree = NULL;
+    order_check check;
+    int stopped = 0;
+
+    u64t_init(&tree);
+    // Scrambled insertion order, keys spread over the whole range
+    for (uint64_t i = 0; i < _U64_TEST_KEYS; i++) {
+        uint64_t key = ((i * 7919) % _U64_TEST_KEYS) * 0x9e3779b97f4a7c15ULL;
+        u64t_add(tree, key, &key, sizeof(key));
+    }
+    mu_assert("Incorrect size after insertions.", u64t_size(tree) == _U64_TEST_KEYS);
+
+    memset(&check, 0, sizeof(check));
+    mu_assert("u64t_for_each() should visit every entry.", u64t_for_each(tree, check_order, &check));
+    mu_assert("u64t_for_each() visited the wrong number of entries.", check.count == _U64_TEST_KEYS);
+    mu_assert("u64t_for_each() is not in numeric order.", check.unordered == 0);
+    mu_assert("u64t_for_each() did not stop when asked.", !u64t_for_each(tree, stop_after_3, &stopped) && stopped == 3);
+
+    for (uint64_t i = 0; i < _U64_TEST_KEYS; i += 2) {
+        mu_assert("Removal failed.", u64t_remove(tree, i * 0x9e3779b97f4a7c15ULL));
+    }
+    for (uint64_t i = 0; i < _U64_TEST_KEYS; i++) {
+        uint64_t *value = u64t_get(tree, i * 0x9e3779b97f4a7c15ULL);
+        mu_assert("Removed key is still present.", i % 2 || !value);
+        mu_assert("Remaining entry is missing.", !(i % 2) || (value && *value == i * 0x9e3779b97f4a7c15ULL));
+    }
+
+    // Sequential keys degrade the tree into a list, which must still be freed
+    for (uint64_t i = 0; i < 10000; i++) u64t_add(tree, i, &i, sizeof(i));
+
+    u64t_free(&tree);
+    return MU_TEST_PASS;
+}
+
+void all_tests() {
+    mu_run_test(test_u64t_empty);
+    mu_run_test(test_u64t_add_get_remove);
+    mu_run_test(test_u64t_many);
+}
+
+int main() {
+    all_tests();
+
+    printf("\nTests run: %d\nTests failed: %d\nTotal assertions: %d\n\n", tests_run, tests_failed, num_assertions);
+
+    if (!tests_failed) {
+        printf("All tests passed\n");
+        return EXIT_SUCCESS;
+    } else {
+        return EXIT_FAILURE;
+    }
+}
@@ -84,11 +84,50 @@ mu_test(test_vector_free_element) {
     return MU_TEST_PASS;
 }
 
+static void double_element(void *element, size_t index, void *ctx) {
+    (void)index;
+    (void)ctx;
+    *(int *)element *= 2;
+}
+
+static void sum_element(void *acc, void *element, size_t index, void *ctx) {
+    (void)ctx;
+    *(long *)acc += *(int *)element - (long)index;
+}
+
+static void add_longs(void *acc, const void *part, void *ctx) {
+    (void)ctx;
+    *(long *)acc += *(const long *)part;
+}
+
+mu_test(test_vector_parallel) {
+    Vector v;
+    long sum;
+    vector_init(&v, 4, sizeof(int), NULL);
+    for (int i = 0; i < 100000; i++) {
+        vector_pushback(&v, &i);
+    }
+
+    // Each element is visited exactly once, whatever the thread count
+    for (unsigned threads = 0; threads <= 8; threads += 4) {
+        vector_parallel_for(&v, double_element, NULL, threads);
+        sum = 0;
+        vector_parallel_reduce(&v, sum_element, add_longs, &sum, sizeof(long), NULL, threads);
+        mu_assert("Parallel loop visited the wrong elements.", *(int *)vector_get(&v, 99999) == 99999 << (threads / 4 + 1));
+        mu_assert("Parallel reduction has the wrong result.", sum == ((1L << (threads / 4 + 1)) - 1) * (100000L * 99999 / 2));
+    }
+
+    vector_free(&v);
+
+    return MU_TEST_PASS;
+}
+
 void all_tests() {
     mu_run_test(test_vector_empty);
     mu_run_test(test_vector_grow);
     mu_run_test(test_vector_grow_and_delete);
     mu_run_test(test_vector_free_element);
+    mu_run_test(test_vector_parallel);
 }
 
 int main() {